@@ -27,6 +27,7 @@
 #define ENABLE_LOG_ERROR
 #define ENABLE_LOG_INFO
 // #define ENABLE_LOG_DEBUG
+#define ENABLE_RUN_LOOP_TIMER_HEAP
 
 // BTstack configuration. buffers, sizes, ...
 #define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
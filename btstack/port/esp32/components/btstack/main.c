@@ -62,6 +62,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "xtensa/hal.h"
 
 uint32_t esp_log_timestamp();
 
@@ -79,11 +80,12 @@ uint32_t hal_time_ms(void) {
 
 static void (*transport_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
 
-// ring buffer for incoming HCI packets. Each packet has 2 byte len tag + H4 packet type + packet itself
+// ring buffer for incoming HCI packets. Each packet has 6 byte tag (len + receive cycle count) + H4 packet type + packet itself
 #define MAX_NR_HOST_EVENT_PACKETS 4
-static uint8_t hci_ringbuffer_storage[HCI_HOST_ACL_PACKET_NUM   * (2 + 1 + HCI_ACL_HEADER_SIZE + HCI_HOST_ACL_PACKET_LEN) +
-                                      HCI_HOST_SCO_PACKET_NUM   * (2 + 1 + HCI_SCO_HEADER_SIZE + HCI_HOST_SCO_PACKET_LEN) +
-                                      MAX_NR_HOST_EVENT_PACKETS * (2 + 1 + HCI_EVENT_BUFFER_SIZE)];
+#define PACKET_TAG_SIZE 6
+static uint8_t hci_ringbuffer_storage[HCI_HOST_ACL_PACKET_NUM   * (PACKET_TAG_SIZE + 1 + HCI_ACL_HEADER_SIZE + HCI_HOST_ACL_PACKET_LEN) +
+                                      HCI_HOST_SCO_PACKET_NUM   * (PACKET_TAG_SIZE + 1 + HCI_SCO_HEADER_SIZE + HCI_HOST_SCO_PACKET_LEN) +
+                                      MAX_NR_HOST_EVENT_PACKETS * (PACKET_TAG_SIZE + 1 + HCI_EVENT_BUFFER_SIZE)];
 
 static btstack_ring_buffer_t hci_ringbuffer;
 
@@ -98,6 +100,9 @@ static btstack_data_source_t transport_data_source;
 static int                   transport_signal_sent;
 static int                   transport_packets_to_deliver;
 
+// cycle count when the packet being delivered was received from the controller
+static uint32_t              transport_rx_cycles;
+
 // TODO: remove once stable 
 void report_recv_called_from_isr(void){
      printf("host_recv_pkt_cb called from ISR!\n");
@@ -128,20 +133,23 @@ static int host_recv_pkt_cb(uint8_t *data, uint16_t len){
         return 0;
     }
 
+    uint32_t rx_cycles = xthal_get_ccount();
+
     xSemaphoreTake(ring_buffer_mutex, portMAX_DELAY);
 
     // check space
     uint16_t space = btstack_ring_buffer_bytes_free(&hci_ringbuffer);
-    if (space < len){
+    if (space < (PACKET_TAG_SIZE + len)){
         xSemaphoreGive(ring_buffer_mutex);
         log_error("transport_recv_pkt_cb packet %u, space %u -> dropping packet", len, space);
         return 0;
     }
 
-    // store size in ringbuffer
-    uint8_t len_tag[2];
-    little_endian_store_16(len_tag, 0, len);
-    btstack_ring_buffer_write(&hci_ringbuffer, len_tag, sizeof(len_tag));
+    // store size and receive time in ringbuffer
+    uint8_t tag[PACKET_TAG_SIZE];
+    little_endian_store_16(tag, 0, len);
+    little_endian_store_32(tag, 2, rx_cycles);
+    btstack_ring_buffer_write(&hci_ringbuffer, tag, sizeof(tag));
 
     // store in ringbuffer
     btstack_ring_buffer_write(&hci_ringbuffer, data, len);
@@ -171,9 +179,10 @@ static void transport_deliver_packets(void){
     xSemaphoreTake(ring_buffer_mutex, portMAX_DELAY);
     while (btstack_ring_buffer_bytes_available(&hci_ringbuffer)){
         uint32_t number_read;
-        uint8_t len_tag[2];
-        btstack_ring_buffer_read(&hci_ringbuffer, len_tag, 2, &number_read);
-        uint32_t len = little_endian_read_16(len_tag, 0);
+        uint8_t tag[PACKET_TAG_SIZE];
+        btstack_ring_buffer_read(&hci_ringbuffer, tag, PACKET_TAG_SIZE, &number_read);
+        uint32_t len = little_endian_read_16(tag, 0);
+        transport_rx_cycles = little_endian_read_32(tag, 2);
         btstack_ring_buffer_read(&hci_ringbuffer, hci_receive_buffer, len, &number_read);
         xSemaphoreGive(ring_buffer_mutex);
         transport_packet_handler(hci_receive_buffer[0], &hci_receive_buffer[1], len-1);
@@ -300,6 +309,11 @@ static const hci_transport_t transport = {
     NULL, // set SCO config
 };
 
+// used by the application to measure latencies from the packet reception
+uint32_t hci_transport_rx_cycles(void){
+    return transport_rx_cycles;
+}
+
 #else
 
 // this port requires the ESP32 Bluetooth to be enabled in the sdkconfig
@@ -326,6 +340,10 @@ static const hci_transport_t transport = {
     NULL, // reset link
     NULL, // set SCO config
 };
+
+uint32_t hci_transport_rx_cycles(void){
+    return 0;
+}
 #endif
 
 
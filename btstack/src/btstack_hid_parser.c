@@ -518,3 +518,148 @@ int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t *
     }
     return 0;
 }
+
+// Compiled report layout
+
+static int btstack_hid_report_layout_add_report_id(uint8_t * report_ids, int num_report_ids, uint8_t report_id){
+    int i;
+    for (i=0;i<num_report_ids;i++){
+        if (report_ids[i] == report_id) return num_report_ids;
+    }
+    if (num_report_ids >= MAX_NR_HID_REPORT_LAYOUT_REPORTS) return -1;
+    report_ids[num_report_ids] = report_id;
+    return num_report_ids + 1;
+}
+
+// walk an all-zero report with the parser and record position and format of each field before it is read
+static int btstack_hid_report_layout_compile_report(btstack_hid_report_layout_t * layout, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, uint8_t report_id){
+    btstack_hid_parser_t parser;
+    uint8_t probe[256];
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t  value;
+
+    int report_len = btstack_hid_get_report_size_for_id(report_id, HID_REPORT_TYPE_INPUT, hid_descriptor_len, hid_descriptor);
+    if (layout->report_ids_declared){
+        report_len++;
+    }
+    if ((report_len == 0) || (report_len > (int) sizeof(probe))) return -1;
+    memset(probe, 0, report_len);
+    probe[0] = report_id;
+
+    btstack_hid_report_id_layout_t * report = &layout->reports[layout->num_reports];
+    report->report_id   = report_id;
+    report->first_field = layout->num_fields;
+    report->num_fields  = 0;
+    report->report_len  = report_len;
+
+    btstack_hid_parser_init(&parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, probe, report_len);
+    while (btstack_hid_parser_has_more(&parser)){
+        if (layout->num_fields >= MAX_NR_HID_REPORT_LAYOUT_FIELDS) return -1;
+        if ((parser.global_report_size == 0) || (parser.global_report_size > 32)) return -1;
+        btstack_hid_report_field_layout_t * field = &layout->fields[layout->num_fields];
+        field->bit_offset      = parser.report_pos_in_bit;
+        field->bit_size        = parser.global_report_size;
+        field->logical_minimum = parser.global_logical_minimum;
+        field->logical_maximum = parser.global_logical_maximum;
+        field->flags = 0;
+        if (parser.descriptor_item.item_value & 2){
+            field->flags |= BTSTACK_HID_REPORT_FIELD_VARIABLE;
+        }
+        if (parser.global_logical_minimum < 0){
+            field->flags |= BTSTACK_HID_REPORT_FIELD_SIGNED;
+        }
+        btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
+        field->usage_page = usage_page;
+        field->usage      = (field->flags & BTSTACK_HID_REPORT_FIELD_VARIABLE) ? usage : 0;
+        layout->num_fields++;
+        report->num_fields++;
+    }
+
+    // skip report IDs without input fields
+    if (report->num_fields){
+        layout->num_reports++;
+    }
+    return 0;
+}
+
+int btstack_hid_report_layout_compile(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, btstack_hid_report_layout_t * layout){
+    uint8_t report_ids[MAX_NR_HID_REPORT_LAYOUT_REPORTS];
+    int num_report_ids = 0;
+    const uint8_t * descriptor = hid_descriptor;
+    uint16_t descriptor_len = hid_descriptor_len;
+    int i;
+
+    memset(layout, 0, sizeof(btstack_hid_report_layout_t));
+
+    // collect report IDs
+    while (descriptor_len){
+        hid_descriptor_item_t item;
+        btstack_hid_parse_descriptor_item(&item, descriptor, descriptor_len);
+        if ((item.item_size == 0) || (item.item_size > descriptor_len)) return -1;
+        if ((item.item_type == Global) && (item.item_tag == ReportID)){
+            num_report_ids = btstack_hid_report_layout_add_report_id(report_ids, num_report_ids, item.item_value);
+            if (num_report_ids < 0) return -1;
+        }
+        descriptor_len -= item.item_size;
+        descriptor += item.item_size;
+    }
+
+    if (num_report_ids == 0){
+        if (btstack_hid_report_layout_compile_report(layout, hid_descriptor, hid_descriptor_len, 0)) return -1;
+    } else {
+        layout->report_ids_declared = 1;
+        for (i=0;i<num_report_ids;i++){
+            if (btstack_hid_report_layout_compile_report(layout, hid_descriptor, hid_descriptor_len, report_ids[i])) return -1;
+        }
+    }
+    return layout->num_reports ? 0 : -1;
+}
+
+const btstack_hid_report_id_layout_t * btstack_hid_report_layout_find(const btstack_hid_report_layout_t * layout, const uint8_t * hid_report, uint16_t hid_report_len){
+    int i;
+    if (!layout->report_ids_declared){
+        return layout->num_reports ? &layout->reports[0] : NULL;
+    }
+    if (hid_report_len < 1) return NULL;
+    for (i=0;i<layout->num_reports;i++){
+        if (layout->reports[i].report_id == hid_report[0]) return &layout->reports[i];
+    }
+    return NULL;
+}
+
+int btstack_hid_report_layout_extract(const btstack_hid_report_layout_t * layout, const uint8_t * hid_report, uint16_t hid_report_len, btstack_hid_report_field_t * fields, int max_fields){
+    const btstack_hid_report_id_layout_t * report = btstack_hid_report_layout_find(layout, hid_report, hid_report_len);
+    if (!report) return -1;
+
+    const btstack_hid_report_field_layout_t * field = &layout->fields[report->first_field];
+    int num_fields = btstack_min(report->num_fields, max_fields);
+    int i;
+    for (i=0;i<num_fields;i++, field++){
+        // read up to 32 bit little endian, bytes beyond end of report read as zero
+        int pos_start = field->bit_offset >> 3;
+        int pos_end   = (field->bit_offset + field->bit_size - 1) >> 3;
+        uint64_t multi_byte_value = 0;
+        int pos;
+        for (pos = pos_start; (pos <= pos_end) && (pos < hid_report_len); pos++){
+            multi_byte_value |= ((uint64_t) hid_report[pos]) << ((pos - pos_start) * 8);
+        }
+        uint32_t unsigned_value = (uint32_t) (multi_byte_value >> (field->bit_offset & 0x07));
+        if (field->bit_size < 32){
+            unsigned_value &= (1u << field->bit_size) - 1;
+        }
+        fields[i].usage_page = field->usage_page;
+        if (field->flags & BTSTACK_HID_REPORT_FIELD_VARIABLE){
+            fields[i].usage = field->usage;
+            if ((field->flags & BTSTACK_HID_REPORT_FIELD_SIGNED) && (field->bit_size < 32) && (unsigned_value & (1u << (field->bit_size - 1)))){
+                fields[i].value = (int32_t) (unsigned_value - (1u << field->bit_size));
+            } else {
+                fields[i].value = (int32_t) unsigned_value;
+            }
+        } else {
+            fields[i].usage = unsigned_value;
+            fields[i].value = 1;
+        }
+    }
+    return num_fields;
+}
@@ -161,6 +161,49 @@ typedef struct {
     uint8_t         global_report_id;
 } btstack_hid_parser_t;
 
+// compiled report layout limits
+#ifndef MAX_NR_HID_REPORT_LAYOUT_FIELDS
+#define MAX_NR_HID_REPORT_LAYOUT_FIELDS  64
+#endif
+#ifndef MAX_NR_HID_REPORT_LAYOUT_REPORTS
+#define MAX_NR_HID_REPORT_LAYOUT_REPORTS 8
+#endif
+
+// compiled field flags
+#define BTSTACK_HID_REPORT_FIELD_VARIABLE 0x01
+#define BTSTACK_HID_REPORT_FIELD_SIGNED   0x02
+
+typedef struct {
+    uint16_t usage_page;
+    uint16_t usage;             // variable fields only, array fields report the usage as value
+    uint16_t bit_offset;        // from start of report, including report ID
+    uint8_t  bit_size;
+    uint8_t  flags;
+    int32_t  logical_minimum;
+    int32_t  logical_maximum;
+} btstack_hid_report_field_layout_t;
+
+typedef struct {
+    uint8_t  report_id;         // 0 if no report IDs are declared
+    uint8_t  num_fields;
+    uint16_t first_field;       // index into btstack_hid_report_layout_t.fields
+    uint16_t report_len;        // including report ID
+} btstack_hid_report_id_layout_t;
+
+typedef struct {
+    btstack_hid_report_field_layout_t fields[MAX_NR_HID_REPORT_LAYOUT_FIELDS];
+    btstack_hid_report_id_layout_t    reports[MAX_NR_HID_REPORT_LAYOUT_REPORTS];
+    uint16_t num_fields;
+    uint8_t  num_reports;
+    uint8_t  report_ids_declared;
+} btstack_hid_report_layout_t;
+
+typedef struct {
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t  value;
+} btstack_hid_report_field_t;
+
 /* API_START */
 
 /**
@@ -220,6 +263,35 @@ hid_report_id_status_t btstack_hid_id_valid(int report_id, uint16_t hid_descript
  * @param hid_descriptor
  */
 int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t * hid_descriptor);
+/**
+ * @brief Compile the input report layout of a HID descriptor: usage page, usage, bit offset, bit size and
+ *        logical min/max of every field of every report ID, so reports can be decoded without the parser
+ * @param hid_descriptor
+ * @param hid_descriptor_len
+ * @param layout
+ * @return 0 if ok, -1 if the descriptor has no input fields or exceeds the layout limits
+ */
+int btstack_hid_report_layout_compile(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, btstack_hid_report_layout_t * layout);
+
+/**
+ * @brief Find compiled layout of an input report
+ * @param layout
+ * @param hid_report
+ * @param hid_report_len
+ * @return report layout or NULL if report ID unknown
+ */
+const btstack_hid_report_id_layout_t * btstack_hid_report_layout_find(const btstack_hid_report_layout_t * layout, const uint8_t * hid_report, uint16_t hid_report_len);
+
+/**
+ * @brief Extract all fields of an input report, same fields and values as btstack_hid_parser_get_field
+ * @param layout
+ * @param hid_report
+ * @param hid_report_len
+ * @param fields
+ * @param max_fields
+ * @return number of fields stored, or -1 if report ID unknown
+ */
+int btstack_hid_report_layout_extract(const btstack_hid_report_layout_t * layout, const uint8_t * hid_report, uint16_t hid_report_len, btstack_hid_report_field_t * fields, int max_fields);
 /* API_END */
 
 #if defined __cplusplus
@@ -50,6 +50,7 @@
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
@@ -67,6 +68,7 @@
 #ifdef MAX_NR_HCI_CONNECTIONS
 #if MAX_NR_HCI_CONNECTIONS > 0
 static hci_connection_t hci_connection_storage[MAX_NR_HCI_CONNECTIONS];
+static uint32_t hci_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_HCI_CONNECTIONS)];
 static btstack_memory_pool_t hci_connection_pool;
 hci_connection_t * btstack_memory_hci_connection_get(void){
     void * buffer = btstack_memory_pool_get(&hci_connection_pool);
@@ -78,26 +80,47 @@ hci_connection_t * btstack_memory_hci_connection_get(void){
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
     btstack_memory_pool_free(&hci_connection_pool, hci_connection);
 }
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&hci_connection_pool, stats);
+}
 #else
+static uint32_t hci_connection_failed;
 hci_connection_t * btstack_memory_hci_connection_get(void){
+    hci_connection_failed++;
     return NULL;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) hci_connection;
 };
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = hci_connection_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t hci_connection_stats;
 hci_connection_t * btstack_memory_hci_connection_get(void){
     void * buffer = malloc(sizeof(hci_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hci_connection_t));
+        hci_connection_stats.used++;
+        if (hci_connection_stats.used > hci_connection_stats.max_used){
+            hci_connection_stats.max_used = hci_connection_stats.used;
+        }
+    } else {
+        hci_connection_stats.failed++;
     }
     return (hci_connection_t *) buffer;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    if (hci_connection == NULL) return;
+    hci_connection_stats.used--;
     free(hci_connection);
 }
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hci_connection_stats;
+}
 #endif
 
 
@@ -114,6 +137,7 @@ void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
 #ifdef MAX_NR_L2CAP_SERVICES
 #if MAX_NR_L2CAP_SERVICES > 0
 static l2cap_service_t l2cap_service_storage[MAX_NR_L2CAP_SERVICES];
+static uint32_t l2cap_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_L2CAP_SERVICES)];
 static btstack_memory_pool_t l2cap_service_pool;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
     void * buffer = btstack_memory_pool_get(&l2cap_service_pool);
@@ -125,26 +149,47 @@ l2cap_service_t * btstack_memory_l2cap_service_get(void){
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
     btstack_memory_pool_free(&l2cap_service_pool, l2cap_service);
 }
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&l2cap_service_pool, stats);
+}
 #else
+static uint32_t l2cap_service_failed;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    l2cap_service_failed++;
     return NULL;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
     // silence compiler warning about unused parameter in a portable way
     (void) l2cap_service;
 };
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = l2cap_service_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t l2cap_service_stats;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
     void * buffer = malloc(sizeof(l2cap_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_service_t));
+        l2cap_service_stats.used++;
+        if (l2cap_service_stats.used > l2cap_service_stats.max_used){
+            l2cap_service_stats.max_used = l2cap_service_stats.used;
+        }
+    } else {
+        l2cap_service_stats.failed++;
     }
     return (l2cap_service_t *) buffer;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    if (l2cap_service == NULL) return;
+    l2cap_service_stats.used--;
     free(l2cap_service);
 }
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_service_stats;
+}
 #endif
 
 
@@ -160,6 +205,7 @@ void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
 #ifdef MAX_NR_L2CAP_CHANNELS
 #if MAX_NR_L2CAP_CHANNELS > 0
 static l2cap_channel_t l2cap_channel_storage[MAX_NR_L2CAP_CHANNELS];
+static uint32_t l2cap_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_L2CAP_CHANNELS)];
 static btstack_memory_pool_t l2cap_channel_pool;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     void * buffer = btstack_memory_pool_get(&l2cap_channel_pool);
@@ -171,26 +217,47 @@ l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
     btstack_memory_pool_free(&l2cap_channel_pool, l2cap_channel);
 }
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&l2cap_channel_pool, stats);
+}
 #else
+static uint32_t l2cap_channel_failed;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    l2cap_channel_failed++;
     return NULL;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) l2cap_channel;
 };
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = l2cap_channel_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t l2cap_channel_stats;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     void * buffer = malloc(sizeof(l2cap_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_channel_t));
+        l2cap_channel_stats.used++;
+        if (l2cap_channel_stats.used > l2cap_channel_stats.max_used){
+            l2cap_channel_stats.max_used = l2cap_channel_stats.used;
+        }
+    } else {
+        l2cap_channel_stats.failed++;
     }
     return (l2cap_channel_t *) buffer;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    if (l2cap_channel == NULL) return;
+    l2cap_channel_stats.used--;
     free(l2cap_channel);
 }
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_channel_stats;
+}
 #endif
 
 
@@ -208,6 +275,7 @@ void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
 #ifdef MAX_NR_RFCOMM_MULTIPLEXERS
 #if MAX_NR_RFCOMM_MULTIPLEXERS > 0
 static rfcomm_multiplexer_t rfcomm_multiplexer_storage[MAX_NR_RFCOMM_MULTIPLEXERS];
+static uint32_t rfcomm_multiplexer_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_MULTIPLEXERS)];
 static btstack_memory_pool_t rfcomm_multiplexer_pool;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     void * buffer = btstack_memory_pool_get(&rfcomm_multiplexer_pool);
@@ -219,26 +287,47 @@ rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
     btstack_memory_pool_free(&rfcomm_multiplexer_pool, rfcomm_multiplexer);
 }
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_multiplexer_pool, stats);
+}
 #else
+static uint32_t rfcomm_multiplexer_failed;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    rfcomm_multiplexer_failed++;
     return NULL;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_multiplexer;
 };
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = rfcomm_multiplexer_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_multiplexer_stats;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     void * buffer = malloc(sizeof(rfcomm_multiplexer_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_multiplexer_t));
+        rfcomm_multiplexer_stats.used++;
+        if (rfcomm_multiplexer_stats.used > rfcomm_multiplexer_stats.max_used){
+            rfcomm_multiplexer_stats.max_used = rfcomm_multiplexer_stats.used;
+        }
+    } else {
+        rfcomm_multiplexer_stats.failed++;
     }
     return (rfcomm_multiplexer_t *) buffer;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    if (rfcomm_multiplexer == NULL) return;
+    rfcomm_multiplexer_stats.used--;
     free(rfcomm_multiplexer);
 }
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_multiplexer_stats;
+}
 #endif
 
 
@@ -254,6 +343,7 @@ void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multipl
 #ifdef MAX_NR_RFCOMM_SERVICES
 #if MAX_NR_RFCOMM_SERVICES > 0
 static rfcomm_service_t rfcomm_service_storage[MAX_NR_RFCOMM_SERVICES];
+static uint32_t rfcomm_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_SERVICES)];
 static btstack_memory_pool_t rfcomm_service_pool;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     void * buffer = btstack_memory_pool_get(&rfcomm_service_pool);
@@ -265,26 +355,47 @@ rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
     btstack_memory_pool_free(&rfcomm_service_pool, rfcomm_service);
 }
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_service_pool, stats);
+}
 #else
+static uint32_t rfcomm_service_failed;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    rfcomm_service_failed++;
     return NULL;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_service;
 };
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = rfcomm_service_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_service_stats;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     void * buffer = malloc(sizeof(rfcomm_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_service_t));
+        rfcomm_service_stats.used++;
+        if (rfcomm_service_stats.used > rfcomm_service_stats.max_used){
+            rfcomm_service_stats.max_used = rfcomm_service_stats.used;
+        }
+    } else {
+        rfcomm_service_stats.failed++;
     }
     return (rfcomm_service_t *) buffer;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    if (rfcomm_service == NULL) return;
+    rfcomm_service_stats.used--;
     free(rfcomm_service);
 }
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_service_stats;
+}
 #endif
 
 
@@ -300,6 +411,7 @@ void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
 #ifdef MAX_NR_RFCOMM_CHANNELS
 #if MAX_NR_RFCOMM_CHANNELS > 0
 static rfcomm_channel_t rfcomm_channel_storage[MAX_NR_RFCOMM_CHANNELS];
+static uint32_t rfcomm_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_RFCOMM_CHANNELS)];
 static btstack_memory_pool_t rfcomm_channel_pool;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     void * buffer = btstack_memory_pool_get(&rfcomm_channel_pool);
@@ -311,26 +423,47 @@ rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
     btstack_memory_pool_free(&rfcomm_channel_pool, rfcomm_channel);
 }
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_channel_pool, stats);
+}
 #else
+static uint32_t rfcomm_channel_failed;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    rfcomm_channel_failed++;
     return NULL;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_channel;
 };
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = rfcomm_channel_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_channel_stats;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     void * buffer = malloc(sizeof(rfcomm_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_channel_t));
+        rfcomm_channel_stats.used++;
+        if (rfcomm_channel_stats.used > rfcomm_channel_stats.max_used){
+            rfcomm_channel_stats.max_used = rfcomm_channel_stats.used;
+        }
+    } else {
+        rfcomm_channel_stats.failed++;
     }
     return (rfcomm_channel_t *) buffer;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    if (rfcomm_channel == NULL) return;
+    rfcomm_channel_stats.used--;
     free(rfcomm_channel);
 }
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_channel_stats;
+}
 #endif
 
 
@@ -347,6 +480,7 @@ void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
 #ifdef MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES
 #if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
 static btstack_link_key_db_memory_entry_t btstack_link_key_db_memory_entry_storage[MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES];
+static uint32_t btstack_link_key_db_memory_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)];
 static btstack_memory_pool_t btstack_link_key_db_memory_entry_pool;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
     void * buffer = btstack_memory_pool_get(&btstack_link_key_db_memory_entry_pool);
@@ -358,26 +492,47 @@ btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_e
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
     btstack_memory_pool_free(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry);
 }
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&btstack_link_key_db_memory_entry_pool, stats);
+}
 #else
+static uint32_t btstack_link_key_db_memory_entry_failed;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    btstack_link_key_db_memory_entry_failed++;
     return NULL;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) btstack_link_key_db_memory_entry;
 };
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = btstack_link_key_db_memory_entry_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t btstack_link_key_db_memory_entry_stats;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
     void * buffer = malloc(sizeof(btstack_link_key_db_memory_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(btstack_link_key_db_memory_entry_t));
+        btstack_link_key_db_memory_entry_stats.used++;
+        if (btstack_link_key_db_memory_entry_stats.used > btstack_link_key_db_memory_entry_stats.max_used){
+            btstack_link_key_db_memory_entry_stats.max_used = btstack_link_key_db_memory_entry_stats.used;
+        }
+    } else {
+        btstack_link_key_db_memory_entry_stats.failed++;
     }
     return (btstack_link_key_db_memory_entry_t *) buffer;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    if (btstack_link_key_db_memory_entry == NULL) return;
+    btstack_link_key_db_memory_entry_stats.used--;
     free(btstack_link_key_db_memory_entry);
 }
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = btstack_link_key_db_memory_entry_stats;
+}
 #endif
 
 
@@ -394,6 +549,7 @@ void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_me
 #ifdef MAX_NR_BNEP_SERVICES
 #if MAX_NR_BNEP_SERVICES > 0
 static bnep_service_t bnep_service_storage[MAX_NR_BNEP_SERVICES];
+static uint32_t bnep_service_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BNEP_SERVICES)];
 static btstack_memory_pool_t bnep_service_pool;
 bnep_service_t * btstack_memory_bnep_service_get(void){
     void * buffer = btstack_memory_pool_get(&bnep_service_pool);
@@ -405,26 +561,47 @@ bnep_service_t * btstack_memory_bnep_service_get(void){
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
     btstack_memory_pool_free(&bnep_service_pool, bnep_service);
 }
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&bnep_service_pool, stats);
+}
 #else
+static uint32_t bnep_service_failed;
 bnep_service_t * btstack_memory_bnep_service_get(void){
+    bnep_service_failed++;
     return NULL;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
     // silence compiler warning about unused parameter in a portable way
     (void) bnep_service;
 };
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = bnep_service_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t bnep_service_stats;
 bnep_service_t * btstack_memory_bnep_service_get(void){
     void * buffer = malloc(sizeof(bnep_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_service_t));
+        bnep_service_stats.used++;
+        if (bnep_service_stats.used > bnep_service_stats.max_used){
+            bnep_service_stats.max_used = bnep_service_stats.used;
+        }
+    } else {
+        bnep_service_stats.failed++;
     }
     return (bnep_service_t *) buffer;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    if (bnep_service == NULL) return;
+    bnep_service_stats.used--;
     free(bnep_service);
 }
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_service_stats;
+}
 #endif
 
 
@@ -440,6 +617,7 @@ void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
 #ifdef MAX_NR_BNEP_CHANNELS
 #if MAX_NR_BNEP_CHANNELS > 0
 static bnep_channel_t bnep_channel_storage[MAX_NR_BNEP_CHANNELS];
+static uint32_t bnep_channel_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_BNEP_CHANNELS)];
 static btstack_memory_pool_t bnep_channel_pool;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
     void * buffer = btstack_memory_pool_get(&bnep_channel_pool);
@@ -451,26 +629,47 @@ bnep_channel_t * btstack_memory_bnep_channel_get(void){
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
     btstack_memory_pool_free(&bnep_channel_pool, bnep_channel);
 }
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&bnep_channel_pool, stats);
+}
 #else
+static uint32_t bnep_channel_failed;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    bnep_channel_failed++;
     return NULL;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) bnep_channel;
 };
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = bnep_channel_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t bnep_channel_stats;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
     void * buffer = malloc(sizeof(bnep_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_channel_t));
+        bnep_channel_stats.used++;
+        if (bnep_channel_stats.used > bnep_channel_stats.max_used){
+            bnep_channel_stats.max_used = bnep_channel_stats.used;
+        }
+    } else {
+        bnep_channel_stats.failed++;
     }
     return (bnep_channel_t *) buffer;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    if (bnep_channel == NULL) return;
+    bnep_channel_stats.used--;
     free(bnep_channel);
 }
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_channel_stats;
+}
 #endif
 
 
@@ -487,6 +686,7 @@ void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
 #ifdef MAX_NR_HFP_CONNECTIONS
 #if MAX_NR_HFP_CONNECTIONS > 0
 static hfp_connection_t hfp_connection_storage[MAX_NR_HFP_CONNECTIONS];
+static uint32_t hfp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_HFP_CONNECTIONS)];
 static btstack_memory_pool_t hfp_connection_pool;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
     void * buffer = btstack_memory_pool_get(&hfp_connection_pool);
@@ -498,26 +698,47 @@ hfp_connection_t * btstack_memory_hfp_connection_get(void){
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
     btstack_memory_pool_free(&hfp_connection_pool, hfp_connection);
 }
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&hfp_connection_pool, stats);
+}
 #else
+static uint32_t hfp_connection_failed;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    hfp_connection_failed++;
     return NULL;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) hfp_connection;
 };
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = hfp_connection_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t hfp_connection_stats;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
     void * buffer = malloc(sizeof(hfp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hfp_connection_t));
+        hfp_connection_stats.used++;
+        if (hfp_connection_stats.used > hfp_connection_stats.max_used){
+            hfp_connection_stats.max_used = hfp_connection_stats.used;
+        }
+    } else {
+        hfp_connection_stats.failed++;
     }
     return (hfp_connection_t *) buffer;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    if (hfp_connection == NULL) return;
+    hfp_connection_stats.used--;
     free(hfp_connection);
 }
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hfp_connection_stats;
+}
 #endif
 
 
@@ -534,6 +755,7 @@ void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
 #ifdef MAX_NR_SERVICE_RECORD_ITEMS
 #if MAX_NR_SERVICE_RECORD_ITEMS > 0
 static service_record_item_t service_record_item_storage[MAX_NR_SERVICE_RECORD_ITEMS];
+static uint32_t service_record_item_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_SERVICE_RECORD_ITEMS)];
 static btstack_memory_pool_t service_record_item_pool;
 service_record_item_t * btstack_memory_service_record_item_get(void){
     void * buffer = btstack_memory_pool_get(&service_record_item_pool);
@@ -545,26 +767,47 @@ service_record_item_t * btstack_memory_service_record_item_get(void){
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
     btstack_memory_pool_free(&service_record_item_pool, service_record_item);
 }
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&service_record_item_pool, stats);
+}
 #else
+static uint32_t service_record_item_failed;
 service_record_item_t * btstack_memory_service_record_item_get(void){
+    service_record_item_failed++;
     return NULL;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
     // silence compiler warning about unused parameter in a portable way
     (void) service_record_item;
 };
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = service_record_item_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t service_record_item_stats;
 service_record_item_t * btstack_memory_service_record_item_get(void){
     void * buffer = malloc(sizeof(service_record_item_t));
     if (buffer){
         memset(buffer, 0, sizeof(service_record_item_t));
+        service_record_item_stats.used++;
+        if (service_record_item_stats.used > service_record_item_stats.max_used){
+            service_record_item_stats.max_used = service_record_item_stats.used;
+        }
+    } else {
+        service_record_item_stats.failed++;
     }
     return (service_record_item_t *) buffer;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    if (service_record_item == NULL) return;
+    service_record_item_stats.used--;
     free(service_record_item);
 }
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = service_record_item_stats;
+}
 #endif
 
 
@@ -581,6 +824,7 @@ void btstack_memory_service_record_item_free(service_record_item_t *service_reco
 #ifdef MAX_NR_AVDTP_STREAM_ENDPOINTS
 #if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
 static avdtp_stream_endpoint_t avdtp_stream_endpoint_storage[MAX_NR_AVDTP_STREAM_ENDPOINTS];
+static uint32_t avdtp_stream_endpoint_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVDTP_STREAM_ENDPOINTS)];
 static btstack_memory_pool_t avdtp_stream_endpoint_pool;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     void * buffer = btstack_memory_pool_get(&avdtp_stream_endpoint_pool);
@@ -592,26 +836,47 @@ avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
     btstack_memory_pool_free(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint);
 }
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avdtp_stream_endpoint_pool, stats);
+}
 #else
+static uint32_t avdtp_stream_endpoint_failed;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    avdtp_stream_endpoint_failed++;
     return NULL;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
     // silence compiler warning about unused parameter in a portable way
     (void) avdtp_stream_endpoint;
 };
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = avdtp_stream_endpoint_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avdtp_stream_endpoint_stats;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     void * buffer = malloc(sizeof(avdtp_stream_endpoint_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_stream_endpoint_t));
+        avdtp_stream_endpoint_stats.used++;
+        if (avdtp_stream_endpoint_stats.used > avdtp_stream_endpoint_stats.max_used){
+            avdtp_stream_endpoint_stats.max_used = avdtp_stream_endpoint_stats.used;
+        }
+    } else {
+        avdtp_stream_endpoint_stats.failed++;
     }
     return (avdtp_stream_endpoint_t *) buffer;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    if (avdtp_stream_endpoint == NULL) return;
+    avdtp_stream_endpoint_stats.used--;
     free(avdtp_stream_endpoint);
 }
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_stream_endpoint_stats;
+}
 #endif
 
 
@@ -628,6 +893,7 @@ void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_st
 #ifdef MAX_NR_AVDTP_CONNECTIONS
 #if MAX_NR_AVDTP_CONNECTIONS > 0
 static avdtp_connection_t avdtp_connection_storage[MAX_NR_AVDTP_CONNECTIONS];
+static uint32_t avdtp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVDTP_CONNECTIONS)];
 static btstack_memory_pool_t avdtp_connection_pool;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     void * buffer = btstack_memory_pool_get(&avdtp_connection_pool);
@@ -639,26 +905,47 @@ avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
     btstack_memory_pool_free(&avdtp_connection_pool, avdtp_connection);
 }
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avdtp_connection_pool, stats);
+}
 #else
+static uint32_t avdtp_connection_failed;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    avdtp_connection_failed++;
     return NULL;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avdtp_connection;
 };
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = avdtp_connection_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avdtp_connection_stats;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     void * buffer = malloc(sizeof(avdtp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_connection_t));
+        avdtp_connection_stats.used++;
+        if (avdtp_connection_stats.used > avdtp_connection_stats.max_used){
+            avdtp_connection_stats.max_used = avdtp_connection_stats.used;
+        }
+    } else {
+        avdtp_connection_stats.failed++;
     }
     return (avdtp_connection_t *) buffer;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    if (avdtp_connection == NULL) return;
+    avdtp_connection_stats.used--;
     free(avdtp_connection);
 }
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_connection_stats;
+}
 #endif
 
 
@@ -675,6 +962,7 @@ void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
 #ifdef MAX_NR_AVRCP_CONNECTIONS
 #if MAX_NR_AVRCP_CONNECTIONS > 0
 static avrcp_connection_t avrcp_connection_storage[MAX_NR_AVRCP_CONNECTIONS];
+static uint32_t avrcp_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVRCP_CONNECTIONS)];
 static btstack_memory_pool_t avrcp_connection_pool;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     void * buffer = btstack_memory_pool_get(&avrcp_connection_pool);
@@ -686,26 +974,47 @@ avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
     btstack_memory_pool_free(&avrcp_connection_pool, avrcp_connection);
 }
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avrcp_connection_pool, stats);
+}
 #else
+static uint32_t avrcp_connection_failed;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    avrcp_connection_failed++;
     return NULL;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avrcp_connection;
 };
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = avrcp_connection_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avrcp_connection_stats;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_connection_t));
+        avrcp_connection_stats.used++;
+        if (avrcp_connection_stats.used > avrcp_connection_stats.max_used){
+            avrcp_connection_stats.max_used = avrcp_connection_stats.used;
+        }
+    } else {
+        avrcp_connection_stats.failed++;
     }
     return (avrcp_connection_t *) buffer;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    if (avrcp_connection == NULL) return;
+    avrcp_connection_stats.used--;
     free(avrcp_connection);
 }
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_connection_stats;
+}
 #endif
 
 
@@ -722,6 +1031,7 @@ void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
 #ifdef MAX_NR_AVRCP_BROWSING_CONNECTIONS
 #if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
 static avrcp_browsing_connection_t avrcp_browsing_connection_storage[MAX_NR_AVRCP_BROWSING_CONNECTIONS];
+static uint32_t avrcp_browsing_connection_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_AVRCP_BROWSING_CONNECTIONS)];
 static btstack_memory_pool_t avrcp_browsing_connection_pool;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
     void * buffer = btstack_memory_pool_get(&avrcp_browsing_connection_pool);
@@ -733,26 +1043,47 @@ avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void)
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
     btstack_memory_pool_free(&avrcp_browsing_connection_pool, avrcp_browsing_connection);
 }
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avrcp_browsing_connection_pool, stats);
+}
 #else
+static uint32_t avrcp_browsing_connection_failed;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    avrcp_browsing_connection_failed++;
     return NULL;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avrcp_browsing_connection;
 };
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = avrcp_browsing_connection_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avrcp_browsing_connection_stats;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_browsing_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_browsing_connection_t));
+        avrcp_browsing_connection_stats.used++;
+        if (avrcp_browsing_connection_stats.used > avrcp_browsing_connection_stats.max_used){
+            avrcp_browsing_connection_stats.max_used = avrcp_browsing_connection_stats.used;
+        }
+    } else {
+        avrcp_browsing_connection_stats.failed++;
     }
     return (avrcp_browsing_connection_t *) buffer;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    if (avrcp_browsing_connection == NULL) return;
+    avrcp_browsing_connection_stats.used--;
     free(avrcp_browsing_connection);
 }
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_browsing_connection_stats;
+}
 #endif
 
 
@@ -771,6 +1102,7 @@ void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *
 #ifdef MAX_NR_GATT_CLIENTS
 #if MAX_NR_GATT_CLIENTS > 0
 static gatt_client_t gatt_client_storage[MAX_NR_GATT_CLIENTS];
+static uint32_t gatt_client_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_GATT_CLIENTS)];
 static btstack_memory_pool_t gatt_client_pool;
 gatt_client_t * btstack_memory_gatt_client_get(void){
     void * buffer = btstack_memory_pool_get(&gatt_client_pool);
@@ -782,26 +1114,47 @@ gatt_client_t * btstack_memory_gatt_client_get(void){
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
     btstack_memory_pool_free(&gatt_client_pool, gatt_client);
 }
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&gatt_client_pool, stats);
+}
 #else
+static uint32_t gatt_client_failed;
 gatt_client_t * btstack_memory_gatt_client_get(void){
+    gatt_client_failed++;
     return NULL;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
     // silence compiler warning about unused parameter in a portable way
     (void) gatt_client;
 };
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = gatt_client_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t gatt_client_stats;
 gatt_client_t * btstack_memory_gatt_client_get(void){
     void * buffer = malloc(sizeof(gatt_client_t));
     if (buffer){
         memset(buffer, 0, sizeof(gatt_client_t));
+        gatt_client_stats.used++;
+        if (gatt_client_stats.used > gatt_client_stats.max_used){
+            gatt_client_stats.max_used = gatt_client_stats.used;
+        }
+    } else {
+        gatt_client_stats.failed++;
     }
     return (gatt_client_t *) buffer;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    if (gatt_client == NULL) return;
+    gatt_client_stats.used--;
     free(gatt_client);
 }
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = gatt_client_stats;
+}
 #endif
 
 
@@ -817,6 +1170,7 @@ void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
 #ifdef MAX_NR_WHITELIST_ENTRIES
 #if MAX_NR_WHITELIST_ENTRIES > 0
 static whitelist_entry_t whitelist_entry_storage[MAX_NR_WHITELIST_ENTRIES];
+static uint32_t whitelist_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_WHITELIST_ENTRIES)];
 static btstack_memory_pool_t whitelist_entry_pool;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     void * buffer = btstack_memory_pool_get(&whitelist_entry_pool);
@@ -828,26 +1182,47 @@ whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
     btstack_memory_pool_free(&whitelist_entry_pool, whitelist_entry);
 }
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&whitelist_entry_pool, stats);
+}
 #else
+static uint32_t whitelist_entry_failed;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    whitelist_entry_failed++;
     return NULL;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) whitelist_entry;
 };
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = whitelist_entry_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t whitelist_entry_stats;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     void * buffer = malloc(sizeof(whitelist_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(whitelist_entry_t));
+        whitelist_entry_stats.used++;
+        if (whitelist_entry_stats.used > whitelist_entry_stats.max_used){
+            whitelist_entry_stats.max_used = whitelist_entry_stats.used;
+        }
+    } else {
+        whitelist_entry_stats.failed++;
     }
     return (whitelist_entry_t *) buffer;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    if (whitelist_entry == NULL) return;
+    whitelist_entry_stats.used--;
     free(whitelist_entry);
 }
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = whitelist_entry_stats;
+}
 #endif
 
 
@@ -863,6 +1238,7 @@ void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
 #ifdef MAX_NR_SM_LOOKUP_ENTRIES
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
 static sm_lookup_entry_t sm_lookup_entry_storage[MAX_NR_SM_LOOKUP_ENTRIES];
+static uint32_t sm_lookup_entry_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_SM_LOOKUP_ENTRIES)];
 static btstack_memory_pool_t sm_lookup_entry_pool;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     void * buffer = btstack_memory_pool_get(&sm_lookup_entry_pool);
@@ -874,26 +1250,47 @@ sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
     btstack_memory_pool_free(&sm_lookup_entry_pool, sm_lookup_entry);
 }
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&sm_lookup_entry_pool, stats);
+}
 #else
+static uint32_t sm_lookup_entry_failed;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    sm_lookup_entry_failed++;
     return NULL;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) sm_lookup_entry;
 };
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = sm_lookup_entry_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t sm_lookup_entry_stats;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     void * buffer = malloc(sizeof(sm_lookup_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(sm_lookup_entry_t));
+        sm_lookup_entry_stats.used++;
+        if (sm_lookup_entry_stats.used > sm_lookup_entry_stats.max_used){
+            sm_lookup_entry_stats.max_used = sm_lookup_entry_stats.used;
+        }
+    } else {
+        sm_lookup_entry_stats.failed++;
     }
     return (sm_lookup_entry_t *) buffer;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    if (sm_lookup_entry == NULL) return;
+    sm_lookup_entry_stats.used--;
     free(sm_lookup_entry);
 }
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = sm_lookup_entry_stats;
+}
 #endif
 
 
@@ -912,6 +1309,7 @@ void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
 #ifdef MAX_NR_MESH_NETWORK_PDUS
 #if MAX_NR_MESH_NETWORK_PDUS > 0
 static mesh_network_pdu_t mesh_network_pdu_storage[MAX_NR_MESH_NETWORK_PDUS];
+static uint32_t mesh_network_pdu_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_NETWORK_PDUS)];
 static btstack_memory_pool_t mesh_network_pdu_pool;
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_network_pdu_pool);
@@ -923,26 +1321,47 @@ mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
     btstack_memory_pool_free(&mesh_network_pdu_pool, mesh_network_pdu);
 }
+void btstack_memory_mesh_network_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_network_pdu_pool, stats);
+}
 #else
+static uint32_t mesh_network_pdu_failed;
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    mesh_network_pdu_failed++;
     return NULL;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_network_pdu;
 };
+void btstack_memory_mesh_network_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_network_pdu_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_network_pdu_stats;
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_network_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_pdu_t));
+        mesh_network_pdu_stats.used++;
+        if (mesh_network_pdu_stats.used > mesh_network_pdu_stats.max_used){
+            mesh_network_pdu_stats.max_used = mesh_network_pdu_stats.used;
+        }
+    } else {
+        mesh_network_pdu_stats.failed++;
     }
     return (mesh_network_pdu_t *) buffer;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    if (mesh_network_pdu == NULL) return;
+    mesh_network_pdu_stats.used--;
     free(mesh_network_pdu);
 }
+void btstack_memory_mesh_network_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_network_pdu_stats;
+}
 #endif
 
 
@@ -958,6 +1377,7 @@ void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
 #ifdef MAX_NR_MESH_TRANSPORT_PDUS
 #if MAX_NR_MESH_TRANSPORT_PDUS > 0
 static mesh_transport_pdu_t mesh_transport_pdu_storage[MAX_NR_MESH_TRANSPORT_PDUS];
+static uint32_t mesh_transport_pdu_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_TRANSPORT_PDUS)];
 static btstack_memory_pool_t mesh_transport_pdu_pool;
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_transport_pdu_pool);
@@ -969,26 +1389,47 @@ mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
     btstack_memory_pool_free(&mesh_transport_pdu_pool, mesh_transport_pdu);
 }
+void btstack_memory_mesh_transport_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_transport_pdu_pool, stats);
+}
 #else
+static uint32_t mesh_transport_pdu_failed;
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
+    mesh_transport_pdu_failed++;
     return NULL;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_transport_pdu;
 };
+void btstack_memory_mesh_transport_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_transport_pdu_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_transport_pdu_stats;
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_transport_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_pdu_t));
+        mesh_transport_pdu_stats.used++;
+        if (mesh_transport_pdu_stats.used > mesh_transport_pdu_stats.max_used){
+            mesh_transport_pdu_stats.max_used = mesh_transport_pdu_stats.used;
+        }
+    } else {
+        mesh_transport_pdu_stats.failed++;
     }
     return (mesh_transport_pdu_t *) buffer;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    if (mesh_transport_pdu == NULL) return;
+    mesh_transport_pdu_stats.used--;
     free(mesh_transport_pdu);
 }
+void btstack_memory_mesh_transport_pdu_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_transport_pdu_stats;
+}
 #endif
 
 
@@ -1004,6 +1445,7 @@ void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport
 #ifdef MAX_NR_MESH_NETWORK_KEYS
 #if MAX_NR_MESH_NETWORK_KEYS > 0
 static mesh_network_key_t mesh_network_key_storage[MAX_NR_MESH_NETWORK_KEYS];
+static uint32_t mesh_network_key_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_NETWORK_KEYS)];
 static btstack_memory_pool_t mesh_network_key_pool;
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_network_key_pool);
@@ -1015,26 +1457,47 @@ mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
     btstack_memory_pool_free(&mesh_network_key_pool, mesh_network_key);
 }
+void btstack_memory_mesh_network_key_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_network_key_pool, stats);
+}
 #else
+static uint32_t mesh_network_key_failed;
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    mesh_network_key_failed++;
     return NULL;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_network_key;
 };
+void btstack_memory_mesh_network_key_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_network_key_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_network_key_stats;
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     void * buffer = malloc(sizeof(mesh_network_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_key_t));
+        mesh_network_key_stats.used++;
+        if (mesh_network_key_stats.used > mesh_network_key_stats.max_used){
+            mesh_network_key_stats.max_used = mesh_network_key_stats.used;
+        }
+    } else {
+        mesh_network_key_stats.failed++;
     }
     return (mesh_network_key_t *) buffer;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    if (mesh_network_key == NULL) return;
+    mesh_network_key_stats.used--;
     free(mesh_network_key);
 }
+void btstack_memory_mesh_network_key_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_network_key_stats;
+}
 #endif
 
 
@@ -1050,6 +1513,7 @@ void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
 #ifdef MAX_NR_MESH_TRANSPORT_KEYS
 #if MAX_NR_MESH_TRANSPORT_KEYS > 0
 static mesh_transport_key_t mesh_transport_key_storage[MAX_NR_MESH_TRANSPORT_KEYS];
+static uint32_t mesh_transport_key_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_TRANSPORT_KEYS)];
 static btstack_memory_pool_t mesh_transport_key_pool;
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_transport_key_pool);
@@ -1061,26 +1525,47 @@ mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
     btstack_memory_pool_free(&mesh_transport_key_pool, mesh_transport_key);
 }
+void btstack_memory_mesh_transport_key_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_transport_key_pool, stats);
+}
 #else
+static uint32_t mesh_transport_key_failed;
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    mesh_transport_key_failed++;
     return NULL;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_transport_key;
 };
+void btstack_memory_mesh_transport_key_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_transport_key_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_transport_key_stats;
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     void * buffer = malloc(sizeof(mesh_transport_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_key_t));
+        mesh_transport_key_stats.used++;
+        if (mesh_transport_key_stats.used > mesh_transport_key_stats.max_used){
+            mesh_transport_key_stats.max_used = mesh_transport_key_stats.used;
+        }
+    } else {
+        mesh_transport_key_stats.failed++;
     }
     return (mesh_transport_key_t *) buffer;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    if (mesh_transport_key == NULL) return;
+    mesh_transport_key_stats.used--;
     free(mesh_transport_key);
 }
+void btstack_memory_mesh_transport_key_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_transport_key_stats;
+}
 #endif
 
 
@@ -1096,6 +1581,7 @@ void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport
 #ifdef MAX_NR_MESH_VIRTUAL_ADDRESSS
 #if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
 static mesh_virtual_address_t mesh_virtual_address_storage[MAX_NR_MESH_VIRTUAL_ADDRESSS];
+static uint32_t mesh_virtual_address_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_VIRTUAL_ADDRESSS)];
 static btstack_memory_pool_t mesh_virtual_address_pool;
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_virtual_address_pool);
@@ -1107,26 +1593,47 @@ mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
     btstack_memory_pool_free(&mesh_virtual_address_pool, mesh_virtual_address);
 }
+void btstack_memory_mesh_virtual_address_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_virtual_address_pool, stats);
+}
 #else
+static uint32_t mesh_virtual_address_failed;
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    mesh_virtual_address_failed++;
     return NULL;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_virtual_address;
 };
+void btstack_memory_mesh_virtual_address_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_virtual_address_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_virtual_address_stats;
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     void * buffer = malloc(sizeof(mesh_virtual_address_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_virtual_address_t));
+        mesh_virtual_address_stats.used++;
+        if (mesh_virtual_address_stats.used > mesh_virtual_address_stats.max_used){
+            mesh_virtual_address_stats.max_used = mesh_virtual_address_stats.used;
+        }
+    } else {
+        mesh_virtual_address_stats.failed++;
     }
     return (mesh_virtual_address_t *) buffer;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    if (mesh_virtual_address == NULL) return;
+    mesh_virtual_address_stats.used--;
     free(mesh_virtual_address);
 }
+void btstack_memory_mesh_virtual_address_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_virtual_address_stats;
+}
 #endif
 
 
@@ -1142,6 +1649,7 @@ void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtu
 #ifdef MAX_NR_MESH_SUBNETS
 #if MAX_NR_MESH_SUBNETS > 0
 static mesh_subnet_t mesh_subnet_storage[MAX_NR_MESH_SUBNETS];
+static uint32_t mesh_subnet_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_NR_MESH_SUBNETS)];
 static btstack_memory_pool_t mesh_subnet_pool;
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     void * buffer = btstack_memory_pool_get(&mesh_subnet_pool);
@@ -1153,26 +1661,47 @@ mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
     btstack_memory_pool_free(&mesh_subnet_pool, mesh_subnet);
 }
+void btstack_memory_mesh_subnet_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&mesh_subnet_pool, stats);
+}
 #else
+static uint32_t mesh_subnet_failed;
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    mesh_subnet_failed++;
     return NULL;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
     // silence compiler warning about unused parameter in a portable way
     (void) mesh_subnet;
 };
+void btstack_memory_mesh_subnet_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = mesh_subnet_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t mesh_subnet_stats;
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     void * buffer = malloc(sizeof(mesh_subnet_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_subnet_t));
+        mesh_subnet_stats.used++;
+        if (mesh_subnet_stats.used > mesh_subnet_stats.max_used){
+            mesh_subnet_stats.max_used = mesh_subnet_stats.used;
+        }
+    } else {
+        mesh_subnet_stats.failed++;
     }
     return (mesh_subnet_t *) buffer;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    if (mesh_subnet == NULL) return;
+    mesh_subnet_stats.used--;
     free(mesh_subnet);
 }
+void btstack_memory_mesh_subnet_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = mesh_subnet_stats;
+}
 #endif
 
 
@@ -1180,81 +1709,140 @@ void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
 // init
 void btstack_memory_init(void){
 #if MAX_NR_HCI_CONNECTIONS > 0
-    btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t));
+    btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t), hci_connection_allocated);
 #endif
 #if MAX_NR_L2CAP_SERVICES > 0
-    btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t));
+    btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t), l2cap_service_allocated);
 #endif
 #if MAX_NR_L2CAP_CHANNELS > 0
-    btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t));
+    btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t), l2cap_channel_allocated);
 #endif
 #ifdef ENABLE_CLASSIC
 #if MAX_NR_RFCOMM_MULTIPLEXERS > 0
-    btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t));
+    btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t), rfcomm_multiplexer_allocated);
 #endif
 #if MAX_NR_RFCOMM_SERVICES > 0
-    btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t));
+    btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t), rfcomm_service_allocated);
 #endif
 #if MAX_NR_RFCOMM_CHANNELS > 0
-    btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t));
+    btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t), rfcomm_channel_allocated);
 #endif
 #if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
-    btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t));
+    btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t), btstack_link_key_db_memory_entry_allocated);
 #endif
 #if MAX_NR_BNEP_SERVICES > 0
-    btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t));
+    btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t), bnep_service_allocated);
 #endif
 #if MAX_NR_BNEP_CHANNELS > 0
-    btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t));
+    btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t), bnep_channel_allocated);
 #endif
 #if MAX_NR_HFP_CONNECTIONS > 0
-    btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t));
+    btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t), hfp_connection_allocated);
 #endif
 #if MAX_NR_SERVICE_RECORD_ITEMS > 0
-    btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t));
+    btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t), service_record_item_allocated);
 #endif
 #if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
-    btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t));
+    btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t), avdtp_stream_endpoint_allocated);
 #endif
 #if MAX_NR_AVDTP_CONNECTIONS > 0
-    btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t));
+    btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t), avdtp_connection_allocated);
 #endif
 #if MAX_NR_AVRCP_CONNECTIONS > 0
-    btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t));
+    btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t), avrcp_connection_allocated);
 #endif
 #if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
-    btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t));
+    btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t), avrcp_browsing_connection_allocated);
 #endif
 #endif
 #ifdef ENABLE_BLE
 #if MAX_NR_GATT_CLIENTS > 0
-    btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t));
+    btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t), gatt_client_allocated);
 #endif
 #if MAX_NR_WHITELIST_ENTRIES > 0
-    btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t));
+    btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t), whitelist_entry_allocated);
 #endif
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
-    btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t));
+    btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t), sm_lookup_entry_allocated);
 #endif
 #endif
 #ifdef ENABLE_MESH
 #if MAX_NR_MESH_NETWORK_PDUS > 0
-    btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t));
+    btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t), mesh_network_pdu_allocated);
 #endif
 #if MAX_NR_MESH_TRANSPORT_PDUS > 0
-    btstack_memory_pool_create(&mesh_transport_pdu_pool, mesh_transport_pdu_storage, MAX_NR_MESH_TRANSPORT_PDUS, sizeof(mesh_transport_pdu_t));
+    btstack_memory_pool_create(&mesh_transport_pdu_pool, mesh_transport_pdu_storage, MAX_NR_MESH_TRANSPORT_PDUS, sizeof(mesh_transport_pdu_t), mesh_transport_pdu_allocated);
 #endif
 #if MAX_NR_MESH_NETWORK_KEYS > 0
-    btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t));
+    btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t), mesh_network_key_allocated);
 #endif
 #if MAX_NR_MESH_TRANSPORT_KEYS > 0
-    btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t));
+    btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t), mesh_transport_key_allocated);
 #endif
 #if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
-    btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t));
+    btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t), mesh_virtual_address_allocated);
 #endif
 #if MAX_NR_MESH_SUBNETS > 0
-    btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t));
+    btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t), mesh_subnet_allocated);
+#endif
+#endif
+}
+
+// statistics
+void btstack_memory_log_stats(void){
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_hci_connection_get_stats(&stats);
+    log_info("hci_connection: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_l2cap_service_get_stats(&stats);
+    log_info("l2cap_service: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_l2cap_channel_get_stats(&stats);
+    log_info("l2cap_channel: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+#ifdef ENABLE_CLASSIC
+    btstack_memory_rfcomm_multiplexer_get_stats(&stats);
+    log_info("rfcomm_multiplexer: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_rfcomm_service_get_stats(&stats);
+    log_info("rfcomm_service: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_rfcomm_channel_get_stats(&stats);
+    log_info("rfcomm_channel: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_btstack_link_key_db_memory_entry_get_stats(&stats);
+    log_info("btstack_link_key_db_memory_entry: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_bnep_service_get_stats(&stats);
+    log_info("bnep_service: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_bnep_channel_get_stats(&stats);
+    log_info("bnep_channel: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_hfp_connection_get_stats(&stats);
+    log_info("hfp_connection: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_service_record_item_get_stats(&stats);
+    log_info("service_record_item: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_avdtp_stream_endpoint_get_stats(&stats);
+    log_info("avdtp_stream_endpoint: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_avdtp_connection_get_stats(&stats);
+    log_info("avdtp_connection: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_avrcp_connection_get_stats(&stats);
+    log_info("avrcp_connection: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_avrcp_browsing_connection_get_stats(&stats);
+    log_info("avrcp_browsing_connection: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
 #endif
+#ifdef ENABLE_BLE
+    btstack_memory_gatt_client_get_stats(&stats);
+    log_info("gatt_client: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_whitelist_entry_get_stats(&stats);
+    log_info("whitelist_entry: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_sm_lookup_entry_get_stats(&stats);
+    log_info("sm_lookup_entry: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+#endif
+#ifdef ENABLE_MESH
+    btstack_memory_mesh_network_pdu_get_stats(&stats);
+    log_info("mesh_network_pdu: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_mesh_transport_pdu_get_stats(&stats);
+    log_info("mesh_transport_pdu: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_mesh_network_key_get_stats(&stats);
+    log_info("mesh_network_key: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_mesh_transport_key_get_stats(&stats);
+    log_info("mesh_transport_key: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_mesh_virtual_address_get_stats(&stats);
+    log_info("mesh_virtual_address: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
+    btstack_memory_mesh_subnet_get_stats(&stats);
+    log_info("mesh_subnet: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);
 #endif
 }
@@ -42,58 +42,87 @@
  *
  *  Fixed-size block allocation
  *
- *  Free blocks are kept in singly linked list
+ *  Free blocks are kept in singly linked list, blocks in use are marked in a
+ *  bitmap to check blocks returned in constant time
  *
  */
 
 #include "btstack_memory_pool.h"
 
 #include <stddef.h>
+#include <string.h>
 #include "btstack_debug.h"
 
 typedef struct node {
     struct node * next;
 } node_t;
 
-void btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size){
-    node_t *free_blocks = (node_t*) pool;
+void btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size, uint32_t * allocated){
     char   *mem_ptr = (char *) storage;
     int i;
-    
+
+    pool->storage    = (char *) storage;
+    pool->allocated  = allocated;
+    pool->block_size = (uint16_t) block_size;
+    memset(&pool->stats, 0, sizeof(btstack_memory_pool_stats_t));
+    pool->stats.count = (uint16_t) count;
+    memset(allocated, 0, BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) * sizeof(uint32_t));
+
     // create singly linked list of all available blocks
-    free_blocks->next = NULL;
+    pool->free_blocks = NULL;
     for (i = 0 ; i < count ; i++){
-        btstack_memory_pool_free(pool, mem_ptr);
+        node_t *node      = (node_t *) mem_ptr;
+        node->next        = (node_t *) pool->free_blocks;
+        pool->free_blocks = node;
         mem_ptr += block_size;
     }
 }
 
 void * btstack_memory_pool_get(btstack_memory_pool_t *pool){
-    node_t *free_blocks = (node_t*) pool;
-    
-    if (!free_blocks->next) return NULL;
+    node_t *node = (node_t *) pool->free_blocks;
+
+    if (!node) {
+        pool->stats.failed++;
+        return NULL;
+    }
     
     // remove first
-    node_t *node      = free_blocks->next;
-    free_blocks->next = node->next;
+    pool->free_blocks = node->next;
+
+    // mark as allocated
+    uint32_t index = (uint32_t) ((char *) node - pool->storage) / pool->block_size;
+    pool->allocated[index >> 5] |= 1u << (index & 0x1f);
+    pool->stats.used++;
+    if (pool->stats.used > pool->stats.max_used){
+        pool->stats.max_used = pool->stats.used;
+    }
     
     return (void*) node;
 }
 
 void btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block){
-    node_t *free_blocks = (node_t*) pool;
-    node_t *node        = (node_t*) block;
+    node_t *node = (node_t*) block;
 
-    // raise error and abort if node already in list
-    node_t * it;
-    for (it = free_blocks->next; it != NULL; it = it->next){
-        if (it == node) {
-            log_error("btstack_memory_pool_free: block %p freed twice for pool %p", block, pool);
-            return;
-        }
+    // raise error and abort if block not from pool or not allocated
+    uint32_t offset = (uint32_t) ((char *) block - pool->storage);
+    uint32_t index  = offset / pool->block_size;
+    if (((char *) block < pool->storage) || (index >= pool->stats.count) || ((offset % pool->block_size) != 0)){
+        log_error("btstack_memory_pool_free: block %p not from pool %p", block, pool);
+        return;
+    }
+    uint32_t mask = 1u << (index & 0x1f);
+    if ((pool->allocated[index >> 5] & mask) == 0){
+        log_error("btstack_memory_pool_free: block %p freed twice for pool %p", block, pool);
+        return;
     }
+    pool->allocated[index >> 5] &= ~mask;
+    pool->stats.used--;
 
     // add block as node to list
-    node->next          = free_blocks->next;
-    free_blocks->next   = node;
+    node->next        = (node_t *) pool->free_blocks;
+    pool->free_blocks = node;
+}
+
+void btstack_memory_pool_get_stats(btstack_memory_pool_t *pool, btstack_memory_pool_stats_t * stats){
+    *stats = pool->stats;
 }
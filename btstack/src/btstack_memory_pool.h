@@ -42,21 +42,41 @@
  *
  *  @Assumption block_size >= sizeof(void *)
  *  @Assumption size of storage >= count * block_size
+ *  @Assumption size of allocated >= BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) words
  *
- *  @Note minimal implementation, no error checking/handling
+ *  @Note blocks in use are tracked in a bitmap, freeing a block twice or a
+ *        block that is not from the pool is logged and ignored
  */
 
 #ifndef btstack_memory_pool_H
 #define btstack_memory_pool_H
 
+#include <stdint.h>
+
 #if defined __cplusplus
 extern "C" {
 #endif
 
-typedef void * btstack_memory_pool_t;
+// words of the allocation bitmap for a pool of count blocks
+#define BTSTACK_MEMORY_POOL_BITMAP_SIZE(count) (((count) + 31) / 32)
+
+typedef struct {
+    uint16_t count;         // blocks in pool, 0 if allocated with malloc
+    uint16_t used;          // blocks in use
+    uint16_t max_used;      // high-water mark of used
+    uint32_t failed;        // allocations that found no free block
+} btstack_memory_pool_stats_t;
 
-// initialize memory pool with with given storage, block size and count
-void   btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size);
+typedef struct {
+    void     * free_blocks; // singly linked list of free blocks
+    char     * storage;
+    uint32_t * allocated;   // one bit per block, set while in use
+    uint16_t   block_size;
+    btstack_memory_pool_stats_t stats;
+} btstack_memory_pool_t;
+
+// initialize memory pool with with given storage, block size and count, and allocation bitmap
+void   btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size, uint32_t * allocated);
 
 // get free block from pool, @returns NULL or pointer to block
 void * btstack_memory_pool_get(btstack_memory_pool_t *pool);
@@ -64,6 +84,9 @@ void * btstack_memory_pool_get(btstack_memory_pool_t *pool);
 // return previously reserved block to memory pool
 void   btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block);
 
+// get usage statistics of memory pool
+void   btstack_memory_pool_get_stats(btstack_memory_pool_t *pool, btstack_memory_pool_stats_t * stats);
+
 #if defined __cplusplus
 }
 #endif
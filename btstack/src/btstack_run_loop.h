@@ -92,6 +92,12 @@ typedef struct btstack_timer_source {
     // will be called when timer fired
     void  (*process)(struct btstack_timer_source *ts); 
     void * context;
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    // timer heap of btstack_run_loop_base, item.next links the siblings
+    struct btstack_timer_source * heap_child;
+    struct btstack_timer_source * heap_prev;    // previous sibling, or parent of a first child
+    uint32_t heap_order;                        // add order, breaks ties between equal timeouts
+#endif
 } btstack_timer_source_t;
 
 typedef struct btstack_run_loop {
@@ -53,9 +53,17 @@
 btstack_linked_list_t btstack_run_loop_base_timers;
 btstack_linked_list_t btstack_run_loop_base_data_sources;
 
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+// add order of the next timer, breaks ties between equal timeouts
+static uint32_t btstack_run_loop_base_timer_order;
+#endif
+
 void btstack_run_loop_base_init(void){
     btstack_run_loop_base_timers = NULL;
     btstack_run_loop_base_data_sources = NULL;    
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    btstack_run_loop_base_timer_order = 0;
+#endif
 }
 
 void btstack_run_loop_base_add_data_source(btstack_data_source_t *ds){
@@ -74,6 +82,151 @@ void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t *
     ds->flags &= ~callback_types;
 }
 
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+
+/*
+ * Timers in a pairing heap: btstack_run_loop_base_timers is the root, the timer that fires first.
+ * Each timer links to its first child (heap_child), its next sibling (item.next) and its previous
+ * sibling or, for a first child, its parent (heap_prev). Add is O(1), remove and process are
+ * O(log n) amortized, instead of O(n) walks of a sorted list.
+ *
+ * Timeouts are compared with btstack_time_delta as in the list, timers with the same timeout fire
+ * in the order they were added.
+ */
+
+static inline btstack_timer_source_t * btstack_run_loop_base_timer_root(void){
+    return (btstack_timer_source_t *) btstack_run_loop_base_timers;
+}
+
+static inline btstack_timer_source_t * btstack_run_loop_base_timer_next(btstack_timer_source_t * ts){
+    return (btstack_timer_source_t *) ts->item.next;
+}
+
+static bool btstack_run_loop_base_timer_before(btstack_timer_source_t * a, btstack_timer_source_t * b){
+    int32_t delta = btstack_time_delta(a->timeout, b->timeout);
+    if (delta != 0) return delta < 0;
+    return (int32_t)(a->heap_order - b->heap_order) < 0;
+}
+
+static bool btstack_run_loop_base_timer_in_heap(btstack_timer_source_t * ts){
+    if (ts == btstack_run_loop_base_timer_root()) return true;
+    btstack_timer_source_t * prev = ts->heap_prev;
+    if (prev == NULL) return false;
+    return (prev->heap_child == ts) || (btstack_run_loop_base_timer_next(prev) == ts);
+}
+
+// merge two heaps whose roots have no siblings
+static btstack_timer_source_t * btstack_run_loop_base_timer_meld(btstack_timer_source_t * a, btstack_timer_source_t * b){
+    if (btstack_run_loop_base_timer_before(b, a)){
+        btstack_timer_source_t * tmp = a;
+        a = b;
+        b = tmp;
+    }
+    b->item.next = (btstack_linked_item_t *) a->heap_child;
+    if (a->heap_child != NULL){
+        a->heap_child->heap_prev = b;
+    }
+    b->heap_prev = a;
+    a->heap_child = b;
+    return a;
+}
+
+// merge a list of siblings into one heap: meld them pairwise left to right, then the pairs right to left
+static btstack_timer_source_t * btstack_run_loop_base_timer_merge_pairs(btstack_timer_source_t * first){
+    btstack_timer_source_t * pairs = NULL;
+    while (first != NULL){
+        btstack_timer_source_t * a = first;
+        btstack_timer_source_t * b = btstack_run_loop_base_timer_next(a);
+        first = (b != NULL) ? btstack_run_loop_base_timer_next(b) : NULL;
+        a->item.next = NULL;
+        a->heap_prev = NULL;
+        if (b != NULL){
+            b->item.next = NULL;
+            b->heap_prev = NULL;
+            a = btstack_run_loop_base_timer_meld(a, b);
+        }
+        // stack of pairs, last one on top
+        a->item.next = (btstack_linked_item_t *) pairs;
+        pairs = a;
+    }
+    btstack_timer_source_t * root = NULL;
+    while (pairs != NULL){
+        btstack_timer_source_t * pair = pairs;
+        pairs = btstack_run_loop_base_timer_next(pair);
+        pair->item.next = NULL;
+        root = (root != NULL) ? btstack_run_loop_base_timer_meld(root, pair) : pair;
+    }
+    return root;
+}
+
+bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
+    if (!btstack_run_loop_base_timer_in_heap(ts)) return false;
+    btstack_timer_source_t * children = btstack_run_loop_base_timer_merge_pairs(ts->heap_child);
+    if (ts == btstack_run_loop_base_timer_root()){
+        btstack_run_loop_base_timers = (btstack_linked_item_t *) children;
+    } else {
+        // unlink from siblings/parent, then merge its children back
+        btstack_timer_source_t * next = btstack_run_loop_base_timer_next(ts);
+        if (ts->heap_prev->heap_child == ts){
+            ts->heap_prev->heap_child = next;
+        } else {
+            ts->heap_prev->item.next = (btstack_linked_item_t *) next;
+        }
+        if (next != NULL){
+            next->heap_prev = ts->heap_prev;
+        }
+        if (children != NULL){
+            btstack_run_loop_base_timers = (btstack_linked_item_t *) btstack_run_loop_base_timer_meld(btstack_run_loop_base_timer_root(), children);
+        }
+    }
+    ts->item.next  = NULL;
+    ts->heap_child = NULL;
+    ts->heap_prev  = NULL;
+    return true;
+}
+
+void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
+    // don't add timer that's already in there
+    if (btstack_run_loop_base_timer_in_heap(ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
+    }
+    ts->item.next  = NULL;
+    ts->heap_child = NULL;
+    ts->heap_prev  = NULL;
+    ts->heap_order = btstack_run_loop_base_timer_order++;
+    if (btstack_run_loop_base_timers == NULL){
+        btstack_run_loop_base_timers = (btstack_linked_item_t *) ts;
+    } else {
+        btstack_run_loop_base_timers = (btstack_linked_item_t *) btstack_run_loop_base_timer_meld(btstack_run_loop_base_timer_root(), ts);
+    }
+}
+
+void btstack_run_loop_base_dump_timer(void){
+#ifdef ENABLE_LOG_INFO
+    // pre-order walk, going up through the first sibling to the parent
+    btstack_timer_source_t * ts = btstack_run_loop_base_timer_root();
+    int i = 0;
+    while (ts != NULL){
+        log_info("timer %u (%p): timeout %u\n", i++, ts, (unsigned int) ts->timeout);
+        if (ts->heap_child != NULL){
+            ts = ts->heap_child;
+            continue;
+        }
+        while ((ts != NULL) && (ts->item.next == NULL)){
+            while ((ts->heap_prev != NULL) && (ts->heap_prev->heap_child != ts)){
+                ts = ts->heap_prev;
+            }
+            ts = ts->heap_prev;
+        }
+        if (ts != NULL){
+            ts = btstack_run_loop_base_timer_next(ts);
+        }
+    }
+#endif
+}
+
+#else
 
 bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
     return btstack_linked_list_remove(&btstack_run_loop_base_timers, (btstack_linked_item_t *) ts);
@@ -96,6 +249,19 @@ void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
     it->next = (btstack_linked_item_t *) ts;
 }
 
+void btstack_run_loop_base_dump_timer(void){
+#ifdef ENABLE_LOG_INFO
+    btstack_linked_item_t *it;
+    int i = 0;
+    for (it = (btstack_linked_item_t *) btstack_run_loop_base_timers; it ; it = it->next){
+        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
+        log_info("timer %u (%p): timeout %u\n", i++, ts, (unsigned int) ts->timeout);
+    }
+#endif
+}
+
+#endif
+
 void  btstack_run_loop_base_process_timers(uint32_t now){
     // process timers, exit when timeout is in the future
     while (btstack_run_loop_base_timers) {
@@ -55,6 +55,7 @@ extern "C" {
 #endif
 
 // private data (access only by run loop implementations)
+// timers: sorted list, or root of the timer heap with ENABLE_RUN_LOOP_TIMER_HEAP (first timer to fire in both cases)
 extern btstack_linked_list_t btstack_run_loop_base_timers;
 extern btstack_linked_list_t btstack_run_loop_base_data_sources;
 	
@@ -76,6 +77,11 @@ void btstack_run_loop_base_add_timer(btstack_timer_source_t * timer);
  */
 bool  btstack_run_loop_base_remove_timer(btstack_timer_source_t * timer);
 
+/**
+ * @brief Log all timers
+ */
+void btstack_run_loop_base_dump_timer(void);
+
 /**
  * @brief Process timers: remove expired timers from list and call their process function
  * @param now
@@ -0,0 +1,90 @@
+
+// *****************************************************************************
+//
+// HID Parser Benchmark - reports/s decoded by the parser and by a compiled layout
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_hid_parser.h"
+
+#define NUM_REPORTS 1000000
+
+// from USB HID Specification 1.1, Appendix B.1, plus a mouse on report ID 1 and a keyboard on report ID 2
+static const uint8_t combo_descriptor_with_report_ids[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xA0, 0x05, 0x09, 0x19, 0x01, 0x29,
+    0x03, 0x14, 0x25, 0x01, 0x75, 0x01, 0x95, 0x03, 0x81, 0x02, 0x75, 0x05, 0x95, 0x01, 0x81, 0x01,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+    0xC0, 0xC0,
+    0xA1, 0x01, 0x85, 0x02, 0x75, 0x01, 0x95, 0x08, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+    0x25, 0x01, 0x81, 0x02, 0x75, 0x01, 0x95, 0x08, 0x81, 0x03, 0x95, 0x05, 0x75, 0x01, 0x05, 0x08,
+    0x19, 0x01, 0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x03, 0x95, 0x06, 0x75, 0x08,
+    0x15, 0x00, 0x25, 0xFF, 0x05, 0x07, 0x19, 0x00, 0x29, 0xFF, 0x81, 0x00, 0xC0,
+};
+
+static const uint8_t mouse_report[]    = { 0x01, 0x03, 0x02, 0x03 };
+static const uint8_t keyboard_report[] = { 0x02, 0x01, 0x00, 0x04, 0x05, 0x06, 0x00, 0x00, 0x00 };
+
+static volatile int32_t sink;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double benchmark_parser(const uint8_t * report, uint16_t report_len){
+    btstack_hid_parser_t parser;
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t  value;
+    int i;
+    double start = now_s();
+    for (i=0;i<NUM_REPORTS;i++){
+        btstack_hid_parser_init(&parser, combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), HID_REPORT_TYPE_INPUT, report, report_len);
+        while (btstack_hid_parser_has_more(&parser)){
+            btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
+            sink += value;
+        }
+    }
+    return NUM_REPORTS / (now_s() - start);
+}
+
+static double benchmark_layout(const btstack_hid_report_layout_t * layout, const uint8_t * report, uint16_t report_len){
+    btstack_hid_report_field_t fields[MAX_NR_HID_REPORT_LAYOUT_FIELDS];
+    int num_fields;
+    int i, j;
+    double start = now_s();
+    for (i=0;i<NUM_REPORTS;i++){
+        num_fields = btstack_hid_report_layout_extract(layout, report, report_len, fields, MAX_NR_HID_REPORT_LAYOUT_FIELDS);
+        for (j=0;j<num_fields;j++){
+            sink += fields[j].value;
+        }
+    }
+    return NUM_REPORTS / (now_s() - start);
+}
+
+static void benchmark(const char * name, const btstack_hid_report_layout_t * layout, const uint8_t * report, uint16_t report_len){
+    double parser_rate = benchmark_parser(report, report_len);
+    double layout_rate = benchmark_layout(layout, report, report_len);
+    printf("%-10s parser %10.0f reports/s, layout %10.0f reports/s, speedup %.1fx\n", name, parser_rate, layout_rate, layout_rate / parser_rate);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    static btstack_hid_report_layout_t layout;
+    if (btstack_hid_report_layout_compile(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), &layout)){
+        printf("Compiling report layout failed\n");
+        return EXIT_FAILURE;
+    }
+    benchmark("mouse", &layout, mouse_report, sizeof(mouse_report));
+    benchmark("keyboard", &layout, keyboard_report, sizeof(keyboard_report));
+    return EXIT_SUCCESS;
+}
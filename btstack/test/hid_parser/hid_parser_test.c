@@ -343,6 +343,67 @@ TEST(HID, GetReportSize){
     CHECK_EQUAL(8, report_size);
 }
 
+// compiled layout must yield the same fields as the parser
+static void expect_layout_equivalent(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, const uint8_t * hid_report, uint16_t hid_report_len){
+    static btstack_hid_parser_t hid_parser;
+    static btstack_hid_report_layout_t layout;
+    btstack_hid_report_field_t fields[MAX_NR_HID_REPORT_LAYOUT_FIELDS];
+    CHECK_EQUAL(0, btstack_hid_report_layout_compile(hid_descriptor, hid_descriptor_len, &layout));
+    int num_fields = btstack_hid_report_layout_extract(&layout, hid_report, hid_report_len, fields, MAX_NR_HID_REPORT_LAYOUT_FIELDS);
+    btstack_hid_parser_init(&hid_parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, hid_report, hid_report_len);
+    int i;
+    for (i=0;i<num_fields;i++){
+        expect_field(&hid_parser, fields[i].usage_page, fields[i].usage, fields[i].value);
+    }
+    CHECK_EQUAL(0, btstack_hid_parser_has_more(&hid_parser));
+}
+
+TEST(HID, LayoutMouseWithoutReportID){
+    expect_layout_equivalent(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_positive_xy, sizeof(mouse_report_without_id_positive_xy));
+    expect_layout_equivalent(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy));
+}
+
+TEST(HID, LayoutMouseWithReportID){
+    expect_layout_equivalent(mouse_descriptor_with_report_id, sizeof(mouse_descriptor_with_report_id), mouse_report_with_id_1, sizeof(mouse_report_with_id_1));
+}
+
+TEST(HID, LayoutBootKeyboard){
+    expect_layout_equivalent(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), keyboard_report1, sizeof(keyboard_report1));
+}
+
+TEST(HID, LayoutCombo){
+    expect_layout_equivalent(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report1, sizeof(combo_report1));
+    expect_layout_equivalent(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report2, sizeof(combo_report2));
+}
+
+TEST(HID, LayoutCompile){
+    static btstack_hid_report_layout_t layout;
+    CHECK_EQUAL(0, btstack_hid_report_layout_compile(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), &layout));
+    CHECK_EQUAL(1, layout.report_ids_declared);
+    CHECK_EQUAL(2, layout.num_reports);
+    CHECK_EQUAL(1, layout.reports[0].report_id);
+    CHECK_EQUAL(5, layout.reports[0].num_fields);
+    CHECK_EQUAL(4, layout.reports[0].report_len);
+    CHECK_EQUAL(2, layout.reports[1].report_id);
+    CHECK_EQUAL(14, layout.reports[1].num_fields);
+    CHECK_EQUAL(9, layout.reports[1].report_len);
+
+    // mouse X: after report ID, 3 buttons and 5 bits padding
+    const btstack_hid_report_field_layout_t * field = &layout.fields[layout.reports[0].first_field + 3];
+    CHECK_EQUAL(1, field->usage_page);
+    CHECK_EQUAL(0x30, field->usage);
+    CHECK_EQUAL(16, field->bit_offset);
+    CHECK_EQUAL(8, field->bit_size);
+    CHECK_EQUAL(-127, field->logical_minimum);
+    CHECK_EQUAL(127, field->logical_maximum);
+    CHECK_EQUAL(BTSTACK_HID_REPORT_FIELD_VARIABLE | BTSTACK_HID_REPORT_FIELD_SIGNED, field->flags);
+
+    // unknown report ID
+    const uint8_t report_unknown_id[] = { 0x03, 0x00 };
+    btstack_hid_report_field_t fields[MAX_NR_HID_REPORT_LAYOUT_FIELDS];
+    CHECK_EQUAL(-1, btstack_hid_report_layout_extract(&layout, report_unknown_id, sizeof(report_unknown_id), fields, MAX_NR_HID_REPORT_LAYOUT_FIELDS));
+    POINTERS_EQUAL(NULL, btstack_hid_report_layout_find(&layout, report_unknown_id, sizeof(report_unknown_id)));
+}
 
 int main (int argc, const char * argv[]){
     // hci_dump_open("hci_dump.pklg", HCI_DUMP_PACKETLOGGER);
@@ -0,0 +1,77 @@
+// *****************************************************************************
+//
+// Memory Pool Benchmark - blocks/s freed with the allocation bitmap check, and
+// with a walk over the free list as it was done before
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_memory_pool.h"
+
+#define MAX_BLOCKS 4096
+#define NUM_FREES  1000000
+
+typedef struct {
+    void *  next;
+    uint8_t data[28];
+} block_t;
+
+static block_t storage[MAX_BLOCKS];
+static uint32_t allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(MAX_BLOCKS)];
+static void * blocks[MAX_BLOCKS];
+static volatile int sink;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// double free check of the free list version
+static int in_free_list(btstack_memory_pool_t * pool, void * block){
+    void ** it;
+    for (it = (void **) pool->free_blocks; it != NULL; it = (void **) *it){
+        if ((void *) it == block) return 1;
+    }
+    return 0;
+}
+
+// free and get back one block at a time of a pool with half of its blocks in use
+static double benchmark(int count, int list_walk){
+    btstack_memory_pool_t pool;
+    int i;
+    btstack_memory_pool_create(&pool, storage, count, sizeof(block_t), allocated);
+    for (i=0;i<count/2;i++){
+        blocks[i] = btstack_memory_pool_get(&pool);
+    }
+    double start = now_s();
+    for (i=0;i<NUM_FREES;i++){
+        int index = i % (count / 2);
+        if (list_walk){
+            sink += in_free_list(&pool, blocks[index]);
+        }
+        btstack_memory_pool_free(&pool, blocks[index]);
+        blocks[index] = btstack_memory_pool_get(&pool);
+    }
+    return NUM_FREES / (now_s() - start);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    static const int counts[] = { 16, 256, MAX_BLOCKS };
+    unsigned int i;
+    for (i=0;i<sizeof(counts)/sizeof(counts[0]);i++){
+        double list_rate   = benchmark(counts[i], 1);
+        double bitmap_rate = benchmark(counts[i], 0);
+        printf("%4u blocks: free list walk %10.0f frees/s, bitmap %10.0f frees/s, speedup %.1fx\n",
+               counts[i], list_rate, bitmap_rate, bitmap_rate / list_rate);
+    }
+    return EXIT_SUCCESS;
+}
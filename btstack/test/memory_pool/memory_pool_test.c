@@ -0,0 +1,129 @@
+// *****************************************************************************
+//
+// Memory Pool Test
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory_pool.h"
+
+#define NUM_BLOCKS 40
+
+typedef struct {
+    void *  next;
+    uint8_t data[20];
+} block_t;
+
+static block_t storage[NUM_BLOCKS];
+static uint32_t allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(NUM_BLOCKS)];
+static btstack_memory_pool_t pool;
+
+TEST_GROUP(MemoryPool){
+    void setup(void){
+        btstack_memory_pool_create(&pool, storage, NUM_BLOCKS, sizeof(block_t), allocated);
+    }
+};
+
+TEST(MemoryPool, GetAll){
+    bool seen[NUM_BLOCKS];
+    int i;
+    memset(seen, 0, sizeof(seen));
+    for (i=0;i<NUM_BLOCKS;i++){
+        block_t * block = (block_t *) btstack_memory_pool_get(&pool);
+        CHECK(block != NULL);
+        int index = (int) (block - storage);
+        CHECK(index >= 0 && index < NUM_BLOCKS);
+        CHECK_FALSE(seen[index]);
+        seen[index] = true;
+    }
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(NUM_BLOCKS, stats.count);
+    CHECK_EQUAL(NUM_BLOCKS, stats.used);
+    CHECK_EQUAL(NUM_BLOCKS, stats.max_used);
+    CHECK_EQUAL(2, stats.failed);
+}
+
+TEST(MemoryPool, FreeAndReuse){
+    void * a = btstack_memory_pool_get(&pool);
+    void * b = btstack_memory_pool_get(&pool);
+    btstack_memory_pool_free(&pool, a);
+    POINTERS_EQUAL(a, btstack_memory_pool_get(&pool));
+    btstack_memory_pool_free(&pool, b);
+    btstack_memory_pool_free(&pool, a);
+
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(0, stats.used);
+    CHECK_EQUAL(2, stats.max_used);
+    CHECK_EQUAL(0, stats.failed);
+}
+
+TEST(MemoryPool, FreeTwice){
+    void * blocks[NUM_BLOCKS];
+    int i;
+    for (i=0;i<NUM_BLOCKS;i++){
+        blocks[i] = btstack_memory_pool_get(&pool);
+    }
+    // blocks in the second bitmap word too
+    btstack_memory_pool_free(&pool, blocks[3]);
+    btstack_memory_pool_free(&pool, blocks[3]);
+    btstack_memory_pool_free(&pool, blocks[35]);
+    btstack_memory_pool_free(&pool, blocks[35]);
+
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(NUM_BLOCKS - 2, stats.used);
+
+    // each block only once in the free list
+    CHECK(btstack_memory_pool_get(&pool) != NULL);
+    CHECK(btstack_memory_pool_get(&pool) != NULL);
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+}
+
+TEST(MemoryPool, FreeNotFromPool){
+    block_t other;
+    void * block = btstack_memory_pool_get(&pool);
+    btstack_memory_pool_free(&pool, &other);
+    btstack_memory_pool_free(&pool, &storage[NUM_BLOCKS]);
+    btstack_memory_pool_free(&pool, ((uint8_t *) block) + 4);
+
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(1, stats.used);
+    btstack_memory_pool_free(&pool, block);
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(0, stats.used);
+}
+
+TEST(MemoryPool, Create){
+    int i;
+    for (i=0;i<10;i++){
+        btstack_memory_pool_get(&pool);
+    }
+    // create again resets blocks and statistics
+    btstack_memory_pool_create(&pool, storage, NUM_BLOCKS, sizeof(block_t), allocated);
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(0, stats.used);
+    CHECK_EQUAL(0, stats.max_used);
+    for (i=0;i<NUM_BLOCKS;i++){
+        CHECK(btstack_memory_pool_get(&pool) != NULL);
+    }
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
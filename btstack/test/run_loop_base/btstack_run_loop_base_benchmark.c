@@ -0,0 +1,87 @@
+// *****************************************************************************
+//
+// Run Loop Base Benchmark - timer add/remove/process with 10k timers, for the
+// sorted list or the timer heap (ENABLE_RUN_LOOP_TIMER_HEAP)
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_run_loop_base.h"
+
+#define NUM_TIMERS  10000
+#define MAX_TIMEOUT 60000
+
+static btstack_timer_source_t timers[NUM_TIMERS];
+static uint32_t random_state = 1;
+static int num_fired;
+static int num_rearm;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t random_next(void){
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+// re-armed once, like a protocol timer restarted from its handler
+static void timer_handler(btstack_timer_source_t * ts){
+    num_fired++;
+    if (num_rearm == 0) return;
+    num_rearm--;
+    ts->timeout += 1 + random_next() % MAX_TIMEOUT;
+    btstack_run_loop_base_add_timer(ts);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    int i;
+    double start, add, remove, process;
+
+    btstack_run_loop_base_init();
+    memset(timers, 0, sizeof(timers));
+
+    start = now_s();
+    for (i=0;i<NUM_TIMERS;i++){
+        timers[i].timeout = random_next() % MAX_TIMEOUT;
+        timers[i].process = &timer_handler;
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    add = now_s() - start;
+
+    start = now_s();
+    for (i=0;i<NUM_TIMERS;i+=2){
+        btstack_run_loop_base_remove_timer(&timers[i]);
+    }
+    remove = now_s() - start;
+
+    // half of the timers left, each re-armed once
+    num_rearm = NUM_TIMERS / 2;
+    start = now_s();
+    btstack_run_loop_base_process_timers(2 * MAX_TIMEOUT);
+    process = now_s() - start;
+    if (num_fired != NUM_TIMERS){
+        printf("Fired %u timers instead of %u\n", num_fired, NUM_TIMERS);
+        return EXIT_FAILURE;
+    }
+
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    printf("timer heap, %u timers\n", NUM_TIMERS);
+#else
+    printf("timer list, %u timers\n", NUM_TIMERS);
+#endif
+    printf("add     %12.0f timers/s\n", NUM_TIMERS / add);
+    printf("remove  %12.0f timers/s\n", (NUM_TIMERS / 2) / remove);
+    printf("process %12.0f timers/s (re-armed once each)\n", NUM_TIMERS / process);
+    return EXIT_SUCCESS;
+}
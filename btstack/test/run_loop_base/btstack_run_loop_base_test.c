@@ -0,0 +1,220 @@
+// *****************************************************************************
+//
+// Run Loop Base Test - timers of btstack_run_loop_base, as sorted list or as
+// heap with ENABLE_RUN_LOOP_TIMER_HEAP
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+
+#define NUM_TIMERS 200
+
+static btstack_timer_source_t timers[NUM_TIMERS];
+static btstack_timer_source_t * fired[2 * NUM_TIMERS];
+static int num_fired;
+static uint32_t rearm_ms;
+static int rearm_count;
+
+static void timer_handler(btstack_timer_source_t * ts){
+    fired[num_fired++] = ts;
+}
+
+static void timer_rearm_handler(btstack_timer_source_t * ts){
+    fired[num_fired++] = ts;
+    if (rearm_count == 0) return;
+    rearm_count--;
+    ts->timeout += rearm_ms;
+    btstack_run_loop_base_add_timer(ts);
+}
+
+static void timer_setup(btstack_timer_source_t * ts, uint32_t timeout){
+    memset(ts, 0, sizeof(btstack_timer_source_t));
+    ts->timeout = timeout;
+    ts->process = &timer_handler;
+}
+
+static uint32_t random_state;
+
+static uint32_t random_next(void){
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+TEST_GROUP(RunLoopBaseTimers){
+    void setup(void){
+        btstack_run_loop_base_init();
+        memset(fired, 0, sizeof(fired));
+        num_fired = 0;
+        rearm_ms = 0;
+        rearm_count = 0;
+        random_state = 1;
+    }
+};
+
+TEST(RunLoopBaseTimers, Empty){
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(0));
+    btstack_run_loop_base_process_timers(1000);
+    CHECK_EQUAL(0, num_fired);
+}
+
+TEST(RunLoopBaseTimers, Order){
+    timer_setup(&timers[0], 30);
+    timer_setup(&timers[1], 10);
+    timer_setup(&timers[2], 20);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    btstack_run_loop_base_add_timer(&timers[2]);
+    CHECK_EQUAL(5, btstack_run_loop_base_get_time_until_timeout(5));
+    CHECK_EQUAL(0, btstack_run_loop_base_get_time_until_timeout(15));
+
+    btstack_run_loop_base_process_timers(20);
+    CHECK_EQUAL(2, num_fired);
+    POINTERS_EQUAL(&timers[1], fired[0]);
+    POINTERS_EQUAL(&timers[2], fired[1]);
+    CHECK_EQUAL(10, btstack_run_loop_base_get_time_until_timeout(20));
+
+    btstack_run_loop_base_process_timers(30);
+    CHECK_EQUAL(3, num_fired);
+    POINTERS_EQUAL(&timers[0], fired[2]);
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(30));
+}
+
+TEST(RunLoopBaseTimers, EqualTimeoutsInAddOrder){
+    int i;
+    for (i=0;i<10;i++){
+        timer_setup(&timers[i], (i & 1) ? 100 : 50);
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(10, num_fired);
+    for (i=0;i<5;i++){
+        POINTERS_EQUAL(&timers[2*i],   fired[i]);
+        POINTERS_EQUAL(&timers[2*i+1], fired[5+i]);
+    }
+}
+
+TEST(RunLoopBaseTimers, Remove){
+    int i;
+    for (i=0;i<5;i++){
+        timer_setup(&timers[i], 10 * (i + 1));
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    // first, in the middle, last, not added
+    CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[0]));
+    CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[2]));
+    CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[4]));
+    CHECK_FALSE(btstack_run_loop_base_remove_timer(&timers[2]));
+    timer_setup(&timers[5], 5);
+    CHECK_FALSE(btstack_run_loop_base_remove_timer(&timers[5]));
+    CHECK_EQUAL(20, btstack_run_loop_base_get_time_until_timeout(0));
+
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(2, num_fired);
+    POINTERS_EQUAL(&timers[1], fired[0]);
+    POINTERS_EQUAL(&timers[3], fired[1]);
+}
+
+TEST(RunLoopBaseTimers, AddTwice){
+    timer_setup(&timers[0], 10);
+    timer_setup(&timers[1], 20);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(2, num_fired);
+}
+
+TEST(RunLoopBaseTimers, WrapAround){
+    uint32_t now = 0xfffffff0u;
+    timer_setup(&timers[0], 0x00000008u);
+    timer_setup(&timers[1], 0xfffffff8u);
+    timer_setup(&timers[2], 0xffffffe0u);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    btstack_run_loop_base_add_timer(&timers[2]);
+    // already expired
+    CHECK_EQUAL(0, btstack_run_loop_base_get_time_until_timeout(now));
+    btstack_run_loop_base_process_timers(now);
+    CHECK_EQUAL(1, num_fired);
+    POINTERS_EQUAL(&timers[2], fired[0]);
+    CHECK_EQUAL(8, btstack_run_loop_base_get_time_until_timeout(now));
+
+    btstack_run_loop_base_process_timers(now + 0x20);
+    CHECK_EQUAL(3, num_fired);
+    POINTERS_EQUAL(&timers[1], fired[1]);
+    POINTERS_EQUAL(&timers[0], fired[2]);
+}
+
+TEST(RunLoopBaseTimers, AddFromHandler){
+    timer_setup(&timers[0], 10);
+    timer_setup(&timers[1], 25);
+    timers[0].process = &timer_rearm_handler;
+    rearm_ms = 10;
+    rearm_count = 3;
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+
+    // fires at 10 and 20, re-added for 30
+    btstack_run_loop_base_process_timers(20);
+    CHECK_EQUAL(2, num_fired);
+    CHECK_EQUAL(5, btstack_run_loop_base_get_time_until_timeout(20));
+
+    // 25, then 30 and 40, not re-added after that
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(5, num_fired);
+    POINTERS_EQUAL(&timers[1], fired[2]);
+    POINTERS_EQUAL(&timers[0], fired[3]);
+    POINTERS_EQUAL(&timers[0], fired[4]);
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(100));
+}
+
+TEST(RunLoopBaseTimers, Random){
+    bool removed[NUM_TIMERS];
+    int num_removed = 0;
+    int i;
+    for (i=0;i<NUM_TIMERS;i++){
+        timer_setup(&timers[i], random_next() % 1000);
+        btstack_run_loop_base_add_timer(&timers[i]);
+        removed[i] = false;
+    }
+    // remove some, part of them while expired timers are processed
+    for (i=0;i<NUM_TIMERS;i+=3){
+        CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[i]));
+        removed[i] = true;
+        num_removed++;
+    }
+    btstack_run_loop_base_process_timers(500);
+    for (i=1;i<NUM_TIMERS;i+=3){
+        if (btstack_run_loop_base_remove_timer(&timers[i])){
+            CHECK_TRUE(timers[i].timeout > 500);
+            removed[i] = true;
+            num_removed++;
+        }
+    }
+    btstack_run_loop_base_process_timers(1000);
+
+    CHECK_EQUAL(NUM_TIMERS - num_removed, num_fired);
+    for (i=0;i<num_fired;i++){
+        int index = (int) (fired[i] - timers);
+        CHECK_FALSE(removed[index]);
+        removed[index] = true;
+        if (i > 0){
+            CHECK_TRUE(fired[i-1]->timeout <= fired[i]->timeout);
+        }
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
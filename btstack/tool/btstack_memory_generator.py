@@ -60,6 +60,7 @@ extern "C" {
 #endif
 
 #include "btstack_config.h"
+#include "btstack_memory_pool.h"
     
 // Core
 #include "hci.h"
@@ -95,6 +96,11 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+/**
+ * @brief Log usage statistics of all memory pools: blocks in use, high-water mark and failed allocations
+ */
+void btstack_memory_log_stats(void);
+
 /* API_END */
 """
 
@@ -106,7 +112,9 @@ hfile_header_end = """
 #endif // BTSTACK_MEMORY_H
 """
 
-cfile_header_begin = """
+cfile_header_begin = """#define BTSTACK_FILE__ "btstack_memory.c"
+
+
 /*
  *  btstack_memory.h
  *
@@ -119,13 +127,15 @@ cfile_header_begin = """
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
 """
 
 header_template = """STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void);
-void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);"""
+void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);
+void   btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats);"""
 
 code_template = """
 // MARK: STRUCT_TYPE
@@ -140,6 +150,7 @@ code_template = """
 #ifdef POOL_COUNT
 #if POOL_COUNT > 0
 static STRUCT_TYPE STRUCT_NAME_storage[POOL_COUNT];
+static uint32_t STRUCT_NAME_allocated[BTSTACK_MEMORY_POOL_BITMAP_SIZE(POOL_COUNT)];
 static btstack_memory_pool_t STRUCT_NAME_pool;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = btstack_memory_pool_get(&STRUCT_NAME_pool);
@@ -151,33 +162,57 @@ STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     btstack_memory_pool_free(&STRUCT_NAME_pool, STRUCT_NAME);
 }
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&STRUCT_NAME_pool, stats);
+}
 #else
+static uint32_t STRUCT_NAME_failed;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
+    STRUCT_NAME_failed++;
     return NULL;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     // silence compiler warning about unused parameter in a portable way
     (void) STRUCT_NAME;
 };
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    memset(stats, 0, sizeof(btstack_memory_pool_stats_t));
+    stats->failed = STRUCT_NAME_failed;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t STRUCT_NAME_stats;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = malloc(sizeof(STRUCT_TYPE));
     if (buffer){
         memset(buffer, 0, sizeof(STRUCT_TYPE));
+        STRUCT_NAME_stats.used++;
+        if (STRUCT_NAME_stats.used > STRUCT_NAME_stats.max_used){
+            STRUCT_NAME_stats.max_used = STRUCT_NAME_stats.used;
+        }
+    } else {
+        STRUCT_NAME_stats.failed++;
     }
     return (STRUCT_NAME_t *) buffer;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    if (STRUCT_NAME == NULL) return;
+    STRUCT_NAME_stats.used--;
     free(STRUCT_NAME);
 }
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = STRUCT_NAME_stats;
+}
 #endif
 """
 
 init_template = """#if POOL_COUNT > 0
-    btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE));
+    btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE), STRUCT_NAME_allocated);
 #endif"""
 
+stats_template = """    btstack_memory_STRUCT_NAME_get_stats(&stats);
+    log_info("STRUCT_NAME: used %u, max %u of %u, failed %u", stats.used, stats.max_used, stats.count, (unsigned int) stats.failed);"""
+
 def writeln(f, data):
     f.write(data + "\n")
 
@@ -296,5 +331,29 @@ for struct_names in list_of_mesh_structs:
         writeln(f, replacePlaceholder(init_template, struct_name))
 writeln(f, "#endif")
 writeln(f, "}")
+
+writeln(f, "")
+writeln(f, "// statistics")
+writeln(f, "void btstack_memory_log_stats(void){")
+writeln(f, "    btstack_memory_pool_stats_t stats;")
+for struct_names in list_of_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(stats_template, struct_name))
+writeln(f, "#ifdef ENABLE_CLASSIC")
+for struct_names in list_of_classic_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(stats_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_BLE")
+for struct_names in list_of_le_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(stats_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_MESH")
+for struct_names in list_of_mesh_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(stats_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "}")
 f.close();
     
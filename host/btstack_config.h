@@ -0,0 +1,24 @@
+//
+// btstack_config.h for the host (posix) build of the HID to IR bridge
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_POSIX_FILE_IO
+#define HAVE_POSIX_TIME
+#define HAVE_BTSTACK_STDIN  // console of the bridge, fed by the script (sim_main.cpp)
+
+// BTstack features that can be enabled
+#define ENABLE_CLASSIC
+#define ENABLE_LOG_ERROR
+#define ENABLE_RUN_LOOP_TIMER_HEAP
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE (1021 + 4)
+
+#define NVM_NUM_LINK_KEYS 16
+
+#endif
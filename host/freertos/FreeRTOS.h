@@ -0,0 +1,25 @@
+/* Host stand-in for FreeRTOS: types of the queue and task calls used by the IR transmitter */
+
+/*
+ * Only what main/ir_tx.cpp needs to be built and driven by ir_tx_test.cpp,
+ * which implements the calls on the virtual clock of the IRremote host test.
+ * Ticks are milliseconds (CONFIG_FREERTOS_HZ=1000 on the ESP32).
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif
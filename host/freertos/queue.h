@@ -0,0 +1,15 @@
+/* Host stand-in for FreeRTOS: queue calls */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue);
+
+#endif
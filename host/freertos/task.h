@@ -0,0 +1,14 @@
+/* Host stand-in for FreeRTOS: task calls */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* const name, const uint32_t stack_size,
+    void* const arg, UBaseType_t priority, TaskHandle_t* const handle, const BaseType_t core);
+
+#endif
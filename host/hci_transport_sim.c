@@ -0,0 +1,1237 @@
+/*
+ * hci_transport_sim.c
+ *
+ * Simulated HCI controller with up to HCI_TRANSPORT_SIM_MAX_DEVICES remote HID
+ * devices, each replaying the script on its own ACL connection. Events and ACL
+ * packets for the host stack are queued and delivered from the run loop, so
+ * the stack never gets re-entered from within hci_send_cmd/hci_send_acl.
+ *
+ * Inquiries are answered by the HID devices and a crowd of other devices, each
+ * one several times. Authentication runs Secure Simple Pairing (Just Works)
+ * unless the host has the link key the device stored on the previous pairing.
+ *
+ * A device asleep does not answer pages, when it wakes up it pages the host
+ * (if the host is page scanning and not busy paging) and opens the HID
+ * channels itself.
+ */
+
+#define BTSTACK_FILE__ "hci_transport_sim.c"
+
+#include <string.h>
+
+#include "btstack_config.h"
+
+#include "bluetooth.h"
+#include "bluetooth_psm.h"
+#include "bluetooth_sdp.h"
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "classic/sdp_util.h"
+#include "hci_cmd.h"
+#include "hci_transport.h"
+#include "l2cap_signaling.h"
+
+#include "hci_transport_sim.h"
+#include "host_time.h"
+#include "latency.h"
+
+// ACL connection handle of the first remote device (the others follow)
+#define SIM_CON_HANDLE          0x0040
+// ACL buffers reported to the host stack
+#define SIM_ACL_PACKET_LEN      1021
+#define SIM_ACL_PACKETS         8
+// L2CAP MTU of the remote device channels
+#define SIM_L2CAP_MTU           672
+// first L2CAP CID allocated by the remote device
+#define SIM_L2CAP_FIRST_CID     0x0040
+
+// L2CAP values on the wire (the BTstack enums of these are private to l2cap.c)
+#define L2CAP_SIM_RESULT_SUCCESS            0x0000
+#define L2CAP_SIM_RESULT_PENDING            0x0001
+#define L2CAP_SIM_RESULT_NO_RESOURCES       0x0004
+#define L2CAP_SIM_INFO_EXTENDED_FEATURES    0x0002
+#define L2CAP_SIM_INFO_FIXED_CHANNELS       0x0003
+#define SIM_MAX_CHANNELS        4
+// packets waiting to be delivered to the host stack
+#define SIM_QUEUE_LEN           (32 * HCI_TRANSPORT_SIM_MAX_DEVICES)
+#define SIM_MAX_PACKET_LEN      (4 + SIM_L2CAP_MTU + 8)
+#define SIM_SDP_RECORD_LEN      (SIM_L2CAP_MTU - 16)
+
+// inquiry: other devices in range and number of responses of each device per inquiry
+#define SIM_INQUIRY_OTHER_DEVICES   40
+#define SIM_INQUIRY_RESPONSES       3
+// Class of Device of the HID devices: peripheral, keyboard
+#define SIM_HID_CLASS_OF_DEVICE     0x002540
+// link key type stored on pairing: unauthenticated combination key P-192
+#define SIM_LINK_KEY_TYPE           0x04
+
+typedef struct {
+    uint8_t  type;
+    uint16_t len;
+    uint8_t  data[SIM_MAX_PACKET_LEN];
+} sim_packet_t;
+
+typedef struct {
+    uint16_t psm;
+    uint16_t local_cid;     // remote device side
+    uint16_t remote_cid;    // host stack side
+    uint8_t  config_state;  // SIM_CONFIG_*
+    uint8_t  outgoing;      // opened by the remote device
+} sim_channel_t;
+
+#define SIM_CONFIG_REQUEST_ANSWERED  0x01
+#define SIM_CONFIG_RESPONSE_RECEIVED 0x02
+#define SIM_CONFIG_DONE              0x03
+
+typedef struct {
+    uint8_t                 used;           // address assigned by a connection of the host
+    uint8_t                 addr[6];        // little endian, as in HCI packets
+    uint8_t                 connected;
+    hci_con_handle_t        con_handle;
+    sim_channel_t           channels[SIM_MAX_CHANNELS];
+    uint16_t                next_cid;
+    // report replay
+    btstack_timer_source_t  report_timer;
+    uint32_t                report_pos;
+    uint8_t                 replay_active;
+    uint8_t                 replay_done;
+    // link key stored by a pairing
+    uint8_t                 bonded;
+    // sleep: pages are not answered until the device wakes up and pages the host
+    uint8_t                 asleep;
+    uint8_t                 wake_pending;   // woke up while the host was paging
+    uint8_t                 initiator;      // connection started by the device, it opens the channels
+    // sniff: the device only transmits at the anchor points, one per interval from the mode change
+    uint32_t                sniff_interval_ms;  // 0 in active mode
+    uint32_t                sniff_anchor_ms;
+    uint8_t                 report_deferred;    // due report waiting for the next anchor point
+} sim_device_t;
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static void (*report_handler)(uint8_t device, uint32_t report_index, uint64_t time_us);
+static void (*done_handler)(void);
+static void (*connected_handler)(uint8_t device, uint64_t time_us);
+
+static const hci_transport_sim_script_t * sim_script;
+
+// packets for the host stack
+static sim_packet_t            sim_queue[SIM_QUEUE_LEN];
+static uint16_t                sim_queue_head;
+static uint16_t                sim_queue_count;
+static btstack_timer_source_t  sim_queue_timer;
+
+// remote devices
+static sim_device_t            sim_devices[HCI_TRANSPORT_SIM_MAX_DEVICES];
+static uint8_t                 sim_num_devices = 1;
+static uint8_t                 sim_num_done;
+static uint8_t                 sim_signaling_identifier;
+static uint8_t                 sim_sdp_record[SIM_SDP_RECORD_LEN];
+
+// cycle count when the packet being delivered was received
+static uint32_t                sim_rx_cycles;
+
+// SDP channels opened by the host
+static uint32_t                sim_sdp_connections;
+
+// pairings and authentications with a stored link key, inquiry results sent
+static uint32_t                sim_pairings;
+static uint32_t                sim_link_key_authentications;
+static uint32_t                sim_inquiry_results;
+
+// devices paired on a previous run
+static uint8_t                 sim_bonded;
+
+// pairings the devices still refuse (user confirmation failed)
+static uint8_t                 sim_pairing_failures;
+
+// host page scan enabled, page timeout set by the host and page of an asleep device in progress
+static uint8_t                 sim_page_scan;
+static uint32_t                sim_page_timeout_ms = 5120;
+static uint8_t                 sim_paging;
+static uint8_t                 sim_page_addr[6];
+static btstack_timer_source_t  sim_page_timer;
+
+// pages by the host and connections requested by the devices
+static uint32_t                sim_pages;
+static uint32_t                sim_page_timeouts;
+static uint32_t                sim_connection_requests;
+static uint32_t                sim_connections_accepted;
+
+// reports delayed to the next sniff anchor point and their total delay
+static uint32_t                sim_sniff_delayed_reports;
+static uint32_t                sim_sniff_delay_ms;
+
+// address of the first HID device answering inquiries (little endian), the others follow
+static const uint8_t           sim_inquiry_addr[6] = { 0x2E, 0x05, 0x16, 0x01, 0x0E, 0x3D };
+
+// Class of Device of the other devices: phone, headset, computer, mouse, gamepad
+static const uint32_t          sim_inquiry_other_cod[] = { 0x5A020C, 0x240404, 0x3E010C, 0x002580, 0x002508 };
+
+/**************************************************************************************************/
+
+static void sim_queue_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    sim_packet_t packet;
+    // packets queued while delivering are delivered in the same pass
+    while (sim_queue_count){
+        packet = sim_queue[sim_queue_head];
+        sim_queue_head = (sim_queue_head + 1) % SIM_QUEUE_LEN;
+        sim_queue_count--;
+        sim_rx_cycles = latency_now();
+        (*packet_handler)(packet.type, packet.data, packet.len);
+    }
+}
+
+static uint8_t * sim_queue_reserve(uint8_t type, uint16_t len){
+    if (sim_queue_count >= SIM_QUEUE_LEN){
+        log_error("sim queue full, packet type %u dropped", type);
+        return NULL;
+    }
+    if (len > SIM_MAX_PACKET_LEN){
+        log_error("sim packet too long (%u)", len);
+        return NULL;
+    }
+    sim_packet_t * packet = &sim_queue[(sim_queue_head + sim_queue_count) % SIM_QUEUE_LEN];
+    sim_queue_count++;
+    packet->type = type;
+    packet->len  = len;
+    if (sim_queue_count == 1){
+        // the timer may still be pending from a pass that already delivered its packets
+        btstack_run_loop_remove_timer(&sim_queue_timer);
+        btstack_run_loop_set_timer_handler(&sim_queue_timer, &sim_queue_timer_handler);
+        btstack_run_loop_set_timer(&sim_queue_timer, 0);
+        btstack_run_loop_add_timer(&sim_queue_timer);
+    }
+    return packet->data;
+}
+
+static void sim_queue_event(const uint8_t * event, uint16_t len){
+    uint8_t * packet = sim_queue_reserve(HCI_EVENT_PACKET, len);
+    if (!packet) return;
+    (void)memcpy(packet, event, len);
+}
+
+static void sim_queue_addr_event(uint8_t event_code, const uint8_t * addr, const uint8_t * params, uint8_t params_len){
+    uint8_t event[2 + 6 + 32];
+    event[0] = event_code;
+    event[1] = 6 + params_len;
+    (void)memcpy(&event[2], addr, 6);
+    if (params_len){
+        (void)memcpy(&event[8], params, params_len);
+    }
+    sim_queue_event(event, 8 + params_len);
+}
+
+static sim_device_t * sim_device_for_con_handle(hci_con_handle_t con_handle){
+    uint16_t index = con_handle - SIM_CON_HANDLE;
+    if ((index >= HCI_TRANSPORT_SIM_MAX_DEVICES) || !sim_devices[index].used) return NULL;
+    return &sim_devices[index];
+}
+
+// device answering the page of an address, a new one while there are devices left in range
+static sim_device_t * sim_device_for_addr(const uint8_t * addr){
+    int i;
+    for (i=0;i<sim_num_devices;i++){
+        if (sim_devices[i].used && (memcmp(sim_devices[i].addr, addr, 6) == 0)) return &sim_devices[i];
+    }
+    for (i=0;i<sim_num_devices;i++){
+        if (sim_devices[i].used) continue;
+        sim_devices[i].used = 1;
+        (void)memcpy(sim_devices[i].addr, addr, 6);
+        return &sim_devices[i];
+    }
+    return NULL;
+}
+
+// connected device with an address, NULL if none
+static sim_device_t * sim_device_connected_for_addr(const uint8_t * addr){
+    int i;
+    for (i=0;i<sim_num_devices;i++){
+        if (sim_devices[i].connected && (memcmp(sim_devices[i].addr, addr, 6) == 0)) return &sim_devices[i];
+    }
+    return NULL;
+}
+
+static void sim_send_command_complete(uint16_t opcode, const uint8_t * params, uint16_t params_len){
+    uint8_t event[6 + 256];
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 4 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    event[5] = ERROR_CODE_SUCCESS;
+    (void)memcpy(&event[6], params, params_len);
+    sim_queue_event(event, 6 + params_len);
+}
+
+static void sim_send_command_status(uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    sim_queue_event(event, sizeof(event));
+}
+
+// send L2CAP payload to the host stack on given channel
+static void sim_send_l2cap(sim_device_t * device, uint16_t cid, const uint8_t * data, uint16_t len){
+    uint8_t * packet = sim_queue_reserve(HCI_ACL_DATA_PACKET, 8 + len);
+    if (!packet) return;
+    little_endian_store_16(packet, 0, device->con_handle | 0x2000);
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    (void)memcpy(&packet[8], data, len);
+}
+
+static void sim_send_signaling(sim_device_t * device, uint8_t code, uint8_t identifier, const uint8_t * data, uint16_t len){
+    uint8_t command[4 + 16];
+    command[0] = code;
+    command[1] = identifier;
+    little_endian_store_16(command, 2, len);
+    (void)memcpy(&command[4], data, len);
+    sim_send_l2cap(device, L2CAP_CID_SIGNALING, command, 4 + len);
+}
+
+static void sim_send_connection_complete(const uint8_t * addr, sim_device_t * device, uint8_t status){
+    uint8_t event[13];
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = status;
+    little_endian_store_16(event, 3, (status == ERROR_CODE_SUCCESS) ? device->con_handle : 0);
+    (void)memcpy(&event[5], addr, 6);
+    event[11] = 0x01;   // ACL
+    event[12] = 0x00;   // no encryption
+    if (status == ERROR_CODE_SUCCESS){
+        device->connected = 1;
+        device->next_cid = SIM_L2CAP_FIRST_CID;
+    }
+    sim_queue_event(event, sizeof(event));
+}
+
+/**************************************************************************************************/
+
+// SDP record of the remote HID device
+static void sim_sdp_create_record(void){
+    uint8_t * attribute;
+    uint8_t * protocol;
+    uint8_t * additional;
+    uint8_t * descriptor_list;
+    uint8_t * descriptor;
+
+    de_create_sequence(sim_sdp_record);
+
+    de_add_number(sim_sdp_record, DE_UINT, DE_SIZE_16, BLUETOOTH_ATTRIBUTE_SERVICE_CLASS_ID_LIST);
+    attribute = de_push_sequence(sim_sdp_record);
+    de_add_number(attribute, DE_UUID, DE_SIZE_16, BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE);
+    de_pop_sequence(sim_sdp_record, attribute);
+
+    de_add_number(sim_sdp_record, DE_UINT, DE_SIZE_16, BLUETOOTH_ATTRIBUTE_PROTOCOL_DESCRIPTOR_LIST);
+    attribute = de_push_sequence(sim_sdp_record);
+    protocol = de_push_sequence(attribute);
+    de_add_number(protocol, DE_UUID, DE_SIZE_16, BLUETOOTH_PROTOCOL_L2CAP);
+    de_add_number(protocol, DE_UINT, DE_SIZE_16, BLUETOOTH_PSM_HID_CONTROL);
+    de_pop_sequence(attribute, protocol);
+    protocol = de_push_sequence(attribute);
+    de_add_number(protocol, DE_UUID, DE_SIZE_16, BLUETOOTH_PROTOCOL_HIDP);
+    de_pop_sequence(attribute, protocol);
+    de_pop_sequence(sim_sdp_record, attribute);
+
+    de_add_number(sim_sdp_record, DE_UINT, DE_SIZE_16, BLUETOOTH_ATTRIBUTE_ADDITIONAL_PROTOCOL_DESCRIPTOR_LISTS);
+    attribute = de_push_sequence(sim_sdp_record);
+    additional = de_push_sequence(attribute);
+    protocol = de_push_sequence(additional);
+    de_add_number(protocol, DE_UUID, DE_SIZE_16, BLUETOOTH_PROTOCOL_L2CAP);
+    de_add_number(protocol, DE_UINT, DE_SIZE_16, BLUETOOTH_PSM_HID_INTERRUPT);
+    de_pop_sequence(additional, protocol);
+    protocol = de_push_sequence(additional);
+    de_add_number(protocol, DE_UUID, DE_SIZE_16, BLUETOOTH_PROTOCOL_HIDP);
+    de_pop_sequence(additional, protocol);
+    de_pop_sequence(attribute, additional);
+    de_pop_sequence(sim_sdp_record, attribute);
+
+    if (sim_script && sim_script->hid_descriptor_len){
+        de_add_number(sim_sdp_record, DE_UINT, DE_SIZE_16, BLUETOOTH_ATTRIBUTE_HID_DESCRIPTOR_LIST);
+        descriptor_list = de_push_sequence(sim_sdp_record);
+        descriptor = de_push_sequence(descriptor_list);
+        de_add_number(descriptor, DE_UINT, DE_SIZE_8, 0x22);    // Report Descriptor
+        de_add_data(descriptor, DE_STRING, sim_script->hid_descriptor_len, (uint8_t *) sim_script->hid_descriptor);
+        de_pop_sequence(descriptor_list, descriptor);
+        de_pop_sequence(sim_sdp_record, descriptor_list);
+    }
+}
+
+// answer ServiceSearchAttributeRequest with the HID record, continuation state is the offset
+static void sim_sdp_handle_request(sim_device_t * device, sim_channel_t * channel, const uint8_t * request, uint16_t len){
+    uint8_t  response[7 + SIM_L2CAP_MTU];
+    uint8_t  record_list[3 + SIM_SDP_RECORD_LEN];
+    uint16_t record_list_len;
+    uint16_t max_bytes;
+    uint16_t offset = 0;
+    uint16_t pos;
+    uint16_t chunk;
+
+    if ((len < 5) || (request[0] != SDP_ServiceSearchAttributeRequest)) return;
+
+    // ServiceSearchPattern, MaximumAttributeByteCount, AttributeIDList, ContinuationState
+    pos = 5;
+    pos += de_get_len_safe(&request[pos], len - pos);
+    if ((pos + 2) > len) return;
+    max_bytes = big_endian_read_16(request, pos);
+    pos += 2;
+    pos += de_get_len_safe(&request[pos], len - pos);
+    if ((pos < len) && (request[pos] == 2) && ((pos + 3) <= len)){
+        offset = big_endian_read_16(request, pos + 1);
+    }
+
+    // list with a single record
+    sim_sdp_create_record();
+    de_create_sequence(record_list);
+    de_add_data(record_list, DE_DES, de_get_data_size(sim_sdp_record), &sim_sdp_record[de_get_header_size(sim_sdp_record)]);
+    record_list_len = de_get_len(record_list);
+
+    if (offset > record_list_len) offset = record_list_len;
+    chunk = btstack_min(record_list_len - offset, btstack_min(max_bytes, SIM_L2CAP_MTU - 10));
+
+    response[0] = SDP_ServiceSearchAttributeResponse;
+    big_endian_store_16(response, 1, big_endian_read_16(request, 1));
+    big_endian_store_16(response, 5, chunk);
+    (void)memcpy(&response[7], &record_list[offset], chunk);
+    pos = 7 + chunk;
+    if ((offset + chunk) < record_list_len){
+        response[pos++] = 2;
+        big_endian_store_16(response, pos, offset + chunk);
+        pos += 2;
+    } else {
+        response[pos++] = 0;
+    }
+    big_endian_store_16(response, 3, pos - 5);
+    sim_send_l2cap(device, channel->remote_cid, response, pos);
+}
+
+/**************************************************************************************************/
+
+static void sim_report_timer_handler(btstack_timer_source_t * ts);
+static void sim_connection_closed(sim_device_t * device);
+static void sim_wake(sim_device_t * device);
+
+static uint8_t sim_device_index(const sim_device_t * device){
+    return (uint8_t) (device - sim_devices);
+}
+
+static void sim_report_schedule(sim_device_t * device){
+    uint32_t total = sim_script->num_reports * sim_script->repeat;
+    if (device->report_pos >= total){
+        device->replay_active = 0;
+        if (!device->replay_done){
+            device->replay_done = 1;
+            sim_num_done++;
+        }
+        if ((sim_num_done == sim_num_devices) && done_handler){
+            (*done_handler)();
+        }
+        return;
+    }
+    btstack_run_loop_set_timer_handler(&device->report_timer, &sim_report_timer_handler);
+    btstack_run_loop_set_timer_context(&device->report_timer, device);
+    btstack_run_loop_set_timer(&device->report_timer, sim_script->reports[device->report_pos % sim_script->num_reports].delay_ms);
+    btstack_run_loop_add_timer(&device->report_timer);
+}
+
+static void sim_report_timer_handler(btstack_timer_source_t * ts){
+    sim_device_t * device = (sim_device_t *) btstack_run_loop_get_timer_context(ts);
+    sim_channel_t * interrupt = NULL;
+    uint8_t packet[8 + HCI_TRANSPORT_SIM_MAX_REPORT_LEN];
+    int i;
+
+    const hci_transport_sim_report_t * report = &sim_script->reports[device->report_pos % sim_script->num_reports];
+
+    // step run by the report handler, nothing sent on the link
+    if (report->type == HCI_TRANSPORT_SIM_STEP){
+        if (report_handler){
+            (*report_handler)(sim_device_index(device), device->report_pos, host_time_us());
+        }
+        device->report_pos++;
+        sim_report_schedule(device);
+        return;
+    }
+
+    // device woken up, replay goes on once it reconnected
+    if (report->type == HCI_TRANSPORT_SIM_WAKE){
+        if (report_handler){
+            (*report_handler)(sim_device_index(device), device->report_pos, host_time_us());
+        }
+        device->report_pos++;
+        sim_wake(device);
+        return;
+    }
+
+    for (i=0;i<SIM_MAX_CHANNELS;i++){
+        if ((device->channels[i].psm == BLUETOOTH_PSM_HID_INTERRUPT) && (device->channels[i].config_state == SIM_CONFIG_DONE)){
+            interrupt = &device->channels[i];
+        }
+    }
+    if (!interrupt){
+        device->replay_active = 0;
+        return;
+    }
+
+    // remote device drops the connection, replay goes on once reconnected
+    if (report->type == HCI_TRANSPORT_SIM_DISCONNECT){
+        uint8_t event[6];
+        if (report_handler){
+            (*report_handler)(sim_device_index(device), device->report_pos, host_time_us());
+        }
+        device->report_pos++;
+        // the device goes to sleep until the wake step if the script has one next, the link is
+        // lost otherwise
+        device->asleep = (device->report_pos < sim_script->num_reports * sim_script->repeat) &&
+            (sim_script->reports[device->report_pos % sim_script->num_reports].type == HCI_TRANSPORT_SIM_WAKE);
+        sim_connection_closed(device);
+        event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+        event[1] = 4;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, device->con_handle);
+        event[5] = device->asleep ? ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION : ERROR_CODE_CONNECTION_TIMEOUT;
+        sim_queue_event(event, 6);
+        if (device->asleep){
+            sim_report_schedule(device);
+        }
+        return;
+    }
+
+    // in sniff mode the report waits for the next anchor point
+    uint32_t delay_ms = 0;
+    if (device->sniff_interval_ms && !device->report_deferred){
+        delay_ms = (btstack_run_loop_get_time_ms() - device->sniff_anchor_ms) % device->sniff_interval_ms;
+        if (delay_ms){
+            delay_ms = device->sniff_interval_ms - delay_ms;
+        }
+    }
+    if (delay_ms){
+        device->report_deferred = 1;
+        sim_sniff_delayed_reports++;
+        sim_sniff_delay_ms += delay_ms;
+        btstack_run_loop_set_timer(&device->report_timer, delay_ms);
+        btstack_run_loop_add_timer(&device->report_timer);
+        return;
+    }
+    device->report_deferred = 0;
+
+    // deliver report directly to measure the host stack alone
+    little_endian_store_16(packet, 0, device->con_handle | 0x2000);
+    little_endian_store_16(packet, 2, 4 + report->len);
+    little_endian_store_16(packet, 4, report->len);
+    little_endian_store_16(packet, 6, interrupt->remote_cid);
+    (void)memcpy(&packet[8], report->data, report->len);
+    uint64_t time_us = host_time_us();
+    sim_rx_cycles = latency_now();
+    (*packet_handler)(HCI_ACL_DATA_PACKET, packet, 8 + report->len);
+    if (report_handler){
+        (*report_handler)(sim_device_index(device), device->report_pos, time_us);
+    }
+
+    device->report_pos++;
+    sim_report_schedule(device);
+}
+
+static void sim_replay_start(sim_device_t * device){
+    if (device->replay_active || !sim_script || !sim_script->num_reports || !sim_script->repeat) return;
+    device->replay_active = 1;
+    if (connected_handler){
+        (*connected_handler)(sim_device_index(device), host_time_us());
+    }
+    sim_report_schedule(device);
+}
+
+/**************************************************************************************************/
+
+static sim_channel_t * sim_channel_for_local_cid(sim_device_t * device, uint16_t cid){
+    int i;
+    for (i=0;i<SIM_MAX_CHANNELS;i++){
+        if (device->channels[i].psm && (device->channels[i].local_cid == cid)) return &device->channels[i];
+    }
+    return NULL;
+}
+
+static void sim_send_configure_request(sim_device_t * device, sim_channel_t * channel){
+    uint8_t request[4];
+    // request basic mode with default MTU
+    little_endian_store_16(request, 0, channel->remote_cid);
+    little_endian_store_16(request, 2, 0);
+    sim_send_signaling(device, CONFIGURE_REQUEST, ++sim_signaling_identifier, request, 4);
+}
+
+// open a HID channel to the host, from the device side
+static void sim_open_channel(sim_device_t * device, uint16_t psm){
+    uint8_t request[4];
+    sim_channel_t * channel = NULL;
+    int i;
+    for (i=0;i<SIM_MAX_CHANNELS;i++){
+        if (!device->channels[i].psm){
+            channel = &device->channels[i];
+            break;
+        }
+    }
+    if (!channel) return;
+    channel->psm = psm;
+    channel->local_cid = device->next_cid++;
+    channel->remote_cid = 0;
+    channel->config_state = 0;
+    channel->outgoing = 1;
+    little_endian_store_16(request, 0, psm);
+    little_endian_store_16(request, 2, channel->local_cid);
+    sim_send_signaling(device, CONNECTION_REQUEST, ++sim_signaling_identifier, request, 4);
+}
+
+static void sim_channel_config_state(sim_device_t * device, sim_channel_t * channel, uint8_t state){
+    channel->config_state |= state;
+    if (channel->config_state != SIM_CONFIG_DONE) return;
+    if (channel->psm == BLUETOOTH_PSM_HID_INTERRUPT){
+        sim_replay_start(device);
+    } else if ((channel->psm == BLUETOOTH_PSM_HID_CONTROL) && channel->outgoing){
+        // interrupt channel follows the control channel
+        sim_open_channel(device, BLUETOOTH_PSM_HID_INTERRUPT);
+    }
+}
+
+static void sim_handle_signaling(sim_device_t * device, const uint8_t * command, uint16_t len){
+    uint8_t  response[12];
+    uint8_t  code       = command[0];
+    uint8_t  identifier = command[1];
+    sim_channel_t * channel;
+    int i;
+    UNUSED(len);
+
+    switch (code){
+        case CONNECTION_REQUEST: {
+            uint16_t psm = little_endian_read_16(command, 4);
+            uint16_t remote_cid = little_endian_read_16(command, 6);
+            channel = NULL;
+            for (i=0;i<SIM_MAX_CHANNELS;i++){
+                if (!device->channels[i].psm){
+                    channel = &device->channels[i];
+                    break;
+                }
+            }
+            little_endian_store_16(response, 2, remote_cid);
+            little_endian_store_16(response, 6, 0);
+            if (!channel){
+                little_endian_store_16(response, 0, 0);
+                little_endian_store_16(response, 4, L2CAP_SIM_RESULT_NO_RESOURCES);
+                sim_send_signaling(device, CONNECTION_RESPONSE, identifier, response, 8);
+                break;
+            }
+            if (psm == BLUETOOTH_PSM_SDP){
+                sim_sdp_connections++;
+            }
+            channel->psm = psm;
+            channel->local_cid = device->next_cid++;
+            channel->remote_cid = remote_cid;
+            channel->config_state = 0;
+            channel->outgoing = 0;
+            little_endian_store_16(response, 0, channel->local_cid);
+            little_endian_store_16(response, 4, L2CAP_SIM_RESULT_SUCCESS);
+            sim_send_signaling(device, CONNECTION_RESPONSE, identifier, response, 8);
+            sim_send_configure_request(device, channel);
+            break;
+        }
+        case CONNECTION_RESPONSE: {
+            uint16_t result = little_endian_read_16(command, 8);
+            channel = sim_channel_for_local_cid(device, little_endian_read_16(command, 6));
+            // the host answers pending until the link is authenticated
+            if (!channel || !channel->outgoing || (result == L2CAP_SIM_RESULT_PENDING)) break;
+            if (result != L2CAP_SIM_RESULT_SUCCESS){
+                channel->psm = 0;
+                break;
+            }
+            channel->remote_cid = little_endian_read_16(command, 4);
+            sim_send_configure_request(device, channel);
+            break;
+        }
+        case CONFIGURE_REQUEST:
+            channel = sim_channel_for_local_cid(device, little_endian_read_16(command, 4));
+            if (!channel) break;
+            little_endian_store_16(response, 0, channel->remote_cid);
+            little_endian_store_16(response, 2, 0);
+            little_endian_store_16(response, 4, 0);   // success
+            sim_send_signaling(device, CONFIGURE_RESPONSE, identifier, response, 6);
+            sim_channel_config_state(device, channel, SIM_CONFIG_REQUEST_ANSWERED);
+            break;
+        case CONFIGURE_RESPONSE:
+            channel = sim_channel_for_local_cid(device, little_endian_read_16(command, 4));
+            if (!channel) break;
+            sim_channel_config_state(device, channel, SIM_CONFIG_RESPONSE_RECEIVED);
+            break;
+        case DISCONNECTION_REQUEST:
+            channel = sim_channel_for_local_cid(device, little_endian_read_16(command, 4));
+            (void)memcpy(response, &command[4], 4);
+            sim_send_signaling(device, DISCONNECTION_RESPONSE, identifier, response, 4);
+            if (channel){
+                channel->psm = 0;
+            }
+            break;
+        case INFORMATION_REQUEST: {
+            uint16_t info_type = little_endian_read_16(command, 4);
+            little_endian_store_16(response, 0, info_type);
+            little_endian_store_16(response, 2, 0);
+            memset(&response[4], 0, 8);
+            switch (info_type){
+                case L2CAP_SIM_INFO_EXTENDED_FEATURES:
+                    sim_send_signaling(device, INFORMATION_RESPONSE, identifier, response, 8);
+                    break;
+                case L2CAP_SIM_INFO_FIXED_CHANNELS:
+                    response[4] = 1 << L2CAP_CID_SIGNALING;
+                    sim_send_signaling(device, INFORMATION_RESPONSE, identifier, response, 12);
+                    break;
+                default:
+                    little_endian_store_16(response, 2, 1);   // not supported
+                    sim_send_signaling(device, INFORMATION_RESPONSE, identifier, response, 4);
+                    break;
+            }
+            break;
+        }
+        case ECHO_REQUEST:
+            sim_send_signaling(device, ECHO_RESPONSE, identifier, NULL, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+static void sim_handle_acl(const uint8_t * packet, int size){
+    uint8_t completed[7];
+    if (size < 8) return;
+    sim_device_t * device = sim_device_for_con_handle(little_endian_read_16(packet, 0) & 0x0fff);
+    if (!device || !device->connected) return;
+    uint16_t l2cap_len = little_endian_read_16(packet, 4);
+    uint16_t cid       = little_endian_read_16(packet, 6);
+    const uint8_t * payload = &packet[8];
+    if ((l2cap_len + 8) > size) return;
+
+    if (cid == L2CAP_CID_SIGNALING){
+        uint16_t pos = 0;
+        while ((pos + 4) <= l2cap_len){
+            uint16_t command_len = little_endian_read_16(payload, pos + 2);
+            if ((pos + 4 + command_len) > l2cap_len) break;
+            sim_handle_signaling(device, &payload[pos], 4 + command_len);
+            pos += 4 + command_len;
+        }
+    } else {
+        sim_channel_t * channel = sim_channel_for_local_cid(device, cid);
+        if (channel && (channel->psm == BLUETOOTH_PSM_SDP)){
+            sim_sdp_handle_request(device, channel, payload, l2cap_len);
+        }
+    }
+
+    // ACL buffer freed
+    completed[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    completed[1] = 5;
+    completed[2] = 1;
+    little_endian_store_16(completed, 3, little_endian_read_16(packet, 0) & 0x0fff);
+    little_endian_store_16(completed, 5, 1);
+    sim_queue_event(completed, sizeof(completed));
+}
+
+/**************************************************************************************************/
+
+static void sim_connection_closed(sim_device_t * device){
+    device->connected = 0;
+    device->initiator = 0;
+    device->replay_active = 0;
+    device->sniff_interval_ms = 0;
+    device->report_deferred = 0;
+    btstack_run_loop_remove_timer(&device->report_timer);
+    memset(device->channels, 0, sizeof(device->channels));
+}
+
+// device woken up by a key press pages the host, it waits to be paged if the host is not connectable
+static void sim_wake(sim_device_t * device){
+    uint8_t params[4];
+    device->asleep = 0;
+    if (device->connected) return;
+    if (sim_paging){
+        // the host controller does not page scan while paging
+        device->wake_pending = 1;
+        return;
+    }
+    if (!sim_page_scan) return;
+    device->initiator = 1;
+    sim_connection_requests++;
+    little_endian_store_24(params, 0, SIM_HID_CLASS_OF_DEVICE);
+    params[3] = 0x01;   // ACL
+    sim_queue_addr_event(HCI_EVENT_CONNECTION_REQUEST, device->addr, params, 4);
+}
+
+// page of an asleep device timed out, the devices that woke up meanwhile page the host now
+static void sim_page_timer_handler(btstack_timer_source_t * ts){
+    int i;
+    UNUSED(ts);
+    sim_paging = 0;
+    sim_page_timeouts++;
+    sim_send_connection_complete(sim_page_addr, NULL, ERROR_CODE_PAGE_TIMEOUT);
+    for (i=0;i<sim_num_devices;i++){
+        if (!sim_devices[i].wake_pending) continue;
+        sim_devices[i].wake_pending = 0;
+        sim_wake(&sim_devices[i]);
+    }
+}
+
+// page of the host, answered right away unless the device is asleep
+static void sim_page(const uint8_t * addr){
+    sim_device_t * device = sim_device_for_addr(addr);
+    sim_pages++;
+    if (!device){
+        // no more devices in range
+        sim_page_timeouts++;
+        sim_send_connection_complete(addr, NULL, ERROR_CODE_PAGE_TIMEOUT);
+        return;
+    }
+    if (!device->asleep){
+        sim_send_connection_complete(addr, device, ERROR_CODE_SUCCESS);
+        return;
+    }
+    sim_paging = 1;
+    (void)memcpy(sim_page_addr, addr, 6);
+    btstack_run_loop_set_timer_handler(&sim_page_timer, &sim_page_timer_handler);
+    btstack_run_loop_set_timer(&sim_page_timer, sim_page_timeout_ms);
+    btstack_run_loop_add_timer(&sim_page_timer);
+}
+
+// answer an inquiry: every device in range responds several times, the HID devices after the others
+static void sim_inquiry(void){
+    uint8_t  event[17];
+    uint32_t cod;
+    int round;
+    int i;
+
+    // HID devices not connected yet take their address
+    for (i=0;i<sim_num_devices;i++){
+        if (sim_devices[i].used) continue;
+        sim_devices[i].used = 1;
+        (void)memcpy(sim_devices[i].addr, sim_inquiry_addr, 6);
+        sim_devices[i].addr[0] += i;
+    }
+
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_INQUIRY_RESULT;
+    event[1] = 15;
+    event[2] = 1;
+    for (round=0;round<SIM_INQUIRY_RESPONSES;round++){
+        for (i=0;i<(SIM_INQUIRY_OTHER_DEVICES + sim_num_devices);i++){
+            if (i < SIM_INQUIRY_OTHER_DEVICES){
+                const uint8_t other_addr[6] = { (uint8_t) i, 0x00, 0x00, 0x5B, 0xF0, 0xC0 };
+                (void)memcpy(&event[3], other_addr, 6);
+                cod = sim_inquiry_other_cod[i % (sizeof(sim_inquiry_other_cod) / sizeof(sim_inquiry_other_cod[0]))];
+            } else {
+                (void)memcpy(&event[3], sim_devices[i - SIM_INQUIRY_OTHER_DEVICES].addr, 6);
+                cod = SIM_HID_CLASS_OF_DEVICE;
+            }
+            little_endian_store_24(event, 12, cod);
+            sim_queue_event(event, sizeof(event));
+            sim_inquiry_results++;
+        }
+    }
+
+    event[0] = HCI_EVENT_INQUIRY_COMPLETE;
+    event[1] = 1;
+    event[2] = ERROR_CODE_SUCCESS;
+    sim_queue_event(event, 3);
+}
+
+static void sim_authentication_complete(sim_device_t * device, uint8_t status){
+    uint8_t event[5];
+    event[0] = HCI_EVENT_AUTHENTICATION_COMPLETE;
+    event[1] = 3;
+    event[2] = status;
+    little_endian_store_16(event, 3, device->con_handle);
+    sim_queue_event(event, sizeof(event));
+}
+
+// link key of a device, the same on each pairing so the bond outlives the simulation
+static void sim_link_key(const sim_device_t * device, uint8_t * link_key){
+    int i;
+    for (i=0;i<16;i++){
+        link_key[i] = (uint8_t) (0xA0 + i) ^ device->addr[0];
+    }
+}
+
+// Just Works pairing confirmed by the host, the device stores the link key
+static void sim_pairing_complete(sim_device_t * device){
+    uint8_t params[17];
+
+    params[0] = ERROR_CODE_SUCCESS;
+    sim_queue_addr_event(HCI_EVENT_SIMPLE_PAIRING_COMPLETE, device->addr, params, 1);
+    device->bonded = 1;
+    sim_pairings++;
+    sim_link_key(device, params);
+    params[16] = SIM_LINK_KEY_TYPE;
+    sim_queue_addr_event(HCI_EVENT_LINK_KEY_NOTIFICATION, device->addr, params, 17);
+    sim_authentication_complete(device, ERROR_CODE_SUCCESS);
+}
+
+// pairing and authentication commands, returns 0 if the command is not one of them
+static int sim_handle_security_command(uint16_t opcode, const uint8_t * packet){
+    const uint8_t * addr = &packet[3];
+    sim_device_t * device;
+    uint8_t params[4];
+    uint8_t link_key[16];
+
+    if (opcode == hci_authentication_requested.opcode){
+        device = sim_device_for_con_handle(little_endian_read_16(packet, 3));
+        sim_send_command_status(opcode, device ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+        if (!device) return 1;
+        sim_queue_addr_event(HCI_EVENT_LINK_KEY_REQUEST, device->addr, NULL, 0);
+        return 1;
+    }
+    if ((opcode == hci_link_key_request_reply.opcode) || (opcode == hci_link_key_request_negative_reply.opcode) ||
+        (opcode == hci_io_capability_request_reply.opcode) || (opcode == hci_io_capability_request_negative_reply.opcode) ||
+        (opcode == hci_user_confirmation_request_reply.opcode) || (opcode == hci_user_confirmation_request_negative_reply.opcode)){
+        sim_send_command_complete(opcode, addr, 6);
+        device = sim_device_connected_for_addr(addr);
+        if (!device) return 1;
+        if (opcode == hci_link_key_request_reply.opcode){
+            // the host has a link key, it only works if it is the one the device stored
+            sim_link_key(device, link_key);
+            if ((device->bonded || sim_bonded) && (memcmp(&packet[9], link_key, 16) == 0)){
+                sim_link_key_authentications++;
+                sim_authentication_complete(device, ERROR_CODE_SUCCESS);
+            } else {
+                sim_authentication_complete(device, ERROR_CODE_AUTHENTICATION_FAILURE);
+            }
+        } else if (opcode == hci_link_key_request_negative_reply.opcode){
+            sim_queue_addr_event(HCI_EVENT_IO_CAPABILITY_REQUEST, device->addr, NULL, 0);
+        } else if (opcode == hci_io_capability_request_reply.opcode){
+            params[0] = SSP_IO_CAPABILITY_KEYBOARD_ONLY;
+            params[1] = 0;  // no OOB data
+            params[2] = SSP_IO_AUTHREQ_MITM_PROTECTION_NOT_REQUIRED_GENERAL_BONDING;
+            sim_queue_addr_event(HCI_EVENT_IO_CAPABILITY_RESPONSE, device->addr, params, 3);
+            little_endian_store_32(params, 0, 123456);
+            sim_queue_addr_event(HCI_EVENT_USER_CONFIRMATION_REQUEST, device->addr, params, 4);
+        } else if ((opcode == hci_user_confirmation_request_reply.opcode) && !sim_pairing_failures){
+            sim_pairing_complete(device);
+        } else {
+            if (opcode == hci_user_confirmation_request_reply.opcode) sim_pairing_failures--;
+            params[0] = ERROR_CODE_AUTHENTICATION_FAILURE;
+            sim_queue_addr_event(HCI_EVENT_SIMPLE_PAIRING_COMPLETE, device->addr, params, 1);
+            sim_authentication_complete(device, ERROR_CODE_AUTHENTICATION_FAILURE);
+        }
+        return 1;
+    }
+    if (opcode == hci_set_connection_encryption.opcode){
+        uint8_t event[6];
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        event[0] = HCI_EVENT_ENCRYPTION_CHANGE;
+        event[1] = 4;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, little_endian_read_16(packet, 3));
+        event[5] = packet[5];
+        sim_queue_event(event, sizeof(event));
+        return 1;
+    }
+    if (opcode == hci_read_encryption_key_size.opcode){
+        little_endian_store_16(params, 0, little_endian_read_16(packet, 3));
+        params[2] = 16;
+        sim_send_command_complete(opcode, params, 3);
+        return 1;
+    }
+    return 0;
+}
+
+static void sim_handle_command(const uint8_t * packet, int size){
+    uint8_t  params[64];
+    uint8_t  event[2 + 255];
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    UNUSED(size);
+
+    memset(params, 0, sizeof(params));
+
+    // commands answered by command complete with return parameters
+    if (opcode == hci_read_local_version_information.opcode){
+        params[1] = 0x09;                           // HCI version 5.0
+        params[4] = 0x09;                           // LMP version 5.0
+        little_endian_store_16(params, 5, 0xFFFF);  // manufacturer: reserved for internal use
+        sim_send_command_complete(opcode, params, 9);
+        return;
+    }
+    if (opcode == hci_read_local_supported_commands.opcode){
+        params[14] = 0x80;  // Read Buffer Size
+        sim_send_command_complete(opcode, params, 64);
+        return;
+    }
+    if (opcode == hci_read_local_supported_features.opcode){
+        params[6] = 1 << 3;     // Secure Simple Pairing
+        sim_send_command_complete(opcode, params, 8);
+        return;
+    }
+    if (opcode == hci_read_buffer_size.opcode){
+        little_endian_store_16(params, 0, SIM_ACL_PACKET_LEN);
+        params[2] = 64;
+        little_endian_store_16(params, 3, SIM_ACL_PACKETS);
+        little_endian_store_16(params, 5, SIM_ACL_PACKETS);
+        sim_send_command_complete(opcode, params, 7);
+        return;
+    }
+    if (opcode == hci_read_bd_addr.opcode){
+        const uint8_t local_addr[] = { 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
+        (void)memcpy(params, local_addr, 6);
+        sim_send_command_complete(opcode, params, 6);
+        return;
+    }
+
+    // commands answered by command status and a completion event
+    if (opcode == hci_create_connection.opcode){
+        sim_send_command_status(opcode, sim_paging ? ERROR_CODE_COMMAND_DISALLOWED : ERROR_CODE_SUCCESS);
+        if (!sim_paging){
+            sim_page(&packet[3]);
+        }
+        return;
+    }
+    if ((opcode == hci_accept_connection_request.opcode) || (opcode == hci_reject_connection_request.opcode)){
+        sim_device_t * device = NULL;
+        int i;
+        for (i=0;i<sim_num_devices;i++){
+            if (sim_devices[i].initiator && !sim_devices[i].connected && (memcmp(sim_devices[i].addr, &packet[3], 6) == 0)){
+                device = &sim_devices[i];
+            }
+        }
+        sim_send_command_status(opcode, device ? ERROR_CODE_SUCCESS : ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+        if (!device) return;
+        if (opcode == hci_reject_connection_request.opcode){
+            // the device waits to be paged
+            device->initiator = 0;
+            sim_send_connection_complete(device->addr, device, packet[9]);
+            return;
+        }
+        sim_connections_accepted++;
+        sim_send_connection_complete(device->addr, device, ERROR_CODE_SUCCESS);
+        sim_open_channel(device, BLUETOOTH_PSM_HID_CONTROL);
+        return;
+    }
+    if (opcode == hci_disconnect.opcode){
+        sim_device_t * device = sim_device_for_con_handle(little_endian_read_16(packet, 3));
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        if (device){
+            sim_connection_closed(device);
+        }
+        event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+        event[1] = 4;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, little_endian_read_16(packet, 3));
+        event[5] = ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST;
+        sim_queue_event(event, 6);
+        return;
+    }
+    if (opcode == hci_read_remote_supported_features_command.opcode){
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        memset(event, 0, 13);
+        event[0] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+        event[1] = 11;
+        little_endian_store_16(event, 3, little_endian_read_16(packet, 3));
+        event[5 + 6] = 1 << 3;  // Secure Simple Pairing
+        sim_queue_event(event, 13);
+        return;
+    }
+    if (opcode == hci_remote_name_request.opcode){
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        memset(event, 0, 2 + 255);
+        event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+        event[1] = 255;
+        (void)memcpy(&event[3], &packet[3], 6);
+        strcpy((char *) &event[9], "Simulated HID");
+        sim_queue_event(event, 2 + 255);
+        return;
+    }
+    if ((opcode == hci_sniff_mode.opcode) || (opcode == hci_exit_sniff_mode.opcode)){
+        sim_device_t * device = sim_device_for_con_handle(little_endian_read_16(packet, 3));
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        if (device){
+            // the maximum interval is used, in 0.625 ms slots
+            device->sniff_interval_ms = (opcode == hci_sniff_mode.opcode) ? ((little_endian_read_16(packet, 5) * 5) / 8) : 0;
+            device->sniff_anchor_ms = btstack_run_loop_get_time_ms();
+        }
+        event[0] = HCI_EVENT_MODE_CHANGE;
+        event[1] = 6;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, little_endian_read_16(packet, 3));
+        event[5] = (opcode == hci_sniff_mode.opcode) ? 2 : 0;
+        little_endian_store_16(event, 6, (opcode == hci_sniff_mode.opcode) ? little_endian_read_16(packet, 5) : 0);
+        sim_queue_event(event, 8);
+        return;
+    }
+    if (opcode == hci_inquiry.opcode){
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        sim_inquiry();
+        return;
+    }
+    if (opcode == hci_inquiry_cancel.opcode){
+        sim_send_command_complete(opcode, params, 0);
+        return;
+    }
+    if (sim_handle_security_command(opcode, packet)){
+        return;
+    }
+    if ((opcode >> 10) == OGF_LINK_CONTROL){
+        // other link control commands are accepted without further events
+        sim_send_command_status(opcode, ERROR_CODE_SUCCESS);
+        return;
+    }
+
+    // settings the devices depend on
+    if (opcode == hci_write_scan_enable.opcode){
+        sim_page_scan = (packet[3] & 0x02) != 0;
+    } else if (opcode == hci_write_page_timeout.opcode){
+        sim_page_timeout_ms = little_endian_read_16(packet, 3) * 625 / 1000;
+    }
+
+    // everything else succeeds, return parameters zeroed
+    sim_send_command_complete(opcode, params, 4);
+}
+
+/**************************************************************************************************/
+
+static void hci_transport_sim_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int hci_transport_sim_open(void){
+    int i;
+    sim_queue_head = 0;
+    sim_queue_count = 0;
+    sim_num_done = 0;
+    for (i=0;i<HCI_TRANSPORT_SIM_MAX_DEVICES;i++){
+        sim_connection_closed(&sim_devices[i]);
+        memset(&sim_devices[i], 0, sizeof(sim_device_t));
+        sim_devices[i].con_handle = SIM_CON_HANDLE + i;
+    }
+    return 0;
+}
+
+static int hci_transport_sim_close(void){
+    int i;
+    btstack_run_loop_remove_timer(&sim_queue_timer);
+    btstack_run_loop_remove_timer(&sim_page_timer);
+    sim_paging = 0;
+    for (i=0;i<HCI_TRANSPORT_SIM_MAX_DEVICES;i++){
+        sim_connection_closed(&sim_devices[i]);
+    }
+    return 0;
+}
+
+static void hci_transport_sim_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static int hci_transport_sim_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return sim_queue_count < SIM_QUEUE_LEN;
+}
+
+static int hci_transport_sim_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    // asynchronous like the ESP32 VHCI transport: the packet buffer is released by this event
+    const uint8_t packet_sent[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0 };
+    sim_queue_event(packet_sent, sizeof(packet_sent));
+
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            sim_handle_command(packet, size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            sim_handle_acl(packet, size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t hci_transport_sim = {
+    /* const char * name; */                                        "SIM",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_sim_init,
+    /* int    (*open)(void); */                                     &hci_transport_sim_open,
+    /* int    (*close)(void); */                                    &hci_transport_sim_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_sim_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_sim_can_send_packet_now,
+    /* int    (*send_packet)(...); */                               &hci_transport_sim_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+const hci_transport_t * hci_transport_sim_instance(void){
+    return &hci_transport_sim;
+}
+
+void hci_transport_sim_set_script(const hci_transport_sim_script_t * script){
+    sim_script = script;
+}
+
+void hci_transport_sim_set_num_devices(uint8_t num_devices){
+    sim_num_devices = btstack_min(btstack_max(num_devices, 1), HCI_TRANSPORT_SIM_MAX_DEVICES);
+}
+
+void hci_transport_sim_set_bonded(uint8_t bonded){
+    sim_bonded = bonded;
+}
+
+void hci_transport_sim_set_pairing_failures(uint8_t failures){
+    sim_pairing_failures = failures;
+}
+
+void hci_transport_sim_register_report_handler(void (*handler)(uint8_t device, uint32_t report_index, uint64_t time_us)){
+    report_handler = handler;
+}
+
+void hci_transport_sim_register_done_handler(void (*handler)(void)){
+    done_handler = handler;
+}
+
+void hci_transport_sim_register_connected_handler(void (*handler)(uint8_t device, uint64_t time_us)){
+    connected_handler = handler;
+}
+
+uint32_t hci_transport_sim_get_sdp_connections(void){
+    return sim_sdp_connections;
+}
+
+uint32_t hci_transport_sim_get_pairings(void){
+    return sim_pairings;
+}
+
+uint32_t hci_transport_sim_get_link_key_authentications(void){
+    return sim_link_key_authentications;
+}
+
+uint32_t hci_transport_sim_get_inquiry_results(void){
+    return sim_inquiry_results;
+}
+
+uint32_t hci_transport_sim_get_pages(void){
+    return sim_pages;
+}
+
+uint32_t hci_transport_sim_get_page_timeouts(void){
+    return sim_page_timeouts;
+}
+
+uint32_t hci_transport_sim_get_connection_requests(void){
+    return sim_connection_requests;
+}
+
+uint32_t hci_transport_sim_get_connections_accepted(void){
+    return sim_connections_accepted;
+}
+
+uint32_t hci_transport_sim_get_sniff_delayed_reports(void){
+    return sim_sniff_delayed_reports;
+}
+
+uint32_t hci_transport_sim_get_sniff_delay_ms(void){
+    return sim_sniff_delay_ms;
+}
+
+uint32_t hci_transport_rx_cycles(void){
+    return sim_rx_cycles;
+}
@@ -0,0 +1,137 @@
+/*
+ * hci_transport_sim.h
+ *
+ * Simulated HCI controller for the host build: answers the HCI commands sent
+ * by BTstack, plays the remote HID devices side of inquiry, pairing, L2CAP
+ * signaling and SDP exchange, and replays scripted HID input reports on their
+ * interrupt channels.
+ */
+
+#ifndef HCI_TRANSPORT_SIM_H
+#define HCI_TRANSPORT_SIM_H
+
+#include <stdint.h>
+
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of remote devices (a BR/EDR piconet has up to 7 active devices)
+#define HCI_TRANSPORT_SIM_MAX_DEVICES 7
+
+// Largest HID report of a script (HIDP header included)
+#define HCI_TRANSPORT_SIM_MAX_REPORT_LEN 64
+
+// script steps
+#define HCI_TRANSPORT_SIM_REPORT     0  // HID report sent on the interrupt channel
+#define HCI_TRANSPORT_SIM_DISCONNECT 1  // link lost (the device waits for the host to reconnect), or device
+                                        // going to sleep if the next step is a wake up
+#define HCI_TRANSPORT_SIM_WAKE       2  // device asleep pages the host and opens its channels
+#define HCI_TRANSPORT_SIM_STEP       3  // simulation step outside the link (data given to the report handler only)
+
+typedef struct {
+    uint16_t delay_ms;  // delay before the step
+    uint8_t  type;      // HCI_TRANSPORT_SIM_*
+    uint8_t  len;
+    uint8_t  data[HCI_TRANSPORT_SIM_MAX_REPORT_LEN];
+} hci_transport_sim_report_t;
+
+typedef struct {
+    const uint8_t * hid_descriptor;
+    uint16_t        hid_descriptor_len;
+    const hci_transport_sim_report_t * reports;
+    uint32_t        num_reports;
+    uint32_t        repeat;     // number of times the report list is replayed
+} hci_transport_sim_script_t;
+
+/**
+ * @brief Get simulated transport instance
+ */
+const hci_transport_t * hci_transport_sim_instance(void);
+
+/**
+ * @brief Set script of the simulated HID device, must stay valid while running
+ */
+void hci_transport_sim_set_script(const hci_transport_sim_script_t * script);
+
+/**
+ * @brief Set number of remote devices in range (1 by default), each one replays the script once
+ * the host connected it. The devices are assigned in order to the addresses the host pages, or
+ * take their own address when answering an inquiry.
+ */
+void hci_transport_sim_set_num_devices(uint8_t num_devices);
+
+/**
+ * @brief Set whether the devices are paired from a previous run, they accept the link key of
+ * their last pairing from the start
+ */
+void hci_transport_sim_set_bonded(uint8_t bonded);
+
+/**
+ * @brief Set number of pairings refused by the devices before they accept one (0 by default), the
+ * user confirmation fails
+ */
+void hci_transport_sim_set_pairing_failures(uint8_t failures);
+
+/**
+ * @brief Register handler called after each report has been processed by the host stack
+ * @param handler with device index, report index and time the report was handed to the stack in us
+ */
+void hci_transport_sim_register_report_handler(void (*handler)(uint8_t device, uint32_t report_index, uint64_t time_us));
+
+/**
+ * @brief Register handler called once all devices have sent all reports of the script
+ */
+void hci_transport_sim_register_done_handler(void (*handler)(void));
+
+/**
+ * @brief Register handler called each time the host opened the HID interrupt channel
+ * @param handler with device index and time the channel was ready in us
+ */
+void hci_transport_sim_register_connected_handler(void (*handler)(uint8_t device, uint64_t time_us));
+
+/**
+ * @brief Get number of SDP channels opened by the host
+ */
+uint32_t hci_transport_sim_get_sdp_connections(void);
+
+/**
+ * @brief Get number of Secure Simple Pairings completed by the devices
+ */
+uint32_t hci_transport_sim_get_pairings(void);
+
+/**
+ * @brief Get number of authentications done with the link key stored on a previous pairing
+ */
+uint32_t hci_transport_sim_get_link_key_authentications(void);
+
+/**
+ * @brief Get number of inquiry results sent to the host
+ */
+uint32_t hci_transport_sim_get_inquiry_results(void);
+
+/**
+ * @brief Get number of pages by the host, and of those not answered (device asleep or out of range)
+ */
+uint32_t hci_transport_sim_get_pages(void);
+uint32_t hci_transport_sim_get_page_timeouts(void);
+
+/**
+ * @brief Get number of connections requested by devices waking up, and of those the host accepted
+ */
+uint32_t hci_transport_sim_get_connection_requests(void);
+uint32_t hci_transport_sim_get_connections_accepted(void);
+
+/**
+ * @brief Get number of reports delayed to the next anchor point of a link in sniff mode, and their total delay
+ */
+uint32_t hci_transport_sim_get_sniff_delayed_reports(void);
+uint32_t hci_transport_sim_get_sniff_delay_ms(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_TRANSPORT_SIM_H
@@ -0,0 +1,18 @@
+/* Host monotonic time */
+
+#ifndef HOST_TIME_H
+#define HOST_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Microseconds of the monotonic clock
+static inline uint64_t host_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+#endif
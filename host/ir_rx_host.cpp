@@ -0,0 +1,58 @@
+/* Host IR receiver: frames injected by the simulation */
+
+#include "ir_rx.h"
+#include "ir_rx_host.h"
+
+#include <string.h>
+
+/**************************************************************************************************/
+
+static bool ir_sampling;
+static bool ir_pending;
+static ir_rx_capture_t ir_capture;
+static uint32_t ir_num_received;
+
+/**************************************************************************************************/
+
+void ir_rx_init(const uint8_t pin)
+{
+    (void)pin;
+
+    ir_sampling = false;
+    ir_pending = false;
+    ir_num_received = 0;
+}
+
+void ir_rx_start(void)
+{
+    ir_sampling = true;
+}
+
+void ir_rx_stop(void)
+{
+    ir_sampling = false;
+    ir_pending = false;
+}
+
+bool ir_rx_poll(ir_rx_capture_t* capture)
+{
+    if(!ir_pending)
+        return false;
+    memcpy(capture, &ir_capture, sizeof(ir_rx_capture_t));
+    ir_pending = false;
+    return true;
+}
+
+void ir_rx_host_inject(const ir_rx_capture_t* capture)
+{
+    if(!ir_sampling)
+        return;
+    memcpy(&ir_capture, capture, sizeof(ir_rx_capture_t));
+    ir_pending = true;
+    ir_num_received++;
+}
+
+uint32_t ir_rx_host_get_num_received(void)
+{
+    return ir_num_received;
+}
@@ -0,0 +1,22 @@
+/* Host IR receiver: frames injected by the simulation */
+
+/*
+ * Implements the ir_rx.h API for the host build. The simulation injects the
+ * frames a remote control would send, they are returned by ir_rx_poll() while
+ * the receiver is started (frames injected while it is stopped are lost).
+ */
+
+#ifndef IR_RX_HOST_H
+#define IR_RX_HOST_H
+
+#include <stdint.h>
+
+#include "ir_rx.h"
+
+// Receive a frame (replaces the one not polled yet)
+void ir_rx_host_inject(const ir_rx_capture_t* capture);
+
+// Number of frames injected while the receiver was started
+uint32_t ir_rx_host_get_num_received(void);
+
+#endif
@@ -0,0 +1,234 @@
+/* Host IR transmitter: records frames instead of driving a pin */
+
+#include "ir_tx.h"
+#include "ir_tx_host.h"
+
+#include <string.h>
+
+#include "host_time.h"
+#include "ir_hold.h"
+#include "irRmtEncoder.h"
+#include "latency.h"
+
+/**************************************************************************************************/
+
+static ir_tx_host_event_t ir_events[IR_TX_HOST_MAX_EVENTS];
+static uint32_t ir_num_events;
+
+// Simulated transmitter timeline
+static uint64_t ir_epoch_us;
+static uint64_t ir_busy_until_us;
+static uint64_t ir_pending_start_us[IR_TX_QUEUE_LEN];
+static ir_hold_t ir_hold;
+
+static ir_tx_stats_t ir_stats;
+
+/**************************************************************************************************/
+
+static uint32_t ir_now_ms(const uint64_t time_us)
+{
+    return (uint32_t)((time_us - ir_epoch_us) / 1000);
+}
+
+// Get the NEC data of a frame waveform
+static uint32_t ir_waveform_nec_data(const ir_waveform_t* waveform)
+{
+    uint32_t data = 0;
+
+    if(waveform->len != IR_NEC_FRAME_ITEMS)
+        return 0;
+    for(uint8_t i = 1; i <= 32; i++)
+    {
+        data <<= 1;
+        if(IR_RMT_DURATION1(waveform->items[i]) > IR_NEC_BIT_MARK * 2)
+            data |= 1;
+    }
+    return data;
+}
+
+// Duration of an encoded NEC frame
+static uint32_t ir_nec_duration_us(const uint32_t data)
+{
+    uint32_t duration = IR_NEC_HDR_MARK + IR_NEC_HDR_SPACE + (33 * IR_NEC_BIT_MARK);
+
+    for(uint8_t i = 0; i < 32; i++)
+        duration += ((data >> i) & 1) ? IR_NEC_ONE_SPACE : IR_NEC_ZERO_SPACE;
+    return duration;
+}
+
+// Account the repeat bursts of the held key sent on air until given time
+static void ir_hold_advance(const uint64_t now_us)
+{
+    uint32_t due_ms;
+    uint64_t start_us;
+
+    if(ir_hold.repeat == NULL)
+        return;
+    while(1)
+    {
+        due_ms = ir_hold.last_start_ms + ir_hold.period_ms;
+        if((uint64_t)due_ms * 1000 + ir_epoch_us > now_us)
+            break;
+        start_us = (uint64_t)due_ms * 1000 + ir_epoch_us;
+        if(start_us < ir_busy_until_us)
+            start_us = ir_busy_until_us;
+        ir_hold_poll(&ir_hold, ir_now_ms(start_us));
+        // The next frame waits for the period of the burst
+        ir_busy_until_us = start_us + (uint64_t)ir_hold.period_ms * 1000;
+        ir_stats.repeats++;
+    }
+}
+
+// Number of queued frames that have not started on air yet
+static uint16_t ir_queue_depth(const uint64_t now_us)
+{
+    uint16_t depth = 0;
+
+    for(uint16_t i = 0; i < IR_TX_QUEUE_LEN; i++)
+    {
+        if(ir_pending_start_us[i] > now_us)
+            depth++;
+    }
+    return depth;
+}
+
+static bool ir_record(const ir_frame_t* frame, const uint8_t type)
+{
+    const ir_protocol_t* protocol = ir_protocol_get(frame->protocol);
+    ir_tx_host_event_t event;
+    uint64_t now_us = host_time_us();
+    uint64_t period_us;
+    uint32_t duration_us;
+    uint8_t count;
+    uint16_t depth;
+
+    if((protocol == NULL) || ((frame->protocol == IR_PROTOCOL_RAW) && (frame->waveform == NULL)))
+        return false;
+
+    // On air time of the first frame, then copies one period apart
+    period_us = protocol->period_ms * 1000;
+    count = ir_frame_count(frame);
+    if(frame->waveform != NULL)
+        duration_us = IRrmtEncoder::duration_us(frame->waveform->items, frame->waveform->len);
+    else if(frame->protocol == IR_PROTOCOL_NEC)
+        duration_us = ir_nec_duration_us(ir_frame_data(frame, false));
+    else
+        duration_us = period_us;
+
+    ir_hold_advance(now_us);
+    depth = ir_queue_depth(now_us);
+
+    memset(&event, 0, sizeof(event));
+    event.time_us = now_us;
+    event.code = (frame->waveform != NULL) ? ir_waveform_nec_data(frame->waveform) : ir_frame_data(frame, false);
+    event.protocol = frame->protocol;
+    event.type = type;
+    if(depth >= IR_TX_QUEUE_LEN)
+    {
+        event.type = IR_TX_HOST_DROPPED;
+        ir_stats.dropped++;
+    }
+    else
+    {
+        // A new frame pre-empts the repeats of the held key
+        ir_hold_stop(&ir_hold);
+        event.start_us = (now_us > ir_busy_until_us) ? now_us : ir_busy_until_us;
+        event.end_us = event.start_us + duration_us;
+        ir_busy_until_us = event.start_us + (count - 1) * period_us + duration_us;
+        if(ir_busy_until_us < event.start_us + count * period_us)
+            ir_busy_until_us = event.start_us + count * period_us;
+        ir_pending_start_us[ir_stats.enqueued % IR_TX_QUEUE_LEN] = event.start_us;
+        ir_stats.enqueued++;
+        ir_stats.sent++;
+
+        // The simulated times on air are in the future of the trace, frames queued outside of a
+        // report (macro steps) are not traced
+        if(latency_origin() != 0)
+        {
+            uint32_t cycles = latency_now() - latency_origin();
+            latency_mark(LATENCY_STAGE_IR_ENQUEUE);
+            latency_record(LATENCY_STAGE_IR_FIRST_MARK,
+                cycles + (uint32_t)(event.start_us - now_us) * LATENCY_CYCLES_PER_US);
+            latency_record(LATENCY_STAGE_IR_LAST_SPACE,
+                cycles + (uint32_t)(event.end_us - now_us) * LATENCY_CYCLES_PER_US);
+        }
+        depth++;
+        if(depth > ir_stats.max_depth)
+            ir_stats.max_depth = depth;
+        if(type == IR_TX_HOST_HOLD)
+        {
+            ir_hold_start(&ir_hold, &ir_nec_repeat_waveform, IR_NEC_REPEAT_PERIOD_MS,
+                ir_now_ms(event.start_us));
+        }
+    }
+
+    if(ir_num_events < IR_TX_HOST_MAX_EVENTS)
+        ir_events[ir_num_events++] = event;
+    return (event.type != IR_TX_HOST_DROPPED);
+}
+
+/**************************************************************************************************/
+
+void ir_tx_init(const uint8_t pin)
+{
+    (void)pin;
+
+    ir_num_events = 0;
+    ir_epoch_us = host_time_us();
+    ir_busy_until_us = 0;
+    memset(ir_pending_start_us, 0, sizeof(ir_pending_start_us));
+    memset(&ir_stats, 0, sizeof(ir_stats));
+    ir_hold_init(&ir_hold);
+    latency_init();
+}
+
+bool ir_tx_enqueue_frame(const ir_frame_t* frame)
+{
+    return ir_record(frame, IR_TX_HOST_FRAME);
+}
+
+bool ir_tx_enqueue(const uint32_t code)
+{
+    ir_frame_t frame = { IR_PROTOCOL_NEC, 32, 0, (uint16_t)(code >> 16), code & 0xFFFF, NULL };
+    return ir_record(&frame, IR_TX_HOST_FRAME);
+}
+
+bool ir_tx_enqueue_waveform(const ir_waveform_t* waveform)
+{
+    ir_frame_t frame = { IR_PROTOCOL_RAW, 0, 0, 0, 0, waveform };
+    return ir_record(&frame, IR_TX_HOST_FRAME);
+}
+
+bool ir_tx_hold(const ir_waveform_t* waveform)
+{
+    ir_frame_t frame = { IR_PROTOCOL_NEC, 32, 0, 0, 0, waveform };
+    return ir_record(&frame, IR_TX_HOST_HOLD);
+}
+
+bool ir_tx_release(void)
+{
+    ir_hold_advance(host_time_us());
+    ir_hold_stop(&ir_hold);
+    return true;
+}
+
+void ir_tx_get_stats(ir_tx_stats_t* stats)
+{
+    uint64_t now_us = host_time_us();
+
+    ir_hold_advance(now_us);
+    *stats = ir_stats;
+    stats->depth = ir_queue_depth(now_us);
+}
+
+uint32_t ir_tx_host_get_num_events(void)
+{
+    return ir_num_events;
+}
+
+const ir_tx_host_event_t* ir_tx_host_get_event(uint32_t index)
+{
+    if(index >= ir_num_events)
+        return NULL;
+    return &ir_events[index];
+}
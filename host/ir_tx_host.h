@@ -0,0 +1,47 @@
+/* Host IR transmitter: records frames instead of driving a pin */
+
+/*
+ * Implements the ir_tx.h API for the host build. Every frame is recorded with
+ * the time it was queued and the time it would start and end on air, using
+ * the same queue length, hold, repeat and frame period timing as the ESP32
+ * transmitter. Frames of protocols other than NEC are not encoded, they take
+ * the whole period of their copies on air.
+ */
+
+#ifndef IR_TX_HOST_H
+#define IR_TX_HOST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of frames recorded (later frames are only counted)
+#define IR_TX_HOST_MAX_EVENTS 65536
+
+// Recorded frame types
+#define IR_TX_HOST_FRAME    0  // Frame sent once
+#define IR_TX_HOST_HOLD     1  // Frame of a held key (followed by repeat bursts)
+#define IR_TX_HOST_DROPPED  2  // Frame rejected because the queue was full
+
+typedef struct {
+    uint64_t time_us;   // Time the frame was queued
+    uint64_t start_us;  // Simulated start of the frame on air
+    uint64_t end_us;    // Simulated end of the frame on air (repeat bursts not included)
+    uint32_t code;      // Data of the frame (ir_frame_data(), NEC data of a waveform)
+    uint8_t  protocol;  // IR_PROTOCOL_*
+    uint8_t  type;      // IR_TX_HOST_*
+} ir_tx_host_event_t;
+
+// Number of frames recorded
+uint32_t ir_tx_host_get_num_events(void);
+
+// Get a recorded frame
+const ir_tx_host_event_t* ir_tx_host_get_event(uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
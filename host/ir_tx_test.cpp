@@ -0,0 +1,309 @@
+/*
+ * ir_tx_test.cpp
+ *
+ * Hold-to-repeat test of the ESP32 IR transmitter: main/ir_tx.cpp is built as
+ * it is on the device, its FreeRTOS queue and task calls (freertos/) run on
+ * the virtual clock of the IRremote host test, and IRsend with the RMT
+ * backend records the LED timeline there. Each scenario queues key presses,
+ * frames and releases at given times from the producer side and checks when
+ * the full frames and repeat bursts start on air.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "Arduino.h"
+#include "ir_host.h"
+#include "ir_tx.h"
+#include "ir_waveform.h"
+#include "lg32ls570s.h"
+
+// Start of a burst on air may differ from the expected one by the millisecond of the clock reads
+#define IR_TX_TEST_TOLERANCE_MS 1
+
+// A scenario ends when the transmitter is idle with nothing left to queue, or this long after its
+// last step (repeats that never stop)
+#define IR_TX_TEST_TAIL_MS 1000
+
+#define IR_TX_TEST_MAX_STEPS  8
+#define IR_TX_TEST_MAX_BURSTS 64
+
+// Producer steps
+#define STEP_HOLD    0  // Key pressed, NEC frame then repeat bursts (ir_tx_hold)
+#define STEP_FRAME   1  // Frame sent once (ir_tx_enqueue)
+#define STEP_RELEASE 2  // Key released (ir_tx_release)
+
+typedef struct {
+    uint32_t at_ms;
+    uint8_t  type;
+    uint16_t code;  // LG code of the frame
+} ir_tx_test_step_t;
+
+// Burst seen on air, from the start of the first one
+typedef struct {
+    uint32_t start_ms;
+    bool     repeat;
+} ir_tx_test_burst_t;
+
+typedef struct {
+    const char*        name;
+    ir_tx_test_step_t  steps[IR_TX_TEST_MAX_STEPS];
+    uint8_t            num_steps;
+    ir_tx_test_burst_t expected[IR_TX_TEST_MAX_BURSTS];
+    uint8_t            num_expected;
+} ir_tx_test_scenario_t;
+
+// Thrown by xQueueReceive() to leave the transmitter task once the scenario is over
+struct ir_tx_test_done {};
+
+/**************************************************************************************************/
+
+// Queue of the transmitter, a single one
+
+struct host_queue {
+    uint8_t*    items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static struct host_queue tx_queue;
+static TaskFunction_t    tx_task;
+
+// Scenario being run
+static const ir_tx_test_scenario_t* scenario;
+static uint8_t       next_step;
+static unsigned long scenario_start_us;
+static unsigned long scenario_end_us;
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size)
+{
+    tx_queue.items = (uint8_t*) calloc(length, item_size);
+    tx_queue.length = length;
+    tx_queue.item_size = item_size;
+    return &tx_queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait)
+{
+    (void)wait;
+    if(queue->count == queue->length)
+        return pdFALSE;
+    memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], item,
+        queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* const name, const uint32_t stack_size,
+    void* const arg, UBaseType_t priority, TaskHandle_t* const handle, const BaseType_t core)
+{
+    (void)name;
+    (void)stack_size;
+    (void)arg;
+    (void)priority;
+    (void)handle;
+    (void)core;
+
+    // Run by each scenario
+    tx_task = task;
+    return pdTRUE;
+}
+
+// Run the producer steps due by now, as if the BTstack run loop had queued them meanwhile
+static void ir_tx_test_run_steps(void)
+{
+    while((next_step < scenario->num_steps) &&
+        (scenario_start_us + scenario->steps[next_step].at_ms * 1000UL <= irHostNow()))
+    {
+        const ir_tx_test_step_t* step = &scenario->steps[next_step++];
+        switch(step->type)
+        {
+            case STEP_HOLD:
+                ir_tx_hold(ir_waveform_lg_lookup(step->code));
+                break;
+            case STEP_FRAME:
+                ir_tx_enqueue(NEC_INIT_MASK | step->code);
+                break;
+            default:
+                ir_tx_release();
+                break;
+        }
+    }
+}
+
+// The transmitter task blocks here, the clock moves to the next step or to the end of the wait
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait)
+{
+    unsigned long wake_us;
+
+    ir_tx_test_run_steps();
+    if(queue->count == 0)
+    {
+        if((next_step == scenario->num_steps) && (wait == portMAX_DELAY))
+            throw ir_tx_test_done();
+        wake_us = (wait == portMAX_DELAY) ? scenario_end_us : irHostNow() + wait * 1000UL;
+        if(next_step < scenario->num_steps)
+        {
+            unsigned long step_us = scenario_start_us + scenario->steps[next_step].at_ms * 1000UL;
+            if(step_us < wake_us)
+                wake_us = step_us;
+        }
+        if(wake_us >= scenario_end_us)
+            throw ir_tx_test_done();
+        if(wake_us > irHostNow())
+            delayMicroseconds(wake_us - irHostNow());
+        ir_tx_test_run_steps();
+        if(queue->count == 0)
+            return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+/**************************************************************************************************/
+
+// Bursts of the recorded timeline: a 9 ms header mark followed by the 4.5 ms space of a frame or
+// the 2.25 ms one of a repeat
+static uint8_t ir_tx_test_bursts(ir_tx_test_burst_t* bursts)
+{
+    const uint32_t* durations;
+    unsigned int len = irHostTimeline(&durations);
+    unsigned long time_us = 0;
+    uint8_t count = 0;
+
+    for(unsigned int i = 0; i < len; i += 2)
+    {
+        if((durations[i] >= IR_NEC_HDR_MARK - 500) && (i + 1 < len) && (count < IR_TX_TEST_MAX_BURSTS))
+        {
+            bursts[count].start_ms = (time_us + 500) / 1000;
+            bursts[count].repeat = (durations[i + 1] < (IR_NEC_HDR_SPACE + IR_NEC_RPT_SPACE) / 2);
+            count++;
+        }
+        time_us += durations[i];
+        if(i + 1 < len)
+            time_us += durations[i + 1];
+    }
+    return count;
+}
+
+static bool ir_tx_test_run(const ir_tx_test_scenario_t* test)
+{
+    ir_tx_test_burst_t bursts[IR_TX_TEST_MAX_BURSTS];
+    uint8_t count;
+    uint8_t repeats = 0;
+    bool ok = true;
+
+    // Past the frame period of the previous scenario
+    delay(IR_TX_TEST_TAIL_MS);
+
+    scenario = test;
+    next_step = 0;
+    scenario_start_us = irHostNow();
+    scenario_end_us = scenario_start_us + (test->steps[test->num_steps - 1].at_ms + IR_TX_TEST_TAIL_MS) * 1000UL;
+    irHostReset();
+    try
+    {
+        tx_task(NULL);
+    }
+    catch(const ir_tx_test_done&)
+    {
+    }
+
+    count = ir_tx_test_bursts(bursts);
+    for(uint8_t i = 0; i < count; i++)
+    {
+        if(bursts[i].repeat)
+            repeats++;
+        if(i >= test->num_expected)
+            continue;
+        if((bursts[i].repeat != test->expected[i].repeat) ||
+            (bursts[i].start_ms + IR_TX_TEST_TOLERANCE_MS < test->expected[i].start_ms) ||
+            (bursts[i].start_ms > test->expected[i].start_ms + IR_TX_TEST_TOLERANCE_MS))
+        {
+            printf("%s: burst %u is a %s at %u ms, expected a %s at %u ms\n", test->name, i,
+                bursts[i].repeat ? "repeat" : "frame", bursts[i].start_ms,
+                test->expected[i].repeat ? "repeat" : "frame", test->expected[i].start_ms);
+            ok = false;
+        }
+    }
+    if(count != test->num_expected)
+    {
+        printf("%s: %u bursts on air, expected %u\n", test->name, count, test->num_expected);
+        ok = false;
+    }
+    printf("%-16s %u bursts, %u repeats: %s\n", test->name, count, repeats, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/**************************************************************************************************/
+
+// Full frame at 0 then repeat bursts every IR_NEC_REPEAT_PERIOD_MS until given time
+static void ir_tx_test_expect_hold(ir_tx_test_scenario_t* test, const uint32_t until_ms)
+{
+    test->expected[test->num_expected++] = { 0, false };
+    for(uint32_t t = IR_NEC_REPEAT_PERIOD_MS; t < until_ms; t += IR_NEC_REPEAT_PERIOD_MS)
+        test->expected[test->num_expected++] = { t, true };
+}
+
+int main(void)
+{
+    static ir_tx_test_scenario_t tests[5];
+    unsigned int failed = 0;
+    unsigned int i;
+
+    ir_tx_init(0);
+
+    // Held for 3 s
+    tests[0] = { "hold", { { 0, STEP_HOLD, LG_VOL_PLUS }, { 3000, STEP_RELEASE, 0 } }, 2, {}, 0 };
+    ir_tx_test_expect_hold(&tests[0], 3000);
+
+    // Released after two repeats, nothing more on air
+    tests[1] = { "release", { { 0, STEP_HOLD, LG_VOL_PLUS }, { 250, STEP_RELEASE, 0 } }, 2, {}, 0 };
+    ir_tx_test_expect_hold(&tests[1], 250);
+
+    // Another key pre-empts the repeats, its frame starts a period after the last repeat
+    tests[2] = { "preempt", { { 0, STEP_HOLD, LG_VOL_PLUS }, { 250, STEP_FRAME, LG_MUTE } }, 2, {}, 0 };
+    ir_tx_test_expect_hold(&tests[2], 250);
+    tests[2].expected[tests[2].num_expected++] = { 3 * IR_NEC_REPEAT_PERIOD_MS, false };
+
+    // Release queued behind a frame: the held key is never repeated
+    tests[3] = { "queued-release",
+        { { 0, STEP_HOLD, LG_VOL_PLUS }, { 10, STEP_FRAME, LG_MUTE }, { 20, STEP_RELEASE, 0 } }, 3, {}, 0 };
+    tests[3].expected[tests[3].num_expected++] = { 0, false };
+    tests[3].expected[tests[3].num_expected++] = { IR_NEC_REPEAT_PERIOD_MS, false };
+
+    // Release while the queue is full (IR_TX_QUEUE_LEN frames waiting), applied once it is empty
+    tests[4] = { "pending-release", {}, 0, {}, 0 };
+    for(i = 0; i < IR_TX_QUEUE_LEN - 1; i++)
+    {
+        tests[4].steps[tests[4].num_steps++] = { 0, STEP_FRAME, LG_MUTE };
+        tests[4].expected[tests[4].num_expected++] = { i * IR_NEC_REPEAT_PERIOD_MS, false };
+    }
+    tests[4].steps[tests[4].num_steps++] = { 0, STEP_HOLD, LG_VOL_PLUS };
+    tests[4].steps[tests[4].num_steps++] = { 0, STEP_RELEASE, 0 };
+    tests[4].expected[tests[4].num_expected++] = { i * IR_NEC_REPEAT_PERIOD_MS, false };
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        if(!ir_tx_test_run(&tests[i]))
+            failed++;
+    }
+
+    printf("IR transmitter hold scenarios: %s\n", failed ? "FAILED" : "passed");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,552 @@
+/*
+ * sim_main.cpp
+ *
+ * Host (posix) build of the HID to IR bridge: runs main/main.cpp on the
+ * BTstack posix run loop against a simulated HCI controller whose devices
+ * replay a HID report script concurrently, and reports IR frames, latency and
+ * throughput. In pairing mode the bridge gets no device address, it finds the
+ * devices by inquiry and pairs them, the TLV store may be kept to check they
+ * reconnect with the stored link key on the next run.
+ *
+ * Script format, one command per line ('#' starts a comment):
+ *   descriptor <hex bytes>           HID descriptor of the device (lines are appended)
+ *   report <delay ms> <hex bytes>    HID report sent on the interrupt channel (HIDP header included)
+ *   disconnect <delay ms>            link lost, the script goes on once reconnected (followed by wake:
+ *                                    device going to sleep)
+ *   wake <delay ms>                  device asleep since the disconnect wakes up and pages the bridge
+ *   learn <delay ms>                 IR learning mode started (console command i of the bridge)
+ *   ir <delay ms> nec|raw <hex>      frame of the original remote at the IR receiver, as decoded NEC
+ *                                    data or as the timing of the NEC frame (protocol not decoded)
+ *   keymap <usage> <protocol> <address> <command>
+ *                                    key of the keymap stored in TLV before the bridge starts (hex
+ *                                    values, protocol named as in ir_frame.cpp)
+ *   console <delay ms> [text]        typed in the serial console of the bridge: a single character as a
+ *                                    command key, a longer text (or none) as a line ended by Enter
+ */
+
+#define BTSTACK_FILE__ "sim_main.cpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "btstack_config.h"
+
+#include "btstack_debug.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_stdin.h"
+#include "btstack_tlv_posix.h"
+#include "classic/btstack_link_key_db_tlv.h"
+#include "hci.h"
+#include "hci_dump.h"
+
+#include "hci_transport_sim.h"
+#include "hid_pairing.h"
+#include "hid_reconnect.h"
+#include "hid_sniff.h"
+#include "keymap.h"
+#include "ir_frame.h"
+#include "ir_learn.h"
+#include "ir_macro.h"
+#include "host_time.h"
+#include "ir_tx.h"
+#include "event_log.h"
+#include "ir_rx_host.h"
+#include "ir_tx_host.h"
+#include "latency.h"
+
+#define SIM_MAX_REPORTS        1024
+#define SIM_MAX_DESCRIPTOR_LEN 512
+
+// Address of the first simulated device (the builtin one of the bridge), the others follow
+#define SIM_DEVICE_ADDR_FORMAT "3D-0E-01-16-05-%02X"
+#define SIM_DEVICE_ADDR_FIRST  0x2E
+
+extern "C" int btstack_main(int argc, const char * argv[]);
+
+static hci_transport_sim_report_t sim_reports[SIM_MAX_REPORTS];
+static uint8_t                    sim_descriptor[SIM_MAX_DESCRIPTOR_LEN];
+static hci_transport_sim_script_t sim_script;
+
+// keymap stored before the bridge starts
+static keymap_stored_key_t sim_keymap[KEYMAP_STORED_MAX_KEYS];
+static uint16_t  sim_keymap_len;
+
+static const btstack_tlv_t *      tlv_impl;
+static btstack_tlv_posix_t        tlv_context;
+
+// devices, addresses passed to the bridge
+static uint8_t   sim_num_devices = 1;
+static char      sim_device_addr[HCI_TRANSPORT_SIM_MAX_DEVICES][18];
+
+// results
+static int       sim_verbose;
+static long      sim_expected_frames = -1;
+static uint32_t  sim_reports_done;
+static uint32_t  sim_device_reports[HCI_TRANSPORT_SIM_MAX_DEVICES];
+static uint8_t   sim_reports_started;
+static uint64_t  sim_first_report_us;
+static uint64_t  sim_last_report_us;
+static uint32_t  sim_events_seen;
+static uint32_t  sim_latency_count;
+static uint64_t  sim_latency_sum_us;
+static uint64_t  sim_latency_min_us = UINT64_MAX;
+static uint64_t  sim_latency_max_us;
+static long      sim_latency_bound_us = -1;
+static long      sim_expected_sdp = -1;
+static long      sim_expected_pairings = -1;
+static long      sim_expected_accepted = -1;
+static long      sim_expected_sniff_delayed = -1;
+static long      sim_expected_learned = -1;
+static long      sim_expected_repeats = -1;
+static long      sim_expected_macros_rejected = -1;
+// script steps outside the link (first data byte)
+#define SIM_STEP_LEARN   0
+#define SIM_STEP_IR_NEC  1
+#define SIM_STEP_IR_RAW  2
+#define SIM_STEP_CONSOLE 3  // followed by the text of the line
+
+// console handler of the bridge, fed by the console steps instead of stdin
+static void (*sim_stdin_handler)(char c);
+
+static uint64_t  sim_disconnect_us[HCI_TRANSPORT_SIM_MAX_DEVICES];
+static uint32_t  sim_reconnect_count;
+static uint64_t  sim_reconnect_sum_us;
+static uint64_t  sim_reconnect_max_us;
+
+static btstack_timer_source_t     sim_watchdog;
+
+/**************************************************************************************************/
+
+static int sim_parse_hex(char * token, uint8_t * data, int max_len){
+    int len = 0;
+    char * end;
+    for (; token; token = strtok(NULL, " \t\r\n")){
+        if (len >= max_len) return -1;
+        long value = strtol(token, &end, 16);
+        if ((*end != 0) || (value < 0) || (value > 0xff)) return -1;
+        data[len++] = (uint8_t) value;
+    }
+    return len;
+}
+
+static int sim_load_script(const char * path){
+    char line[512];
+    int line_nr = 0;
+    int len;
+    FILE * file = fopen(path, "r");
+    if (!file){
+        printf("Cannot open script %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file)){
+        line_nr++;
+        char * comment = strchr(line, '#');
+        if (comment) *comment = 0;
+        char * command = strtok(line, " \t\r\n");
+        if (!command) continue;
+        if (strcmp(command, "descriptor") == 0){
+            len = sim_parse_hex(strtok(NULL, " \t\r\n"), &sim_descriptor[sim_script.hid_descriptor_len], SIM_MAX_DESCRIPTOR_LEN - sim_script.hid_descriptor_len);
+            if (len < 0) break;
+            sim_script.hid_descriptor_len += len;
+        } else if ((strcmp(command, "report") == 0) && (sim_script.num_reports < SIM_MAX_REPORTS)){
+            hci_transport_sim_report_t * report = &sim_reports[sim_script.num_reports];
+            char * delay = strtok(NULL, " \t\r\n");
+            if (!delay) break;
+            report->delay_ms = atoi(delay);
+            len = sim_parse_hex(strtok(NULL, " \t\r\n"), report->data, HCI_TRANSPORT_SIM_MAX_REPORT_LEN);
+            if (len <= 0) break;
+            report->type = HCI_TRANSPORT_SIM_REPORT;
+            report->len = len;
+            sim_script.num_reports++;
+        } else if (((strcmp(command, "disconnect") == 0) || (strcmp(command, "wake") == 0)) && (sim_script.num_reports < SIM_MAX_REPORTS)){
+            hci_transport_sim_report_t * report = &sim_reports[sim_script.num_reports];
+            report->type = (strcmp(command, "wake") == 0) ? HCI_TRANSPORT_SIM_WAKE : HCI_TRANSPORT_SIM_DISCONNECT;
+            char * delay = strtok(NULL, " \t\r\n");
+            if (!delay) break;
+            report->delay_ms = atoi(delay);
+            report->len = 0;
+            sim_script.num_reports++;
+        } else if (((strcmp(command, "learn") == 0) || (strcmp(command, "ir") == 0)) && (sim_script.num_reports < SIM_MAX_REPORTS)){
+            hci_transport_sim_report_t * report = &sim_reports[sim_script.num_reports];
+            char * delay = strtok(NULL, " \t\r\n");
+            if (!delay) break;
+            report->type = HCI_TRANSPORT_SIM_STEP;
+            report->delay_ms = atoi(delay);
+            report->data[0] = SIM_STEP_LEARN;
+            report->len = 1;
+            if (strcmp(command, "ir") == 0){
+                char * protocol = strtok(NULL, " \t\r\n");
+                char * value = strtok(NULL, " \t\r\n");
+                if (!protocol || !value) break;
+                if (strcmp(protocol, "nec") == 0) report->data[0] = SIM_STEP_IR_NEC;
+                else if (strcmp(protocol, "raw") == 0) report->data[0] = SIM_STEP_IR_RAW;
+                else break;
+                big_endian_store_32(report->data, 1, (uint32_t) strtoul(value, NULL, 16));
+                report->len = 5;
+            }
+            sim_script.num_reports++;
+        } else if ((strcmp(command, "keymap") == 0) && (sim_keymap_len < KEYMAP_STORED_MAX_KEYS)){
+            if (keymap_parse_key(strtok(NULL, "\r\n"), &sim_keymap[sim_keymap_len])) break;
+            sim_keymap_len++;
+        } else if ((strcmp(command, "console") == 0) && (sim_script.num_reports < SIM_MAX_REPORTS)){
+            hci_transport_sim_report_t * report = &sim_reports[sim_script.num_reports];
+            char * delay = strtok(NULL, " \t\r\n");
+            char * text = strtok(NULL, "\r\n");
+            if (!delay) break;
+            if (!text) text = (char *) "";
+            if (strlen(text) >= HCI_TRANSPORT_SIM_MAX_REPORT_LEN) break;
+            report->type = HCI_TRANSPORT_SIM_STEP;
+            report->delay_ms = atoi(delay);
+            report->data[0] = SIM_STEP_CONSOLE;
+            memcpy(&report->data[1], text, strlen(text));
+            report->len = 1 + strlen(text);
+            sim_script.num_reports++;
+        } else {
+            break;
+        }
+    }
+    int error = !feof(file);
+    fclose(file);
+    if (error){
+        printf("%s:%u: invalid script line\n", path, line_nr);
+        return -1;
+    }
+    sim_script.hid_descriptor = sim_descriptor;
+    sim_script.reports = sim_reports;
+    return 0;
+}
+
+/**************************************************************************************************/
+
+// Timing of a NEC frame as sampled by the IR receiver, with some jitter on each duration
+static void sim_nec_capture(uint32_t data, ir_rx_capture_t * capture){
+    uint16_t len = 0;
+    capture->durations_us[len++] = 9000;
+    capture->durations_us[len++] = 4500;
+    for (int i = 31; i >= 0; i--){
+        capture->durations_us[len++] = 560;
+        capture->durations_us[len++] = ((data >> i) & 1) ? 1690 : 560;
+    }
+    capture->durations_us[len++] = 560;
+    for (uint16_t i = 0; i < len; i++){
+        capture->durations_us[i] += ((i % 3) - 1) * 40;
+    }
+    capture->len = len;
+}
+
+void btstack_stdin_setup(void (*stdin_handler)(char c)){
+    sim_stdin_handler = stdin_handler;
+}
+
+static void sim_step(const hci_transport_sim_report_t * report){
+    ir_rx_capture_t capture;
+    if (report->data[0] == SIM_STEP_LEARN){
+        ir_learn_start();
+        return;
+    }
+    if (report->data[0] == SIM_STEP_CONSOLE){
+        for (uint16_t i = 1; i < report->len; i++){
+            (*sim_stdin_handler)((char) report->data[i]);
+        }
+        if (report->len != 2) (*sim_stdin_handler)('\n');
+        return;
+    }
+    memset(&capture, 0, sizeof(capture));
+    capture.value = big_endian_read_32(report->data, 1);
+    if (report->data[0] == SIM_STEP_IR_NEC){
+        capture.protocol = IR_RX_NEC;
+    } else {
+        capture.protocol = IR_RX_RAW;
+        sim_nec_capture(capture.value, &capture);
+    }
+    ir_rx_host_inject(&capture);
+}
+
+static void sim_report_handler(uint8_t device, uint32_t report_index, uint64_t time_us){
+    uint32_t num_events = ir_tx_host_get_num_events();
+    if (!sim_reports_started){
+        sim_reports_started = 1;
+        sim_first_report_us = time_us;
+    }
+    if (sim_reports[report_index % sim_script.num_reports].type == HCI_TRANSPORT_SIM_STEP){
+        sim_step(&sim_reports[report_index % sim_script.num_reports]);
+        event_log_drain();
+        return;
+    }
+    // reconnect time runs from the disconnect, or from the wake up if the device slept
+    if (sim_reports[report_index % sim_script.num_reports].type != HCI_TRANSPORT_SIM_REPORT){
+        sim_disconnect_us[device] = time_us;
+        return;
+    }
+    sim_last_report_us = host_time_us();
+    sim_reports_done++;
+    sim_device_reports[device]++;
+
+    // there is no log task on the host, print the records written while handling the report
+    event_log_drain();
+
+    // frames queued while the stack processed this report (those queued before by a macro have no
+    // report latency)
+    for (; sim_events_seen < num_events; sim_events_seen++){
+        const ir_tx_host_event_t * event = ir_tx_host_get_event(sim_events_seen);
+        uint64_t latency_us = event->time_us - time_us;
+        if (event->time_us < time_us){
+            if (sim_verbose){
+                printf("IR %-7s %-9s 0x%08x macro, on air %u-%u us\n", "frame",
+                    ir_protocol_get(event->protocol)->name, event->code,
+                    (unsigned) (event->start_us - sim_first_report_us), (unsigned) (event->end_us - sim_first_report_us));
+            }
+            continue;
+        }
+        sim_latency_count++;
+        sim_latency_sum_us += latency_us;
+        if (latency_us < sim_latency_min_us) sim_latency_min_us = latency_us;
+        if (latency_us > sim_latency_max_us) sim_latency_max_us = latency_us;
+        if (sim_verbose){
+            printf("IR %-7s %-9s 0x%08x device %u report %u, latency %u us, on air %u-%u us\n",
+                (event->type == IR_TX_HOST_DROPPED) ? "dropped" : (event->type == IR_TX_HOST_HOLD) ? "hold" : "frame",
+                ir_protocol_get(event->protocol)->name, event->code, device, report_index, (unsigned) latency_us,
+                (unsigned) (event->start_us - sim_first_report_us), (unsigned) (event->end_us - sim_first_report_us));
+        }
+    }
+}
+
+static void sim_connected_handler(uint8_t device, uint64_t time_us){
+    uint64_t reconnect_us;
+    if (!sim_disconnect_us[device]) return;
+    reconnect_us = time_us - sim_disconnect_us[device];
+    sim_disconnect_us[device] = 0;
+    sim_reconnect_count++;
+    sim_reconnect_sum_us += reconnect_us;
+    if (reconnect_us > sim_reconnect_max_us) sim_reconnect_max_us = reconnect_us;
+    if (sim_verbose){
+        printf("Device %u reconnected in %u us\n", device, (unsigned) reconnect_us);
+    }
+}
+
+static void sim_done_handler(void){
+    ir_tx_stats_t stats;
+    uint64_t elapsed_us = sim_last_report_us - sim_first_report_us;
+    uint32_t num_events = ir_tx_host_get_num_events();
+    int result = EXIT_SUCCESS;
+
+    event_log_drain();
+    ir_tx_get_stats(&stats);
+    printf("\nReports: %u in %u us (%.0f reports/s)\n", sim_reports_done, (unsigned) elapsed_us,
+        elapsed_us ? (sim_reports_done * 1e6 / elapsed_us) : 0.0);
+    if (sim_num_devices > 1){
+        printf("Reports per device:");
+        for (int i=0; i<sim_num_devices; i++){
+            printf(" %u", sim_device_reports[i]);
+        }
+        printf("\n");
+    }
+    printf("IR: %u frames, %u repeats, %u dropped, max queue depth %u\n", stats.enqueued,
+        stats.repeats, stats.dropped, stats.max_depth);
+    if (sim_latency_count){
+        printf("Report to IR queue latency: min %u us, avg %u us, max %u us\n",
+            (unsigned) sim_latency_min_us, (unsigned) (sim_latency_sum_us / sim_latency_count),
+            (unsigned) sim_latency_max_us);
+    }
+    if (sim_reconnect_count){
+        printf("Reconnects: %u, avg %u us, max %u us\n", sim_reconnect_count,
+            (unsigned) (sim_reconnect_sum_us / sim_reconnect_count), (unsigned) sim_reconnect_max_us);
+    }
+    printf("SDP queries: %u\n", hci_transport_sim_get_sdp_connections());
+    if (hci_transport_sim_get_inquiry_results()){
+        hid_pairing_stats_t pairing_stats;
+        hid_pairing_get_stats(&pairing_stats);
+        printf("Inquiry: %u results sent, %u received from %u devices, %u HID devices found, %u not remembered\n",
+            hci_transport_sim_get_inquiry_results(), pairing_stats.results, pairing_stats.devices,
+            pairing_stats.found, pairing_stats.overflow);
+    }
+    printf("Pairings: %u, link key authentications: %u\n", hci_transport_sim_get_pairings(),
+        hci_transport_sim_get_link_key_authentications());
+    printf("Pages: %u (%u timed out), connection requests: %u (%u accepted)\n", hci_transport_sim_get_pages(),
+        hci_transport_sim_get_page_timeouts(), hci_transport_sim_get_connection_requests(),
+        hci_transport_sim_get_connections_accepted());
+    hid_reconnect_dump();
+    printf("Sniff: %u reports delayed to the next anchor point, %u ms in total\n",
+        hci_transport_sim_get_sniff_delayed_reports(), hci_transport_sim_get_sniff_delay_ms());
+    hid_sniff_dump();
+    ir_macro_dump();
+    ir_learn_dump();
+    latency_dump();
+    if ((sim_expected_sdp >= 0) && (hci_transport_sim_get_sdp_connections() != (uint32_t) sim_expected_sdp)){
+        printf("FAILED: expected %ld SDP queries, got %u\n", sim_expected_sdp, hci_transport_sim_get_sdp_connections());
+        result = EXIT_FAILURE;
+    }
+    if ((sim_expected_pairings >= 0) && (hci_transport_sim_get_pairings() != (uint32_t) sim_expected_pairings)){
+        printf("FAILED: expected %ld pairings, got %u\n", sim_expected_pairings, hci_transport_sim_get_pairings());
+        result = EXIT_FAILURE;
+    }
+    if ((sim_expected_accepted >= 0) && (hci_transport_sim_get_connections_accepted() != (uint32_t) sim_expected_accepted)){
+        printf("FAILED: expected %ld connections accepted, got %u\n", sim_expected_accepted, hci_transport_sim_get_connections_accepted());
+        result = EXIT_FAILURE;
+    }
+    if ((sim_expected_sniff_delayed >= 0) && (hci_transport_sim_get_sniff_delayed_reports() != (uint32_t) sim_expected_sniff_delayed)){
+        printf("FAILED: expected %ld reports delayed by sniff, got %u\n", sim_expected_sniff_delayed, hci_transport_sim_get_sniff_delayed_reports());
+        result = EXIT_FAILURE;
+    }
+    if (sim_expected_learned >= 0){
+        ir_learn_stats_t learn_stats;
+        ir_learn_get_stats(&learn_stats);
+        if (learn_stats.nec + learn_stats.raw != (uint32_t) sim_expected_learned){
+            printf("FAILED: expected %ld learned keys, got %u\n", sim_expected_learned, learn_stats.nec + learn_stats.raw);
+            result = EXIT_FAILURE;
+        }
+    }
+    if (sim_expected_macros_rejected >= 0){
+        ir_macro_stats_t macro_stats;
+        ir_macro_get_stats(&macro_stats);
+        if (macro_stats.rejected != (uint32_t) sim_expected_macros_rejected){
+            printf("FAILED: expected %ld macro tables rejected, got %u\n", sim_expected_macros_rejected, macro_stats.rejected);
+            result = EXIT_FAILURE;
+        }
+    }
+    if ((sim_expected_repeats >= 0) && (stats.repeats != (uint32_t) sim_expected_repeats)){
+        printf("FAILED: expected %ld repeat bursts of held keys, got %u\n", sim_expected_repeats, stats.repeats);
+        result = EXIT_FAILURE;
+    }
+    if ((sim_latency_bound_us >= 0) && (sim_latency_max_us > (uint64_t) sim_latency_bound_us) && sim_latency_count){
+        printf("FAILED: report to IR queue latency %u us above the bound of %ld us\n", (unsigned) sim_latency_max_us, sim_latency_bound_us);
+        result = EXIT_FAILURE;
+    }
+    if ((sim_expected_frames >= 0) && (num_events != (uint32_t) sim_expected_frames)){
+        printf("FAILED: expected %ld IR frames, got %u\n", sim_expected_frames, num_events);
+        result = EXIT_FAILURE;
+    }
+    exit(result);
+}
+
+static void sim_watchdog_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    printf("FAILED: timeout, %u of %u reports sent\n", sim_reports_done, sim_script.num_reports * sim_script.repeat * sim_num_devices);
+    exit(EXIT_FAILURE);
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [-n repeat] [-m devices] [-f] [-p] [-k] [-F pairings refused] [-e expected IR frames] [-q expected SDP queries] [-P expected pairings] [-a expected connections accepted] [-s expected reports delayed by sniff] [-l expected learned keys] [-r expected repeat bursts] [-x expected macro tables rejected] [-L max latency us] [-t timeout s] [-d hci_dump.pklg] [-v] script\n", name);
+    printf("  -p: pairing mode, the bridge finds the devices by inquiry\n");
+    printf("  -L: fail if a report takes longer than this to reach the IR queue\n");
+    printf("  -F: the devices refuse this many pairings before accepting one\n");
+    printf("  -k: keep the TLV store (paired devices, link keys, SDP records) of the previous run\n");
+}
+
+int main(int argc, const char * argv[]){
+    const char * tlv_path = "/tmp/hid_ir_sim.tlv";
+    const char * pklg_path = NULL;
+    const char * bridge_argv[1 + HCI_TRANSPORT_SIM_MAX_DEVICES];
+    uint32_t timeout_s = 10;
+    int fast = 0;
+    int pairing = 0;
+    int keep_tlv = 0;
+    int pairing_failures = 0;
+    int i;
+
+    sim_script.repeat = 1;
+    for (i=1; i<argc; i++){
+        if ((strcmp(argv[i], "-n") == 0) && (i+1 < argc)){
+            sim_script.repeat = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-m") == 0) && (i+1 < argc)){
+            sim_num_devices = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-e") == 0) && (i+1 < argc)){
+            sim_expected_frames = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-q") == 0) && (i+1 < argc)){
+            sim_expected_sdp = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-P") == 0) && (i+1 < argc)){
+            sim_expected_pairings = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-a") == 0) && (i+1 < argc)){
+            sim_expected_accepted = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-s") == 0) && (i+1 < argc)){
+            sim_expected_sniff_delayed = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-l") == 0) && (i+1 < argc)){
+            sim_expected_learned = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-r") == 0) && (i+1 < argc)){
+            sim_expected_repeats = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-x") == 0) && (i+1 < argc)){
+            sim_expected_macros_rejected = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-L") == 0) && (i+1 < argc)){
+            sim_latency_bound_us = atol(argv[++i]);
+        } else if ((strcmp(argv[i], "-F") == 0) && (i+1 < argc)){
+            pairing_failures = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-t") == 0) && (i+1 < argc)){
+            timeout_s = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-d") == 0) && (i+1 < argc)){
+            pklg_path = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0){
+            fast = 1;
+        } else if (strcmp(argv[i], "-p") == 0){
+            pairing = 1;
+        } else if (strcmp(argv[i], "-k") == 0){
+            keep_tlv = 1;
+        } else if (strcmp(argv[i], "-v") == 0){
+            sim_verbose = 1;
+        } else if ((argv[i][0] != '-') && (i == argc-1)){
+            if (sim_load_script(argv[i])) return EXIT_FAILURE;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!sim_script.num_reports || !sim_num_devices || (sim_num_devices > HCI_TRANSPORT_SIM_MAX_DEVICES)){
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (fast){
+        // replay as fast as the stack processes the reports to measure throughput
+        for (i=0; i<(int) sim_script.num_reports; i++){
+            sim_reports[i].delay_ms = 0;
+        }
+    }
+
+	/// GET STARTED with BTstack ///
+	btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+
+    if (pklg_path){
+        if (strcmp(pklg_path, "-") == 0) hci_dump_open(NULL, HCI_DUMP_STDOUT); else hci_dump_open(pklg_path, HCI_DUMP_PACKETLOGGER);
+    }
+
+    // init HCI with the simulated controller
+    hci_transport_sim_set_script(&sim_script);
+    hci_transport_sim_set_num_devices(sim_num_devices);
+    hci_transport_sim_set_bonded(keep_tlv);
+    hci_transport_sim_set_pairing_failures(pairing_failures);
+    hci_transport_sim_register_report_handler(&sim_report_handler);
+    hci_transport_sim_register_done_handler(&sim_done_handler);
+    hci_transport_sim_register_connected_handler(&sim_connected_handler);
+    hci_init(hci_transport_sim_instance(), NULL);
+
+    // setup TLV and link key DB before the bridge loads its settings, start from an empty store
+    // unless asked to keep it
+    if (!keep_tlv) unlink(tlv_path);
+    tlv_impl = btstack_tlv_posix_init_instance(&tlv_context, tlv_path);
+    btstack_tlv_set_instance(tlv_impl, &tlv_context);
+    hci_set_link_key_db(btstack_link_key_db_tlv_get_instance(tlv_impl, &tlv_context));
+    if (sim_keymap_len && keymap_store(sim_keymap, sim_keymap_len)){
+        printf("Cannot store the keymap\n");
+        return EXIT_FAILURE;
+    }
+
+    btstack_run_loop_set_timer_handler(&sim_watchdog, &sim_watchdog_handler);
+    btstack_run_loop_set_timer(&sim_watchdog, timeout_s * 1000);
+    btstack_run_loop_add_timer(&sim_watchdog);
+
+    // setup app, connecting to the simulated devices (or to those it has paired)
+    bridge_argv[0] = argv[0];
+    for (i=0; i<sim_num_devices; i++){
+        snprintf(sim_device_addr[i], sizeof(sim_device_addr[i]), SIM_DEVICE_ADDR_FORMAT, SIM_DEVICE_ADDR_FIRST + i);
+        bridge_argv[1 + i] = sim_device_addr[i];
+    }
+    btstack_main(pairing ? 1 : (1 + sim_num_devices), bridge_argv);
+
+    // go
+    btstack_run_loop_execute();
+    return 0;
+}
@@ -41,7 +41,10 @@
 // I may revisit this code at a later date and look at the assembler produced
 //   in a hope of finding out what is going on, but for now they will remain as
 //   functions even in non-DEBUG mode
+// Revisited: without DEBUG they are inline functions in IRremoteInt.h, these
+//   are only the DEBUG versions
 //
+#if DEBUG
 int  MATCH (int measured,  int desired)
 {
  	DBG_PRINT(F("Testing: "));
@@ -110,21 +113,71 @@ int  MATCH_SPACE (int measured_ticks,  int desired_us)
     DBG_PRINTLN(F("?; FAILED")); 
  	return passed;
 }
+#endif // DEBUG
+
+//+=============================================================================
+// Append an entry to the frame being captured, in the ring after the frames
+// waiting to be decoded. A frame longer than RAWBUF is cut and flagged, one
+// longer than the room left in the ring is dropped when pushed.
+//
+void  IRAM_ATTR  irRingPut (unsigned int ticks)
+{
+	uint16_t  end = irRing.tickHead + irRing.len;
+
+	if (irRing.len >= RAWBUF) {
+		irRing.overflow = true;
+		return;
+	}
+	if ((uint16_t)(end - irRing.tickTail) >= IR_RING_TICKS) {
+		irRing.full = true;
+		return;
+	}
+	irRing.ticks[end & (IR_RING_TICKS - 1)] = ticks;
+	irRing.len++;
+}
+
+//+=============================================================================
+// Hand the frame captured over to decode(), or drop it if IR_RING_FRAMES are
+// already waiting or its entries did not fit. The frame head is written last,
+// decode() does not look at the frame before.
+//
+void  IRAM_ATTR  irRingPush (unsigned long time)
+{
+	uint8_t  head = irRing.frameHead;
+
+	if (irRing.full || ((uint8_t)(head - irRing.frameTail) >= IR_RING_FRAMES)) {
+		irRing.dropped++;
+	} else if (irRing.len) {
+		volatile irframe_t  *frame = &irRing.frames[head & (IR_RING_FRAMES - 1)];
+
+		frame->start    = irRing.tickHead;
+		frame->len      = irRing.len;
+		frame->overflow = irRing.overflow;
+		frame->time     = time;
+		if (irRing.overflow)  irRing.overflows++ ;
+
+		irRing.tickHead  += irRing.len;
+		irRing.frameHead  = head + 1;
+	}
+	irRing.len      = 0;
+	irRing.overflow = false;
+	irRing.full     = false;
+}
 
 //+=============================================================================
 // Interrupt Service Routine - Fires every 50uS
 // TIMER2 interrupt code to collect raw data.
-// Widths of alternating SPACE, MARK are recorded in rawbuf.
+// Widths of alternating SPACE, MARK are recorded in the capture ring.
 // Recorded in ticks of 50uS [microseconds, 0.000050 seconds]
-// 'rawlen' counts the number of entries recorded so far.
 // First entry is the SPACE between transmissions.
 // As soon as a the first [SPACE] entry gets long:
-//   Ready is set; State switches to IDLE; Timing of SPACE continues.
+//   The frame is pushed to the ring; State switches to IDLE; Timing of SPACE continues.
 // As soon as first MARK arrives:
-//   Gap width is recorded; Ready is cleared; New logging starts
+//   Gap width is recorded; New logging starts
+// The frames wait in the ring for decode(), capture goes on meanwhile.
 //
 #ifdef IR_TIMER_USE_ESP32
-void IRTimer()
+void IRAM_ATTR IRTimer()
 #else
 ISR (TIMER_INTR_NAME)
 #endif
@@ -136,7 +189,6 @@ ISR (TIMER_INTR_NAME)
 	uint8_t  irdata = (uint8_t)digitalRead(irparams.recvpin);
 
 	irparams.timer++;  // One more 50uS tick
-	if (irparams.rawlen >= RAWBUF)  irparams.rcvstate = STATE_OVERFLOW ;  // Buffer overflow
 
 	switch(irparams.rcvstate) {
 		//......................................................................
@@ -147,9 +199,7 @@ ISR (TIMER_INTR_NAME)
 
 				} else {
 					// Gap just ended; Record duration; Start recording transmission
-					irparams.overflow                  = false;
-					irparams.rawlen                    = 0;
-					irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+					irRingPut(irparams.timer);
 					irparams.timer                     = 0;
 					irparams.rcvstate                  = STATE_MARK;
 				}
@@ -158,7 +208,7 @@ ISR (TIMER_INTR_NAME)
 		//......................................................................
 		case STATE_MARK:  // Timing Mark
 			if (irdata == SPACE) {   // Mark ended; Record time
-				irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+				irRingPut(irparams.timer);
 				irparams.timer                     = 0;
 				irparams.rcvstate                  = STATE_SPACE;
 			}
@@ -166,27 +216,19 @@ ISR (TIMER_INTR_NAME)
 		//......................................................................
 		case STATE_SPACE:  // Timing Space
 			if (irdata == MARK) {  // Space just ended; Record time
-				irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+				irRingPut(irparams.timer);
 				irparams.timer                     = 0;
 				irparams.rcvstate                  = STATE_MARK;
 
 			} else if (irparams.timer > GAP_TICKS) {  // Space
 					// A long Space, indicates gap between codes
-					// Flag the current code as ready for processing
-					// Switch to STOP
+					// Push the current code for processing
+					// Switch to IDLE, ready for the next one
 					// Don't reset timer; keep counting Space width
-					irparams.rcvstate = STATE_STOP;
+					irRingPush(micros() - irparams.timer * USECPERTICK);
+					irparams.rcvstate = STATE_IDLE;
 			}
 			break;
-		//......................................................................
-		case STATE_STOP:  // Waiting; Measuring Gap
-		 	if (irdata == MARK)  irparams.timer = 0 ;  // Reset gap timer
-		 	break;
-		//......................................................................
-		case STATE_OVERFLOW:  // Flag up a read overflow; Stop the State Machine
-			irparams.overflow = true;
-			irparams.rcvstate = STATE_STOP;
-		 	break;
 	}
 
 	// If requested, flash LED while receiving IR data
@@ -22,6 +22,7 @@
 // The ISR header contains several useful macros the user may wish to use
 //
 #include "IRremoteInt.h"
+#include "irRmtEncoder.h"
 
 //------------------------------------------------------------------------------
 // Supported IR protocols
@@ -79,6 +80,12 @@
 #define DECODE_LEGO_PF       0 // NOT WRITTEN
 #define SEND_LEGO_PF         1
 
+//------------------------------------------------------------------------------
+// decode() tries NEC, then only calls the other decoders whose header timing
+// fits the frame. Uncomment to try every decoder in turn instead (same results)
+//
+//#define IR_DECODE_SEQUENTIAL
+
 //------------------------------------------------------------------------------
 // When sending a Pronto code we request to send either the "once" code
 //                                                   or the "repeat" code
@@ -139,11 +146,13 @@ decode_type_t;
 #endif
 
 //------------------------------------------------------------------------------
-// Mark & Space matching functions
+// Mark & Space matching functions (inlined from IRremoteInt.h without DEBUG)
 //
+#if DEBUG
 int  MATCH       (int measured, int desired) ;
 int  MATCH_MARK  (int measured_ticks, int desired_us) ;
 int  MATCH_SPACE (int measured_ticks, int desired_us) ;
+#endif
 
 //------------------------------------------------------------------------------
 // Results returned from the decoder
@@ -156,8 +165,10 @@ class decode_results
 		unsigned long          value;        // Decoded value [max 32-bits]
 		int                    bits;         // Number of bits in decoded value
 		volatile unsigned int  *rawbuf;      // Raw intervals in 50uS ticks
+		volatile uint16_t      *rawbufUs;    // Raw intervals in uS (RMT receiver only, NULL otherwise)
 		int                    rawlen;       // Number of records in rawbuf
 		int                    overflow;     // true iff IR raw code too long
+		unsigned long          timestamp;    // micros() at the end of the last mark
 };
 
 //------------------------------------------------------------------------------
@@ -177,11 +188,18 @@ class IRrecv
 		void  blink13    (int blinkflag) ;
 		int   decode     (decode_results *results) ;
 		void  enableIRIn ( ) ;
+		void  disableIRIn ( ) ;
 		bool  isIdle     ( ) ;
 		void  resume     ( ) ;
 
+		unsigned int  dropped   ( ) ;  // Frames lost, the capture ring was full
+		unsigned int  overflows ( ) ;  // Frames cut
+
 	private:
 		long  decodeHash (decode_results *results) ;
+#		ifndef IR_DECODE_SEQUENTIAL
+			bool  decodeByHeader (decode_results *results) ;
+#		endif
 		int   compare    (unsigned int oldval, unsigned int newval) ;
 
 		//......................................................................
@@ -259,17 +277,27 @@ class IRrecv
 class IRsend
 {
 	public:
-		IRsend(uint8_t pin){
+		IRsend(uint8_t pin)
+#		ifdef IR_SEND_USE_RMT
+			: rmt(NULL), rmtEncoder(rmtItems, IR_RMT_MAX_ITEMS)
+#		endif
+		{
 			timerPwmPin=pin;
-			IRsend ();
 		}
-		IRsend () { timerPwmPin=3; }
+		IRsend ()
+#		ifdef IR_SEND_USE_RMT
+			: rmt(NULL), rmtEncoder(rmtItems, IR_RMT_MAX_ITEMS)
+#		endif
+		{
+			timerPwmPin=3;
+		}
 
 		void  custom_delay_usec (unsigned long uSecs);
 		void  enableIROut 		(int khz) ;
 		void  mark        		(unsigned int usec) ;
 		void  space       		(unsigned int usec) ;
 		void  sendRaw     		(const unsigned int buf[],  unsigned int len,  unsigned int hz) ;
+		void  sendItems   		(const uint32_t items[],  unsigned int len,  unsigned int khz) ;
 
 		//......................................................................
 #		if SEND_RC5
@@ -281,6 +309,7 @@ class IRsend
 		//......................................................................
 #		if SEND_NEC
 			void  sendNEC        (unsigned long data,  int nbits) ;
+			void  sendNECRepeat  ( ) ;
 #		endif
 		//......................................................................
 #		if SEND_SONY
@@ -346,6 +375,16 @@ class IRsend
 
 	private:
 		uint8_t timerPwmPin;
+
+#		ifdef IR_SEND_USE_RMT
+			// Send the encoded items in one write and wait for the frame to end
+			void  rmtFlush ( ) ;
+			void  rmtSend  (const uint32_t items[],  unsigned int len) ;
+
+			rmt_obj_t     *rmt;
+			uint32_t      rmtItems[IR_RMT_MAX_ITEMS];
+			IRrmtEncoder  rmtEncoder;
+#		endif
 } ;
 
 #endif
@@ -28,6 +28,17 @@
 #	endif
 #endif
 
+//------------------------------------------------------------------------------
+// Code run from the receiver interrupt, kept in IRAM on the ESP32 so that the
+// interrupt may fire while the flash cache is disabled by a flash write
+//
+#if defined(ESP32)
+#	include <esp_attr.h>
+#endif
+#ifndef IRAM_ATTR
+#	define IRAM_ATTR
+#endif
+
 //------------------------------------------------------------------------------
 // This handles definition and access to global variables
 //
@@ -51,7 +62,7 @@ typedef
 		uint8_t       blinkflag;       // true -> enable blinking of pin on IR processing
 		uint8_t       rawlen;          // counter of entries in rawbuf
 		unsigned int  timer;           // State timer, counts 50uS ticks.
-		unsigned int  rawbuf[RAWBUF];  // raw data
+		unsigned int  rawbuf[RAWBUF];  // raw data of the frame being decoded (see irRing)
 		uint8_t       overflow;        // Raw buffer overflow occurred
 	}
 irparams_t;
@@ -110,4 +121,120 @@ EXTERN  volatile irparams_t  irparams;
 // All board specific stuff has been moved to its own file, included here.
 #include "boarddefs.h"
 
+//------------------------------------------------------------------------------
+// Without DEBUG output the match functions are inlined, and the tick limits of
+// a constant duration worked out by the compiler (see IRremote.cpp otherwise)
+//
+#if !DEBUG
+inline int  MATCH (int measured,  int desired)
+{
+	return (measured >= TICKS_LOW(desired)) && (measured <= TICKS_HIGH(desired));
+}
+
+inline int  MATCH_MARK (int measured_ticks,  int desired_us)
+{
+	return MATCH(measured_ticks, desired_us + MARK_EXCESS);
+}
+
+inline int  MATCH_SPACE (int measured_ticks,  int desired_us)
+{
+	return MATCH(measured_ticks, desired_us - MARK_EXCESS);
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Tolerance window of a duration in ticks, the same limits as MATCH_MARK and
+// MATCH_SPACE. The decoders keep a table of them per protocol, initialized at
+// compile time, and check a duration against one with a single compare.
+//
+typedef
+	struct {
+		uint16_t  low;
+		uint16_t  high;
+	}
+irWindow;
+
+#define IR_WINDOW(us)        { (uint16_t)TICKS_LOW(us), (uint16_t)TICKS_HIGH(us) }
+#define IR_MARK_WINDOW(us)   IR_WINDOW((us) + MARK_EXCESS)
+#define IR_SPACE_WINDOW(us)  IR_WINDOW((us) - MARK_EXCESS)
+
+// Below low, ticks - low wraps around to more than the window width
+inline bool  MATCH_WINDOW (unsigned int ticks,  const irWindow &window)
+{
+	return (ticks - window.low) <= (unsigned int)(window.high - window.low);
+}
+
+//+=============================================================================
+// Pulse distance bits, MSB first from rawbuf[0]: each one a mark in bitMark
+// then a space in oneSpace or zeroSpace. Returns false at the first duration
+// out of its windows, shifts the bits into *data otherwise.
+//
+inline bool  irDecodePulseDistance (volatile unsigned int *rawbuf,  int nbits,  const irWindow &bitMark,
+                                    const irWindow &oneSpace,  const irWindow &zeroSpace,  unsigned long *data)
+{
+	unsigned long  bits = *data;
+
+	for (int  i = 0;  i < nbits;  i++,  rawbuf += 2) {
+		if (!MATCH_WINDOW(rawbuf[0], bitMark))  return false ;
+
+		if      (MATCH_WINDOW(rawbuf[1], oneSpace))   bits = (bits << 1) | 1 ;
+		else if (MATCH_WINDOW(rawbuf[1], zeroSpace))  bits = (bits << 1) | 0 ;
+		else                                          return false ;
+	}
+	*data = bits;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Capture ring: frames recorded by the receiver (ISR or RMT callback, the only
+// producer) until decode() (the only consumer) takes them out into rawbuf.
+// The entries of the frames follow each other in ticks[], each frame starting
+// with the gap before it like rawbuf. Indexes run freely and are masked, the
+// producer only writes the heads and the consumer only the tails.
+//
+#define IR_RING_FRAMES  8    // Frames waiting to be decoded, power of 2
+#define IR_RING_TICKS   1024 // Entries of those frames, power of 2
+
+typedef
+	struct {
+		uint16_t       start;     // First entry (the gap) in ticks[]
+		uint16_t       len;       // Number of entries, as rawlen
+		uint8_t        overflow;  // Frame cut at RAWBUF entries
+		unsigned long  time;      // micros() at the end of the last mark
+	}
+irframe_t;
+
+typedef
+	struct {
+		unsigned int   ticks[IR_RING_TICKS];
+#		ifdef IR_RECV_USE_RMT
+		uint16_t       us[IR_RING_TICKS];      // Same entries in uS
+#		endif
+		irframe_t      frames[IR_RING_FRAMES];
+		uint16_t       tickHead;   // End of the last frame captured
+		uint16_t       tickTail;   // End of the last frame decoded
+		uint8_t        frameHead;  // Frames captured
+		uint8_t        frameTail;  // Frames decoded
+		uint16_t       len;        // Entries of the frame being captured
+		uint8_t        overflow;   // The frame being captured is cut
+		uint8_t        full;       // No room left for the frame being captured
+		unsigned int   dropped;    // Frames lost, the ring was full
+		unsigned int   overflows;  // Frames cut
+	}
+irring_t;
+
+EXTERN  volatile irring_t  irRing;
+
+// Producer side, defined next to the ISR
+void  IRAM_ATTR  irRingPut  (unsigned int ticks) ;  // Append an entry to the frame being captured
+void  IRAM_ATTR  irRingPush (unsigned long time) ;  // Hand the frame over to decode()
+
+#ifdef IR_RECV_USE_RMT
+// RMT receiver: durations of the frame being decoded in microseconds (rawbuf
+// holds them in ticks), and the end of the last frame seen to time the gap
+// before the next one
+EXTERN  volatile uint16_t       irRawbufUs[RAWBUF];
+EXTERN  volatile unsigned long  irLastFrameEnd;
+#endif
+
 #endif
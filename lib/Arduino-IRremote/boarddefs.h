@@ -146,6 +146,15 @@
 
 #elif defined(ESP32)
 	#define IR_TIMER_USE_ESP32
+	// Uncomment to send with the RMT peripheral (carrier generated in hardware,
+	// one write per frame) instead of switching LEDC duty and spinning on micros()
+	//#define IR_SEND_USE_RMT
+	// Receive with the RMT peripheral (edges timed in hardware to the microsecond,
+	// a frame handed over once the receiver is idle). Define IR_RECV_USE_TIMER to
+	// sample the receiver pin from a timer interrupt every 50us instead
+	#if !defined(IR_RECV_USE_TIMER) && !defined(IR_RECV_USE_RMT)
+		#define IR_RECV_USE_RMT
+	#endif
 #else
 // Arduino Duemilanove, Diecimila, LilyPad, Mini, Fio, Nano, etc
 // ATmega48, ATmega88, ATmega168, ATmega328
@@ -587,6 +596,16 @@
 #define TIMER_PWM_PIN  5  
 #define LEDCHANNEL 0
 
+// RMT transmitter: 1us ticks, 80MHz APB clock for the carrier duty counters. A frame is written
+// at once (the driver refills the channel memory from it), the items hold the longest one
+#define IR_RMT_MAX_ITEMS   512
+#define IR_RMT_TICK_NS     1000
+#define IR_RMT_APB_KHZ     80000
+
+// RMT receiver: same ticks, pulses shorter than the filter (APB clock cycles) are ignored, a frame
+// ends after a _GAP without edges
+#define IR_RMT_RX_FILTER   200
+
 //---------------------------------------------------------
 // Unknown Timer
 //
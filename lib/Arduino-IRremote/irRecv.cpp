@@ -3,23 +3,72 @@
 
 #ifdef IR_TIMER_USE_ESP32
 hw_timer_t *timer;
-void IRTimer(); // defined in IRremote.cpp
+void IRAM_ATTR IRTimer(); // defined in IRremote.cpp
 #endif
+
+#ifdef IR_RECV_USE_RMT
+static rmt_obj_t  *rmtRx = NULL;
+#endif
+
+//+=============================================================================
+// Take the oldest frame captured out of the ring, into rawbuf where the
+// decoders read it. The receiver keeps capturing meanwhile: the entries of
+// the frame are only given back to it once they have been copied.
+//
+static bool  irRingPop (unsigned long *time)
+{
+	uint8_t             tail = irRing.frameTail;
+	volatile irframe_t  *frame;
+
+	if (tail == irRing.frameHead)  return false ;
+	frame = &irRing.frames[tail & (IR_RING_FRAMES - 1)];
+
+	for (unsigned int  i = 0;  i < frame->len;  i++) {
+		unsigned int  index = (frame->start + i) & (IR_RING_TICKS - 1);
+
+		irparams.rawbuf[i] = irRing.ticks[index];
+#ifdef IR_RECV_USE_RMT
+		irRawbufUs[i] = irRing.us[index];
+#endif
+	}
+	irparams.rawlen   = frame->len;
+	irparams.overflow = frame->overflow;
+	*time             = frame->time;
+
+	irRing.tickTail  = frame->start + frame->len;
+	irRing.frameTail = tail + 1;
+	return true;
+}
 
 //+=============================================================================
-// Decodes the received IR message
+// Decodes the oldest IR message received
 // Returns 0 if no data ready, 1 if data ready.
-// Results of decoding are stored in results
+// Results of decoding are stored in results, until the next call: each
+// frame is decoded once, the next call goes on with the next one.
 //
 int  IRrecv::decode (decode_results *results)
 {
+	if (!irRingPop(&results->timestamp))  return false ;
+
 	results->rawbuf   = irparams.rawbuf;
 	results->rawlen   = irparams.rawlen;
+#ifdef IR_RECV_USE_RMT
+	results->rawbufUs = irRawbufUs;
+#else
+	results->rawbufUs = NULL;
+#endif
 
 	results->overflow = irparams.overflow;
 
-	if (irparams.rcvstate != STATE_STOP)  return false ;
-
+#ifndef IR_DECODE_SEQUENTIAL
+#if DECODE_NEC
+	// NEC frames and repeats first, as below, without going through the header index: its
+	// decoder starts with the header mark check already
+	if (decodeNEC(results))  return true ;
+#endif
+	// Then only the other decoders whose header fits the frame
+	if (decodeByHeader(results))  return true ;
+#else
 #if DECODE_NEC
 	DBG_PRINTLN("Attempting NEC decode");
 	if (decodeNEC(results))  return true ;
@@ -89,16 +138,139 @@ int  IRrecv::decode (decode_results *results)
 	DBG_PRINTLN("Attempting Lego Power Functions");
 	if (decodeLegoPowerFunctions(results))  return true ;
 #endif
+#endif // IR_DECODE_SEQUENTIAL
 
 	// decodeHash returns a hash on any input.
 	// Thus, it needs to be last in the list.
 	// If you add any decodes, add them before this.
 	if (decodeHash(results))  return true ;
 
-	// Throw away and start over
-	resume();
+	// Throw away, the next frame is already being captured
+	return false;
+}
+
+#ifndef IR_DECODE_SEQUENTIAL
+//+=============================================================================
+// Header timing of the decoders after NEC, in the order decode() tries them
+// The frame length, its first mark and its first space are looked at once and
+// only the decoders they fit are called: the first mark indexes the decoders
+// it can start, usually one or two. The table holds the checks each decoder
+// starts with (same timings as the ir_*.cpp files), so the result is the one
+// trying every decoder in turn would give, without walking rawbuf again for
+// each protocol that cannot match.
+//
+#define IR_HEADER_MARK_TICKS  256  // First mark index size (longer marks share the last entry)
+
+#define IR_MARK_TICKS(us)   TICKS_LOW((us) + MARK_EXCESS), TICKS_HIGH((us) + MARK_EXCESS)
+#define IR_SPACE_TICKS(us)  TICKS_LOW((us) - MARK_EXCESS), TICKS_HIGH((us) - MARK_EXCESS)
+#define IR_ANY_TICKS        0, 0xFFFF
+
+typedef
+	struct {
+		bool  (IRrecv::*decode)(decode_results *results) ;
+		int   minLen;              // rawlen the decoder accepts
+		int   maxLen;
+		int   markLow, markHigh;   // First mark (ticks)
+		int   spaceLow, spaceHigh; // First space (ticks)
+		int   gapBelow;            // Shorter gaps before the frame are taken as a repeat, whatever
+		                           // follows (0 for none)
+	}
+irDecoderHeader;
+
+bool  IRrecv::decodeByHeader (decode_results *results)
+{
+	static const irDecoderHeader  decoders[] = {
+#if DECODE_SONY
+		{ &IRrecv::decodeSony,        26, RAWBUF, IR_MARK_TICKS(2400), IR_ANY_TICKS,         500 },
+#endif
+#if DECODE_SANYO
+		{ &IRrecv::decodeSanyo,       26, RAWBUF, IR_MARK_TICKS(3500), IR_ANY_TICKS,         800 },
+#endif
+#if DECODE_MITSUBISHI
+		{ &IRrecv::decodeMitsubishi,  34, RAWBUF, IR_MARK_TICKS(350),  IR_ANY_TICKS,         0   },
+#endif
+#if DECODE_RC5
+		// First level is one to three half bits (start bits merged with the first data bit)
+		{ &IRrecv::decodeRC5,         13, RAWBUF, TICKS_LOW(889 + MARK_EXCESS), TICKS_HIGH(3 * 889 + MARK_EXCESS),
+		                                          IR_ANY_TICKS,         0   },
+#endif
+#if DECODE_RC6
+		{ &IRrecv::decodeRC6,         1,  RAWBUF, IR_MARK_TICKS(2666), IR_SPACE_TICKS(889),  0   },
+#endif
+#if DECODE_PANASONIC
+		{ &IRrecv::decodePanasonic,   0,  RAWBUF, IR_MARK_TICKS(3502), IR_MARK_TICKS(1750),  0   },  // Space matched as a mark
+#endif
+#if DECODE_LG
+		{ &IRrecv::decodeLG,          57, RAWBUF, IR_MARK_TICKS(8000), IR_SPACE_TICKS(4000), 0   },
+#endif
+#if DECODE_JVC
+		{ &IRrecv::decodeJVC,         34, 34,     IR_MARK_TICKS(600),  IR_ANY_TICKS,         0   },  // Repeat
+		{ &IRrecv::decodeJVC,         33, RAWBUF, IR_MARK_TICKS(8000), IR_SPACE_TICKS(4000), 0   },
+#endif
+#if DECODE_SAMSUNG
+		{ &IRrecv::decodeSAMSUNG,     4,  RAWBUF, IR_MARK_TICKS(5000), IR_ANY_TICKS,         0   },  // Repeat or header space
+#endif
+#if DECODE_WHYNTER
+		{ &IRrecv::decodeWhynter,     70, RAWBUF, IR_MARK_TICKS(750),  IR_SPACE_TICKS(750),  0   },
+#endif
+#if DECODE_AIWA_RC_T501
+		{ &IRrecv::decodeAiwaRCT501,  88, RAWBUF, IR_MARK_TICKS(8800), IR_SPACE_TICKS(4500), 0   },
+#endif
+#if DECODE_DENON
+		{ &IRrecv::decodeDenon,       32, 32,     IR_MARK_TICKS(300),  IR_SPACE_TICKS(750),  0   },
+#endif
+#if DECODE_LEGO_PF
+		{ &IRrecv::decodeLegoPowerFunctions, 0, RAWBUF, IR_ANY_TICKS,  IR_ANY_TICKS,         0   },
+#endif
+	};
+
+	static const int  count = sizeof(decoders) / sizeof(decoders[0]);
+	static uint32_t   byMark[IR_HEADER_MARK_TICKS];  // Decoders (bit per table entry) by first mark
+	static uint32_t   byGap;                         // Decoders taking short gaps as a repeat
+	static int        gapMax;                        // Longest of their gaps
+	static bool       indexed = false;
+
+	if (!indexed) {
+		for (int  i = 0;  i < count;  i++) {
+			for (int  t = decoders[i].markLow;  (t <= decoders[i].markHigh) && (t < IR_HEADER_MARK_TICKS);  t++)
+				byMark[t] |= 1UL << i;
+			if (decoders[i].markHigh >= IR_HEADER_MARK_TICKS - 1)  byMark[IR_HEADER_MARK_TICKS - 1] |= 1UL << i ;
+			if (decoders[i].gapBelow)  byGap |= 1UL << i ;
+			if (decoders[i].gapBelow > gapMax)  gapMax = decoders[i].gapBelow ;
+		}
+		indexed = true;
+	}
+
+	// Read as the decoders read them, whatever the frame length
+	int       len   = results->rawlen;
+	int       gap   = results->rawbuf[0];
+	int       mark  = results->rawbuf[1];
+	int       space = results->rawbuf[2];
+	uint32_t  candidates = byMark[(mark < IR_HEADER_MARK_TICKS) ? mark : (IR_HEADER_MARK_TICKS - 1)];
+
+	// Decoders taking the frame as a repeat, only after a gap short enough for them
+	if (gap < gapMax) {
+		for (uint32_t  g = byGap;  g;  g &= g - 1) {
+			int  i = __builtin_ctz(g);
+			if (gap < decoders[i].gapBelow)  candidates |= 1UL << i ;
+		}
+	}
+
+	// In table order
+	while (candidates) {
+		int                    i = __builtin_ctz(candidates);
+		const irDecoderHeader  *d = &decoders[i];
+
+		candidates &= candidates - 1;
+		if ((len < d->minLen) || (len > d->maxLen))  continue ;
+		if ((gap >= d->gapBelow)
+		    && ((mark < d->markLow) || (mark > d->markHigh) || (space < d->spaceLow) || (space > d->spaceHigh)))
+			continue ;
+		if ((this->*(d->decode))(results))  return true ;
+	}
 	return false;
 }
+#endif
 
 //+=============================================================================
 IRrecv::IRrecv (int recvpin)
@@ -117,13 +289,77 @@ IRrecv::IRrecv (int recvpin, int blinkpin)
 
 
 
+#ifdef IR_RECV_USE_RMT
+//+=============================================================================
+// Same as irRingPut(), keeping the duration in uS too
+//
+static void  IRAM_ATTR  irRingPutUs (unsigned long us)
+{
+	uint16_t  end = irRing.tickHead + irRing.len;
+
+	irRingPut((us + USECPERTICK / 2) / USECPERTICK);
+	if ((uint16_t)(irRing.tickHead + irRing.len) != end)
+		irRing.us[end & (IR_RING_TICKS - 1)] = (us > 0xFFFF) ? 0xFFFF : us;
+}
+
+//+=============================================================================
+// RMT receive callback, called with the items of a frame once the receiver
+// has been idle for _GAP (the item where it went idle has a zero duration).
+// The durations are merged per level, then pushed to the capture ring with
+// the gap since the previous frame, as the timer interrupt does. It runs from
+// the RMT interrupt, in IRAM like everything it calls.
+//
+static void  IRAM_ATTR  IRrmtReceive (uint32_t *data,  size_t len)
+{
+	static uint32_t  rxUs[RAWBUF];     // Durations of the frame, mark first
+	unsigned long    frameEnd = micros() - _GAP;
+	unsigned long    lastEnd  = irLastFrameEnd;
+	unsigned long    frameUs  = 0;
+	unsigned int     n        = 0;
+	bool             overflow = false;
+	uint8_t          level    = SPACE;
+
+	irLastFrameEnd = frameEnd;
+	for (size_t  i = 0;  i < 2 * len;  i++) {
+		uint32_t  item = data[i / 2];
+		uint32_t  us   = (i & 1) ? IR_RMT_DURATION1(item) : IR_RMT_DURATION0(item);
+		uint8_t   lvl  = (i & 1) ? IR_RMT_LEVEL1(item)    : IR_RMT_LEVEL0(item);
+
+		if (!us)  break ;
+		if (!n && (lvl == SPACE))  continue ;  // Idle before the first mark
+
+		if (n && (lvl == level)) {
+			rxUs[n - 1] += us;                 // Long duration split in items
+		} else if (n + 1 >= RAWBUF) {
+			overflow = true;
+			break;
+		} else {
+			rxUs[n++] = us;
+		}
+		level = lvl;
+	}
+
+	// Frames end with a mark
+	if (n && (level == SPACE))  n-- ;
+	if (!n)  return ;
+
+	for (unsigned int  i = 0;  i < n;  i++)  frameUs += rxUs[i] ;
+	irRingPutUs(frameEnd - frameUs - lastEnd);
+	for (unsigned int  i = 0;  i < n;  i++)  irRingPutUs(rxUs[i]) ;
+	if (overflow)  irRing.overflow = true ;
+	irRingPush(frameEnd);
+}
+#endif
+
 //+=============================================================================
 // initialization
 //
 void  IRrecv::enableIRIn ( )
 {
 // Interrupt Service Routine - Fires every 50uS
-#ifdef ESP32
+#if defined(IR_RECV_USE_RMT)
+	// No interrupt, the RMT receiver is started below
+#elif defined(ESP32)
 	// ESP32 has a proper API to setup timers, no weird chip macros needed
 	// simply call the readable API versions :)
 	// 3 timers, choose #1, 80 divider nanosecond precision, 1 to count up
@@ -148,12 +384,49 @@ void  IRrecv::enableIRIn ( )
 	sei();  // enable interrupts
 #endif
 
-	// Initialize state machine variables
+	// Initialize state machine variables, frames captured before are dropped
 	irparams.rcvstate = STATE_IDLE;
 	irparams.rawlen = 0;
+	irRing.len = 0;
+	irRing.overflow = false;
+	irRing.full = false;
+	irRing.tickTail = irRing.tickHead;
+	irRing.frameTail = irRing.frameHead;
 
 	// Set pin modes
 	pinMode(irparams.recvpin, INPUT);
+
+#ifdef IR_RECV_USE_RMT
+	// Edges timed by the RMT peripheral, the callback runs once per frame
+	if (!rmtRx) {
+		rmtRx = rmtInit(irparams.recvpin, false, RMT_MEM_192);
+		rmtSetTick(rmtRx, IR_RMT_TICK_NS);
+		rmtSetFilter(rmtRx, true, IR_RMT_RX_FILTER);
+		rmtSetRxThreshold(rmtRx, _GAP);
+	}
+	rmtRead(rmtRx, IRrmtReceive);
+#endif
+}
+
+//+=============================================================================
+// Stop the pulse clock interrupt (enableIRIn() starts it again)
+//
+void  IRrecv::disableIRIn ( )
+{
+#if defined(IR_RECV_USE_RMT)
+	if (rmtRx) {
+		rmtDeinit(rmtRx);
+		rmtRx = NULL;
+	}
+#elif defined(ESP32)
+	timerAlarmDisable(timer);
+	timerDetachInterrupt(timer);
+	timerEnd(timer);
+#else
+	cli();
+	TIMER_DISABLE_INTR;
+	sei();
+#endif
 }
 
 //+=============================================================================
@@ -173,12 +446,26 @@ bool  IRrecv::isIdle ( )
  return (irparams.rcvstate == STATE_IDLE || irparams.rcvstate == STATE_STOP) ? true : false;
 }
 //+=============================================================================
-// Restart the ISR state machine
+// Frames are taken out of the capture ring by decode() and the receiver never
+// stops, there is nothing to restart (kept for the sketches calling it)
 //
 void  IRrecv::resume ( )
 {
-	irparams.rcvstate = STATE_IDLE;
-	irparams.rawlen = 0;
+}
+
+//+=============================================================================
+// Frames lost because the capture ring was full (IR_RING_FRAMES waiting to be
+// decoded, or no room left for their entries), and frames cut (longer than
+// RAWBUF), since the receiver was created
+//
+unsigned int  IRrecv::dropped ( )
+{
+	return irRing.dropped;
+}
+
+unsigned int  IRrecv::overflows ( )
+{
+	return irRing.overflows;
 }
 
 //+=============================================================================
@@ -0,0 +1,121 @@
+//******************************************************************************
+// IRremote
+// RMT item encoder for the ESP32 hardware transmitter
+//
+// Converts the mark/space stream produced by the IRsend protocol encoders
+// into RMT items (two level/duration halves per 32-bit word, 1us per tick).
+// The carrier is generated by the RMT peripheral, so a mark is just a high
+// level half and a space a low level half.
+//
+// No Arduino or ESP-IDF dependency, so it can be built and checked on a host.
+//******************************************************************************
+
+#ifndef irRmtEncoder_h
+#define irRmtEncoder_h
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// RMT item layout (same as rmt_data_t in esp32-hal-rmt.h)
+//
+#define IR_RMT_MAX_DURATION  0x7FFF  // 15 bits duration per half item
+
+#define IR_RMT_HALF(level, us)       (((uint32_t)(level) << 15) | ((uint32_t)(us) & IR_RMT_MAX_DURATION))
+#define IR_RMT_ITEM(mark_us, space_us)  (IR_RMT_HALF(1, mark_us) | (IR_RMT_HALF(0, space_us) << 16))
+
+// Duration of each half of an item
+#define IR_RMT_DURATION0(item)  ((item) & IR_RMT_MAX_DURATION)
+#define IR_RMT_LEVEL0(item)     (((item) >> 15) & 1)
+#define IR_RMT_DURATION1(item)  (((item) >> 16) & IR_RMT_MAX_DURATION)
+#define IR_RMT_LEVEL1(item)     ((item) >> 31)
+
+//------------------------------------------------------------------------------
+// Accumulates marks and spaces into a caller provided item array.
+// Consecutive halves of the same level are merged and durations longer than
+// IR_RMT_MAX_DURATION are split, so the item array always matches the
+// requested waveform. A zero duration half terminates the transmission.
+//
+class IRrmtEncoder
+{
+	public:
+		IRrmtEncoder (uint32_t *items,  unsigned int maxItems)
+			: buf(items), size(maxItems)
+		{
+			reset();
+		}
+
+		void  reset ( )
+		{
+			count = 0;
+			halfPending = false;
+			level = 0;
+			duration = 0;
+		}
+
+		// Append a mark (carrier on) or a space (carrier off)
+		// Returns false when the item array is full
+		bool  mark  (unsigned long usec)  { return add(1, usec); }
+		bool  space (unsigned long usec)  { return add(0, usec); }
+
+		// Write the pending half and the end marker, returns number of items
+		// to send (the end marker itself is not included)
+		unsigned int  finish ( )
+		{
+			if (duration)  flushRun();
+			if (halfPending) {
+				// Terminate the odd half item with a zero duration half
+				buf[count++] &= 0xFFFF;
+				halfPending = false;
+			}
+			return count;
+		}
+
+		// Total waveform duration of the finished items in microseconds
+		static unsigned long  duration_us (const uint32_t *items,  unsigned int len)
+		{
+			unsigned long total = 0;
+			for (unsigned int i = 0;  i < len;  i++)
+				total += IR_RMT_DURATION0(items[i]) + IR_RMT_DURATION1(items[i]);
+			return total;
+		}
+
+		unsigned int  length ( )  { return count + (halfPending ? 1 : 0); }
+		bool          full   ( )  { return count >= size; }
+
+	private:
+		bool  add (uint8_t lvl,  unsigned long usec)
+		{
+			if (usec == 0)  return true;
+			if (duration && (lvl != level) && !flushRun())  return false;
+			level = lvl;
+			duration += usec;
+			return true;
+		}
+
+		// Emit the accumulated run of one level, splitting it in max size halves
+		bool  flushRun ( )
+		{
+			while (duration) {
+				unsigned long chunk = (duration > IR_RMT_MAX_DURATION) ? IR_RMT_MAX_DURATION : duration;
+				if (!halfPending) {
+					if (count >= size)  return false;
+					buf[count] = IR_RMT_HALF(level, chunk);
+					halfPending = true;
+				} else {
+					buf[count++] |= IR_RMT_HALF(level, chunk) << 16;
+					halfPending = false;
+				}
+				duration -= chunk;
+			}
+			return true;
+		}
+
+		uint32_t       *buf;
+		unsigned int   size;
+		unsigned int   count;
+		bool           halfPending;
+		uint8_t        level;
+		unsigned long  duration;
+} ;
+
+#endif
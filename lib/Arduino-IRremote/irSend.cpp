@@ -15,13 +15,46 @@ void  IRsend::sendRaw (const unsigned int buf[],  unsigned int len,  unsigned in
 	space(0);  // Always end with the LED off
 }
 
+//+=============================================================================
+// Sends a precomputed waveform given as RMT items (see irRmtEncoder.h)
+// With the RMT backend the items are written to the peripheral as they are,
+// otherwise each half item is played as a mark or space.
+//
+void  IRsend::sendItems (const uint32_t items[],  unsigned int len,  unsigned int khz)
+{
+	// Set IR carrier frequency
+	enableIROut(khz);
+
+#ifdef IR_SEND_USE_RMT
+	rmtSend(items, len);
+#else
+	for (unsigned int i = 0;  i < len;  i++) {
+		if (!IR_RMT_DURATION0(items[i]))  break ;
+		if (IR_RMT_LEVEL0(items[i]))  mark (IR_RMT_DURATION0(items[i])) ;
+		else                          space(IR_RMT_DURATION0(items[i])) ;
+		if (!IR_RMT_DURATION1(items[i]))  break ;
+		if (IR_RMT_LEVEL1(items[i]))  mark (IR_RMT_DURATION1(items[i])) ;
+		else                          space(IR_RMT_DURATION1(items[i])) ;
+	}
+#endif
+
+	space(0);  // Always end with the LED off
+}
+
 //+=============================================================================
 // Sends an IR mark for the specified number of microseconds.
 // The mark output is modulated at the PWM frequency.
 //
 void  IRsend::mark (unsigned int time)
 {
-	#ifdef ESP32
+	#ifdef IR_SEND_USE_RMT
+		// Item array full, send what we have and keep encoding
+		if (!rmtEncoder.mark(time)) {
+			rmtFlush();
+			rmtEncoder.mark(time);
+		}
+		return;
+	#elif defined(ESP32)
 		ledcWrite(LEDCHANNEL, 50);
 	#else
 		TIMER_ENABLE_PWM; // Enable pin 3 PWM output
@@ -36,7 +69,16 @@ void  IRsend::mark (unsigned int time)
 //
 void  IRsend::space (unsigned int time)
 {
-	#ifdef ESP32
+	#ifdef IR_SEND_USE_RMT
+		// A zero length space ends the frame
+		if (time == 0) {
+			rmtFlush();
+		} else if (!rmtEncoder.space(time)) {
+			rmtFlush();
+			rmtEncoder.space(time);
+		}
+		return;
+	#elif defined(ESP32)
 		ledcWrite(LEDCHANNEL, 0);
 	#else
 		TIMER_DISABLE_PWM; // Disable pin 3 PWM output
@@ -62,7 +104,16 @@ void  IRsend::space (unsigned int time)
 //
 void  IRsend::enableIROut (int khz)
 {
-#ifdef ESP32
+#if defined(IR_SEND_USE_RMT)
+	// Carrier generated by the RMT peripheral, high for a third of the period
+	uint32_t period = IR_RMT_APB_KHZ / khz;
+	if (!rmt) {
+		rmt = rmtInit(timerPwmPin, true, RMT_MEM_128);
+		rmtSetTick(rmt, IR_RMT_TICK_NS);
+	}
+	rmtSetCarrier(rmt, true, 1, period - (period / 3), period / 3);
+	rmtEncoder.reset();
+#elif defined(ESP32)
 	ledcSetup(LEDCHANNEL, khz*1000, 8);
 	ledcAttachPin(timerPwmPin, LEDCHANNEL);
 #else
@@ -81,6 +132,41 @@ void  IRsend::enableIROut (int khz)
 #endif
 }
 
+#ifdef IR_SEND_USE_RMT
+//+=============================================================================
+// Send the items encoded so far.
+// A frame longer than IR_RMT_MAX_ITEMS is split here, with the gap of a
+// write between the parts: the item array is sized so that no frame of the
+// protocol encoders (nor a usual raw one) gets there.
+//
+void  IRsend::rmtFlush ( )
+{
+	rmtSend(rmtItems, rmtEncoder.finish());
+	rmtEncoder.reset();
+}
+
+//+=============================================================================
+// Send items with a single RMT write and wait for the end of the frame.
+// Frames longer than the channel memory are refilled from the items by the
+// RMT interrupt, so they must not change before the frame ends. The write is
+// asynchronous: the task sleeps for the whole milliseconds of the frame but
+// the last one, and spins on micros() until the frame ends, so the caller
+// keeps the usual blocking semantics and the next frame starts on time.
+//
+void  IRsend::rmtSend (const uint32_t items[],  unsigned int len)
+{
+	unsigned long  start;
+	unsigned long  usec;
+
+	if (!len || !rmt)  return ;
+	usec  = IRrmtEncoder::duration_us(items, len);
+	start = micros();
+	rmtWrite(rmt, (rmt_data_t *)items, len);
+	if (usec > 2000)  delay((usec / 1000) - 1) ;
+	while ((micros() - start) < usec)  ;
+}
+#endif
+
 //+=============================================================================
 // Custom delay function that circumvents Arduino's delayMicroseconds limit
 
@@ -49,6 +49,7 @@ void  IRsend::sendDISH (unsigned long data,  int nbits)
 		}
 	}
 	mark(DISH_HDR_MARK); //added 26th March 2016, by AnalysIR ( https://www.AnalysIR.com )
+	space(0);  // Always end with the LED off
 }
 #endif
 
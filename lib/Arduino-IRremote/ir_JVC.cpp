@@ -54,15 +54,26 @@ void  IRsend::sendJVC (unsigned long data,  int nbits,  bool repeat)
 
 //+=============================================================================
 #if DECODE_JVC
+// Tick windows of the timings above
+static const struct {
+	irWindow  hdrMark, hdrSpace, bitMark, oneSpace, zeroSpace;
+} jvcTicks = {
+	IR_MARK_WINDOW (JVC_HDR_MARK),
+	IR_SPACE_WINDOW(JVC_HDR_SPACE),
+	IR_MARK_WINDOW (JVC_BIT_MARK),
+	IR_SPACE_WINDOW(JVC_ONE_SPACE),
+	IR_SPACE_WINDOW(JVC_ZERO_SPACE),
+};
+
 bool  IRrecv::decodeJVC (decode_results *results)
 {
-	long  data   = 0;
-	int   offset = 1; // Skip first space
+	unsigned long  data   = 0;
+	int            offset = 1; // Skip first space
 
 	// Check for repeat
 	if (  (irparams.rawlen - 1 == 33)
-	    && MATCH_MARK(results->rawbuf[offset], JVC_BIT_MARK)
-	    && MATCH_MARK(results->rawbuf[irparams.rawlen-1], JVC_BIT_MARK)
+	    && MATCH_WINDOW(results->rawbuf[offset], jvcTicks.bitMark)
+	    && MATCH_WINDOW(results->rawbuf[irparams.rawlen-1], jvcTicks.bitMark)
 	   ) {
 		results->bits        = 0;
 		results->value       = REPEAT;
@@ -71,24 +82,19 @@ bool  IRrecv::decodeJVC (decode_results *results)
 	}
 
 	// Initial mark
-	if (!MATCH_MARK(results->rawbuf[offset++], JVC_HDR_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], jvcTicks.hdrMark))  return false ;
 
 	if (irparams.rawlen < (2 * JVC_BITS) + 1 )  return false ;
 
 	// Initial space
-	if (!MATCH_SPACE(results->rawbuf[offset++], JVC_HDR_SPACE))  return false ;
-
-	for (int i = 0;  i < JVC_BITS;  i++) {
-		if (!MATCH_MARK(results->rawbuf[offset++], JVC_BIT_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], jvcTicks.hdrSpace))  return false ;
 
-		if      (MATCH_SPACE(results->rawbuf[offset], JVC_ONE_SPACE))   data = (data << 1) | 1 ;
-		else if (MATCH_SPACE(results->rawbuf[offset], JVC_ZERO_SPACE))  data = (data << 1) | 0 ;
-		else                                                            return false ;
-		offset++;
-	}
+	if (!irDecodePulseDistance(results->rawbuf + offset, JVC_BITS, jvcTicks.bitMark,
+	                           jvcTicks.oneSpace, jvcTicks.zeroSpace, &data))  return false ;
+	offset += 2 * JVC_BITS;
 
 	// Stop bit
-	if (!MATCH_MARK(results->rawbuf[offset], JVC_BIT_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset], jvcTicks.bitMark))  return false ;
 
 	// Success
 	results->bits        = JVC_BITS;
@@ -20,29 +20,35 @@
 
 //+=============================================================================
 #if DECODE_LG
+// Tick windows of the timings above
+static const struct {
+    irWindow  hdrMark, hdrSpace, bitMark, oneSpace, zeroSpace;
+} lgTicks = {
+    IR_MARK_WINDOW (LG_HDR_MARK),
+    IR_SPACE_WINDOW(LG_HDR_SPACE),
+    IR_MARK_WINDOW (LG_BIT_MARK),
+    IR_SPACE_WINDOW(LG_ONE_SPACE),
+    IR_SPACE_WINDOW(LG_ZERO_SPACE),
+};
+
 bool  IRrecv::decodeLG (decode_results *results)
 {
-    long  data   = 0;
-    int   offset = 1; // Skip first space
+    unsigned long  data   = 0;
+    int            offset = 1; // Skip first space
 
 	// Check we have the right amount of data
     if (irparams.rawlen < (2 * LG_BITS) + 1 )  return false ;
 
     // Initial mark/space
-    if (!MATCH_MARK(results->rawbuf[offset++], LG_HDR_MARK))  return false ;
-    if (!MATCH_SPACE(results->rawbuf[offset++], LG_HDR_SPACE))  return false ;
-
-    for (int i = 0;  i < LG_BITS;  i++) {
-        if (!MATCH_MARK(results->rawbuf[offset++], LG_BIT_MARK))  return false ;
+    if (!MATCH_WINDOW(results->rawbuf[offset++], lgTicks.hdrMark))  return false ;
+    if (!MATCH_WINDOW(results->rawbuf[offset++], lgTicks.hdrSpace))  return false ;
 
-        if      (MATCH_SPACE(results->rawbuf[offset], LG_ONE_SPACE))   data = (data << 1) | 1 ;
-        else if (MATCH_SPACE(results->rawbuf[offset], LG_ZERO_SPACE))  data = (data << 1) | 0 ;
-        else                                                           return false ;
-        offset++;
-    }
+    if (!irDecodePulseDistance(results->rawbuf + offset, LG_BITS, lgTicks.bitMark,
+                               lgTicks.oneSpace, lgTicks.zeroSpace, &data))  return false ;
+    offset += 2 * LG_BITS;
 
     // Stop bit
-    if (!MATCH_MARK(results->rawbuf[offset], LG_BIT_MARK))   return false ;
+    if (!MATCH_WINDOW(results->rawbuf[offset], lgTicks.bitMark))   return false ;
 
     // Success
     results->bits        = LG_BITS;
@@ -43,25 +43,51 @@ void  IRsend::sendNEC (unsigned long data,  int nbits)
 	mark(NEC_BIT_MARK);
 	space(0);  // Always end with the LED off
 }
+
+//+=============================================================================
+// Repeat burst sent every 108ms (from frame start) while a key is held
+//
+void  IRsend::sendNECRepeat ( )
+{
+	// Set IR carrier frequency
+	enableIROut(38);
+
+	mark(NEC_HDR_MARK);
+	space(NEC_RPT_SPACE);
+	mark(NEC_BIT_MARK);
+	space(0);  // Always end with the LED off
+}
 #endif
 
 //+=============================================================================
 // NECs have a repeat only 4 items long
 //
 #if DECODE_NEC
+// Tick windows of the timings above
+static const struct {
+	irWindow  hdrMark, hdrSpace, bitMark, oneSpace, zeroSpace, rptSpace;
+} necTicks = {
+	IR_MARK_WINDOW (NEC_HDR_MARK),
+	IR_SPACE_WINDOW(NEC_HDR_SPACE),
+	IR_MARK_WINDOW (NEC_BIT_MARK),
+	IR_SPACE_WINDOW(NEC_ONE_SPACE),
+	IR_SPACE_WINDOW(NEC_ZERO_SPACE),
+	IR_SPACE_WINDOW(NEC_RPT_SPACE),
+};
+
 bool  IRrecv::decodeNEC (decode_results *results)
 {
-	long  data   = 0;  // We decode in to here; Start with nothing
-	int   offset = 1;  // Index in to results; Skip first entry!?
+	unsigned long  data   = 0;  // We decode in to here; Start with nothing
+	int            offset = 1;  // Index in to results; Skip first entry!?
 
 	// Check header "mark"
-	if (!MATCH_MARK(results->rawbuf[offset], NEC_HDR_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset], necTicks.hdrMark))  return false ;
 	offset++;
 
 	// Check for repeat
 	if ( (irparams.rawlen == 4)
-	    && MATCH_SPACE(results->rawbuf[offset  ], NEC_RPT_SPACE)
-	    && MATCH_MARK (results->rawbuf[offset+1], NEC_BIT_MARK )
+	    && MATCH_WINDOW(results->rawbuf[offset  ], necTicks.rptSpace)
+	    && MATCH_WINDOW(results->rawbuf[offset+1], necTicks.bitMark )
 	   ) {
 		results->bits        = 0;
 		results->value       = REPEAT;
@@ -73,20 +99,12 @@ bool  IRrecv::decodeNEC (decode_results *results)
 	if (irparams.rawlen < (2 * NEC_BITS) + 4)  return false ;
 
 	// Check header "space"
-	if (!MATCH_SPACE(results->rawbuf[offset], NEC_HDR_SPACE))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset], necTicks.hdrSpace))  return false ;
 	offset++;
 
 	// Build the data
-	for (int i = 0;  i < NEC_BITS;  i++) {
-		// Check data "mark"
-		if (!MATCH_MARK(results->rawbuf[offset], NEC_BIT_MARK))  return false ;
-		offset++;
-        // Suppend this bit
-		if      (MATCH_SPACE(results->rawbuf[offset], NEC_ONE_SPACE ))  data = (data << 1) | 1 ;
-		else if (MATCH_SPACE(results->rawbuf[offset], NEC_ZERO_SPACE))  data = (data << 1) | 0 ;
-		else                                                            return false ;
-		offset++;
-	}
+	if (!irDecodePulseDistance(results->rawbuf + offset, NEC_BITS, necTicks.bitMark,
+	                           necTicks.oneSpace, necTicks.zeroSpace, &data))  return false ;
 
 	// Success
 	results->bits        = NEC_BITS;
@@ -49,19 +49,31 @@ void  IRsend::sendSAMSUNG (unsigned long data,  int nbits)
 // SAMSUNGs have a repeat only 4 items long
 //
 #if DECODE_SAMSUNG
+// Tick windows of the timings above
+static const struct {
+	irWindow  hdrMark, hdrSpace, bitMark, oneSpace, zeroSpace, rptSpace;
+} samsungTicks = {
+	IR_MARK_WINDOW (SAMSUNG_HDR_MARK),
+	IR_SPACE_WINDOW(SAMSUNG_HDR_SPACE),
+	IR_MARK_WINDOW (SAMSUNG_BIT_MARK),
+	IR_SPACE_WINDOW(SAMSUNG_ONE_SPACE),
+	IR_SPACE_WINDOW(SAMSUNG_ZERO_SPACE),
+	IR_SPACE_WINDOW(SAMSUNG_RPT_SPACE),
+};
+
 bool  IRrecv::decodeSAMSUNG (decode_results *results)
 {
-	long  data   = 0;
-	int   offset = 1;  // Skip first space
+	unsigned long  data   = 0;
+	int            offset = 1;  // Skip first space
 
 	// Initial mark
-	if (!MATCH_MARK(results->rawbuf[offset], SAMSUNG_HDR_MARK))   return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset], samsungTicks.hdrMark))   return false ;
 	offset++;
 
 	// Check for repeat
 	if (    (irparams.rawlen == 4)
-	     && MATCH_SPACE(results->rawbuf[offset], SAMSUNG_RPT_SPACE)
-	     && MATCH_MARK(results->rawbuf[offset+1], SAMSUNG_BIT_MARK)
+	     && MATCH_WINDOW(results->rawbuf[offset], samsungTicks.rptSpace)
+	     && MATCH_WINDOW(results->rawbuf[offset+1], samsungTicks.bitMark)
 	   ) {
 		results->bits        = 0;
 		results->value       = REPEAT;
@@ -71,16 +83,10 @@ bool  IRrecv::decodeSAMSUNG (decode_results *results)
 	if (irparams.rawlen < (2 * SAMSUNG_BITS) + 4)  return false ;
 
 	// Initial space
-	if (!MATCH_SPACE(results->rawbuf[offset++], SAMSUNG_HDR_SPACE))  return false ;
-
-	for (int i = 0;  i < SAMSUNG_BITS;   i++) {
-		if (!MATCH_MARK(results->rawbuf[offset++], SAMSUNG_BIT_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], samsungTicks.hdrSpace))  return false ;
 
-		if      (MATCH_SPACE(results->rawbuf[offset], SAMSUNG_ONE_SPACE))   data = (data << 1) | 1 ;
-		else if (MATCH_SPACE(results->rawbuf[offset], SAMSUNG_ZERO_SPACE))  data = (data << 1) | 0 ;
-		else                                                                return false ;
-		offset++;
-	}
+	if (!irDecodePulseDistance(results->rawbuf + offset, SAMSUNG_BITS, samsungTicks.bitMark,
+	                           samsungTicks.oneSpace, samsungTicks.zeroSpace, &data))  return false ;
 
 	// Success
 	results->bits        = SAMSUNG_BITS;
@@ -52,6 +52,7 @@ void  IRsend::sendSharpRaw (unsigned long data,  int nbits)
 
 		mark(SHARP_BIT_MARK);
 		space(SHARP_ZERO_SPACE);
+		space(0);  // Ends the frame before the pause
 		delay(40);
 
 		data = data ^ SHARP_TOGGLE_MASK;
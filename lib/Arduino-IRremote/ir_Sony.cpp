@@ -39,7 +39,7 @@ void  IRsend::sendSony (unsigned long data,  int nbits)
     	}
   	}
 
-	// We will have ended with LED off
+	space(0);  // Always end with the LED off
 }
 #endif
 
@@ -46,40 +46,47 @@ void  IRsend::sendWhynter (unsigned long data,  int nbits)
 
 	// Footer
 	mark(WHYNTER_ZERO_MARK);
-	space(WHYNTER_ZERO_SPACE);  // Always end with the LED off
+	space(WHYNTER_ZERO_SPACE);
+	space(0);  // Always end with the LED off
 }
 #endif
 
 //+=============================================================================
 #if DECODE_WHYNTER
+// Tick windows of the timings above
+static const struct {
+	irWindow  hdrMark, hdrSpace, bitMark, oneSpace, zeroSpace;
+} whynterTicks = {
+	IR_MARK_WINDOW (WHYNTER_HDR_MARK),
+	IR_SPACE_WINDOW(WHYNTER_HDR_SPACE),
+	IR_MARK_WINDOW (WHYNTER_BIT_MARK),
+	IR_SPACE_WINDOW(WHYNTER_ONE_SPACE),
+	IR_SPACE_WINDOW(WHYNTER_ZERO_SPACE),
+};
+
 bool  IRrecv::decodeWhynter (decode_results *results)
 {
-	long  data   = 0;
-	int   offset = 1;  // skip initial space
+	unsigned long  data   = 0;
+	int            offset = 1;  // skip initial space
 
 	// Check we have the right amount of data
 	if (irparams.rawlen < (2 * WHYNTER_BITS) + 6)  return false ;
 
 	// Sequence begins with a bit mark and a zero space
-	if (!MATCH_MARK (results->rawbuf[offset++], WHYNTER_BIT_MARK  ))  return false ;
-	if (!MATCH_SPACE(results->rawbuf[offset++], WHYNTER_ZERO_SPACE))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], whynterTicks.bitMark  ))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], whynterTicks.zeroSpace))  return false ;
 
 	// header mark and space
-	if (!MATCH_MARK (results->rawbuf[offset++], WHYNTER_HDR_MARK ))  return false ;
-	if (!MATCH_SPACE(results->rawbuf[offset++], WHYNTER_HDR_SPACE))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], whynterTicks.hdrMark ))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset++], whynterTicks.hdrSpace))  return false ;
 
 	// data bits
-	for (int i = 0;  i < WHYNTER_BITS;  i++) {
-		if (!MATCH_MARK(results->rawbuf[offset++], WHYNTER_BIT_MARK))  return false ;
-
-		if      (MATCH_SPACE(results->rawbuf[offset], WHYNTER_ONE_SPACE ))  data = (data << 1) | 1 ;
-		else if (MATCH_SPACE(results->rawbuf[offset], WHYNTER_ZERO_SPACE))  data = (data << 1) | 0 ;
-		else                                                                return false ;
-		offset++;
-	}
+	if (!irDecodePulseDistance(results->rawbuf + offset, WHYNTER_BITS, whynterTicks.bitMark,
+	                           whynterTicks.oneSpace, whynterTicks.zeroSpace, &data))  return false ;
+	offset += 2 * WHYNTER_BITS;
 
 	// trailing mark
-	if (!MATCH_MARK(results->rawbuf[offset], WHYNTER_BIT_MARK))  return false ;
+	if (!MATCH_WINDOW(results->rawbuf[offset], whynterTicks.bitMark))  return false ;
 
 	// Success
 	results->bits = WHYNTER_BITS;
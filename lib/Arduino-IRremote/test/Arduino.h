@@ -0,0 +1,96 @@
+//******************************************************************************
+// IRremote host test
+// Stand-in for the ESP32 Arduino core
+//
+// Just what the library uses, on a virtual clock: micros() moves forward by
+// one microsecond per call (so the spin loops of IRsend::custom_delay_usec()
+// end), delay() and delayMicroseconds() jump ahead. The LEDC duty, the RMT
+// writes and the receiver pin are backed by the timeline recorder of
+// ir_host.h.
+//******************************************************************************
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_attr.h"
+
+typedef uint8_t  byte;
+typedef bool     boolean;
+
+#define LOW     0
+#define HIGH    1
+#define INPUT   0
+#define OUTPUT  1
+
+//------------------------------------------------------------------------------
+// Clock
+//
+unsigned long  micros            ( ) ;
+unsigned long  millis            ( ) ;
+void           delay             (uint32_t ms) ;
+void           delayMicroseconds (uint32_t us) ;
+
+//------------------------------------------------------------------------------
+// GPIO
+//
+void  pinMode      (uint8_t pin,  uint8_t mode) ;
+void  digitalWrite (uint8_t pin,  uint8_t val) ;
+int   digitalRead  (uint8_t pin) ;
+
+//------------------------------------------------------------------------------
+// LEDC (carrier of the IRsend default backend)
+//
+double  ledcSetup     (uint8_t channel,  double freq,  uint8_t resolution_bits) ;
+void    ledcAttachPin (uint8_t pin,  uint8_t channel) ;
+void    ledcWrite     (uint8_t channel,  uint32_t duty) ;
+
+//------------------------------------------------------------------------------
+// RMT (IRsend backend with IR_SEND_USE_RMT, IRrecv one with IR_RECV_USE_RMT)
+//
+typedef struct rmt_obj_s  rmt_obj_t;
+
+typedef void (*rmt_rx_data_cb_t) (uint32_t *data,  size_t len) ;
+
+typedef struct {
+	uint32_t  val;
+} rmt_data_t;
+
+typedef enum {
+	RMT_MEM_64  = 1,
+	RMT_MEM_128 = 2,
+	RMT_MEM_192 = 3,
+	RMT_MEM_256 = 4,
+	RMT_MEM_320 = 5,
+	RMT_MEM_384 = 6,
+	RMT_MEM_448 = 7,
+	RMT_MEM_512 = 8,
+} rmt_reserve_memsize_t;
+
+rmt_obj_t*  rmtInit       (int pin,  bool tx_not_rx,  rmt_reserve_memsize_t memsize) ;
+float       rmtSetTick    (rmt_obj_t* rmt,  float tick) ;
+bool        rmtSetCarrier (rmt_obj_t* rmt,  bool carrier_en,  bool carrier_level,  uint32_t low,  uint32_t high) ;
+bool        rmtWrite      (rmt_obj_t* rmt,  rmt_data_t* data,  size_t size) ;
+bool        rmtSetFilter      (rmt_obj_t* rmt,  bool filter_en,  uint32_t filter_level) ;
+bool        rmtSetRxThreshold (rmt_obj_t* rmt,  uint32_t value) ;
+bool        rmtRead           (rmt_obj_t* rmt,  rmt_rx_data_cb_t cb) ;
+bool        rmtDeinit         (rmt_obj_t* rmt) ;
+
+//------------------------------------------------------------------------------
+// Hardware timer (IRrecv pulse clock, ticked by hand in the tests)
+//
+typedef struct hw_timer_s  hw_timer_t;
+
+hw_timer_t*  timerBegin           (uint8_t timer,  uint16_t divider,  bool countUp) ;
+void         timerEnd             (hw_timer_t* timer) ;
+void         timerAttachInterrupt (hw_timer_t* timer,  void (*fn)(void),  bool edge) ;
+void         timerDetachInterrupt (hw_timer_t* timer) ;
+void         timerAlarmWrite      (hw_timer_t* timer,  uint64_t interruptAt,  bool autoreload) ;
+void         timerAlarmEnable     (hw_timer_t* timer) ;
+void         timerAlarmDisable    (hw_timer_t* timer) ;
+
+#endif
@@ -0,0 +1,13 @@
+//******************************************************************************
+// IRremote host test
+// Stand-in for esp_attr.h of ESP-IDF
+//
+// Code placement attributes, nothing to place on the host.
+//******************************************************************************
+
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+
+#endif
@@ -0,0 +1,208 @@
+//******************************************************************************
+// IRremote host test
+// Encode and decode throughput per protocol
+//
+// Built for the RMT backend, where encoding a frame is the work of building its
+// items (with the LEDC one it would be the spinning on the virtual clock).
+// Decoding runs IRrecv::decode() again and again on each captured frame of the
+// test corpus, put back in the capture ring each time. ir_bench_seq is the same with IR_DECODE_SEQUENTIAL, trying every
+// decoder in turn, to compare with the header dispatch. Last, the 32 bits of
+// an NEC frame are checked against the tick windows of the decoder, and the
+// same with the tick limits worked out per call like the match functions did,
+// and the preparation of the NEC frame of an LG TV code is timed: items
+// encoded bit by bit as sendNEC() does, the precomputed frame found by a scan
+// of the codes, and found by ir_waveform_lg_lookup().
+//
+// Usage: ir_bench [frames]
+//******************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ir_cases.h"
+#include "IRremoteInt.h"
+#include "ir_waveform.h"
+#include "lg32ls570s.h"
+
+#define IR_BENCH_FRAMES  2000
+
+//+=============================================================================
+static double  seconds ( )
+{
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//+=============================================================================
+// MATCH_MARK and MATCH_SPACE as they were: out of line, floating point limits
+//
+static int __attribute__((noinline))  matchPerCall (int measured,  int desired)
+{
+	return (measured >= TICKS_LOW(desired)) && (measured <= TICKS_HIGH(desired));
+}
+
+static bool  necBitsPerCall (volatile unsigned int *rawbuf,  unsigned long *data)
+{
+	for (int  i = 0;  i < 32;  i++,  rawbuf += 2) {
+		if (!matchPerCall(rawbuf[0], 560 + MARK_EXCESS))  return false ;
+
+		if      (matchPerCall(rawbuf[1], 1690 - MARK_EXCESS))  *data = (*data << 1) | 1 ;
+		else if (matchPerCall(rawbuf[1], 560 - MARK_EXCESS))   *data = (*data << 1) | 0 ;
+		else                                                    return false ;
+	}
+	return true;
+}
+
+static const irWindow  necBitMark   = IR_MARK_WINDOW (560);
+static const irWindow  necOneSpace  = IR_SPACE_WINDOW(1690);
+static const irWindow  necZeroSpace = IR_SPACE_WINDOW(560);
+
+//+=============================================================================
+// NEC bits of the frame in rawbuf (header skipped) checked n times, in fr/s
+//
+static double  benchNecBits (volatile unsigned int *rawbuf,  int n,  bool windows)
+{
+	unsigned long  data = 0;
+	unsigned long  sum  = 0;
+	double         start = seconds();
+
+	for (int  i = 0;  i < n;  i++) {
+		data = 0;
+		if (windows)  irDecodePulseDistance(rawbuf, 32, necBitMark, necOneSpace, necZeroSpace, &data) ;
+		else          necBitsPerCall(rawbuf, &data) ;
+		sum += data;
+	}
+	if (sum != (unsigned long)n * 0x20DF10EF)  return 0 ;
+	return n / (seconds() - start);
+}
+
+//+=============================================================================
+// NEC frame of each LG code prepared n times, in fr/s
+//
+#define IR_BENCH_LG_ENCODE  0
+#define IR_BENCH_LG_SCAN    1
+#define IR_BENCH_LG_LOOKUP  2
+
+static uint16_t      lgCodes[64];
+static unsigned int  lgCodeCount;
+
+static double  benchLgPrepare (int n,  int how)
+{
+	static uint32_t  items[IR_NEC_FRAME_ITEMS];
+	IRrmtEncoder     encoder(items, IR_NEC_FRAME_ITEMS);
+	unsigned long    sum   = 0;
+	double           start = seconds();
+
+	for (int  i = 0;  i < n;  i++) {
+		for (unsigned int  c = 0;  c < lgCodeCount;  c++) {
+			volatile uint16_t  code = lgCodes[c];
+
+			if (how == IR_BENCH_LG_ENCODE) {
+				uint32_t  data = NEC_INIT_MASK | code;
+
+				encoder.reset();
+				encoder.mark(IR_NEC_HDR_MARK);
+				encoder.space(IR_NEC_HDR_SPACE);
+				for (uint32_t  mask = 1UL << 31;  mask;  mask >>= 1) {
+					encoder.mark(IR_NEC_BIT_MARK);
+					encoder.space((data & mask) ? IR_NEC_ONE_SPACE : IR_NEC_ZERO_SPACE);
+				}
+				encoder.mark(IR_NEC_BIT_MARK);
+				sum += items[encoder.finish() - 1];
+			} else if (how == IR_BENCH_LG_SCAN) {
+				for (unsigned int  j = 0;  j < lgCodeCount;  j++) {
+					if (lgCodes[j] == code) {
+						sum += ir_waveform_lg_lookup(lgCodes[j])->items[IR_NEC_FRAME_ITEMS - 1];
+						break;
+					}
+				}
+			} else {
+				sum += ir_waveform_lg_lookup(code)->items[IR_NEC_FRAME_ITEMS - 1];
+			}
+		}
+	}
+	if (sum != (unsigned long)n * lgCodeCount * IR_RMT_ITEM(IR_NEC_BIT_MARK, 0))  return 0 ;
+	return n * lgCodeCount / (seconds() - start);
+}
+
+//+=============================================================================
+int  main (int argc,  char **argv)
+{
+	IRsend          irsend(TIMER_PWM_PIN);
+	IRrecv          irrecv(0);
+	decode_results  results;
+	int             frames = (argc > 1) ? atoi(argv[1]) : IR_BENCH_FRAMES;
+	double          decodeTime = 0;
+	unsigned int    decoded = 0;
+	const uint32_t  *durations;
+	unsigned int    len;
+
+	if (frames <= 0)  frames = IR_BENCH_FRAMES ;
+	irrecv.enableIRIn();
+
+#ifdef IR_DECODE_SEQUENTIAL
+	printf("Decoders tried in turn\n");
+#else
+	printf("Decoders dispatched by header\n");
+#endif
+	printf("%-12s %14s %14s\n", "protocol", "encode fr/s", "decode fr/s");
+	for (unsigned int  i = 0;  i < irTestCaseCount;  i++) {
+		const irTestCase  &tc = irTestCases[i];
+		uint16_t          tickTail;
+		uint8_t           frameTail;
+		double            start, encode, elapsed;
+
+		start = seconds();
+		for (int  n = 0;  n < frames;  n++) {
+			irHostReset();
+			tc.send(irsend);
+		}
+		encode = frames / (seconds() - start);
+
+		if (tc.type == UNUSED) {
+			printf("%-12s %14.0f %14s\n", tc.name, encode, "-");
+			continue;
+		}
+
+		// Capture the frame once, then rewind the ring over it before each decode()
+		len = irHostTimeline(&durations);
+		tickTail  = irRing.tickTail;
+		frameTail = irRing.frameTail;
+		irHostReceive(durations, len, MARK_EXCESS);
+		start = seconds();
+		for (int  n = 0;  n < frames;  n++) {
+			irRing.tickTail  = tickTail;
+			irRing.frameTail = frameTail;
+			if (!irrecv.decode(&results))  break ;
+		}
+		elapsed = seconds() - start;
+		while (irrecv.decode(&results))  ;  // Repeats of the frame
+		if (results.decode_type != tc.type) {
+			printf("%-12s %14.0f %14s\n", tc.name, encode, "not decoded");
+			continue;
+		}
+		decodeTime += elapsed;
+		decoded += frames;
+		printf("%-12s %14.0f %14.0f\n", tc.name, encode, frames / elapsed);
+	}
+	printf("%-12s %14s %14.0f\n", "corpus", "", decoded / decodeTime);
+
+	// NEC frame of the first case, still in rawbuf once decoded
+	irHostReset();
+	irTestCases[0].send(irsend);
+	len = irHostTimeline(&durations);
+	irHostReceive(durations, len, MARK_EXCESS);
+	irrecv.decode(&results);
+	printf("nec bits     per call %9.0f, tick windows %9.0f fr/s\n",
+	       benchNecBits(results.rawbuf + 3, frames * 10, false), benchNecBits(results.rawbuf + 3, frames * 10, true));
+
+	for (uint32_t  code = 0;  (code <= 0xFFFF) && (lgCodeCount < sizeof(lgCodes) / sizeof(lgCodes[0]));  code++) {
+		if (ir_waveform_lg_lookup(code))  lgCodes[lgCodeCount++] = code ;
+	}
+	printf("lg prepare   encode %11.0f, scan %9.0f, lookup %9.0f fr/s\n", benchLgPrepare(frames * 10, IR_BENCH_LG_ENCODE),
+	       benchLgPrepare(frames * 10, IR_BENCH_LG_SCAN), benchLgPrepare(frames * 10, IR_BENCH_LG_LOOKUP));
+	return 0;
+}
@@ -0,0 +1,285 @@
+//******************************************************************************
+// IRremote host test
+// Frames sent by the tests and benchmark, with their golden timing
+//
+// The golden timelines follow the published protocol timings. Lego Power
+// Functions (timing depends on the channel and the repeat slot) and Pronto
+// (a text format on top of sendRaw) are not covered.
+//******************************************************************************
+
+#include "ir_cases.h"
+
+//+=============================================================================
+void  irGolden::mark (unsigned int usec)
+{
+	if (len & 1)  d[len - 1] += usec ;  // Last one is a mark
+	else if (len < IR_HOST_MAX_DURATIONS)  d[len++] = usec ;
+}
+
+void  irGolden::space (unsigned int usec)
+{
+	if (!len)  return ;  // Nothing to see before the first mark
+	if (!(len & 1))  d[len - 1] += usec ;
+	else if (len < IR_HOST_MAX_DURATIONS)  d[len++] = usec ;
+}
+
+void  irGolden::pulseDistance (unsigned long data,  int nbits,  unsigned int bitMark,
+                               unsigned int oneSpace,  unsigned int zeroSpace)
+{
+	for (unsigned long  mask = 1UL << (nbits - 1);  mask;  mask >>= 1) {
+		mark(bitMark);
+		space((data & mask) ? oneSpace : zeroSpace);
+	}
+}
+
+void  irGolden::pulseWidth (unsigned long data,  int nbits,  unsigned int oneMark,
+                            unsigned int zeroMark,  unsigned int bitSpace)
+{
+	for (unsigned long  mask = 1UL << (nbits - 1);  mask;  mask >>= 1) {
+		mark((data & mask) ? oneMark : zeroMark);
+		space(bitSpace);
+	}
+}
+
+void  irGolden::manchester (bool markFirst,  unsigned int usec)
+{
+	if (markFirst) {
+		mark(usec);
+		space(usec);
+	} else {
+		space(usec);
+		mark(usec);
+	}
+}
+
+//+=============================================================================
+// Golden timelines
+//
+static void  nec (irGolden &g,  unsigned long data)
+{
+	g.mark(9000);
+	g.space(4500);
+	g.pulseDistance(data, 32, 560, 1690, 560);
+	g.mark(560);
+}
+
+static void  sony (irGolden &g,  unsigned long data,  int nbits)
+{
+	g.mark(2400);
+	g.space(600);
+	g.pulseWidth(data, nbits, 1200, 600, 600);
+}
+
+static void  rc5 (irGolden &g,  unsigned long data,  int nbits)
+{
+	// Two start bits, the space of the first one is not seen
+	g.mark(889);
+	g.manchester(false, 889);
+	for (unsigned long  mask = 1UL << (nbits - 1);  mask;  mask >>= 1)
+		g.manchester(!(data & mask), 889);
+}
+
+static void  rc6 (irGolden &g,  unsigned long data,  int nbits)
+{
+	g.mark(2666);
+	g.space(889);
+	g.manchester(true, 444);  // Start bit
+	for (int  i = 1;  i <= nbits;  i++)
+		g.manchester((data >> (nbits - i)) & 1, (i == 4) ? 888 : 444);  // Double width trailer bit
+}
+
+static void  headerPulseDistance (irGolden &g,  unsigned int hdrMark,  unsigned int hdrSpace,
+                                  unsigned long data,  int nbits,  unsigned int bitMark,
+                                  unsigned int oneSpace,  unsigned int zeroSpace)
+{
+	g.mark(hdrMark);
+	g.space(hdrSpace);
+	g.pulseDistance(data, nbits, bitMark, oneSpace, zeroSpace);
+	g.mark(bitMark);
+}
+
+static void  sharpFrame (irGolden &g,  unsigned long data)
+{
+	g.pulseDistance(data, 15, 245, 1805, 795);
+	g.mark(245);
+	g.space(795 + 40000);
+}
+
+static const unsigned int  rawFrame[] = { 9000, 4500, 560, 560, 560, 1690, 560, 1690, 560 };
+
+// Air conditioner state, 18 bytes after the header: more items than the RMT
+// channel memory holds
+#define RAW_LONG_BYTES  18
+
+static unsigned int  rawLongFrame[2 + RAW_LONG_BYTES * 16 + 1];
+
+static const unsigned int  *rawLong ( )
+{
+	unsigned int  *p = rawLongFrame;
+
+	*p++ = 3400;
+	*p++ = 1750;
+	for (unsigned int  i = 0;  i < RAW_LONG_BYTES;  i++) {
+		for (unsigned int  mask = 0x80;  mask;  mask >>= 1) {
+			*p++ = 450;
+			*p++ = ((0x5A ^ (i * 0x1D)) & mask) ? 1300 : 420;
+		}
+	}
+	*p = 450;
+	return rawLongFrame;
+}
+
+static void  raw (irGolden &g,  const unsigned int buf[],  unsigned int len)
+{
+	for (unsigned int  i = 0;  i < len;  i++) {
+		if (i & 1)  g.space(buf[i]) ;
+		else        g.mark (buf[i]) ;
+	}
+}
+
+//+=============================================================================
+// Frames
+//
+const irTestCase  irTestCases[] = {
+	{
+		"nec", 38,
+		[](IRsend &s) { s.sendNEC(0x20DF10EF, 32); },
+		[](irGolden &g) { nec(g, 0x20DF10EF); },
+		NEC, 0x20DF10EF, 32, 0
+	},
+	{
+		"nec-repeat", 38,
+		[](IRsend &s) { s.sendNECRepeat(); },
+		[](irGolden &g) { g.mark(9000);  g.space(2250);  g.mark(560); },
+		NEC, REPEAT, 0, 0
+	},
+	{
+		"sony12", 40,
+		[](IRsend &s) { s.sendSony(0xA90, 12); },
+		[](irGolden &g) { sony(g, 0xA90, 12); },
+		SONY, 0xA90, 12, 0
+	},
+	{
+		"sony20", 40,
+		[](IRsend &s) { s.sendSony(0x6B47A, 20); },
+		[](irGolden &g) { sony(g, 0x6B47A, 20); },
+		SONY, 0x6B47A, 20, 0
+	},
+	{
+		"rc5", 36,
+		[](IRsend &s) { s.sendRC5(0x80C, 12); },
+		[](irGolden &g) { rc5(g, 0x80C, 12); },
+		RC5, 0x80C, 12, 0
+	},
+	{
+		"rc6", 36,
+		[](IRsend &s) { s.sendRC6(0x1000C, 20); },
+		[](irGolden &g) { rc6(g, 0x1000C, 20); },
+		RC6, 0x1000C, 20, 0
+	},
+	{
+		"panasonic", 35,
+		[](IRsend &s) { s.sendPanasonic(0x4004, 0x0100BCBD); },
+		[](irGolden &g) {
+			g.mark(3502);
+			g.space(1750);
+			g.pulseDistance(0x4004, 16, 502, 1244, 400);
+			g.pulseDistance(0x0100BCBD, 32, 502, 1244, 400);
+			g.mark(502);
+		},
+		PANASONIC, 0x0100BCBD, 48, 0x4004
+	},
+	{
+		"jvc", 38,
+		[](IRsend &s) { s.sendJVC(0xC2D0, 16, false); },
+		[](irGolden &g) { headerPulseDistance(g, 8000, 4000, 0xC2D0, 16, 600, 1600, 550); },
+		JVC, 0xC2D0, 16, 0
+	},
+	{
+		"jvc-repeat", 38,
+		[](IRsend &s) { s.sendJVC(0xC2D0, 16, true); },
+		[](irGolden &g) {
+			g.pulseDistance(0xC2D0, 16, 600, 1600, 550);
+			g.mark(600);
+		},
+		JVC, REPEAT, 0, 0
+	},
+	{
+		"samsung", 38,
+		[](IRsend &s) { s.sendSAMSUNG(0xE0E040BF, 32); },
+		[](irGolden &g) { headerPulseDistance(g, 5000, 5000, 0xE0E040BF, 32, 560, 1600, 560); },
+		SAMSUNG, 0xE0E040BF, 32, 0
+	},
+	{
+		"lg", 38,
+		[](IRsend &s) { s.sendLG(0x8800347, 28); },
+		[](irGolden &g) { headerPulseDistance(g, 8000, 4000, 0x8800347, 28, 600, 1600, 550); },
+		LG, 0x8800347, 28, 0
+	},
+	{
+		"denon", 38,
+		[](IRsend &s) { s.sendDenon(0x2A4C, 14); },
+		[](irGolden &g) { headerPulseDistance(g, 300, 750, 0x2A4C, 14, 300, 1800, 750); },
+		DENON, 0x2A4C, 14, 0
+	},
+	{
+		"whynter", 38,
+		[](IRsend &s) { s.sendWhynter(0x87654321, 32); },
+		[](irGolden &g) {
+			g.mark(750);
+			g.space(750);
+			headerPulseDistance(g, 2850, 2850, 0x87654321, 32, 750, 2150, 750);
+		},
+		WHYNTER, 0x87654321, 32, 0
+	},
+	{
+		// The encoder sends bits 30 to 16 of the code. NEC is tried first and takes the frame
+		// (same header, same bit timings with 0 and 1 swapped)
+		"aiwa", 38,
+		[](IRsend &s) { s.sendAiwaRCT501(0x01A50000); },
+		[](irGolden &g) {
+			g.mark(8800);
+			g.space(4500);
+			g.pulseDistance(0x0227EEC0, 26, 500, 600, 1700);
+			g.pulseDistance(0x01A5, 15, 500, 600, 1700);
+			g.pulseDistance(0, 1, 500, 600, 1700);
+			g.mark(500);
+		},
+		NEC, 0x76044FFF, 32, 0
+	},
+	{
+		// Normal, inverted and normal frames
+		"sharp", 38,
+		[](IRsend &s) { s.sendSharp(0x11, 0x5B); },
+		[](irGolden &g) {
+			unsigned long  data = (0x11 << 10) | (0x5B << 2) | 2;
+			sharpFrame(g, data);
+			sharpFrame(g, data ^ 0x3FF);
+			sharpFrame(g, data);
+		},
+		UNUSED, 0, 0, 0
+	},
+	{
+		// Header space longer than the gap IRrecv waits for
+		"dish", 56,
+		[](IRsend &s) { s.sendDISH(0x9C00, 16); },
+		[](irGolden &g) { headerPulseDistance(g, 400, 6100, 0x9C00, 16, 400, 1700, 2800); },
+		UNUSED, 0, 0, 0
+	},
+	{
+		// NEC header and three bits, no decoder takes it
+		"raw", 38,
+		[](IRsend &s) { s.sendRaw(rawFrame, sizeof(rawFrame) / sizeof(rawFrame[0]), 38); },
+		[](irGolden &g) { raw(g, rawFrame, sizeof(rawFrame) / sizeof(rawFrame[0])); },
+		UNKNOWN, 0x9D334F57, 32, 0
+	},
+	{
+		// Longer than the capture buffer of IRrecv, only the timing is checked
+		"raw-long", 38,
+		[](IRsend &s) { s.sendRaw(rawLong(), sizeof(rawLongFrame) / sizeof(rawLongFrame[0]), 38); },
+		[](irGolden &g) { raw(g, rawLong(), sizeof(rawLongFrame) / sizeof(rawLongFrame[0])); },
+		UNUSED, 0, 0, 0
+	},
+};
+
+const unsigned int  irTestCaseCount = sizeof(irTestCases) / sizeof(irTestCases[0]);
@@ -0,0 +1,63 @@
+//******************************************************************************
+// IRremote host test
+// Frames sent by the tests and benchmark, with their golden timing
+//******************************************************************************
+
+#ifndef ir_cases_h
+#define ir_cases_h
+
+#include "IRremote.h"
+#include "ir_host.h"
+
+//------------------------------------------------------------------------------
+// Expected timeline of a frame, written from the protocol descriptions (and
+// not from the encoders) with the same conventions as the recorder: mark
+// first, levels merged, no space after the last mark.
+//
+class irGolden
+{
+	public:
+		irGolden ( ) : len(0)  { }
+
+		void  mark  (unsigned int usec) ;
+		void  space (unsigned int usec) ;
+
+		// Bits MSB first, each one a mark then a space telling its value
+		void  pulseDistance (unsigned long data,  int nbits,  unsigned int bitMark,
+		                     unsigned int oneSpace,  unsigned int zeroSpace) ;
+
+		// Bits MSB first, each one a mark then a space of different lengths
+		void  pulseWidth (unsigned long data,  int nbits,  unsigned int oneMark,
+		                  unsigned int zeroMark,  unsigned int bitSpace) ;
+
+		// Bi-phase bit (RC5: 1 is space then mark, RC6: 1 is mark then space)
+		void  manchester (bool markFirst,  unsigned int usec) ;
+
+		// Durations without the space after the last mark
+		unsigned int  length ( )  { return (len & 1) ? len : (len ? len - 1 : 0); }
+
+		uint32_t      d[IR_HOST_MAX_DURATIONS];
+
+	private:
+		unsigned int  len;
+} ;
+
+//------------------------------------------------------------------------------
+// A frame: how to send it, its golden timing and what IRrecv decodes from it
+//
+struct irTestCase
+{
+	const char     *name;
+	unsigned int   khz;
+	void           (*send)   (IRsend &irsend) ;
+	void           (*golden) (irGolden &g) ;
+	decode_type_t  type;     // UNUSED for the protocols IRrecv does not decode
+	unsigned long  value;    // Hash of the frame for UNKNOWN
+	int            bits;
+	unsigned int   address;  // Panasonic only
+};
+
+extern const irTestCase    irTestCases[];
+extern const unsigned int  irTestCaseCount;
+
+#endif
@@ -0,0 +1,322 @@
+//******************************************************************************
+// IRremote host test
+// Timeline recorder behind the Arduino.h stand-in
+//******************************************************************************
+
+#include "Arduino.h"
+#include "ir_host.h"
+#include "IRremote.h"
+#include "IRremoteInt.h"
+
+// Pulse clock interrupt of IRrecv (IRremote.cpp)
+void  IRTimer ( ) ;
+
+//------------------------------------------------------------------------------
+// Recorder state
+//
+static unsigned long  now;
+
+static uint8_t        ledLevel;       // 1 while the carrier is on
+static unsigned long  ledLevelStart;
+static uint32_t       timeline[IR_HOST_MAX_DURATIONS];
+static unsigned int   timelineLen;
+static unsigned int   carrierKhz;
+static unsigned int   rmtWrites;
+
+static uint8_t        rxLevel = SPACE;
+
+struct rmt_obj_s  { int pin; };
+struct hw_timer_s { int num; };
+
+static rmt_obj_t   rmtTx;
+static rmt_obj_t   rmtRx;
+static uint32_t          rmtRxThreshold;
+static rmt_rx_data_cb_t  rmtRxCallback;
+static hw_timer_t  hwTimer;
+
+//+=============================================================================
+// Record a change of the LED level at the current time
+//
+static void  ledSet (uint8_t level)
+{
+	if (level == ledLevel)  return ;
+
+	// Spaces before the first mark are not part of the frame
+	if ((ledLevel || timelineLen) && (timelineLen < IR_HOST_MAX_DURATIONS))
+		timeline[timelineLen++] = now - ledLevelStart;
+	ledLevel = level;
+	ledLevelStart = now;
+}
+
+//+=============================================================================
+unsigned long  irHostNow ( )
+{
+	return now;
+}
+
+void  irHostReset ( )
+{
+	ledLevel = 0;
+	ledLevelStart = now;
+	timelineLen = 0;
+	carrierKhz = 0;
+	rmtWrites = 0;
+}
+
+unsigned int  irHostTimeline (const uint32_t **durations)
+{
+	// A frame still lit is ended now
+	ledSet(0);
+	*durations = timeline;
+	return timelineLen;
+}
+
+unsigned int  irHostCarrierKhz ( )
+{
+	return carrierKhz;
+}
+
+unsigned int  irHostRmtWrites ( )
+{
+	return rmtWrites;
+}
+
+//+=============================================================================
+#ifdef IR_RECV_USE_RMT
+// The RMT receiver hands the items of a frame to the callback once the line
+// has been idle for the threshold, ending them with a zero duration half
+//
+static void  rmtRxFrame (uint16_t *halves,  unsigned int &count)
+{
+	static uint32_t  items[IR_HOST_MAX_DURATIONS + 1];
+
+	if (!count)  return ;
+	halves[count++] = IR_RMT_HALF(SPACE, 0);
+	if (count & 1)  halves[count++] = IR_RMT_HALF(SPACE, 0) ;
+	for (unsigned int  i = 0;  i < count;  i += 2)
+		items[i / 2] = halves[i] | ((uint32_t)halves[i + 1] << 16);
+
+	now += rmtRxThreshold;
+	if (rmtRxCallback)  rmtRxCallback(items, count / 2) ;
+	now -= rmtRxThreshold;
+	count = 0;
+}
+
+void  irHostReceive (const uint32_t *durations,  unsigned int len,  unsigned int lag_us)
+{
+	static uint16_t  halves[2 * IR_HOST_MAX_DURATIONS];
+	unsigned int     count = 0;
+
+	now += IR_HOST_GAP_US;
+	for (unsigned int  i = 0;  i < len;  i++) {
+		uint8_t   level = (i & 1) ? SPACE : MARK;
+		uint32_t  us    = (i & 1) ? ((durations[i] > lag_us) ? (durations[i] - lag_us) : 0)
+		                          : (durations[i] + lag_us);
+
+		if ((level == SPACE) && (us >= rmtRxThreshold))  rmtRxFrame(halves, count) ;
+		now += us;
+		if (!count && (level == SPACE))  continue ;
+
+		// Long levels take several halves
+		for (;  us && (count < 2 * IR_HOST_MAX_DURATIONS - 2);  count++) {
+			uint32_t  part = (us > IR_RMT_MAX_DURATION) ? IR_RMT_MAX_DURATION : us;
+
+			halves[count] = IR_RMT_HALF(level, part);
+			us -= part;
+		}
+	}
+	rmtRxFrame(halves, count);
+	now += IR_HOST_GAP_US;
+}
+
+#else
+void  irHostReceive (const uint32_t *durations,  unsigned int len,  unsigned int lag_us)
+{
+	unsigned long  edge = IR_HOST_GAP_US;  // End of the level being replayed
+	unsigned long  end  = edge + IR_HOST_GAP_US;
+	unsigned int   i    = 0;
+
+	for (unsigned int j = 0;  j < len;  j++)  end += durations[j] ;
+
+	rxLevel = SPACE;
+	for (unsigned long t = 0;  t < end;  t += USECPERTICK) {
+		while ((t >= edge) && (i <= len)) {
+			if (i == len) {
+				rxLevel = SPACE;
+				edge = end;
+			} else if (i & 1) {
+				rxLevel = SPACE;
+				edge += (durations[i] > lag_us) ? (durations[i] - lag_us) : 0;
+			} else {
+				rxLevel = MARK;
+				edge += durations[i] + lag_us;
+			}
+			i++;
+		}
+		now += USECPERTICK;
+		IRTimer();
+	}
+}
+#endif // IR_RECV_USE_RMT
+
+//+=============================================================================
+// Clock
+//
+unsigned long  micros ( )
+{
+	return now++;
+}
+
+unsigned long  millis ( )
+{
+	return now / 1000;
+}
+
+void  delay (uint32_t ms)
+{
+	now += (unsigned long)ms * 1000;
+}
+
+void  delayMicroseconds (uint32_t us)
+{
+	now += us;
+}
+
+//+=============================================================================
+// GPIO, only the receiver pin is read
+//
+void  pinMode (uint8_t pin,  uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void  digitalWrite (uint8_t pin,  uint8_t val)
+{
+	(void)pin;
+	(void)val;
+}
+
+int  digitalRead (uint8_t pin)
+{
+	(void)pin;
+	return rxLevel;
+}
+
+//+=============================================================================
+// LEDC, a non zero duty lights the LED
+//
+double  ledcSetup (uint8_t channel,  double freq,  uint8_t resolution_bits)
+{
+	(void)channel;
+	(void)resolution_bits;
+	carrierKhz = (unsigned int)(freq / 1000);
+	return freq;
+}
+
+void  ledcAttachPin (uint8_t pin,  uint8_t channel)
+{
+	(void)pin;
+	(void)channel;
+}
+
+void  ledcWrite (uint8_t channel,  uint32_t duty)
+{
+	(void)channel;
+	ledSet(duty ? 1 : 0);
+}
+
+//+=============================================================================
+// RMT, items written are played on the clock, frames received are handed to
+// the callback by irHostReceive()
+//
+rmt_obj_t*  rmtInit (int pin,  bool tx_not_rx,  rmt_reserve_memsize_t memsize)
+{
+	rmt_obj_t  *rmt = tx_not_rx ? &rmtTx : &rmtRx;
+
+	(void)memsize;
+	rmt->pin = pin;
+	return rmt;
+}
+
+bool  rmtDeinit (rmt_obj_t* rmt)
+{
+	if (rmt == &rmtRx)  rmtRxCallback = NULL ;
+	return true;
+}
+
+float  rmtSetTick (rmt_obj_t* rmt,  float tick)
+{
+	(void)rmt;
+	return tick;
+}
+
+bool  rmtSetCarrier (rmt_obj_t* rmt,  bool carrier_en,  bool carrier_level,  uint32_t low,  uint32_t high)
+{
+	(void)rmt;
+	(void)carrier_level;
+	if (carrier_en && (low + high))  carrierKhz = IR_RMT_APB_KHZ / (low + high) ;
+	return true;
+}
+
+bool  rmtWrite (rmt_obj_t* rmt,  rmt_data_t* data,  size_t size)
+{
+	unsigned long  start = now;
+
+	(void)rmt;
+	rmtWrites++;
+	for (size_t i = 0;  i < size;  i++) {
+		if (!IR_RMT_DURATION0(data[i].val))  break ;
+		ledSet(IR_RMT_LEVEL0(data[i].val));
+		now += IR_RMT_DURATION0(data[i].val);
+		if (!IR_RMT_DURATION1(data[i].val))  break ;
+		ledSet(IR_RMT_LEVEL1(data[i].val));
+		now += IR_RMT_DURATION1(data[i].val);
+	}
+	ledSet(0);
+
+	// The write is asynchronous, the caller waits for the frame with delay()
+	now = start;
+	return true;
+}
+
+// The receiver filter and idle threshold are in ticks, 1 us with IR_RMT_TICK_NS
+bool  rmtSetFilter (rmt_obj_t* rmt,  bool filter_en,  uint32_t filter_level)
+{
+	(void)rmt;
+	(void)filter_en;
+	(void)filter_level;
+	return true;
+}
+
+bool  rmtSetRxThreshold (rmt_obj_t* rmt,  uint32_t value)
+{
+	(void)rmt;
+	rmtRxThreshold = value;
+	return true;
+}
+
+bool  rmtRead (rmt_obj_t* rmt,  rmt_rx_data_cb_t cb)
+{
+	(void)rmt;
+	rmtRxCallback = cb;
+	return true;
+}
+
+//+=============================================================================
+// Hardware timer, the tests tick the receiver themselves
+//
+hw_timer_t*  timerBegin (uint8_t timer,  uint16_t divider,  bool countUp)
+{
+	(void)divider;
+	(void)countUp;
+	hwTimer.num = timer;
+	return &hwTimer;
+}
+
+void  timerEnd (hw_timer_t* timer)                                      { (void)timer; }
+void  timerAttachInterrupt (hw_timer_t* timer,  void (*fn)(void),  bool edge)  { (void)timer;  (void)fn;  (void)edge; }
+void  timerDetachInterrupt (hw_timer_t* timer)                          { (void)timer; }
+void  timerAlarmWrite (hw_timer_t* timer,  uint64_t interruptAt,  bool autoreload)  { (void)timer;  (void)interruptAt;  (void)autoreload; }
+void  timerAlarmEnable (hw_timer_t* timer)                              { (void)timer; }
+void  timerAlarmDisable (hw_timer_t* timer)                             { (void)timer; }
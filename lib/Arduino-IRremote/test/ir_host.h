@@ -0,0 +1,45 @@
+//******************************************************************************
+// IRremote host test
+// Timeline recorder behind the Arduino.h stand-in
+//
+// The LED level written by IRsend (LEDC duty or RMT items) is recorded as a
+// list of durations, mark first, on the virtual clock. The same kind of list
+// can be replayed on the receiver pin, ticking the IRrecv pulse clock
+// interrupt every USECPERTICK, to decode it as a real frame would be (or
+// handed as RMT items to the IRrecv callback with IR_RECV_USE_RMT).
+//******************************************************************************
+
+#ifndef ir_host_h
+#define ir_host_h
+
+#include <stdint.h>
+
+// Longest timeline recorded (marks and spaces)
+#define IR_HOST_MAX_DURATIONS  512
+
+// Silence around a replayed frame (longer than the gap IRrecv waits for, and than the one
+// telling a new Sony frame from a quick repeat)
+#define IR_HOST_GAP_US  50000
+
+// Virtual clock in microseconds
+unsigned long  irHostNow ( ) ;
+
+// Forget the recorded timeline
+void  irHostReset ( ) ;
+
+// Recorded durations in microseconds (mark first, then space and mark alternately, the LED off
+// time after the last mark is not included), returns their number
+unsigned int  irHostTimeline (const uint32_t **durations) ;
+
+// Carrier of the last frame sent
+unsigned int  irHostCarrierKhz ( ) ;
+
+// Number of RMT writes since the last reset (0 with the LEDC backend)
+unsigned int  irHostRmtWrites ( ) ;
+
+// Replay a timeline on the receiver pin between two gaps, marks stretched and spaces shortened by
+// lag_us (demodulator lag). With IR_RECV_USE_RMT the frames (split at spaces of the RMT idle
+// threshold) are given to the receive callback instead.
+void  irHostReceive (const uint32_t *durations,  unsigned int len,  unsigned int lag_us) ;
+
+#endif
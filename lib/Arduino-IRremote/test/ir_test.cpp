@@ -0,0 +1,242 @@
+//******************************************************************************
+// IRremote host test
+// Golden timing and round trip of every encoder
+//
+// Each frame is sent through IRsend and the recorded timeline is checked
+// against the golden one, mark by mark and space by space. It is then replayed
+// on the receiver pin with the usual demodulator lag, and IRrecv must decode
+// the value the frame was sent with. Last, frames are left waiting in the
+// capture ring to check they come out in order and the ones beyond
+// IR_RING_FRAMES are counted as dropped. The NEC frames the bridge keeps
+// precomputed for the LG TV codes (main/ir_waveform.cpp) must be sent exactly
+// like sendNEC() sends them.
+//
+// Built twice, for the LEDC backend (marks and spaces timed by spinning on
+// micros(), a few microseconds short) and the timer receiver, and for the RMT
+// ones (IR_SEND_USE_RMT, exact durations, and IR_RECV_USE_RMT, the captured
+// durations must then be those replayed to the microsecond).
+//******************************************************************************
+
+#include <stdio.h>
+
+#include "ir_cases.h"
+#include "ir_waveform.h"
+#include "lg32ls570s.h"
+
+// Allowed difference between a recorded and a golden duration
+#ifdef IR_SEND_USE_RMT
+#	define IR_TEST_TOLERANCE_US  0
+#else
+#	define IR_TEST_TOLERANCE_US  8
+#endif
+
+// Codes of lg32ls570s.h
+#define IR_TEST_LG_CODES  49
+
+// Spaces between frames are waited for with delay(), they are only checked
+// against their minimum
+#define IR_TEST_FRAME_GAP_US  20000
+
+//+=============================================================================
+// Compare the recorded timeline with the golden one
+//
+static bool  checkTiming (const irTestCase &tc)
+{
+	irGolden         golden;
+	const uint32_t   *durations;
+	unsigned int     len = irHostTimeline(&durations);
+	bool             ok  = true;
+
+	tc.golden(golden);
+
+	if (irHostCarrierKhz() != tc.khz) {
+		printf("%s: carrier %u kHz, expected %u kHz\n", tc.name, irHostCarrierKhz(), tc.khz);
+		ok = false;
+	}
+#ifdef IR_SEND_USE_RMT
+	// Each frame goes out in one write, a split one has a space stretched by the wait between them
+	unsigned int  frames = 1;
+	for (unsigned int  i = 1;  i < golden.length();  i += 2) {
+		if (golden.d[i] >= IR_TEST_FRAME_GAP_US)  frames++ ;
+	}
+	if (irHostRmtWrites() != frames) {
+		printf("%s: %u RMT writes, expected %u\n", tc.name, irHostRmtWrites(), frames);
+		ok = false;
+	}
+#endif
+	if (len != golden.length()) {
+		printf("%s: %u durations, expected %u\n", tc.name, len, golden.length());
+		return false;
+	}
+	for (unsigned int  i = 0;  i < len;  i++) {
+		long  expected = golden.d[i];
+		long  diff     = (long)durations[i] - expected;
+
+		if ((i & 1) && (expected >= IR_TEST_FRAME_GAP_US))  diff = (diff > 0) ? 0 : diff ;
+		if ((diff > IR_TEST_TOLERANCE_US) || (diff < -IR_TEST_TOLERANCE_US)) {
+			printf("%s: %s %u is %u us, expected %ld us\n", tc.name, (i & 1) ? "space" : "mark",
+			       i, (unsigned int)durations[i], expected);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+//+=============================================================================
+// Replay the recorded timeline and decode it
+//
+static bool  checkDecode (IRrecv &irrecv,  const irTestCase &tc)
+{
+	decode_results   results;
+	const uint32_t   *durations;
+	unsigned int     len = irHostTimeline(&durations);
+	bool             ok  = true;
+
+	irHostReceive(durations, len, MARK_EXCESS);
+	if (!irrecv.decode(&results)) {
+		printf("%s: not decoded\n", tc.name);
+		return false;
+	}
+	// unsigned long is 32 bits on the target, Panasonic leaves its address in the upper bits here
+	if ((results.decode_type != tc.type) || ((uint32_t)results.value != tc.value) || (results.bits != tc.bits)
+	    || ((tc.type == PANASONIC) && (results.address != tc.address))) {
+		printf("%s: decoded type %d value 0x%lX bits %d address 0x%X, expected type %d value 0x%lX bits %d address 0x%X\n",
+		       tc.name, results.decode_type, (unsigned long)(uint32_t)results.value, results.bits, results.address,
+		       tc.type, tc.value, tc.bits, tc.address);
+		ok = false;
+	}
+#ifdef IR_RECV_USE_RMT
+	// First frame of the timeline
+	for (unsigned int  i = 1;  ok && (i < (unsigned int)results.rawlen) && (i <= len);  i++) {
+		uint32_t  us = (i & 1) ? durations[i - 1] + MARK_EXCESS : durations[i - 1] - MARK_EXCESS;
+
+		if (results.rawbufUs[i] != us) {
+			printf("%s: captured duration %u is %u us, expected %u us\n", tc.name, i - 1,
+			       (unsigned int)results.rawbufUs[i], (unsigned int)us);
+			ok = false;
+		}
+	}
+#endif
+
+	// Repeats of the frame sent with it
+	while (irrecv.decode(&results))  ;
+	return ok;
+}
+
+//+=============================================================================
+// Capture frames without decoding them, the oldest IR_RING_FRAMES are kept
+//
+static bool  checkRing (IRsend &irsend,  IRrecv &irrecv,  const irTestCase &tc)
+{
+	decode_results   results;
+	const uint32_t   *durations;
+	unsigned int     len;
+	unsigned int     dropped = irrecv.dropped();
+	unsigned int     frames  = 0;
+	unsigned long    last    = 0;
+	bool             ok      = true;
+
+	irHostReset();
+	tc.send(irsend);
+	len = irHostTimeline(&durations);
+	for (unsigned int  i = 0;  i < IR_RING_FRAMES + 2;  i++)  irHostReceive(durations, len, MARK_EXCESS) ;
+
+	while (irrecv.decode(&results)) {
+		if ((results.decode_type != tc.type) || ((uint32_t)results.value != tc.value) || (results.timestamp <= last)) {
+			printf("ring: frame %u decoded type %d value 0x%lX at %lu us, after %lu us\n", frames,
+			       results.decode_type, (unsigned long)(uint32_t)results.value, results.timestamp, last);
+			ok = false;
+		}
+		last = results.timestamp;
+		frames++;
+	}
+	if ((frames != IR_RING_FRAMES) || (irrecv.dropped() - dropped != 2)) {
+		printf("ring: %u frames decoded, %u dropped, expected %u and 2\n", frames, irrecv.dropped() - dropped,
+		       IR_RING_FRAMES);
+		ok = false;
+	}
+	printf("%-12s %s\n", "ring", ok ? "ok" : "FAILED");
+	return ok;
+}
+
+//+=============================================================================
+// Send every precomputed LG waveform and the same code with sendNEC()
+//
+static bool  checkLgWaveforms (IRsend &irsend)
+{
+	static uint32_t  necTimeline[IR_HOST_MAX_DURATIONS];
+	const uint32_t   *durations;
+	unsigned int     necLen,  len;
+	unsigned int     codes = 0;
+	bool             ok    = true;
+
+	for (uint32_t  code = 0;  code <= 0xFFFF;  code++) {
+		const ir_waveform_t  *waveform = ir_waveform_lg_lookup(code);
+
+		if (!waveform)  continue ;
+		codes++;
+
+		irHostReset();
+		irsend.sendNEC(NEC_INIT_MASK | code, 32);
+		necLen = irHostTimeline(&durations);
+		for (unsigned int  i = 0;  i < necLen;  i++)  necTimeline[i] = durations[i] ;
+
+		irHostReset();
+		irsend.sendItems(waveform->items, waveform->len, waveform->khz);
+		len = irHostTimeline(&durations);
+
+		if ((len != necLen) || (irHostCarrierKhz() != 38)) {
+			printf("lg 0x%04X: %u durations at %u kHz, sendNEC %u at 38 kHz\n", (unsigned int)code, len,
+			       irHostCarrierKhz(), necLen);
+			ok = false;
+			continue;
+		}
+		for (unsigned int  i = 0;  i < len;  i++) {
+			long  diff = (long)durations[i] - (long)necTimeline[i];
+
+			if ((diff > IR_TEST_TOLERANCE_US) || (diff < -IR_TEST_TOLERANCE_US)) {
+				printf("lg 0x%04X: %s %u is %u us, sendNEC %u us\n", (unsigned int)code, (i & 1) ? "space" : "mark",
+				       i, (unsigned int)durations[i], (unsigned int)necTimeline[i]);
+				ok = false;
+			}
+		}
+	}
+	if (codes != IR_TEST_LG_CODES) {
+		printf("lg: %u precomputed codes, expected %u\n", codes, IR_TEST_LG_CODES);
+		ok = false;
+	}
+	printf("%-12s %s\n", "lg-waveform", ok ? "ok" : "FAILED");
+	return ok;
+}
+
+//+=============================================================================
+int  main ( )
+{
+	IRsend        irsend(TIMER_PWM_PIN);
+	IRrecv        irrecv(0);
+	unsigned int  failed = 0;
+
+	irrecv.enableIRIn();
+
+	for (unsigned int  i = 0;  i < irTestCaseCount;  i++) {
+		const irTestCase  &tc = irTestCases[i];
+		bool              ok;
+
+		irHostReset();
+		tc.send(irsend);
+		ok = checkTiming(tc);
+		if (tc.type != UNUSED)  ok = checkDecode(irrecv, tc) && ok ;
+
+		printf("%-12s %s\n", tc.name, ok ? "ok" : "FAILED");
+		if (!ok)  failed++ ;
+	}
+	if (!checkRing(irsend, irrecv, irTestCases[0]))  failed++ ;
+	if (!checkLgWaveforms(irsend))  failed++ ;
+
+#ifdef IR_SEND_USE_RMT
+	printf("%u frames, RMT backends: %s\n", irTestCaseCount, failed ? "FAILED" : "passed");
+#else
+	printf("%u frames, LEDC and timer backends: %s\n", irTestCaseCount, failed ? "FAILED" : "passed");
+#endif
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/* Deferred binary event log */
+
+#include "event_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "latency.h"
+
+#ifdef ESP_PLATFORM
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/task.h"
+#endif
+
+/**************************************************************************************************/
+
+// Printing task setup (lowest priority above idle, on the core not running BTstack)
+#define EVENT_LOG_TASK_STACK_SIZE 2048
+#define EVENT_LOG_TASK_PRIORITY   1
+#define EVENT_LOG_TASK_CORE       1
+#define EVENT_LOG_TASK_PERIOD_MS  20
+
+// Payload formats
+#define EVENT_LOG_FORMAT_NONE    0
+#define EVENT_LOG_FORMAT_HEX     1  // Bytes in hexadecimal
+#define EVENT_LOG_FORMAT_TEXT    2  // Characters
+#define EVENT_LOG_FORMAT_U8      3  // Single byte value
+#define EVENT_LOG_FORMAT_DEVICE  4  // Device index
+#define EVENT_LOG_FORMAT_ADDR    5  // Bluetooth address
+
+typedef struct {
+    const char* name;
+    uint8_t level;
+    uint8_t format;
+} event_log_event_t;
+
+static const event_log_event_t events[EVENT_LOG_NUM_IDS] =
+{
+    { "HCI event",                  EVENT_LOG_LEVEL_DEBUG, EVENT_LOG_FORMAT_HEX    },
+    { "HID packet received",        EVENT_LOG_LEVEL_DEBUG, EVENT_LOG_FORMAT_HEX    },
+    { "HID Control",                EVENT_LOG_LEVEL_DEBUG, EVENT_LOG_FORMAT_HEX    },
+    { "Device connected.",          EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "Device disconnected.",       EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "HID Control connected.",     EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "HID Connection established", EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "L2CAP Connection failed",    EVENT_LOG_LEVEL_ERROR, EVENT_LOG_FORMAT_U8     },
+    { "Key",                        EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_TEXT   },
+    { "Key: Released",              EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "Pairing mode started.",      EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_NONE   },
+    { "Pairing: HID device found",  EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_ADDR   },
+    { "Device paired",              EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_ADDR   },
+    { "Pairing failed",             EVENT_LOG_LEVEL_ERROR, EVENT_LOG_FORMAT_U8     },
+    { "Pairing mode stopped.",      EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_NONE   },
+    { "Connection request.",        EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "Paging.",                    EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "Page failed.",               EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_DEVICE },
+    { "Macro started",              EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_U8     },
+    { "Macro cancelled",            EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_U8     },
+    { "Learning mode started.",     EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_NONE   },
+    { "Learning key",               EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_U8     },
+    { "IR frame learned",           EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_U8     },
+    { "IR frame not learned",       EVENT_LOG_LEVEL_ERROR, EVENT_LOG_FORMAT_U8     },
+    { "Learning mode stopped.",     EVENT_LOG_LEVEL_INFO,  EVENT_LOG_FORMAT_NONE   },
+};
+
+static event_log_record_t ring[EVENT_LOG_LEN];
+
+// Free running indexes, head written by the run loop and tail by the printing task
+static volatile uint32_t ring_head = 0;
+static volatile uint32_t ring_tail = 0;
+
+// Records lost because the ring was full (written by the run loop)
+static volatile uint32_t ring_dropped = 0;
+static uint32_t dropped_reported = 0;
+
+static uint8_t log_level = EVENT_LOG_LEVEL_INFO;
+
+// Timestamp of the last record printed
+static uint32_t last_cycles = 0;
+
+/**************************************************************************************************/
+
+// Reserve the next record, NULL if the event is filtered out or the ring is full
+static event_log_record_t* event_log_reserve(const event_log_id_t id)
+{
+    event_log_record_t* record;
+
+    if(events[id].level > log_level)
+        return NULL;
+    if((ring_head - ring_tail) >= EVENT_LOG_LEN)
+    {
+        ring_dropped++;
+        return NULL;
+    }
+    record = &ring[ring_head & (EVENT_LOG_LEN - 1)];
+    record->cycles = latency_now();
+    record->id = id;
+    return record;
+}
+
+// Make the record visible to the printing task
+static void event_log_commit(void)
+{
+    __sync_synchronize();
+    ring_head++;
+}
+
+static void event_log_print(const event_log_record_t* record)
+{
+    const event_log_event_t* event = &events[record->id];
+
+    printf("[+%u us] %s", (uint32_t)(record->cycles - last_cycles) / LATENCY_CYCLES_PER_US,
+        event->name);
+    last_cycles = record->cycles;
+    switch(event->format)
+    {
+        case EVENT_LOG_FORMAT_HEX:
+            printf(":");
+            for(uint8_t i = 0; i < record->len; i++)
+                printf(" %02X", record->data[i]);
+            break;
+        case EVENT_LOG_FORMAT_TEXT:
+            printf(": %.*s", record->len, (const char*)record->data);
+            break;
+        case EVENT_LOG_FORMAT_U8:
+            printf(": 0x%02x", (record->len > 0) ? record->data[0] : 0);
+            break;
+        case EVENT_LOG_FORMAT_DEVICE:
+            if(record->len > 0)
+                printf(" (device %u)", record->data[0]);
+            break;
+        case EVENT_LOG_FORMAT_ADDR:
+            if(record->len >= 6)
+                printf(": %02X:%02X:%02X:%02X:%02X:%02X", record->data[0], record->data[1],
+                    record->data[2], record->data[3], record->data[4], record->data[5]);
+            break;
+        default:
+            break;
+    }
+    printf("\n");
+}
+
+#ifdef ESP_PLATFORM
+static void event_log_task(void* arg)
+{
+    (void)arg;
+
+    while(1)
+    {
+        event_log_drain();
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_TASK_PERIOD_MS));
+    }
+}
+#endif
+
+/**************************************************************************************************/
+
+void event_log_init(void)
+{
+    last_cycles = latency_now();
+#ifdef ESP_PLATFORM
+    static bool task_started = false;
+    if(!task_started)
+    {
+        task_started = true;
+        xTaskCreatePinnedToCore(event_log_task, "event_log", EVENT_LOG_TASK_STACK_SIZE, NULL,
+            EVENT_LOG_TASK_PRIORITY, NULL, EVENT_LOG_TASK_CORE);
+    }
+#endif
+}
+
+void event_log_set_level(const uint8_t level)
+{
+    log_level = level;
+}
+
+uint8_t event_log_get_level(void)
+{
+    return log_level;
+}
+
+void event_log(const event_log_id_t id, const uint8_t* data, const uint16_t len)
+{
+    event_log_record_t* record = event_log_reserve(id);
+
+    if(record == NULL)
+        return;
+    record->len = (len < EVENT_LOG_PAYLOAD_LEN) ? len : EVENT_LOG_PAYLOAD_LEN;
+    memcpy(record->data, data, record->len);
+    event_log_commit();
+}
+
+void event_log_text(const event_log_id_t id, const char* text)
+{
+    event_log(id, (const uint8_t*)text, strlen(text));
+}
+
+uint32_t event_log_drain(void)
+{
+    uint32_t printed = 0;
+    uint32_t dropped;
+
+    while(ring_tail != ring_head)
+    {
+        // Read the record after its index and release it only once printed
+        __sync_synchronize();
+        event_log_print(&ring[ring_tail & (EVENT_LOG_LEN - 1)]);
+        __sync_synchronize();
+        ring_tail++;
+        printed++;
+    }
+
+    dropped = ring_dropped;
+    if(dropped != dropped_reported)
+    {
+        printf("Event log: %u records dropped\n", dropped - dropped_reported);
+        dropped_reported = dropped;
+    }
+    return printed;
+}
@@ -0,0 +1,86 @@
+/* Deferred binary event log */
+
+/*
+ * Events are written on the hot path as fixed size binary records (event id,
+ * cycle counter timestamp and a few payload bytes) into a lock-free single
+ * producer ring, so logging costs a table lookup and a memcpy. A low priority
+ * task formats and prints the records, so the console never blocks the
+ * BTstack run loop. Records are dropped (and counted) when the ring is full.
+ *
+ * Only the BTstack run loop may write records.
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+
+// Number of records in the ring (power of 2)
+#ifndef EVENT_LOG_LEN
+    #define EVENT_LOG_LEN 64
+#endif
+
+// Payload bytes kept per record (longer payloads are truncated)
+#define EVENT_LOG_PAYLOAD_LEN 22
+
+// Log levels, an event is recorded if its level is lower or equal to the current level
+#define EVENT_LOG_LEVEL_OFF    0
+#define EVENT_LOG_LEVEL_ERROR  1
+#define EVENT_LOG_LEVEL_INFO   2
+#define EVENT_LOG_LEVEL_DEBUG  3
+
+// Events (their level and format are defined in event_log.cpp)
+typedef enum {
+    EVENT_LOG_HCI_EVENT = 0,          // HCI event received (event packet)
+    EVENT_LOG_HID_REPORT,             // HID interrupt channel packet received (packet)
+    EVENT_LOG_HID_CONTROL,            // HID control channel packet received (packet)
+    EVENT_LOG_DEVICE_CONNECTED,       // ACL connection up (device index)
+    EVENT_LOG_DEVICE_DISCONNECTED,    // ACL connection lost (device index)
+    EVENT_LOG_HID_CONTROL_CONNECTED,  // Control channel open (device index)
+    EVENT_LOG_HID_CONNECTED,          // Interrupt channel open, reports can be received (device index)
+    EVENT_LOG_L2CAP_FAILED,           // L2CAP channel could not be opened (status)
+    EVENT_LOG_KEY,                    // Key pressed (keymap label)
+    EVENT_LOG_KEY_RELEASED,           // All keys of a device released (device index)
+    EVENT_LOG_PAIRING_STARTED,        // Pairing mode entered
+    EVENT_LOG_PAIRING_FOUND,          // New HID device found by the inquiry (address)
+    EVENT_LOG_PAIRED,                 // Device paired and added to the allow-list (address)
+    EVENT_LOG_PAIRING_FAILED,         // Pairing with a device failed (status)
+    EVENT_LOG_PAIRING_STOPPED,        // Pairing mode left
+    EVENT_LOG_CONNECTION_REQUEST,     // Device paging the bridge (device index)
+    EVENT_LOG_PAGE,                   // Bridge paging a device (device index)
+    EVENT_LOG_PAGE_FAILED,            // Page of a device failed, retried later (device index)
+    EVENT_LOG_MACRO_STARTED,          // IR macro started by a key (macro number)
+    EVENT_LOG_MACRO_CANCELLED,        // IR macro stopped by another key (macro number)
+    EVENT_LOG_LEARN_STARTED,          // IR learning mode entered
+    EVENT_LOG_LEARN_KEY,              // Key to learn pressed (usage)
+    EVENT_LOG_LEARNED,                // IR frame bound to the key (frame type)
+    EVENT_LOG_LEARN_FAILED,           // IR frame received could not be learned (frame type)
+    EVENT_LOG_LEARN_STOPPED,          // IR learning mode left
+    EVENT_LOG_NUM_IDS
+} event_log_id_t;
+
+typedef struct {
+    uint32_t cycles;                       // latency_now() when the event was written
+    uint8_t id;                            // event_log_id_t
+    uint8_t len;                           // Payload bytes
+    uint8_t data[EVENT_LOG_PAYLOAD_LEN];
+} event_log_record_t;
+
+// Reset the ring and start the task printing the records
+void event_log_init(void);
+
+// Set the runtime log level (EVENT_LOG_LEVEL_*)
+void event_log_set_level(const uint8_t level);
+uint8_t event_log_get_level(void);
+
+// Write an event with a binary payload
+void event_log(const event_log_id_t id, const uint8_t* data, const uint16_t len);
+
+// Write an event with a text payload
+void event_log_text(const event_log_id_t id, const char* text);
+
+// Print the pending records, returns the number printed (done by the task, exposed for hosts
+// without it)
+uint32_t event_log_drain(void);
+
+#endif
@@ -0,0 +1,83 @@
+/* HID device SDP cache */
+
+#include "hid_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "btstack_tlv.h"
+
+/**************************************************************************************************/
+
+// TLV tag of a device entry: 'HC' and the 2 lower bytes of the address (the entry holds the full
+// address to tell apart devices sharing them). No other tag of the bridge starts with 'HC', the
+// address bytes cannot make one of them.
+#define HID_CACHE_TLV_TAG(addr) (((uint32_t)'H' << 24) | ((uint32_t)'C' << 16) | \
+    ((uint32_t)(addr)[4] << 8) | (addr)[5])
+
+// Stored entry header size (the descriptor is stored up to its length)
+#define HID_CACHE_HEADER_SIZE offsetof(hid_cache_entry_t, descriptor)
+
+/**************************************************************************************************/
+
+static bool hid_cache_tlv(const btstack_tlv_t** tlv_impl, void** tlv_context)
+{
+    btstack_tlv_get_instance(tlv_impl, tlv_context);
+    return (*tlv_impl != NULL);
+}
+
+/**************************************************************************************************/
+
+bool hid_cache_get(const bd_addr_t addr, hid_cache_entry_t* entry)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    int size;
+
+    if(!hid_cache_tlv(&tlv_impl, &tlv_context))
+        return false;
+
+    size = tlv_impl->get_tag(tlv_context, HID_CACHE_TLV_TAG(addr), (uint8_t*)entry,
+        sizeof(hid_cache_entry_t));
+    if(size < (int)HID_CACHE_HEADER_SIZE)
+        return false;
+    if((memcmp(entry->addr, addr, sizeof(bd_addr_t)) != 0) ||
+       (entry->descriptor_len > HID_CACHE_MAX_DESCRIPTOR_LEN) ||
+       (size != (int)(HID_CACHE_HEADER_SIZE + entry->descriptor_len)) ||
+       (entry->control_psm == 0) || (entry->interrupt_psm == 0))
+    {
+        return false;
+    }
+    return true;
+}
+
+bool hid_cache_store(const hid_cache_entry_t* entry)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    if(entry->descriptor_len > HID_CACHE_MAX_DESCRIPTOR_LEN)
+        return false;
+    if(!hid_cache_tlv(&tlv_impl, &tlv_context))
+        return false;
+
+    return (tlv_impl->store_tag(tlv_context, HID_CACHE_TLV_TAG(entry->addr), (const uint8_t*)entry,
+        HID_CACHE_HEADER_SIZE + entry->descriptor_len) == 0);
+}
+
+void hid_cache_delete(const bd_addr_t addr)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    if(hid_cache_tlv(&tlv_impl, &tlv_context))
+        tlv_impl->delete_tag(tlv_context, HID_CACHE_TLV_TAG(addr));
+}
+
+bool hid_cache_equal(const hid_cache_entry_t* a, const hid_cache_entry_t* b)
+{
+    return (memcmp(a->addr, b->addr, sizeof(bd_addr_t)) == 0) &&
+        (a->control_psm == b->control_psm) && (a->interrupt_psm == b->interrupt_psm) &&
+        (a->descriptor_len == b->descriptor_len) &&
+        (memcmp(a->descriptor, b->descriptor, a->descriptor_len) == 0);
+}
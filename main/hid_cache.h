@@ -0,0 +1,41 @@
+/* HID device SDP cache */
+
+/*
+ * Keeps the SDP information needed to open the HID channels of each known
+ * device (control and interrupt PSMs and the HID descriptor) in the BTstack
+ * TLV storage, one tag per device derived from its address. A reconnect to a
+ * cached device opens the L2CAP channels right away instead of waiting for
+ * the SDP query, which is then only run in the background to refresh it.
+ */
+
+#ifndef HID_CACHE_H
+#define HID_CACHE_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+
+// Largest HID descriptor cached
+#define HID_CACHE_MAX_DESCRIPTOR_LEN 300
+
+typedef struct {
+    bd_addr_t addr;
+    uint16_t control_psm;
+    uint16_t interrupt_psm;
+    uint16_t descriptor_len;
+    uint8_t descriptor[HID_CACHE_MAX_DESCRIPTOR_LEN];
+} hid_cache_entry_t;
+
+// Get the cached entry of a device, returns false if there is none
+bool hid_cache_get(const bd_addr_t addr, hid_cache_entry_t* entry);
+
+// Store the entry of a device (replacing the cached one), returns false on storage error
+bool hid_cache_store(const hid_cache_entry_t* entry);
+
+// Remove the entry of a device
+void hid_cache_delete(const bd_addr_t addr);
+
+// Check if two entries hold the same SDP information
+bool hid_cache_equal(const hid_cache_entry_t* a, const hid_cache_entry_t* b);
+
+#endif
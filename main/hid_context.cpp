@@ -0,0 +1,172 @@
+/* HID host device contexts */
+
+#include "hid_context.h"
+
+#include <string.h>
+
+/**************************************************************************************************/
+
+// CID map size (power of 2, kept at most half full so probe sequences stay short)
+#ifndef HID_CONTEXT_CID_MAP_LEN
+    #define HID_CONTEXT_CID_MAP_LEN 32
+#endif
+static_assert((HID_CONTEXT_CID_MAP_LEN & (HID_CONTEXT_CID_MAP_LEN - 1)) == 0,
+    "HID_CONTEXT_CID_MAP_LEN must be a power of 2");
+static_assert(HID_CONTEXT_CID_MAP_LEN >= (4 * HID_CONTEXT_MAX),
+    "HID_CONTEXT_CID_MAP_LEN too small for HID_CONTEXT_MAX");
+
+// CID map slot (free if cid is 0, BTstack never allocates it)
+typedef struct {
+    uint16_t cid;
+    uint8_t index;
+} hid_context_cid_slot_t;
+
+static hid_context_t devices[HID_CONTEXT_MAX];
+static uint8_t devices_used[HID_CONTEXT_MAX];
+static uint8_t num_devices = 0;
+
+static hid_context_cid_slot_t cid_map[HID_CONTEXT_CID_MAP_LEN];
+
+/**************************************************************************************************/
+
+// Home slot of a CID (BTstack allocates CIDs sequentially, so live CIDs rarely collide)
+static inline uint32_t hid_context_cid_slot(const uint16_t cid)
+{
+    return cid & (HID_CONTEXT_CID_MAP_LEN - 1);
+}
+
+/**************************************************************************************************/
+
+hid_context_t* hid_context_add(const bd_addr_t addr)
+{
+    hid_context_t* device = hid_context_get_by_addr(addr);
+
+    if(device != NULL)
+        return device;
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        if(devices_used[i])
+            continue;
+        device = &devices[i];
+        memset(device, 0, sizeof(hid_context_t));
+        memcpy(device->addr, addr, sizeof(bd_addr_t));
+        device->index = i;
+        device->state = HID_CONTEXT_IDLE;
+        device->con_handle = HCI_CON_HANDLE_INVALID;
+        devices_used[i] = 1;
+        num_devices++;
+        return device;
+    }
+    return NULL;
+}
+
+void hid_context_remove(hid_context_t* device)
+{
+    if(!devices_used[device->index])
+        return;
+    devices_used[device->index] = 0;
+    num_devices--;
+}
+
+hid_context_t* hid_context_get(const uint8_t index)
+{
+    if((index >= HID_CONTEXT_MAX) || !devices_used[index])
+        return NULL;
+    return &devices[index];
+}
+
+hid_context_t* hid_context_get_by_addr(const bd_addr_t addr)
+{
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        if(devices_used[i] && (memcmp(devices[i].addr, addr, sizeof(bd_addr_t)) == 0))
+            return &devices[i];
+    }
+    return NULL;
+}
+
+hid_context_t* hid_context_get_by_con_handle(const hci_con_handle_t con_handle)
+{
+    if(con_handle == HCI_CON_HANDLE_INVALID)
+        return NULL;
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        if(devices_used[i] && (devices[i].con_handle == con_handle))
+            return &devices[i];
+    }
+    return NULL;
+}
+
+hid_context_t* hid_context_get_by_cid(const uint16_t cid)
+{
+    uint32_t slot = hid_context_cid_slot(cid);
+
+    if(cid == 0)
+        return NULL;
+    while(cid_map[slot].cid != 0)
+    {
+        if(cid_map[slot].cid == cid)
+            return &devices[cid_map[slot].index];
+        slot = (slot + 1) & (HID_CONTEXT_CID_MAP_LEN - 1);
+    }
+    return NULL;
+}
+
+bool hid_context_bind_cid(hid_context_t* device, const uint16_t cid)
+{
+    uint32_t slot = hid_context_cid_slot(cid);
+
+    if(cid == 0)
+        return false;
+    for(uint32_t probes = 0; probes < HID_CONTEXT_CID_MAP_LEN; probes++)
+    {
+        if((cid_map[slot].cid == 0) || (cid_map[slot].cid == cid))
+        {
+            cid_map[slot].cid = cid;
+            cid_map[slot].index = device->index;
+            return true;
+        }
+        slot = (slot + 1) & (HID_CONTEXT_CID_MAP_LEN - 1);
+    }
+    return false;
+}
+
+void hid_context_unbind_cid(const uint16_t cid)
+{
+    uint32_t slot = hid_context_cid_slot(cid);
+    uint32_t next;
+    uint32_t home;
+
+    if(cid == 0)
+        return;
+    while(cid_map[slot].cid != cid)
+    {
+        if(cid_map[slot].cid == 0)
+            return;
+        slot = (slot + 1) & (HID_CONTEXT_CID_MAP_LEN - 1);
+    }
+
+    // Shift back the following entries of the probe sequence so no lookup stops at the hole
+    next = slot;
+    while(1)
+    {
+        next = (next + 1) & (HID_CONTEXT_CID_MAP_LEN - 1);
+        if(cid_map[next].cid == 0)
+            break;
+        home = hid_context_cid_slot(cid_map[next].cid);
+        // Keep the entry if its home slot lies cyclically in (slot, next]
+        if(((next - home) & (HID_CONTEXT_CID_MAP_LEN - 1)) < ((next - slot) &
+            (HID_CONTEXT_CID_MAP_LEN - 1)))
+        {
+            continue;
+        }
+        cid_map[slot] = cid_map[next];
+        slot = next;
+    }
+    cid_map[slot].cid = 0;
+}
+
+uint8_t hid_context_count(void)
+{
+    return num_devices;
+}
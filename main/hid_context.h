@@ -0,0 +1,92 @@
+/* HID host device contexts */
+
+/*
+ * State of each HID device served by the bridge (connection, SDP record,
+ * compiled report layout and keys held) is kept in a fixed table sized at
+ * compile time, so any number of keyboards and remotes up to the table size
+ * can be connected at the same time. L2CAP data and events carry the channel
+ * CID only, the device of a channel is found in O(1) through a small open
+ * addressing map from CID to table index.
+ */
+
+#ifndef HID_CONTEXT_H
+#define HID_CONTEXT_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+#include "btstack_defines.h"
+#include "btstack_hid_parser.h"
+#include "hid_cache.h"
+
+// Maximum number of devices (a BR/EDR piconet has up to 7 active devices)
+#ifndef HID_CONTEXT_MAX
+    #define HID_CONTEXT_MAX 4
+#endif
+
+// Keys held in each input report of the layout
+#define HID_CONTEXT_MAX_PRESSED 8
+
+// No device index
+#define HID_CONTEXT_NONE 0xFF
+
+// Connection states
+#define HID_CONTEXT_IDLE        0  // Not connected
+#define HID_CONTEXT_SDP_QUERY   1  // SDP query of the HID service queued or in progress
+#define HID_CONTEXT_CONNECTING  2  // L2CAP channels being opened
+#define HID_CONTEXT_CONNECTED   3  // Interrupt channel open, reports can be received
+
+// SDP query purpose
+#define HID_CONTEXT_SDP_CONNECT 0  // Connect once the HID service is known
+#define HID_CONTEXT_SDP_REFRESH 1  // Check the cached record in the background of an open connection
+
+typedef struct {
+    uint16_t usage_page;
+    uint16_t usage;
+} hid_key_t;
+
+typedef struct {
+    bd_addr_t addr;
+    uint8_t index;                      // Position in the table
+    uint8_t state;                      // HID_CONTEXT_* connection state
+    uint8_t sdp_mode;                   // HID_CONTEXT_SDP_* purpose of the SDP query
+    uint8_t sdp_pending;                // SDP query waiting for the SDP client (one query at a time)
+    uint8_t cache_used;                 // record was loaded from or stored in the cache
+    uint8_t cache_checked;              // record was checked against the device since boot
+    hci_con_handle_t con_handle;        // ACL connection (HCI_CON_HANDLE_INVALID if none)
+    uint16_t control_cid;
+    uint16_t interrupt_cid;
+    hid_cache_entry_t record;           // SDP information in use (PSMs and HID descriptor)
+    btstack_hid_report_layout_t layout; // Report layout compiled from the descriptor
+    hid_key_t pressed[MAX_NR_HID_REPORT_LAYOUT_REPORTS][HID_CONTEXT_MAX_PRESSED];
+    uint8_t num_pressed[MAX_NR_HID_REPORT_LAYOUT_REPORTS];
+} hid_context_t;
+
+// Get the device of an address, adding it to the table if it is not there (NULL if full)
+hid_context_t* hid_context_add(const bd_addr_t addr);
+
+// Free the table slot of a device (its L2CAP channels must be unbound first)
+void hid_context_remove(hid_context_t* device);
+
+// Get the device at given table index (NULL if the slot is free)
+hid_context_t* hid_context_get(const uint8_t index);
+
+// Get the device of an address (NULL if unknown)
+hid_context_t* hid_context_get_by_addr(const bd_addr_t addr);
+
+// Get the device of an ACL connection (NULL if unknown)
+hid_context_t* hid_context_get_by_con_handle(const hci_con_handle_t con_handle);
+
+// Get the device owning an L2CAP channel (NULL if unknown)
+hid_context_t* hid_context_get_by_cid(const uint16_t cid);
+
+// Associate an L2CAP channel to a device, returns false if the map is full
+bool hid_context_bind_cid(hid_context_t* device, const uint16_t cid);
+
+// Remove an L2CAP channel association
+void hid_context_unbind_cid(const uint16_t cid);
+
+// Number of devices in the table
+uint8_t hid_context_count(void);
+
+#endif
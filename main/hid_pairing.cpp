@@ -0,0 +1,350 @@
+/* HID device discovery and pairing */
+
+#include "hid_pairing.h"
+
+#include <string.h>
+
+#include "btstack.h"
+#include "btstack_tlv.h"
+#include "event_log.h"
+#include "hid_cache.h"
+
+/**************************************************************************************************/
+
+// TLV tag of the allow-list
+#define HID_PAIRING_TLV_TAG (((uint32_t)'H' << 24) | ((uint32_t)'I' << 16) | ((uint32_t)'D' << 8) | 'A')
+
+// Inquiry length (1.28 s units), inquiries are repeated until a device is paired or timeout
+#define HID_PAIRING_INQUIRY_DURATION 4
+
+// New HID devices kept per inquiry, bonded one after the other until one succeeds
+#define HID_PAIRING_MAX_FOUND 4
+
+// Class of Device fields of keyboards and remote controls
+#define HID_PAIRING_COD_MAJOR(cod)        (((cod) >> 8) & 0x1F)
+#define HID_PAIRING_COD_MINOR_TYPE(cod)   (((cod) >> 2) & 0x0F)
+#define HID_PAIRING_COD_PERIPHERAL        0x05
+#define HID_PAIRING_COD_KEYBOARD          0x40  // Minor class keyboard bit
+#define HID_PAIRING_COD_REMOTE_CONTROL    0x03  // Minor class device type
+
+static_assert((HID_PAIRING_SEEN_LEN & (HID_PAIRING_SEEN_LEN - 1)) == 0,
+    "HID_PAIRING_SEEN_LEN must be a power of 2");
+
+// Pairing mode states
+#define HID_PAIRING_IDLE     0
+#define HID_PAIRING_INQUIRY  1  // Inquiry running
+#define HID_PAIRING_BONDING  2  // Bonding with a device found by the last inquiry
+
+static uint8_t state = HID_PAIRING_IDLE;
+static hid_pairing_handler_t paired_handler = NULL;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_timer_source_t timeout_timer;
+
+// Allow-list, most recently paired first
+static bd_addr_t allow_list[HID_PAIRING_MAX_DEVICES];
+static uint8_t num_allowed = 0;
+
+// Addresses seen by the running inquiry (open addressing, a slot is used if its bit is set)
+static bd_addr_t seen[HID_PAIRING_SEEN_LEN];
+static uint32_t seen_used[(HID_PAIRING_SEEN_LEN + 31) / 32];
+
+// New HID devices found by the last inquiry
+static bd_addr_t found[HID_PAIRING_MAX_FOUND];
+static uint8_t num_found = 0;
+static uint8_t next_found = 0;
+
+// Device being bonded (the bonding goes on if the pairing mode stops meanwhile)
+static bd_addr_t bonding_addr;
+static bool bonding = false;
+
+static hid_pairing_stats_t stats;
+
+/**************************************************************************************************/
+
+// Slot an address starts probing at (the lower address part is random enough to spread them)
+static inline uint32_t hid_pairing_seen_slot(const bd_addr_t addr)
+{
+    uint32_t key = ((uint32_t)addr[2] << 24) | ((uint32_t)addr[3] << 16) |
+        ((uint32_t)addr[4] << 8) | addr[5];
+
+    return ((key * 2654435761u) >> 16) & (HID_PAIRING_SEEN_LEN - 1);
+}
+
+// Look an address up, returns true if it was seen, otherwise gives the free slot to remember it at
+// (-1 if the set is full)
+static bool hid_pairing_seen(const bd_addr_t addr, int32_t* free_slot)
+{
+    uint32_t slot = hid_pairing_seen_slot(addr);
+
+    *free_slot = -1;
+    for(uint32_t probes = 0; probes < HID_PAIRING_SEEN_LEN; probes++)
+    {
+        if(!(seen_used[slot / 32] & (1u << (slot % 32))))
+        {
+            *free_slot = slot;
+            return false;
+        }
+        if(memcmp(seen[slot], addr, sizeof(bd_addr_t)) == 0)
+            return true;
+        slot = (slot + 1) & (HID_PAIRING_SEEN_LEN - 1);
+    }
+    return false;
+}
+
+// Remember an address at the free slot given by hid_pairing_seen()
+static void hid_pairing_seen_add(const bd_addr_t addr, const int32_t slot)
+{
+    if(slot < 0)
+    {
+        stats.overflow++;
+        return;
+    }
+    seen_used[slot / 32] |= (1u << (slot % 32));
+    memcpy(seen[slot], addr, sizeof(bd_addr_t));
+    stats.devices++;
+}
+
+static bool hid_pairing_cod_match(const uint32_t cod)
+{
+    if(HID_PAIRING_COD_MAJOR(cod) != HID_PAIRING_COD_PERIPHERAL)
+        return false;
+    return (cod & HID_PAIRING_COD_KEYBOARD) ||
+        (HID_PAIRING_COD_MINOR_TYPE(cod) == HID_PAIRING_COD_REMOTE_CONTROL);
+}
+
+static int hid_pairing_find(const bd_addr_t* list, const uint8_t num, const bd_addr_t addr)
+{
+    for(uint8_t i = 0; i < num; i++)
+    {
+        if(memcmp(list[i], addr, sizeof(bd_addr_t)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static void hid_pairing_store(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return;
+    tlv_impl->store_tag(tlv_context, HID_PAIRING_TLV_TAG, (const uint8_t*)allow_list,
+        num_allowed * sizeof(bd_addr_t));
+}
+
+// Put a paired device first in the allow-list, forgetting the oldest one if it is full, returns
+// true if a device was forgotten
+static bool hid_pairing_allow(const bd_addr_t addr, bd_addr_t evicted)
+{
+    int index = hid_pairing_find(allow_list, num_allowed, addr);
+    bool full = false;
+
+    if(index < 0)
+    {
+        if(num_allowed == HID_PAIRING_MAX_DEVICES)
+        {
+            // The link key and SDP record of the forgotten device are of no use anymore
+            full = true;
+            num_allowed--;
+            memcpy(evicted, allow_list[num_allowed], sizeof(bd_addr_t));
+            gap_drop_link_key_for_bd_addr(evicted);
+            hid_cache_delete(evicted);
+        }
+        index = num_allowed++;
+    }
+    memmove(allow_list[1], allow_list[0], index * sizeof(bd_addr_t));
+    memcpy(allow_list[0], addr, sizeof(bd_addr_t));
+    hid_pairing_store();
+    return full;
+}
+
+static void hid_pairing_inquiry(void)
+{
+    uint8_t status;
+
+    // Devices whose bonding failed are looked at again by the new inquiry
+    state = HID_PAIRING_INQUIRY;
+    num_found = 0;
+    next_found = 0;
+    memset(seen_used, 0, sizeof(seen_used));
+    status = gap_inquiry_start(HID_PAIRING_INQUIRY_DURATION);
+    if(status != ERROR_CODE_SUCCESS)
+    {
+        event_log(EVENT_LOG_PAIRING_FAILED, &status, 1);
+        hid_pairing_stop();
+    }
+}
+
+// Bond with the next device found by the last inquiry, or run a new inquiry if none is left
+static void hid_pairing_next(void)
+{
+    uint8_t status;
+
+    while(next_found < num_found)
+    {
+        memcpy(bonding_addr, found[next_found++], sizeof(bd_addr_t));
+        status = gap_dedicated_bonding(bonding_addr, 0);
+        if(status == ERROR_CODE_SUCCESS)
+        {
+            state = HID_PAIRING_BONDING;
+            bonding = true;
+            return;
+        }
+        event_log(EVENT_LOG_PAIRING_FAILED, &status, 1);
+    }
+    hid_pairing_inquiry();
+}
+
+static void hid_pairing_bonding_complete(const bd_addr_t addr, uint8_t status)
+{
+    bd_addr_t evicted;
+    bool full;
+
+    if(!bonding || (memcmp(addr, bonding_addr, sizeof(bd_addr_t)) != 0))
+        return;
+    bonding = false;
+    if(status != ERROR_CODE_SUCCESS)
+    {
+        event_log(EVENT_LOG_PAIRING_FAILED, &status, 1);
+        if(state == HID_PAIRING_BONDING)
+            hid_pairing_next();
+        return;
+    }
+
+    event_log(EVENT_LOG_PAIRED, addr, sizeof(bd_addr_t));
+    full = hid_pairing_allow(addr, evicted);
+    hid_pairing_stop();
+    if(paired_handler != NULL)
+        paired_handler(addr, full ? evicted : NULL);
+}
+
+static void hid_pairing_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet,
+    uint16_t size)
+{
+    bd_addr_t addr;
+    int32_t slot;
+
+    UNUSED(channel);
+    UNUSED(size);
+
+    if(packet_type != HCI_EVENT_PACKET)
+        return;
+    switch(hci_event_packet_get_type(packet))
+    {
+        case GAP_EVENT_INQUIRY_RESULT:
+            if(state != HID_PAIRING_INQUIRY)
+                break;
+            stats.results++;
+            gap_event_inquiry_result_get_bd_addr(packet, addr);
+            // Each device answers several times, its results are skipped once it is found or
+            // rejected by its class
+            if(hid_pairing_seen(addr, &slot))
+                break;
+            if(!hid_pairing_cod_match(gap_event_inquiry_result_get_class_of_device(packet)))
+            {
+                hid_pairing_seen_add(addr, slot);
+                break;
+            }
+            // Found devices are also checked for when the set is full
+            if((hid_pairing_find(allow_list, num_allowed, addr) >= 0) ||
+               (hid_pairing_find(found, num_found, addr) >= 0) || (num_found == HID_PAIRING_MAX_FOUND))
+            {
+                break;
+            }
+            hid_pairing_seen_add(addr, slot);
+            memcpy(found[num_found++], addr, sizeof(bd_addr_t));
+            stats.found++;
+            event_log(EVENT_LOG_PAIRING_FOUND, addr, sizeof(bd_addr_t));
+            break;
+
+        case GAP_EVENT_INQUIRY_COMPLETE:
+            if(state == HID_PAIRING_INQUIRY)
+                hid_pairing_next();
+            break;
+
+        case GAP_EVENT_DEDICATED_BONDING_COMPLETED:
+            gap_event_dedicated_bonding_completed_get_address(packet, addr);
+            hid_pairing_bonding_complete(addr,
+                gap_event_dedicated_bonding_completed_get_status(packet));
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void hid_pairing_timeout_handler(btstack_timer_source_t* ts)
+{
+    UNUSED(ts);
+    hid_pairing_stop();
+}
+
+/**************************************************************************************************/
+
+void hid_pairing_init(hid_pairing_handler_t handler)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    int size;
+
+    paired_handler = handler;
+    hci_event_callback_registration.callback = &hid_pairing_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    num_allowed = 0;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return;
+    size = tlv_impl->get_tag(tlv_context, HID_PAIRING_TLV_TAG, (uint8_t*)allow_list,
+        sizeof(allow_list));
+    if(size > 0)
+        num_allowed = size / sizeof(bd_addr_t);
+}
+
+uint8_t hid_pairing_get_allow_list(bd_addr_t* addrs, const uint8_t max)
+{
+    uint8_t num = (num_allowed < max) ? num_allowed : max;
+
+    memcpy(addrs, allow_list, num * sizeof(bd_addr_t));
+    return num;
+}
+
+void hid_pairing_start(void)
+{
+    btstack_run_loop_remove_timer(&timeout_timer);
+    btstack_run_loop_set_timer_handler(&timeout_timer, &hid_pairing_timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, HID_PAIRING_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&timeout_timer);
+    if(state != HID_PAIRING_IDLE)
+        return;
+
+    memset(&stats, 0, sizeof(stats));
+    event_log(EVENT_LOG_PAIRING_STARTED, NULL, 0);
+    if(bonding)
+        state = HID_PAIRING_BONDING;
+    else
+        hid_pairing_inquiry();
+}
+
+void hid_pairing_stop(void)
+{
+    if(state == HID_PAIRING_IDLE)
+        return;
+    if(state == HID_PAIRING_INQUIRY)
+        gap_inquiry_stop();
+    state = HID_PAIRING_IDLE;
+    btstack_run_loop_remove_timer(&timeout_timer);
+    event_log(EVENT_LOG_PAIRING_STOPPED, NULL, 0);
+}
+
+bool hid_pairing_active(void)
+{
+    return (state != HID_PAIRING_IDLE);
+}
+
+void hid_pairing_get_stats(hid_pairing_stats_t* stats_out)
+{
+    memcpy(stats_out, &stats, sizeof(hid_pairing_stats_t));
+}
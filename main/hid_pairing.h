@@ -0,0 +1,67 @@
+/* HID device discovery and pairing */
+
+/*
+ * Pairing mode runs GAP inquiries looking for keyboards and remote controls
+ * (Class of Device major class peripheral), bonds with the first new one found
+ * through Secure Simple Pairing and adds it to the allow-list of devices the
+ * bridge connects to. BTstack stores the link key in its link key DB and the
+ * allow-list is stored in TLV, so paired devices reconnect after a reboot.
+ *
+ * Every device in range answers an inquiry several times, an address found or
+ * rejected by its class is not looked at again in the same inquiry through a
+ * fixed size hash set, so places with dozens of devices around cost a hash
+ * probe per inquiry result.
+ */
+
+#ifndef HID_PAIRING_H
+#define HID_PAIRING_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+#include "hid_context.h"
+
+// Allow-list size, the oldest paired device is forgotten to pair a new one when it is full
+#ifndef HID_PAIRING_MAX_DEVICES
+    #define HID_PAIRING_MAX_DEVICES HID_CONTEXT_MAX
+#endif
+
+// Time the pairing mode lasts if no device is paired
+#ifndef HID_PAIRING_TIMEOUT_MS
+    #define HID_PAIRING_TIMEOUT_MS 60000
+#endif
+
+// Addresses remembered per inquiry (power of 2), results of other devices are not filtered
+#ifndef HID_PAIRING_SEEN_LEN
+    #define HID_PAIRING_SEEN_LEN 64
+#endif
+
+typedef struct {
+    uint32_t results;   // Inquiry results received
+    uint32_t devices;   // Devices found or rejected by class, once per inquiry
+    uint32_t found;     // New HID devices found
+    uint32_t overflow;  // Results of devices not remembered (hash set full)
+} hid_pairing_stats_t;
+
+// Called when a device is paired, with the device forgotten to make room for it (NULL if none)
+typedef void (*hid_pairing_handler_t)(const bd_addr_t addr, const uint8_t* evicted_addr);
+
+// Load the allow-list and register for the GAP events (after the HCI event handler of the bridge)
+void hid_pairing_init(hid_pairing_handler_t handler);
+
+// Get the allow-list (loaded from TLV), most recently paired first, returns the number of devices
+uint8_t hid_pairing_get_allow_list(bd_addr_t* addrs, const uint8_t max);
+
+// Start the pairing mode (restarts the timeout if already running)
+void hid_pairing_start(void);
+
+// Stop the pairing mode, a pairing in progress is completed
+void hid_pairing_stop(void);
+
+// Check if the pairing mode is running
+bool hid_pairing_active(void);
+
+// Get the inquiry results of the last pairing mode
+void hid_pairing_get_stats(hid_pairing_stats_t* stats);
+
+#endif
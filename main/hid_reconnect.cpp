@@ -0,0 +1,323 @@
+/* HID device reconnection manager */
+
+#include "hid_reconnect.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "event_log.h"
+
+/**************************************************************************************************/
+
+// Write Page Scan Type is not in the BTstack command set
+static const hci_cmd_t hci_write_page_scan_type =
+{
+    (OGF_CONTROLLER_BASEBAND << 10) | 0x47, "1"
+};
+
+// Interlaced page scan: a second scan right after the first one on the other train, so a device
+// paging the bridge is found within one interval whatever train it starts with
+#define HID_RECONNECT_PAGE_SCAN_INTERLACED 0x01
+
+// Controller settings still to write
+#define HID_RECONNECT_CONFIG_SCAN_ACTIVITY 0x01
+#define HID_RECONNECT_CONFIG_SCAN_TYPE     0x02
+#define HID_RECONNECT_CONFIG_PAGE_TIMEOUT  0x04
+#define HID_RECONNECT_CONFIG_ALL           0x07
+
+typedef struct {
+    btstack_timer_source_t timer;  // Next page
+    uint8_t timer_active;
+    uint8_t page_queued;           // Page waiting for the controller (one page at a time)
+    uint8_t retries;               // Pages failed since the device was last connected
+    uint8_t incoming;              // Connection request of the device being accepted
+    uint8_t timing;                // Reconnection waiting for its first key
+    uint32_t start_ms;             // Time the reconnection started
+} hid_reconnect_device_t;
+
+static hid_reconnect_page_t page_handler = NULL;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint8_t config_pending = 0;
+
+static hid_reconnect_device_t devices[HID_CONTEXT_MAX];
+
+// Device being paged (NULL if the controller is not paging)
+static hid_context_t* paging = NULL;
+
+static hid_reconnect_stats_t stats;
+
+/**************************************************************************************************/
+
+// Write the next controller setting if the controller can take a command
+static void hid_reconnect_configure(void)
+{
+    if(!config_pending || !hci_can_send_command_packet_now())
+        return;
+    if(config_pending & HID_RECONNECT_CONFIG_SCAN_ACTIVITY)
+    {
+        config_pending &= ~HID_RECONNECT_CONFIG_SCAN_ACTIVITY;
+        hci_send_cmd(&hci_write_page_scan_activity, HID_RECONNECT_PAGE_SCAN_INTERVAL,
+            HID_RECONNECT_PAGE_SCAN_WINDOW);
+    }
+    else if(config_pending & HID_RECONNECT_CONFIG_SCAN_TYPE)
+    {
+        config_pending &= ~HID_RECONNECT_CONFIG_SCAN_TYPE;
+        hci_send_cmd(&hci_write_page_scan_type, HID_RECONNECT_PAGE_SCAN_INTERLACED);
+    }
+    else
+    {
+        config_pending &= ~HID_RECONNECT_CONFIG_PAGE_TIMEOUT;
+        hci_send_cmd(&hci_write_page_timeout, HID_RECONNECT_PAGE_TIMEOUT);
+    }
+}
+
+// Accept connections of the known devices only
+static int hid_reconnect_filter(bd_addr_t addr)
+{
+    return (hid_context_get_by_addr(addr) != NULL);
+}
+
+static void hid_reconnect_cancel(hid_context_t* device)
+{
+    hid_reconnect_device_t* state = &devices[device->index];
+
+    btstack_run_loop_remove_timer(&state->timer);
+    state->timer_active = 0;
+    state->page_queued = 0;
+}
+
+// Page the next device waiting for the controller
+static void hid_reconnect_page_next(void)
+{
+    hid_context_t* device;
+    hid_reconnect_device_t* state;
+    bool connected;
+
+    if(paging != NULL)
+        return;
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        device = hid_context_get(i);
+        state = &devices[i];
+        if((device == NULL) || !state->page_queued)
+            continue;
+        state->page_queued = 0;
+        state->start_ms = btstack_run_loop_get_time_ms();
+        // The channels are opened on the ACL connection if there is one already, no page then
+        connected = (hci_connection_for_bd_addr_and_type(device->addr, BD_ADDR_TYPE_ACL) != NULL);
+        if(!page_handler(device) || connected)
+            continue;
+        paging = device;
+        stats.pages++;
+        event_log(EVENT_LOG_PAGE, &device->index, 1);
+        return;
+    }
+}
+
+static void hid_reconnect_timer_handler(btstack_timer_source_t* ts)
+{
+    hid_context_t* device = (hid_context_t*)btstack_run_loop_get_timer_context(ts);
+
+    devices[device->index].timer_active = 0;
+    devices[device->index].page_queued = 1;
+    hid_reconnect_page_next();
+}
+
+static void hid_reconnect_connection_request(const bd_addr_t addr)
+{
+    hid_context_t* device = hid_context_get_by_addr(addr);
+    hid_reconnect_device_t* state;
+
+    if(device == NULL)
+        return;
+    // The device came back on its own, no need to page it
+    state = &devices[device->index];
+    hid_reconnect_cancel(device);
+    state->incoming = 1;
+    state->start_ms = btstack_run_loop_get_time_ms();
+    event_log(EVENT_LOG_CONNECTION_REQUEST, &device->index, 1);
+}
+
+static void hid_reconnect_connection_complete(const bd_addr_t addr, const uint8_t status)
+{
+    hid_context_t* device = hid_context_get_by_addr(addr);
+    hid_reconnect_device_t* state;
+
+    if(device == NULL)
+        return;
+    state = &devices[device->index];
+    if(paging == device)
+    {
+        paging = NULL;
+        if(status == ERROR_CODE_SUCCESS)
+        {
+            stats.outgoing++;
+            state->timing = 1;
+        }
+        else
+        {
+            paging = device;
+            hid_reconnect_lost(device, false);
+        }
+        hid_reconnect_page_next();
+    }
+    else if(state->incoming)
+    {
+        state->incoming = 0;
+        if(status == ERROR_CODE_SUCCESS)
+        {
+            stats.incoming++;
+            state->timing = 1;
+        }
+        else
+            hid_reconnect_lost(device, false);
+    }
+}
+
+static void hid_reconnect_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet,
+    uint16_t size)
+{
+    bd_addr_t addr;
+
+    UNUSED(channel);
+    UNUSED(size);
+
+    if(packet_type != HCI_EVENT_PACKET)
+        return;
+    switch(hci_event_packet_get_type(packet))
+    {
+        case BTSTACK_EVENT_STATE:
+            if(btstack_event_state_get_state(packet) == HCI_STATE_WORKING)
+                config_pending = HID_RECONNECT_CONFIG_ALL;
+            break;
+
+        case HCI_EVENT_CONNECTION_REQUEST:
+            hci_event_connection_request_get_bd_addr(packet, addr);
+            hid_reconnect_connection_request(addr);
+            break;
+
+        case HCI_EVENT_CONNECTION_COMPLETE:
+            hci_event_connection_complete_get_bd_addr(packet, addr);
+            hid_reconnect_connection_complete(addr,
+                hci_event_connection_complete_get_status(packet));
+            break;
+
+        default:
+            break;
+    }
+    hid_reconnect_configure();
+}
+
+/**************************************************************************************************/
+
+void hid_reconnect_init(hid_reconnect_page_t page)
+{
+    page_handler = page;
+    hci_event_callback_registration.callback = &hid_reconnect_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    gap_register_classic_connection_filter(&hid_reconnect_filter);
+    gap_connectable_control(1);
+}
+
+void hid_reconnect_start(hid_context_t* device)
+{
+    hid_reconnect_cancel(device);
+    devices[device->index].retries = 0;
+    devices[device->index].page_queued = 1;
+    hid_reconnect_page_next();
+}
+
+void hid_reconnect_lost(hid_context_t* device, const bool closed_by_device)
+{
+    hid_reconnect_device_t* state = &devices[device->index];
+    uint32_t delay_ms = HID_RECONNECT_BACKOFF_MIN_MS;
+
+    state->timing = 0;
+    if(paging == device)
+    {
+        // Page failed (the L2CAP channel of the page reports it before the ACL event)
+        paging = NULL;
+        stats.page_failures++;
+        event_log(EVENT_LOG_PAGE_FAILED, &device->index, 1);
+        hid_reconnect_page_next();
+    }
+    // Already waiting (the failure of a page is reported by the ACL and the L2CAP events)
+    if(state->timer_active || state->page_queued)
+        return;
+
+    for(uint8_t i = 0; (i < state->retries) && (delay_ms < HID_RECONNECT_BACKOFF_MAX_MS); i++)
+        delay_ms *= 2;
+    // The device pages the bridge itself when it wakes up, the backoff starts long
+    while(closed_by_device && (delay_ms < HID_RECONNECT_SLEEP_DELAY_MS))
+    {
+        delay_ms *= 2;
+        state->retries++;
+    }
+    if(delay_ms > HID_RECONNECT_BACKOFF_MAX_MS)
+        delay_ms = HID_RECONNECT_BACKOFF_MAX_MS;
+    if(state->retries < UINT8_MAX)
+        state->retries++;
+
+    state->timer_active = 1;
+    btstack_run_loop_set_timer_handler(&state->timer, &hid_reconnect_timer_handler);
+    btstack_run_loop_set_timer_context(&state->timer, device);
+    btstack_run_loop_set_timer(&state->timer, delay_ms);
+    btstack_run_loop_add_timer(&state->timer);
+}
+
+void hid_reconnect_connected(hid_context_t* device)
+{
+    hid_reconnect_cancel(device);
+    devices[device->index].retries = 0;
+}
+
+void hid_reconnect_key(hid_context_t* device)
+{
+    hid_reconnect_device_t* state = &devices[device->index];
+    uint32_t elapsed_ms;
+
+    if(!state->timing)
+        return;
+    state->timing = 0;
+    elapsed_ms = btstack_run_loop_get_time_ms() - state->start_ms;
+    if(elapsed_ms > HID_RECONNECT_FIRST_KEY_MAX_MS)
+        return;
+    if((stats.first_keys == 0) || (elapsed_ms < stats.first_key_min_ms))
+        stats.first_key_min_ms = elapsed_ms;
+    if(elapsed_ms > stats.first_key_max_ms)
+        stats.first_key_max_ms = elapsed_ms;
+    stats.first_key_sum_ms += elapsed_ms;
+    stats.first_keys++;
+}
+
+void hid_reconnect_stop(hid_context_t* device)
+{
+    hid_reconnect_cancel(device);
+    devices[device->index].incoming = 0;
+    devices[device->index].timing = 0;
+    if(paging == device)
+    {
+        paging = NULL;
+        hid_reconnect_page_next();
+    }
+}
+
+void hid_reconnect_get_stats(hid_reconnect_stats_t* stats_out)
+{
+    memcpy(stats_out, &stats, sizeof(hid_reconnect_stats_t));
+}
+
+void hid_reconnect_dump(void)
+{
+    printf("Reconnections: %u by the devices, %u by paging, %u pages (%u failed)\n",
+        stats.incoming, stats.outgoing, stats.pages, stats.page_failures);
+    if(stats.first_keys == 0)
+    {
+        printf("Time to first key: no samples\n");
+        return;
+    }
+    printf("Time to first key: %u samples, min %u ms, avg %u ms, max %u ms\n", stats.first_keys,
+        stats.first_key_min_ms, stats.first_key_sum_ms / stats.first_keys, stats.first_key_max_ms);
+}
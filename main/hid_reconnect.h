@@ -0,0 +1,92 @@
+/* HID device reconnection manager */
+
+/*
+ * Keyboards and remote controls page the host themselves when they wake up
+ * (the key press that woke them is sent right after), so the bridge stays
+ * connectable for the devices it knows with a short interlaced page scan and
+ * accepts their connection and HID channels. Only when a device does not come
+ * back on its own the bridge pages it, one page at a time and with an
+ * exponential backoff, so a device switched off does not keep the controller
+ * paging (and deaf to the other devices) for ever.
+ *
+ * The time from the start of each reconnection (connection request of the
+ * device, or page of the bridge) to the first key received is recorded.
+ */
+
+#ifndef HID_RECONNECT_H
+#define HID_RECONNECT_H
+
+#include <stdint.h>
+
+#include "hid_context.h"
+
+// Page scan interval and window (0.625 ms units), a device paging the bridge connects in less than
+// an interval
+#ifndef HID_RECONNECT_PAGE_SCAN_INTERVAL
+    #define HID_RECONNECT_PAGE_SCAN_INTERVAL 0x0180  // 240 ms
+#endif
+#ifndef HID_RECONNECT_PAGE_SCAN_WINDOW
+    #define HID_RECONNECT_PAGE_SCAN_WINDOW   0x0024  // 22.5 ms
+#endif
+
+// Page timeout (0.625 ms units), devices in page scan answer within 1.28 s
+#ifndef HID_RECONNECT_PAGE_TIMEOUT
+    #define HID_RECONNECT_PAGE_TIMEOUT 0x1000  // 2.56 s
+#endif
+
+// Delay before paging a device lost, doubled on each failed page up to the maximum
+#ifndef HID_RECONNECT_BACKOFF_MIN_MS
+    #define HID_RECONNECT_BACKOFF_MIN_MS 1000
+#endif
+#ifndef HID_RECONNECT_BACKOFF_MAX_MS
+    #define HID_RECONNECT_BACKOFF_MAX_MS 64000
+#endif
+
+// Delay before paging a device that closed the connection itself (gone to sleep or switched off)
+#ifndef HID_RECONNECT_SLEEP_DELAY_MS
+    #define HID_RECONNECT_SLEEP_DELAY_MS 32000
+#endif
+
+// Keys received later than this after a reconnection are not counted as its first key
+#ifndef HID_RECONNECT_FIRST_KEY_MAX_MS
+    #define HID_RECONNECT_FIRST_KEY_MAX_MS 10000
+#endif
+
+typedef struct {
+    uint32_t incoming;           // Reconnections started by the device
+    uint32_t outgoing;           // Reconnections by paging the device
+    uint32_t pages;              // Pages started
+    uint32_t page_failures;      // Pages failed (device off or out of range)
+    uint32_t first_keys;         // Reconnections followed by a key
+    uint32_t first_key_min_ms;   // Time from the start of the reconnection to the first key
+    uint32_t first_key_max_ms;
+    uint32_t first_key_sum_ms;
+} hid_reconnect_stats_t;
+
+// Page a device (open its HID channels), returns false if it can not be paged now
+typedef bool (*hid_reconnect_page_t)(hid_context_t* device);
+
+// Register for the HCI events and make the bridge connectable by the devices it knows
+void hid_reconnect_init(hid_reconnect_page_t page);
+
+// Page a device as soon as the controller is free (on power up or when it is added)
+void hid_reconnect_start(hid_context_t* device);
+
+// Connection to a device lost or failed, wait for the device to come back and page it later (much
+// later if the device closed the connection itself)
+void hid_reconnect_lost(hid_context_t* device, const bool closed_by_device);
+
+// HID channels of a device open, reset its backoff
+void hid_reconnect_connected(hid_context_t* device);
+
+// Key received from a device, records the time to the first key of a reconnection
+void hid_reconnect_key(hid_context_t* device);
+
+// Forget a device, cancelling its pages
+void hid_reconnect_stop(hid_context_t* device);
+
+// Get and print the reconnection statistics
+void hid_reconnect_get_stats(hid_reconnect_stats_t* stats);
+void hid_reconnect_dump(void);
+
+#endif
@@ -0,0 +1,239 @@
+/* HID link power mode policy */
+
+#include "hid_sniff.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack.h"
+
+/**************************************************************************************************/
+
+// HCI link modes (Mode Change event)
+#define HID_SNIFF_HCI_MODE_ACTIVE 0x00
+#define HID_SNIFF_HCI_MODE_SNIFF  0x02
+
+typedef struct {
+    btstack_timer_source_t timer;  // Next step down of the policy
+    uint8_t connected;
+    uint8_t mode;                  // Current link mode
+    uint8_t target;                // Mode wanted by the policy
+    uint8_t pending;               // Mode change requested, waiting for the controller
+    uint32_t since_ms;             // Time the current mode was entered
+} hid_sniff_device_t;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static hid_sniff_device_t devices[HID_CONTEXT_MAX];
+static hid_sniff_stats_t stats;
+
+static const char* const mode_names[HID_SNIFF_NUM_MODES] = { "active", "short sniff", "long sniff" };
+
+/**************************************************************************************************/
+
+static void hid_sniff_timer_handler(btstack_timer_source_t* ts);
+
+static void hid_sniff_set_timer(hid_context_t* device, const uint32_t delay_ms)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+
+    btstack_run_loop_remove_timer(&state->timer);
+    btstack_run_loop_set_timer_handler(&state->timer, &hid_sniff_timer_handler);
+    btstack_run_loop_set_timer_context(&state->timer, device);
+    btstack_run_loop_set_timer(&state->timer, delay_ms);
+    btstack_run_loop_add_timer(&state->timer);
+}
+
+// Request the next mode change towards the policy mode (the sniff interval can only be changed
+// from active mode)
+static void hid_sniff_run(hid_context_t* device)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+    uint8_t status;
+
+    if(!state->connected || state->pending || (state->mode == state->target))
+        return;
+    if(state->mode != HID_SNIFF_ACTIVE)
+        status = gap_sniff_mode_exit(device->con_handle);
+    else if(state->target == HID_SNIFF_SHORT)
+    {
+        status = gap_sniff_mode_enter(device->con_handle, HID_SNIFF_SHORT_MIN_INTERVAL,
+            HID_SNIFF_SHORT_MAX_INTERVAL, HID_SNIFF_ATTEMPT, HID_SNIFF_TIMEOUT);
+    }
+    else
+    {
+        status = gap_sniff_mode_enter(device->con_handle, HID_SNIFF_LONG_MIN_INTERVAL,
+            HID_SNIFF_LONG_MAX_INTERVAL, HID_SNIFF_ATTEMPT, HID_SNIFF_TIMEOUT);
+    }
+    if(status != ERROR_CODE_SUCCESS)
+        return;
+    state->pending = 1;
+    stats.requests++;
+}
+
+// Idle for the hold time of the current policy mode, step down
+static void hid_sniff_timer_handler(btstack_timer_source_t* ts)
+{
+    hid_context_t* device = (hid_context_t*)btstack_run_loop_get_timer_context(ts);
+    hid_sniff_device_t* state = &devices[device->index];
+
+    if(state->target == HID_SNIFF_ACTIVE)
+    {
+        state->target = HID_SNIFF_SHORT;
+        hid_sniff_set_timer(device, HID_SNIFF_SHORT_HOLD_MS);
+    }
+    else
+        state->target = HID_SNIFF_LONG;
+    hid_sniff_run(device);
+}
+
+static void hid_sniff_mode_change(hid_context_t* device, const uint8_t status, const uint8_t hci_mode,
+    const uint16_t interval)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+    uint8_t mode = HID_SNIFF_ACTIVE;
+
+    state->pending = 0;
+    if(status != ERROR_CODE_SUCCESS)
+    {
+        // Keep the current mode until the next policy step
+        stats.failures++;
+        state->target = state->mode;
+        return;
+    }
+    // Sniff requested by the device is classified by its interval
+    if(hci_mode == HID_SNIFF_HCI_MODE_SNIFF)
+    {
+        mode = (interval <= HID_SNIFF_SHORT_MAX_INTERVAL) ? HID_SNIFF_SHORT : HID_SNIFF_LONG;
+        stats.interval_ms[mode] = ((uint32_t)interval * 625) / 1000;
+    }
+    if(mode != state->mode)
+    {
+        stats.time_ms[state->mode] += now_ms - state->since_ms;
+        state->since_ms = now_ms;
+        state->mode = mode;
+        stats.transitions[mode]++;
+    }
+    hid_sniff_run(device);
+}
+
+// A mode change refused by the controller gets no Mode Change event
+static void hid_sniff_command_failed(void)
+{
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        if(!devices[i].pending)
+            continue;
+        devices[i].pending = 0;
+        devices[i].target = devices[i].mode;
+        stats.failures++;
+    }
+}
+
+static void hid_sniff_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet,
+    uint16_t size)
+{
+    hid_context_t* device;
+
+    UNUSED(channel);
+    UNUSED(size);
+
+    if(packet_type != HCI_EVENT_PACKET)
+        return;
+    switch(hci_event_packet_get_type(packet))
+    {
+        case HCI_EVENT_MODE_CHANGE:
+            device = hid_context_get_by_con_handle(hci_event_mode_change_get_handle(packet));
+            if((device == NULL) || !devices[device->index].connected)
+                break;
+            hid_sniff_mode_change(device, hci_event_mode_change_get_status(packet),
+                hci_event_mode_change_get_mode(packet), hci_event_mode_change_get_interval(packet));
+            break;
+
+        case HCI_EVENT_COMMAND_STATUS:
+            if(hci_event_command_status_get_status(packet) == ERROR_CODE_SUCCESS)
+                break;
+            if(HCI_EVENT_IS_COMMAND_STATUS(packet, hci_sniff_mode) ||
+               HCI_EVENT_IS_COMMAND_STATUS(packet, hci_exit_sniff_mode))
+            {
+                hid_sniff_command_failed();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**************************************************************************************************/
+
+void hid_sniff_init(void)
+{
+    hci_event_callback_registration.callback = &hid_sniff_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+}
+
+void hid_sniff_connected(hid_context_t* device)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+
+    state->connected = 1;
+    state->pending = 0;
+    state->mode = HID_SNIFF_ACTIVE;
+    state->target = HID_SNIFF_ACTIVE;
+    state->since_ms = btstack_run_loop_get_time_ms();
+    stats.transitions[HID_SNIFF_ACTIVE]++;
+    hid_sniff_set_timer(device, HID_SNIFF_ACTIVE_HOLD_MS);
+}
+
+void hid_sniff_activity(hid_context_t* device)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+
+    if(!state->connected)
+        return;
+    stats.reports[state->mode]++;
+    state->target = HID_SNIFF_ACTIVE;
+    hid_sniff_set_timer(device, HID_SNIFF_ACTIVE_HOLD_MS);
+    hid_sniff_run(device);
+}
+
+void hid_sniff_disconnected(hid_context_t* device)
+{
+    hid_sniff_device_t* state = &devices[device->index];
+
+    if(!state->connected)
+        return;
+    btstack_run_loop_remove_timer(&state->timer);
+    stats.time_ms[state->mode] += btstack_run_loop_get_time_ms() - state->since_ms;
+    state->connected = 0;
+    state->pending = 0;
+}
+
+void hid_sniff_get_stats(hid_sniff_stats_t* stats_out)
+{
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+
+    memcpy(stats_out, &stats, sizeof(hid_sniff_stats_t));
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        if(devices[i].connected)
+            stats_out->time_ms[devices[i].mode] += now_ms - devices[i].since_ms;
+    }
+}
+
+void hid_sniff_dump(void)
+{
+    hid_sniff_stats_t current;
+
+    hid_sniff_get_stats(&current);
+    printf("Link modes: %u changes requested, %u refused\n", current.requests, current.failures);
+    for(uint8_t i = 0; i < HID_SNIFF_NUM_MODES; i++)
+    {
+        printf("  %-11s %u times, %u ms, %u reports", mode_names[i], current.transitions[i],
+            current.time_ms[i], current.reports[i]);
+        if(i != HID_SNIFF_ACTIVE)
+            printf(" (delayed up to %u ms)", current.interval_ms[i]);
+        printf("\n");
+    }
+}
@@ -0,0 +1,86 @@
+/* HID link power mode policy */
+
+/*
+ * A link in sniff mode only listens once per sniff interval, so a key
+ * pressed on an idle keyboard waits up to one interval before its report
+ * gets through. The bridge drives the sniff mode of each link from the HID
+ * activity instead of leaving it to the device: the link goes active on the
+ * first report and stays active for a hold time while keys are being typed,
+ * then drops to a short sniff interval and, after a longer idle time, to a
+ * long one that saves more power at the cost of a slower first key.
+ *
+ * Mode changes, the time spent in each mode and the reports received in
+ * each mode (with the interval they could be delayed by) are counted.
+ */
+
+#ifndef HID_SNIFF_H
+#define HID_SNIFF_H
+
+#include <stdint.h>
+
+#include "hid_context.h"
+
+// Time the link stays active after the last report
+#ifndef HID_SNIFF_ACTIVE_HOLD_MS
+    #define HID_SNIFF_ACTIVE_HOLD_MS 2000
+#endif
+
+// Time the link stays in short sniff before the long one
+#ifndef HID_SNIFF_SHORT_HOLD_MS
+    #define HID_SNIFF_SHORT_HOLD_MS 30000
+#endif
+
+// Sniff intervals (0.625 ms units, even values), the controllers agree on one in the range
+#ifndef HID_SNIFF_SHORT_MIN_INTERVAL
+    #define HID_SNIFF_SHORT_MIN_INTERVAL 0x0012  // 11.25 ms
+#endif
+#ifndef HID_SNIFF_SHORT_MAX_INTERVAL
+    #define HID_SNIFF_SHORT_MAX_INTERVAL 0x0018  // 15 ms
+#endif
+#ifndef HID_SNIFF_LONG_MIN_INTERVAL
+    #define HID_SNIFF_LONG_MIN_INTERVAL  0x0080  // 80 ms
+#endif
+#ifndef HID_SNIFF_LONG_MAX_INTERVAL
+    #define HID_SNIFF_LONG_MAX_INTERVAL  0x00A0  // 100 ms
+#endif
+
+// Sniff attempt and timeout (baseband receive slots)
+#ifndef HID_SNIFF_ATTEMPT
+    #define HID_SNIFF_ATTEMPT 2
+#endif
+#ifndef HID_SNIFF_TIMEOUT
+    #define HID_SNIFF_TIMEOUT 1
+#endif
+
+// Link modes
+#define HID_SNIFF_ACTIVE     0
+#define HID_SNIFF_SHORT      1  // Sniff with an interval up to HID_SNIFF_SHORT_MAX_INTERVAL
+#define HID_SNIFF_LONG       2  // Sniff with a longer interval
+#define HID_SNIFF_NUM_MODES  3
+
+typedef struct {
+    uint32_t transitions[HID_SNIFF_NUM_MODES];  // Times a link entered each mode
+    uint32_t time_ms[HID_SNIFF_NUM_MODES];      // Time spent by the links in each mode
+    uint32_t reports[HID_SNIFF_NUM_MODES];      // Reports received in each mode
+    uint32_t interval_ms[HID_SNIFF_NUM_MODES];  // Last sniff interval of each mode (report delay bound)
+    uint32_t requests;                          // Mode changes requested
+    uint32_t failures;                          // Mode changes refused
+} hid_sniff_stats_t;
+
+// Register for the mode change events
+void hid_sniff_init(void);
+
+// HID channels of a device open, the link starts active
+void hid_sniff_connected(hid_context_t* device);
+
+// Report received from a device, keep its link active
+void hid_sniff_activity(hid_context_t* device);
+
+// Connection of a device closed
+void hid_sniff_disconnected(hid_context_t* device);
+
+// Get and print the counters (time in each mode includes the current one of connected links)
+void hid_sniff_get_stats(hid_sniff_stats_t* stats);
+void hid_sniff_dump(void);
+
+#endif
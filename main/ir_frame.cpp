@@ -0,0 +1,90 @@
+/* Protocol independent IR frames */
+
+#include "ir_frame.h"
+
+#include <stddef.h>
+
+/**************************************************************************************************/
+
+// Protocols, indexed by their number
+static const ir_protocol_t protocols[IR_PROTOCOL_COUNT] =
+{
+    // name         bits  frames  toggle  period
+    { "raw",          0,     1,     0,       0 },
+    { "nec",         32,     1,     0,     IR_NEC_REPEAT_PERIOD_MS },  // Copies are repeat bursts
+    { "samsung",     32,     1,     0,     108 },
+    { "sony",        12,     3,     0,      45 },
+    { "rc5",         12,     1,     1,     114 },
+    { "rc6",         20,     1,     1,     107 },
+    { "panasonic",   48,     1,     0,     130 },
+    { "jvc",         16,     1,     0,      55 }   // Copies have no header
+};
+
+/**************************************************************************************************/
+
+// Reverse the bit order of a field (Sony sends LSB first, IRremote MSB first)
+static uint32_t ir_reverse(uint32_t value, const uint8_t bits)
+{
+    uint32_t reversed = 0;
+
+    for(uint8_t i = 0; i < bits; i++)
+    {
+        reversed = (reversed << 1) | (value & 1);
+        value >>= 1;
+    }
+    return reversed;
+}
+
+/**************************************************************************************************/
+
+const ir_protocol_t* ir_protocol_get(const uint8_t protocol)
+{
+    if(protocol >= IR_PROTOCOL_COUNT)
+        return NULL;
+    return &protocols[protocol];
+}
+
+uint8_t ir_frame_bits(const ir_frame_t* frame)
+{
+    if(frame->bits != 0)
+        return frame->bits;
+    return (frame->protocol < IR_PROTOCOL_COUNT) ? protocols[frame->protocol].bits : 0;
+}
+
+uint8_t ir_frame_count(const ir_frame_t* frame)
+{
+    uint8_t min_frames;
+
+    if(frame->protocol >= IR_PROTOCOL_COUNT)
+        return 0;
+    min_frames = protocols[frame->protocol].min_frames;
+    return (1 + frame->repeat > min_frames) ? (1 + frame->repeat) : min_frames;
+}
+
+uint32_t ir_frame_data(const ir_frame_t* frame, const bool toggle)
+{
+    uint8_t address_bits;
+
+    switch(frame->protocol)
+    {
+        case IR_PROTOCOL_NEC:
+        case IR_PROTOCOL_SAMSUNG:
+            return ((uint32_t)frame->address << 16) | (frame->command & 0xFFFF);
+        case IR_PROTOCOL_SONY:
+            // Command then address, each one LSB first
+            address_bits = (ir_frame_bits(frame) > 7) ? (ir_frame_bits(frame) - 7) : 0;
+            return (ir_reverse(frame->command, 7) << address_bits) |
+                ir_reverse(frame->address, address_bits);
+        case IR_PROTOCOL_RC5:
+            // Second start bit is sent by the encoder
+            return ((uint32_t)toggle << 11) | ((frame->address & 0x1F) << 6) | (frame->command & 0x3F);
+        case IR_PROTOCOL_RC6:
+            // Mode 0 and trailer (toggle) bit
+            return ((uint32_t)toggle << 16) | ((frame->address & 0xFF) << 8) | (frame->command & 0xFF);
+        case IR_PROTOCOL_JVC:
+            return ((frame->address & 0xFF) << 8) | (frame->command & 0xFF);
+        default:
+            // Panasonic address is sent apart by its encoder
+            return frame->command;
+    }
+}
@@ -0,0 +1,62 @@
+/* Protocol independent IR frames */
+
+/*
+ * A frame is given by its protocol, and the address and command fields as
+ * that protocol defines them. The transmitter hands it to the IRremote
+ * encoder of the protocol through a function table, and sends the copies the
+ * protocol asks for one frame period apart (Sony frames go three times, RC5
+ * and RC6 flip their toggle bit on each new frame but not on its copies, NEC
+ * and JVC repeat with a short burst or a frame without header). Precomputed
+ * waveforms (LG codes, learned timings) go through the same path as RAW
+ * frames.
+ */
+
+#ifndef IR_FRAME_H
+#define IR_FRAME_H
+
+#include <stdint.h>
+
+#include "ir_waveform.h"
+
+// Protocols
+#define IR_PROTOCOL_RAW        0  // Precomputed waveform
+#define IR_PROTOCOL_NEC        1  // 16 bits address (with its complement or extended), 16 bits command
+                                  // (with its complement)
+#define IR_PROTOCOL_SAMSUNG    2  // Same fields as NEC
+#define IR_PROTOCOL_SONY       3  // 7 bits command, 5, 8 or 13 bits address (12, 15 or 20 bits frame)
+#define IR_PROTOCOL_RC5        4  // 5 bits address, 6 bits command
+#define IR_PROTOCOL_RC6        5  // Mode 0, 8 bits address, 8 bits command
+#define IR_PROTOCOL_PANASONIC  6  // 16 bits vendor address, 32 bits command
+#define IR_PROTOCOL_JVC        7  // 8 bits address, 8 bits command
+#define IR_PROTOCOL_COUNT      8
+
+typedef struct {
+    uint8_t              protocol;  // IR_PROTOCOL_*
+    uint8_t              bits;      // Frame length (0 for the protocol default)
+    uint8_t              repeat;    // Copies sent after the first frame, on top of those the protocol needs
+    uint16_t             address;
+    uint32_t             command;
+    const ir_waveform_t* waveform;  // RAW frame, or precomputed NEC frame (NULL to encode it)
+} ir_frame_t;
+
+typedef struct {
+    const char* name;
+    uint8_t     bits;        // Default frame length
+    uint8_t     min_frames;  // Frames sent at least (first one and copies)
+    uint8_t     toggle;      // Toggle bit flipped on each new frame
+    uint16_t    period_ms;   // From a frame start to the next one (0 if the gap is in the waveform)
+} ir_protocol_t;
+
+// Get the description of a protocol (NULL if it is not known)
+const ir_protocol_t* ir_protocol_get(const uint8_t protocol);
+
+// Frame length in bits
+uint8_t ir_frame_bits(const ir_frame_t* frame);
+
+// Number of frames to send (first one and copies)
+uint8_t ir_frame_count(const ir_frame_t* frame);
+
+// Data word of the IRremote encoder of the frame, with given toggle bit (protocols having one)
+uint32_t ir_frame_data(const ir_frame_t* frame, const bool toggle);
+
+#endif
@@ -0,0 +1,57 @@
+/* IR key hold (repeat frame) engine */
+
+#include "ir_hold.h"
+
+#include <stddef.h>
+
+/**************************************************************************************************/
+
+void ir_hold_init(ir_hold_t* hold)
+{
+    hold->repeat = NULL;
+    hold->period_ms = 0;
+    hold->last_start_ms = 0;
+    hold->repeats = 0;
+}
+
+void ir_hold_start(ir_hold_t* hold, const ir_waveform_t* repeat, const uint32_t period_ms,
+    const uint32_t start_ms)
+{
+    hold->repeat = repeat;
+    hold->period_ms = period_ms;
+    hold->last_start_ms = start_ms;
+    hold->repeats = 0;
+}
+
+void ir_hold_stop(ir_hold_t* hold)
+{
+    hold->repeat = NULL;
+}
+
+uint32_t ir_hold_time_to_next(const ir_hold_t* hold, const uint32_t now_ms)
+{
+    uint32_t elapsed;
+
+    if(hold->repeat == NULL)
+        return IR_HOLD_IDLE;
+
+    // Unsigned difference handles the millisecond counter wrap-around
+    elapsed = now_ms - hold->last_start_ms;
+    if(elapsed >= hold->period_ms)
+        return 0;
+    return hold->period_ms - elapsed;
+}
+
+const ir_waveform_t* ir_hold_poll(ir_hold_t* hold, const uint32_t now_ms)
+{
+    if(ir_hold_time_to_next(hold, now_ms) != 0)
+        return NULL;
+
+    // Keep the cadence relative to the previous start unless we are already a full period late
+    if((now_ms - hold->last_start_ms) < (2 * hold->period_ms))
+        hold->last_start_ms += hold->period_ms;
+    else
+        hold->last_start_ms = now_ms;
+    hold->repeats++;
+    return hold->repeat;
+}
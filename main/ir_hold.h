@@ -0,0 +1,46 @@
+/* IR key hold (repeat frame) engine */
+
+/*
+ * While a key is held the full frame is sent once and then a short repeat
+ * burst is sent every repeat period, measured from the start of the previous
+ * frame, until the key is released or another frame has to be sent.
+ *
+ * The engine only keeps state and does time arithmetic, the caller provides
+ * the current time and sends the frames, so it can be driven by the IR
+ * transmitter task or by a simulated clock.
+ */
+
+#ifndef IR_HOLD_H
+#define IR_HOLD_H
+
+#include <stdint.h>
+
+#include "ir_waveform.h"
+
+// No repeat pending
+#define IR_HOLD_IDLE 0xFFFFFFFF
+
+typedef struct {
+    const ir_waveform_t* repeat;  // Repeat burst of the held key (NULL if idle)
+    uint32_t period_ms;           // Repeat period
+    uint32_t last_start_ms;       // Start time of the last frame sent
+    uint32_t repeats;             // Repeat bursts sent since the key was pressed
+} ir_hold_t;
+
+// Reset to idle state
+void ir_hold_init(ir_hold_t* hold);
+
+// A held key frame started to be sent at given time, repeat it with given burst and period
+void ir_hold_start(ir_hold_t* hold, const ir_waveform_t* repeat, const uint32_t period_ms,
+    const uint32_t start_ms);
+
+// Key released (or a new frame pre-empts the repeats)
+void ir_hold_stop(ir_hold_t* hold);
+
+// Milliseconds until next repeat burst is due (0 if due now, IR_HOLD_IDLE if no key held)
+uint32_t ir_hold_time_to_next(const ir_hold_t* hold, const uint32_t now_ms);
+
+// Get the repeat burst to send if it is due (NULL otherwise), it is accounted as started now
+const ir_waveform_t* ir_hold_poll(ir_hold_t* hold, const uint32_t now_ms);
+
+#endif
@@ -0,0 +1,466 @@
+/* IR learning mode */
+
+#include "ir_learn.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "btstack_tlv.h"
+#include "event_log.h"
+#include "ir_rx.h"
+#include "ir_tx.h"
+#include "lg32ls570s.h"
+
+/**************************************************************************************************/
+
+// TLV tag of the learned keys table
+#define IR_LEARN_TLV_TAG (((uint32_t)'I' << 24) | ((uint32_t)'R' << 16) | ((uint32_t)'L' << 8) | 'N')
+
+// Timing resolution of the learned frames (IRremote receiver tick)
+#define IR_LEARN_TICK_US 50
+
+// Distinct (mark, space) pairs of a learned frame (4 bits index in the runs)
+#define IR_LEARN_MAX_PAIRS 15
+
+// Mark and space pairs of the longest frame (the last space is 0)
+#define IR_LEARN_MAX_ITEMS ((IR_RX_MAX_DURATIONS + 1) / 2)
+
+// Learned frame types
+#define IR_LEARN_NEC  0  // 4 bytes NEC data (big endian)
+#define IR_LEARN_RAW  1  // Compressed timings
+
+// Learning mode states
+#define IR_LEARN_IDLE      0
+#define IR_LEARN_WAIT_KEY  1  // Waiting for the key to bind
+#define IR_LEARN_WAIT_IR   2  // Waiting for the frame of the remote control
+
+// Learned key entry of the table, followed by its data
+typedef struct __attribute__((packed)) {
+    uint8_t usage_page;
+    uint8_t usage;
+    uint8_t type;  // IR_LEARN_NEC or IR_LEARN_RAW
+    uint8_t len;   // Data length
+} ir_learn_entry_t;
+
+static uint8_t state = IR_LEARN_IDLE;
+static uint16_t learn_usage_page;
+static uint16_t learn_usage;
+static btstack_timer_source_t timeout_timer;
+static btstack_timer_source_t poll_timer;
+
+// Learned keys table (as stored in TLV) and its index
+static uint8_t table[IR_LEARN_TABLE_LEN];
+static uint16_t table_len = 0;
+static uint16_t offsets[IR_LEARN_MAX_KEYS];
+static keymap_action_t actions[IR_LEARN_MAX_KEYS];
+static uint8_t num_keys = 0;
+
+// Timings being sent (the transmitter queue only holds a pointer)
+static uint32_t replay_items[IR_LEARN_REPLAY_SLOTS][IR_LEARN_MAX_ITEMS];
+static ir_waveform_t replay_waveforms[IR_LEARN_REPLAY_SLOTS];
+static uint8_t next_slot = 0;
+
+static ir_learn_stats_t stats;
+
+/**************************************************************************************************/
+
+static inline bool ir_learn_match(const uint16_t ticks, const uint16_t reference)
+{
+    uint16_t diff = (ticks > reference) ? (ticks - reference) : (reference - ticks);
+
+    return (diff <= (reference * IR_LEARN_TOLERANCE_PCT) / 100);
+}
+
+static uint16_t ir_learn_put_varint(uint8_t* data, uint16_t pos, const uint16_t value)
+{
+    if(value >= 0x80)
+        data[pos++] = 0x80 | (value >> 7);
+    data[pos++] = value & 0x7F;
+    return pos;
+}
+
+static uint16_t ir_learn_get_varint(const uint8_t* data, uint16_t* pos)
+{
+    uint16_t value = 0;
+
+    if(data[*pos] & 0x80)
+        value = (data[(*pos)++] & 0x7F) << 7;
+    return value | data[(*pos)++];
+}
+
+// Compress the timings of a frame, returns the data length (0 if it does not fit)
+static uint16_t ir_learn_compress(const ir_rx_capture_t* capture, uint8_t* data, const uint16_t max)
+{
+    uint16_t pairs[IR_LEARN_MAX_PAIRS][2];
+    uint8_t symbols[IR_LEARN_MAX_ITEMS];
+    uint8_t num_pairs = 0;
+    uint16_t num_symbols = (capture->len + 1) / 2;
+    uint16_t mark, space;
+    uint16_t pos;
+    uint8_t i, run;
+
+    if(num_symbols == 0)
+        return 0;
+
+    // Distinct pairs, the first one seen of each is kept
+    for(uint16_t n = 0; n < num_symbols; n++)
+    {
+        mark = (capture->durations_us[2 * n] + IR_LEARN_TICK_US / 2) / IR_LEARN_TICK_US;
+        space = 0;
+        if(n < num_symbols - 1)
+            space = (capture->durations_us[2 * n + 1] + IR_LEARN_TICK_US / 2) / IR_LEARN_TICK_US;
+        for(i = 0; i < num_pairs; i++)
+        {
+            if(ir_learn_match(mark, pairs[i][0]) && ir_learn_match(space, pairs[i][1]))
+                break;
+        }
+        if(i == num_pairs)
+        {
+            if(num_pairs == IR_LEARN_MAX_PAIRS)
+                return 0;
+            pairs[num_pairs][0] = mark;
+            pairs[num_pairs][1] = space;
+            num_pairs++;
+        }
+        symbols[n] = i;
+    }
+
+    // Pairs, then runs of the same pair (index and length - 1)
+    if(1 + num_pairs * 4 + num_symbols > max)
+        return 0;
+    data[0] = num_pairs;
+    pos = 1;
+    for(i = 0; i < num_pairs; i++)
+    {
+        pos = ir_learn_put_varint(data, pos, pairs[i][0]);
+        pos = ir_learn_put_varint(data, pos, pairs[i][1]);
+    }
+    for(uint16_t n = 0; n < num_symbols; n += run)
+    {
+        for(run = 1; (run < 16) && (n + run < num_symbols) && (symbols[n + run] == symbols[n]); run++)
+            ;
+        data[pos++] = (symbols[n] << 4) | (run - 1);
+    }
+    return pos;
+}
+
+// Expand compressed timings to RMT items, returns the number of items
+static uint16_t ir_learn_expand(const uint8_t* data, const uint8_t len, uint32_t* items)
+{
+    uint32_t pairs[IR_LEARN_MAX_PAIRS];
+    uint8_t num_pairs = data[0];
+    uint16_t pos = 1;
+    uint16_t num_items = 0;
+    uint16_t mark, space;
+
+    if(num_pairs > IR_LEARN_MAX_PAIRS)
+        return 0;
+    for(uint8_t i = 0; i < num_pairs; i++)
+    {
+        mark = ir_learn_get_varint(data, &pos);
+        space = ir_learn_get_varint(data, &pos);
+        pairs[i] = IR_RMT_ITEM(mark * IR_LEARN_TICK_US, space * IR_LEARN_TICK_US);
+    }
+    while(pos < len)
+    {
+        if((data[pos] >> 4) >= num_pairs)
+            return 0;
+        for(uint8_t run = (data[pos] & 0x0F) + 1; (run > 0) && (num_items < IR_LEARN_MAX_ITEMS); run--)
+            items[num_items++] = pairs[data[pos] >> 4];
+        pos++;
+    }
+    return num_items;
+}
+
+static const char* ir_learn_label(const uint16_t usage_page, const uint16_t usage)
+{
+    const keymap_action_t* action;
+
+    if(usage_page == HID_USAGE_PAGE_CONSUMER)
+        action = keymap_consumer_get(usage);
+    else
+        action = keymap_get((uint8_t)usage);
+    return (action->label != NULL) ? action->label : "Learned";
+}
+
+// Index the table and build the actions of its keys
+static void ir_learn_index(void)
+{
+    const ir_learn_entry_t* entry;
+    const ir_waveform_t* waveform;
+    keymap_action_t* action;
+    uint16_t pos = 0;
+
+    num_keys = 0;
+    while((pos + sizeof(ir_learn_entry_t) <= table_len) && (num_keys < IR_LEARN_MAX_KEYS))
+    {
+        entry = (const ir_learn_entry_t*)&table[pos];
+        if(pos + sizeof(ir_learn_entry_t) + entry->len > table_len)
+            break;
+        offsets[num_keys] = pos;
+        action = &actions[num_keys];
+        *action = keymap_unmapped();
+        action->label = ir_learn_label(entry->usage_page, entry->usage);
+        if((entry->type == IR_LEARN_NEC) && (entry->len == 4))
+        {
+            action->protocol = KEYMAP_PROTOCOL_NEC;
+            action->code = big_endian_read_32((const uint8_t*)(entry + 1), 0);
+            // Reuse the precomputed frame of the LG codes
+            waveform = NULL;
+            if((action->code & 0xFFFF0000) == NEC_INIT_MASK)
+                waveform = ir_waveform_lg_lookup(action->code & 0xFFFF);
+            if(waveform != NULL)
+                action->waveform = *waveform;
+        }
+        else
+        {
+            action->protocol = KEYMAP_PROTOCOL_LEARNED;
+            action->code = num_keys;
+        }
+        num_keys++;
+        pos += sizeof(ir_learn_entry_t) + entry->len;
+    }
+    table_len = pos;
+}
+
+static int ir_learn_find(const uint16_t usage_page, const uint16_t usage)
+{
+    const ir_learn_entry_t* entry;
+
+    for(uint8_t i = 0; i < num_keys; i++)
+    {
+        entry = (const ir_learn_entry_t*)&table[offsets[i]];
+        if((entry->usage_page == usage_page) && (entry->usage == usage))
+            return i;
+    }
+    return -1;
+}
+
+// Bind a frame to the key being learned (replacing the frame it had), returns false if it does not
+// fit in the table
+static bool ir_learn_bind(const uint8_t type, const uint8_t* data, const uint8_t len)
+{
+    ir_learn_entry_t entry = { (uint8_t)learn_usage_page, (uint8_t)learn_usage, type, len };
+    int index = ir_learn_find(learn_usage_page, learn_usage);
+    uint16_t start = table_len;
+    uint16_t end = table_len;
+
+    if(index >= 0)
+    {
+        start = offsets[index];
+        end = start + sizeof(ir_learn_entry_t) + ((const ir_learn_entry_t*)&table[start])->len;
+    }
+    else if(num_keys == IR_LEARN_MAX_KEYS)
+        return false;
+    if(table_len - (end - start) + sizeof(ir_learn_entry_t) + len > IR_LEARN_TABLE_LEN)
+        return false;
+
+    memmove(&table[start], &table[end], table_len - end);
+    table_len -= end - start;
+    memcpy(&table[table_len], &entry, sizeof(ir_learn_entry_t));
+    memcpy(&table[table_len + sizeof(ir_learn_entry_t)], data, len);
+    table_len += sizeof(ir_learn_entry_t) + len;
+    ir_learn_index();
+    return true;
+}
+
+// Store the table, with the receiver stopped: its interrupt must not fire while flash is written
+static void ir_learn_store(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl != NULL)
+        tlv_impl->store_tag(tlv_context, IR_LEARN_TLV_TAG, table, table_len);
+}
+
+static void ir_learn_frame(const ir_rx_capture_t* capture)
+{
+    uint8_t data[UINT8_MAX];
+    uint16_t len;
+    uint8_t type;
+
+    if(capture->protocol == IR_RX_NEC)
+    {
+        type = IR_LEARN_NEC;
+        big_endian_store_32(data, 0, capture->value);
+        len = 4;
+    }
+    else
+    {
+        type = IR_LEARN_RAW;
+        len = ir_learn_compress(capture, data, sizeof(data));
+    }
+    if((len == 0) || !ir_learn_bind(type, data, len))
+    {
+        // Keep waiting, another button of the remote control may fit
+        stats.failures++;
+        event_log(EVENT_LOG_LEARN_FAILED, &type, 1);
+        return;
+    }
+
+    if(type == IR_LEARN_NEC)
+        stats.nec++;
+    else
+    {
+        stats.raw++;
+        stats.durations += capture->len;
+        stats.bytes += len;
+    }
+    event_log(EVENT_LOG_LEARNED, &type, 1);
+    ir_learn_stop();
+    ir_learn_store();
+}
+
+static void ir_learn_poll_handler(btstack_timer_source_t* ts)
+{
+    ir_rx_capture_t capture;
+
+    if(ir_rx_poll(&capture))
+        ir_learn_frame(&capture);
+    if(state != IR_LEARN_WAIT_IR)
+        return;
+    btstack_run_loop_set_timer(ts, IR_LEARN_POLL_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void ir_learn_timeout_handler(btstack_timer_source_t* ts)
+{
+    UNUSED(ts);
+    ir_learn_stop();
+}
+
+static void ir_learn_set_timeout(void)
+{
+    btstack_run_loop_remove_timer(&timeout_timer);
+    btstack_run_loop_set_timer_handler(&timeout_timer, &ir_learn_timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, IR_LEARN_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&timeout_timer);
+}
+
+/**************************************************************************************************/
+
+int ir_learn_init(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    int size;
+
+    table_len = 0;
+    num_keys = 0;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return 0;
+    size = tlv_impl->get_tag(tlv_context, IR_LEARN_TLV_TAG, table, sizeof(table));
+    if(size > 0)
+        table_len = size;
+    ir_learn_index();
+    return num_keys;
+}
+
+void ir_learn_start(void)
+{
+    ir_learn_set_timeout();
+    if(state != IR_LEARN_IDLE)
+        return;
+    state = IR_LEARN_WAIT_KEY;
+    event_log(EVENT_LOG_LEARN_STARTED, NULL, 0);
+}
+
+void ir_learn_stop(void)
+{
+    if(state == IR_LEARN_IDLE)
+        return;
+    ir_rx_stop();
+    btstack_run_loop_remove_timer(&poll_timer);
+    btstack_run_loop_remove_timer(&timeout_timer);
+    state = IR_LEARN_IDLE;
+    event_log(EVENT_LOG_LEARN_STOPPED, NULL, 0);
+}
+
+bool ir_learn_active(void)
+{
+    return (state != IR_LEARN_IDLE);
+}
+
+bool ir_learn_key(const uint16_t usage_page, const uint16_t usage)
+{
+    uint8_t usage8 = (uint8_t)usage;
+
+    if(state == IR_LEARN_IDLE)
+        return false;
+    // Keys are stored with 8 bits usages, as in the keymaps
+    if(usage >= KEYMAP_SIZE)
+        return true;
+
+    // Another key pressed before the frame was received takes its place
+    learn_usage_page = usage_page;
+    learn_usage = usage;
+    event_log(EVENT_LOG_LEARN_KEY, &usage8, 1);
+    ir_learn_set_timeout();
+    if(state == IR_LEARN_WAIT_IR)
+        return true;
+
+    state = IR_LEARN_WAIT_IR;
+    ir_rx_start();
+    btstack_run_loop_set_timer_handler(&poll_timer, &ir_learn_poll_handler);
+    btstack_run_loop_set_timer(&poll_timer, IR_LEARN_POLL_MS);
+    btstack_run_loop_add_timer(&poll_timer);
+    return true;
+}
+
+const keymap_action_t* ir_learn_get(const uint16_t usage_page, const uint16_t usage)
+{
+    int index;
+
+    if(num_keys == 0)
+        return NULL;
+    index = ir_learn_find(usage_page, usage);
+    return (index >= 0) ? &actions[index] : NULL;
+}
+
+bool ir_learn_send(const uint32_t index)
+{
+    const ir_learn_entry_t* entry;
+    ir_waveform_t* waveform;
+    ir_tx_stats_t tx_stats;
+
+    if(index >= num_keys)
+        return false;
+
+    // A buffer may still be sent if the queue holds as many frames as there are buffers
+    ir_tx_get_stats(&tx_stats);
+    if(tx_stats.depth + 1 >= IR_LEARN_REPLAY_SLOTS)
+    {
+        stats.dropped++;
+        return false;
+    }
+    entry = (const ir_learn_entry_t*)&table[offsets[index]];
+    waveform = &replay_waveforms[next_slot];
+    waveform->items = replay_items[next_slot];
+    waveform->len = ir_learn_expand((const uint8_t*)(entry + 1), entry->len, replay_items[next_slot]);
+    waveform->khz = IR_NEC_KHZ;
+    next_slot = (next_slot + 1) % IR_LEARN_REPLAY_SLOTS;
+    if(!ir_tx_enqueue_waveform(waveform))
+    {
+        stats.dropped++;
+        return false;
+    }
+    stats.sent++;
+    return true;
+}
+
+void ir_learn_get_stats(ir_learn_stats_t* stats_out)
+{
+    memcpy(stats_out, &stats, sizeof(ir_learn_stats_t));
+}
+
+void ir_learn_dump(void)
+{
+    printf("Learned keys: %u (%u of %u bytes), %u NEC, %u timings (%u durations in %u bytes), %u failed\n",
+        num_keys, table_len, IR_LEARN_TABLE_LEN, stats.nec, stats.raw, stats.durations, stats.bytes,
+        stats.failures);
+    printf("Learned timings: %u sent, %u dropped\n", stats.sent, stats.dropped);
+}
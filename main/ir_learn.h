@@ -0,0 +1,82 @@
+/* IR learning mode */
+
+/*
+ * In learning mode the next HID key pressed is not sent: the IR receiver is
+ * started and the next frame received from the original remote control is
+ * bound to that key, in place of its keymap action. NEC frames are kept as
+ * their 32 bits value, any other protocol as its timing in a compressed
+ * form: the distinct (mark, space) pairs of the frame in 50 us units (the
+ * receiver resolution, durations within a tolerance are merged), followed
+ * by one byte per run of the same pair (pair index and repeat count). A 32
+ * bits pulse distance frame takes about 30 bytes instead of the 134 of its
+ * durations, so dozens of learned keys fit in a single TLV tag.
+ */
+
+#ifndef IR_LEARN_H
+#define IR_LEARN_H
+
+#include <stdint.h>
+
+#include "keymap.h"
+
+// Size of the learned keys table stored in TLV and number of keys in it
+#ifndef IR_LEARN_TABLE_LEN
+    #define IR_LEARN_TABLE_LEN 1024
+#endif
+#ifndef IR_LEARN_MAX_KEYS
+    #define IR_LEARN_MAX_KEYS 48
+#endif
+
+// Learning mode timeout (from the start or the key pressed)
+#ifndef IR_LEARN_TIMEOUT_MS
+    #define IR_LEARN_TIMEOUT_MS 30000
+#endif
+
+// Receiver polling period while waiting for the frame
+#ifndef IR_LEARN_POLL_MS
+    #define IR_LEARN_POLL_MS 20
+#endif
+
+// Durations of a frame closer than this are merged (percent)
+#ifndef IR_LEARN_TOLERANCE_PCT
+    #define IR_LEARN_TOLERANCE_PCT 20
+#endif
+
+// Learned timings being sent at once, a frame is dropped if the transmitter queue could still
+// hold the one sent from the same buffer
+#ifndef IR_LEARN_REPLAY_SLOTS
+    #define IR_LEARN_REPLAY_SLOTS 4
+#endif
+
+typedef struct {
+    uint32_t nec;        // Keys learned as NEC frames
+    uint32_t raw;        // Keys learned as timings
+    uint32_t durations;  // Durations of the timings learned
+    uint32_t bytes;      // Compressed size of the timings learned
+    uint32_t failures;   // Frames that could not be learned (too complex, table full)
+    uint32_t sent;       // Learned timings sent
+    uint32_t dropped;    // Learned timings dropped (replay buffers busy)
+} ir_learn_stats_t;
+
+// Load the learned keys stored in TLV, returns their number
+int ir_learn_init(void);
+
+// Enter the learning mode (the next key pressed is bound to the next frame received), and leave it
+void ir_learn_start(void);
+void ir_learn_stop(void);
+bool ir_learn_active(void);
+
+// Key pressed, returns true if it is taken by the learning mode (not to be sent)
+bool ir_learn_key(const uint16_t usage_page, const uint16_t usage);
+
+// Get the learned action of a key (NULL if it was not learned)
+const keymap_action_t* ir_learn_get(const uint16_t usage_page, const uint16_t usage);
+
+// Send the timings of a learned key (action of protocol KEYMAP_PROTOCOL_LEARNED)
+bool ir_learn_send(const uint32_t index);
+
+// Get and print the counters
+void ir_learn_get_stats(ir_learn_stats_t* stats);
+void ir_learn_dump(void);
+
+#endif
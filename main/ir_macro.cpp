@@ -0,0 +1,243 @@
+/* IR macro engine */
+
+#include "ir_macro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "btstack_tlv.h"
+#include "event_log.h"
+#include "ir_tx.h"
+#include "lg32ls570s.h"
+
+/**************************************************************************************************/
+
+// TLV tag of the stored macro table
+#define IR_MACRO_TLV_TAG (((uint32_t)'M' << 24) | ((uint32_t)'A' << 16) | ((uint32_t)'C' << 8) | 'R')
+
+// No macro running
+#define IR_MACRO_NONE 0xFF
+
+// Builtin macros of the LG-32LS570S TV
+static const uint8_t builtin_table[] =
+{
+    // 0: next input source (the input list takes a while to open)
+    IR_MACRO_LG(LG_INPUT), IR_MACRO_WAIT(500), IR_MACRO_LG(LG_DOWN), IR_MACRO_LG(LG_OK), IR_MACRO_END
+};
+
+// RAM copy of the macro table loaded from TLV
+static uint8_t stored_table[IR_MACRO_TABLE_LEN];
+
+// Active table and start of each macro in it
+static const uint8_t* table = builtin_table;
+static uint16_t offsets[IR_MACRO_MAX];
+static uint8_t num_macros = 0;
+
+// Macro running and its next step
+static uint8_t running = IR_MACRO_NONE;
+static uint16_t pc;
+static btstack_timer_source_t step_timer;
+
+static ir_macro_stats_t stats;
+
+/**************************************************************************************************/
+
+// Length of a step (0 if the op is not known)
+static uint8_t ir_macro_step_len(const uint8_t op)
+{
+    switch(op)
+    {
+        case IR_MACRO_OP_END:  return 1;
+        case IR_MACRO_OP_LG:   return 3;
+        case IR_MACRO_OP_NEC:  return 5;
+        case IR_MACRO_OP_WAIT: return 2;
+        default:               return 0;
+    }
+}
+
+// Check a table and find the start of its macros, returns the number of macros (-1 if the table
+// is not valid: unknown op, truncated step or missing end)
+static int ir_macro_index(const uint8_t* code, const uint16_t len, uint16_t* starts)
+{
+    uint16_t pos = 0;
+    uint8_t step_len;
+    int num = 0;
+
+    while(pos < len)
+    {
+        if(num == IR_MACRO_MAX)
+            return -1;
+        starts[num++] = pos;
+        do
+        {
+            step_len = ir_macro_step_len(code[pos]);
+            if((step_len == 0) || (pos + step_len > len))
+                return -1;
+            pos += step_len;
+        } while(code[pos - step_len] != IR_MACRO_OP_END);
+    }
+    return num;
+}
+
+static void ir_macro_set(const uint8_t* code, const uint16_t len)
+{
+    ir_macro_cancel();
+    table = code;
+    num_macros = (uint8_t)ir_macro_index(code, len, offsets);
+}
+
+// Queue a frame of the macro
+static void ir_macro_send(const uint32_t code)
+{
+    const ir_waveform_t* waveform = NULL;
+    bool queued;
+
+    if((code & 0xFFFF0000) == NEC_INIT_MASK)
+        waveform = ir_waveform_lg_lookup(code & 0xFFFF);
+    queued = (waveform != NULL) ? ir_tx_enqueue_waveform(waveform) : ir_tx_enqueue(code);
+    if(queued)
+        stats.frames++;
+    else
+        stats.dropped++;
+}
+
+// Run the steps of the macro up to the next frame due later
+static void ir_macro_step(btstack_timer_source_t* ts)
+{
+    const uint8_t* step;
+    uint32_t delay_ms = 0;
+
+    UNUSED(ts);
+
+    while(1)
+    {
+        step = &table[pc];
+        if(step[0] == IR_MACRO_OP_WAIT)
+        {
+            delay_ms += step[1] * 10;
+            pc += 2;
+            continue;
+        }
+        // Frames and the end wait for the gap after the previous frame
+        if(delay_ms > 0)
+            break;
+        if(step[0] == IR_MACRO_OP_END)
+        {
+            running = IR_MACRO_NONE;
+            stats.completed++;
+            return;
+        }
+        if(step[0] == IR_MACRO_OP_LG)
+            ir_macro_send(NEC_INIT_MASK | ((uint32_t)step[1] << 8) | step[2]);
+        else
+            ir_macro_send(big_endian_read_32(step, 1));
+        pc += ir_macro_step_len(step[0]);
+        delay_ms = IR_MACRO_FRAME_PERIOD_MS;
+    }
+
+    btstack_run_loop_set_timer_handler(&step_timer, &ir_macro_step);
+    btstack_run_loop_set_timer(&step_timer, delay_ms);
+    btstack_run_loop_add_timer(&step_timer);
+}
+
+/**************************************************************************************************/
+
+int ir_macro_load(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    uint16_t starts[IR_MACRO_MAX];
+    int size;
+
+    ir_macro_set(builtin_table, sizeof(builtin_table));
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return 0;
+
+    size = tlv_impl->get_tag(tlv_context, IR_MACRO_TLV_TAG, stored_table, sizeof(stored_table));
+    if((size <= 0) || (ir_macro_index(stored_table, size, starts) <= 0))
+        return 0;
+
+    ir_macro_set(stored_table, size);
+    return num_macros;
+}
+
+int ir_macro_store(const uint8_t* code, const uint16_t len)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    uint16_t starts[IR_MACRO_MAX];
+
+    if((len > IR_MACRO_TABLE_LEN) || (ir_macro_index(code, len, starts) <= 0))
+    {
+        stats.rejected++;
+        return -1;
+    }
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return -1;
+    if(tlv_impl->store_tag(tlv_context, IR_MACRO_TLV_TAG, code, len) != 0)
+        return -1;
+
+    memcpy(stored_table, code, len);
+    ir_macro_set(stored_table, len);
+    return 0;
+}
+
+int ir_macro_parse(const char* text, uint8_t* code, const uint16_t max_len)
+{
+    char* end;
+    unsigned long value;
+    uint16_t len = 0;
+
+    while(1)
+    {
+        while((*text == ' ') || (*text == '\t'))
+            text++;
+        if(*text == 0)
+            return len;
+        value = strtoul(text, &end, 16);
+        if((end == text) || (value > 0xFF) || (len == max_len) || ((*end != 0) && (*end != ' ') && (*end != '\t')))
+            return -1;
+        code[len++] = (uint8_t)value;
+        text = end;
+    }
+}
+
+bool ir_macro_start(const uint8_t macro)
+{
+    if(macro >= num_macros)
+        return false;
+    ir_macro_cancel();
+    running = macro;
+    pc = offsets[macro];
+    stats.started++;
+    event_log(EVENT_LOG_MACRO_STARTED, &macro, 1);
+    ir_macro_step(&step_timer);
+    return true;
+}
+
+void ir_macro_cancel(void)
+{
+    if(running == IR_MACRO_NONE)
+        return;
+    btstack_run_loop_remove_timer(&step_timer);
+    event_log(EVENT_LOG_MACRO_CANCELLED, &running, 1);
+    running = IR_MACRO_NONE;
+    stats.cancelled++;
+}
+
+void ir_macro_get_stats(ir_macro_stats_t* stats_out)
+{
+    memcpy(stats_out, &stats, sizeof(ir_macro_stats_t));
+}
+
+void ir_macro_dump(void)
+{
+    printf("Macros: %u defined, %u started, %u completed, %u cancelled, %u frames (%u dropped), %u tables "
+        "rejected\n", num_macros, stats.started, stats.completed, stats.cancelled, stats.frames, stats.dropped,
+        stats.rejected);
+}
@@ -0,0 +1,82 @@
+/* IR macro engine */
+
+/*
+ * A macro sends a sequence of IR frames for a single key press, like the
+ * digits and OK of a channel number or the steps of a TV menu. Macros are
+ * kept as a compact bytecode table: each macro is a list of steps ended by
+ * IR_MACRO_OP_END, and is numbered by its position in the table. A keymap
+ * action of protocol KEYMAP_PROTOCOL_MACRO runs the macro of its code.
+ *
+ * The steps run from BTstack timers: a frame is queued to the IR
+ * transmitter one NEC repeat period after the previous one (plus the wait
+ * steps in between), so at most one frame of the macro is waiting in the
+ * transmitter queue and a macro cancelled by another key stops right away.
+ *
+ * A macro table can be stored in (and loaded from) the BTstack TLV storage
+ * without reflashing, for instance entered as hex bytes in the serial
+ * console, the builtin one is used otherwise.
+ */
+
+#ifndef IR_MACRO_H
+#define IR_MACRO_H
+
+#include <stdint.h>
+
+// Largest macro table and number of macros in it
+#ifndef IR_MACRO_TABLE_LEN
+    #define IR_MACRO_TABLE_LEN 256
+#endif
+#ifndef IR_MACRO_MAX
+    #define IR_MACRO_MAX 32
+#endif
+
+// Time from a frame of a macro to the next one (NEC repeat period, the TV needs the gap)
+#ifndef IR_MACRO_FRAME_PERIOD_MS
+    #define IR_MACRO_FRAME_PERIOD_MS 108
+#endif
+
+// Bytecode steps (arguments big endian)
+#define IR_MACRO_OP_END   0x00  // End of the macro
+#define IR_MACRO_OP_LG    0x01  // Send a LG-32LS570S frame, 2 bytes code (NEC address 0x20DF)
+#define IR_MACRO_OP_NEC   0x02  // Send a NEC frame, 4 bytes data
+#define IR_MACRO_OP_WAIT  0x03  // Wait before the next frame, 1 byte time (10 ms units)
+
+// Bytecode of the steps
+#define IR_MACRO_LG(code)    IR_MACRO_OP_LG, (uint8_t)((code) >> 8), (uint8_t)(code)
+#define IR_MACRO_NEC(data)   IR_MACRO_OP_NEC, (uint8_t)((data) >> 24), (uint8_t)((data) >> 16), \
+                             (uint8_t)((data) >> 8), (uint8_t)(data)
+#define IR_MACRO_WAIT(ms)    IR_MACRO_OP_WAIT, (uint8_t)((ms) / 10)
+#define IR_MACRO_END         IR_MACRO_OP_END
+
+typedef struct {
+    uint32_t started;    // Macros started
+    uint32_t completed;  // Macros run to the end
+    uint32_t cancelled;  // Macros stopped by another key
+    uint32_t frames;     // Frames queued by macros
+    uint32_t dropped;    // Frames rejected by the transmitter queue
+    uint32_t rejected;   // Macro tables not stored (not valid)
+} ir_macro_stats_t;
+
+// Load the macro table stored in TLV (builtin table if none), returns number of stored macros
+// loaded (0 if none)
+int ir_macro_load(void);
+
+// Store a macro table in TLV (replacing the stored one) and make it active, returns -1 if the
+// table is not valid or can not be stored
+int ir_macro_store(const uint8_t* table, const uint16_t len);
+
+// Parse bytecode written as hex bytes ("01 20 DF 00"), returns the number of bytes (-1 if not valid
+// or longer than max_len)
+int ir_macro_parse(const char* text, uint8_t* code, const uint16_t max_len);
+
+// Run a macro, cancelling the one running (returns false if there is no such macro)
+bool ir_macro_start(const uint8_t macro);
+
+// Stop the macro running (frames already queued are sent)
+void ir_macro_cancel(void);
+
+// Get and print the macro counters
+void ir_macro_get_stats(ir_macro_stats_t* stats);
+void ir_macro_dump(void);
+
+#endif
@@ -0,0 +1,74 @@
+/* IR receiver */
+
+#include "ir_rx.h"
+
+#include "Arduino.h"
+#include "IRremote.h"
+#include "IRremoteInt.h"
+
+/**************************************************************************************************/
+
+// IR Receive Object (pin set on init)
+static IRrecv* ir_receiver = NULL;
+static bool sampling = false;
+
+/**************************************************************************************************/
+
+void ir_rx_init(const uint8_t pin)
+{
+    ir_receiver = new IRrecv(pin);
+}
+
+void ir_rx_start(void)
+{
+    if((ir_receiver == NULL) || sampling)
+        return;
+    ir_receiver->enableIRIn();
+    sampling = true;
+}
+
+void ir_rx_stop(void)
+{
+    if(!sampling)
+        return;
+    ir_receiver->disableIRIn();
+    sampling = false;
+}
+
+bool ir_rx_poll(ir_rx_capture_t* capture)
+{
+    decode_results results;
+    uint16_t len;
+
+    if(!sampling || !ir_receiver->decode(&results))
+        return false;
+
+    // NEC repeat bursts of a held button carry no code
+    if((results.decode_type == NEC) && (results.value == REPEAT))
+    {
+        ir_receiver->resume();
+        return false;
+    }
+    capture->protocol = (results.decode_type == NEC) ? IR_RX_NEC : IR_RX_RAW;
+    capture->value = results.value;
+
+    // Entry 0 is the gap before the frame, marks are measured too long and spaces too short by the
+    // demodulator lag. The RMT receiver also gives the durations to the microsecond.
+    len = (results.rawlen > 1) ? (results.rawlen - 1) : 0;
+    if(len > IR_RX_MAX_DURATIONS)
+        len = IR_RX_MAX_DURATIONS;
+    for(uint16_t i = 0; i < len; i++)
+    {
+        uint32_t duration_us = (results.rawbufUs != NULL) ? results.rawbufUs[i + 1] :
+                               (results.rawbuf[i + 1] * USECPERTICK);
+
+        if(i % 2 == 0)
+            duration_us = (duration_us > MARK_EXCESS) ? (duration_us - MARK_EXCESS) : duration_us;
+        else
+            duration_us += MARK_EXCESS;
+        capture->durations_us[i] = (duration_us > UINT16_MAX) ? UINT16_MAX : duration_us;
+    }
+    capture->len = len;
+    ir_receiver->resume();
+    return true;
+}
@@ -0,0 +1,41 @@
+/* IR receiver */
+
+/*
+ * Captures the frames of an IR remote control with the IRremote receiver
+ * (IRrecv, timing the edges of the demodulator output with the RMT peripheral,
+ * or sampling it every 50 us when built with IR_RECV_USE_TIMER). NEC frames are
+ * given decoded, any other protocol as its mark and space durations so it
+ * can be sent back as it was received.
+ */
+
+#ifndef IR_RX_H
+#define IR_RX_H
+
+#include <stdint.h>
+
+// Longest frame captured (marks and spaces, RAWBUF of IRremote without the leading gap)
+#define IR_RX_MAX_DURATIONS 100
+
+// Capture types
+#define IR_RX_NEC  0  // NEC frame, value decoded
+#define IR_RX_RAW  1  // Other protocol, durations only
+
+typedef struct {
+    uint8_t  protocol;                           // IR_RX_*
+    uint32_t value;                              // NEC data
+    uint16_t len;                                // Number of durations
+    uint16_t durations_us[IR_RX_MAX_DURATIONS];  // Mark first, then space and mark alternately
+} ir_rx_capture_t;
+
+// Set up the receiver on given pin (stopped)
+void ir_rx_init(const uint8_t pin);
+
+// Start and stop sampling the receiver
+void ir_rx_start(void);
+void ir_rx_stop(void);
+
+// Get the oldest frame received and not polled yet (IRremote keeps up to IR_RING_FRAMES of them
+// while capturing goes on), returns false if there is none
+bool ir_rx_poll(ir_rx_capture_t* capture);
+
+#endif
@@ -0,0 +1,305 @@
+/* Non-blocking IR transmitter */
+
+#include "ir_tx.h"
+#include "ir_hold.h"
+#include "latency.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "Arduino.h"
+#include "IRremote.h"
+
+/**************************************************************************************************/
+
+// Transmitter task setup (BT controller and BTstack run on core 0)
+#define IR_TX_TASK_STACK_SIZE 2048
+#define IR_TX_TASK_PRIORITY   5
+#define IR_TX_TASK_CORE       1
+
+// Queue element types
+#define IR_TX_ITEM_FRAME    0  // Send a frame once
+#define IR_TX_ITEM_HOLD     1  // Send a frame and repeat it until released
+#define IR_TX_ITEM_RELEASE  2  // Stop repeating the held frame
+
+// Queue element
+typedef struct {
+    uint8_t type;
+    ir_frame_t frame;
+    uint32_t origin;  // Latency trace the frame belongs to
+} ir_tx_item_t;
+
+// Encoder of a protocol, data from ir_frame_data() (copy tells a frame repeated for the same press)
+typedef void (*ir_tx_encoder_t)(const ir_frame_t* frame, const uint32_t data, const bool copy);
+
+// IR Send Object (pin set on init)
+static IRsend* ir_sender = NULL;
+
+// Pending frames
+static QueueHandle_t ir_tx_queue = NULL;
+
+// Toggle bit of each protocol, flipped on each new frame
+static uint8_t toggles = 0;
+
+// Earliest start of the next frame (period of the previous one)
+static uint32_t next_frame_ms = 0;
+
+// Release requested while the queue was full, applied once the queue is empty
+static volatile bool release_pending = false;
+
+// Statistics (each counter has a single writer)
+static volatile uint32_t stat_enqueued = 0;
+static volatile uint32_t stat_sent = 0;
+static volatile uint32_t stat_repeats = 0;
+static volatile uint32_t stat_dropped = 0;
+static volatile uint16_t stat_max_depth = 0;
+
+/**************************************************************************************************/
+
+// Protocol encoders
+
+static void ir_tx_send_raw(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)data;
+    (void)copy;
+    ir_sender->sendItems(frame->waveform->items, frame->waveform->len, frame->waveform->khz);
+}
+
+static void ir_tx_send_nec(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    const ir_waveform_t* waveform = copy ? &ir_nec_repeat_waveform : frame->waveform;
+
+    if(waveform != NULL)
+        ir_sender->sendItems(waveform->items, waveform->len, waveform->khz);
+    else
+        ir_sender->sendNEC(data, ir_frame_bits(frame));
+}
+
+static void ir_tx_send_samsung(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)copy;
+    ir_sender->sendSAMSUNG(data, ir_frame_bits(frame));
+}
+
+static void ir_tx_send_sony(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)copy;
+    ir_sender->sendSony(data, ir_frame_bits(frame));
+}
+
+static void ir_tx_send_rc5(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)copy;
+    ir_sender->sendRC5(data, ir_frame_bits(frame));
+}
+
+static void ir_tx_send_rc6(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)copy;
+    ir_sender->sendRC6(data, ir_frame_bits(frame));
+}
+
+static void ir_tx_send_panasonic(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    (void)copy;
+    ir_sender->sendPanasonic(frame->address, data);
+}
+
+static void ir_tx_send_jvc(const ir_frame_t* frame, const uint32_t data, const bool copy)
+{
+    ir_sender->sendJVC(data, ir_frame_bits(frame), copy);
+}
+
+// Encoders indexed by protocol
+static const ir_tx_encoder_t encoders[IR_PROTOCOL_COUNT] =
+{
+    ir_tx_send_raw,        // IR_PROTOCOL_RAW
+    ir_tx_send_nec,        // IR_PROTOCOL_NEC
+    ir_tx_send_samsung,    // IR_PROTOCOL_SAMSUNG
+    ir_tx_send_sony,       // IR_PROTOCOL_SONY
+    ir_tx_send_rc5,        // IR_PROTOCOL_RC5
+    ir_tx_send_rc6,        // IR_PROTOCOL_RC6
+    ir_tx_send_panasonic,  // IR_PROTOCOL_PANASONIC
+    ir_tx_send_jvc         // IR_PROTOCOL_JVC
+};
+
+// Wait for the period of the previous frame to end
+static void ir_tx_wait_gap(void)
+{
+    int32_t wait_ms = (int32_t)(next_frame_ms - millis());
+
+    if(wait_ms > 0)
+        delay(wait_ms);
+}
+
+// Send a queued frame and its copies, one protocol period apart, returns the start of the first one
+static uint32_t ir_tx_send(const ir_tx_item_t* item)
+{
+    const ir_frame_t* frame = &item->frame;
+    const ir_protocol_t* protocol = ir_protocol_get(frame->protocol);
+    uint32_t data;
+    uint32_t start_ms;
+    uint8_t count;
+
+    if((protocol == NULL) || ((frame->protocol == IR_PROTOCOL_RAW) && (frame->waveform == NULL)))
+        return millis();
+    if(protocol->toggle)
+        toggles ^= (1 << frame->protocol);
+    data = ir_frame_data(frame, (toggles >> frame->protocol) & 1);
+    count = ir_frame_count(frame);
+
+    ir_tx_wait_gap();
+    start_ms = millis();
+    if(item->origin != 0)
+        latency_record(LATENCY_STAGE_IR_FIRST_MARK, latency_now_remote() - item->origin);
+    for(uint8_t i = 0; i < count; i++)
+    {
+        if(i > 0)
+            ir_tx_wait_gap();
+        next_frame_ms = millis() + protocol->period_ms;
+        encoders[frame->protocol](frame, data, (i > 0));
+    }
+    if(item->origin != 0)
+        latency_record(LATENCY_STAGE_IR_LAST_SPACE, latency_now_remote() - item->origin);
+    stat_sent++;
+    return start_ms;
+}
+
+// Transmitter task, blocks until a frame is available or a held key repeat is due
+static void ir_tx_task(void* arg)
+{
+    ir_tx_item_t item;
+    ir_hold_t hold;
+    const ir_waveform_t* repeat;
+    uint32_t wait_ms;
+    uint32_t start_ms;
+
+    (void)arg;
+    ir_hold_init(&hold);
+    latency_sync_remote();
+
+    while(1)
+    {
+        wait_ms = ir_hold_time_to_next(&hold, millis());
+        if(xQueueReceive(ir_tx_queue, &item, (wait_ms == IR_HOLD_IDLE) ? portMAX_DELAY :
+            pdMS_TO_TICKS(wait_ms)) != pdTRUE)
+        {
+            // Timeout (queue empty), apply a release that could not be queued
+            if(release_pending)
+            {
+                release_pending = false;
+                ir_hold_stop(&hold);
+                continue;
+            }
+
+            // Send the repeat burst of the held key
+            repeat = ir_hold_poll(&hold, millis());
+            if(repeat != NULL)
+            {
+                next_frame_ms = millis() + IR_NEC_REPEAT_PERIOD_MS;
+                ir_sender->sendItems(repeat->items, repeat->len, repeat->khz);
+                stat_repeats++;
+            }
+            continue;
+        }
+
+        // Any queued element ends the repeats of the previous held key
+        ir_hold_stop(&hold);
+        if(item.type == IR_TX_ITEM_RELEASE)
+            continue;
+
+        start_ms = ir_tx_send(&item);
+        if(item.type == IR_TX_ITEM_HOLD)
+            ir_hold_start(&hold, &ir_nec_repeat_waveform, IR_NEC_REPEAT_PERIOD_MS, start_ms);
+    }
+}
+
+/**************************************************************************************************/
+
+void ir_tx_init(const uint8_t pin)
+{
+    if(ir_tx_queue != NULL)
+        return;
+
+    ir_sender = new IRsend(pin);
+    ir_tx_queue = xQueueCreate(IR_TX_QUEUE_LEN, sizeof(ir_tx_item_t));
+    latency_init();
+    xTaskCreatePinnedToCore(ir_tx_task, "ir_tx", IR_TX_TASK_STACK_SIZE, NULL, IR_TX_TASK_PRIORITY,
+        NULL, IR_TX_TASK_CORE);
+
+    // Measure the cycle counter offset of the transmitter core while its task starts
+    latency_sync_local();
+}
+
+// Push an element without waiting for free space (the caller is the BTstack run loop)
+static bool ir_tx_push(const ir_tx_item_t* item)
+{
+    UBaseType_t depth;
+
+    if(ir_tx_queue == NULL)
+        return false;
+
+    if(xQueueSend(ir_tx_queue, item, 0) != pdTRUE)
+    {
+        stat_dropped++;
+        return false;
+    }
+    stat_enqueued++;
+    if(item->type != IR_TX_ITEM_RELEASE)
+        latency_mark(LATENCY_STAGE_IR_ENQUEUE);
+
+    depth = uxQueueMessagesWaiting(ir_tx_queue);
+    if(depth > stat_max_depth)
+        stat_max_depth = depth;
+
+    return true;
+}
+
+bool ir_tx_enqueue_frame(const ir_frame_t* frame)
+{
+    ir_tx_item_t item = { IR_TX_ITEM_FRAME, *frame, latency_origin() };
+    return ir_tx_push(&item);
+}
+
+bool ir_tx_enqueue(const uint32_t code)
+{
+    ir_frame_t frame = { IR_PROTOCOL_NEC, 32, 0, (uint16_t)(code >> 16), code & 0xFFFF, NULL };
+    return ir_tx_enqueue_frame(&frame);
+}
+
+bool ir_tx_enqueue_waveform(const ir_waveform_t* waveform)
+{
+    ir_frame_t frame = { IR_PROTOCOL_RAW, 0, 0, 0, 0, waveform };
+    return ir_tx_enqueue_frame(&frame);
+}
+
+bool ir_tx_hold(const ir_waveform_t* waveform)
+{
+    ir_tx_item_t item = { IR_TX_ITEM_HOLD, { IR_PROTOCOL_NEC, 32, 0, 0, 0, waveform }, latency_origin() };
+
+    if(!ir_tx_push(&item))
+        return false;
+    release_pending = false;
+    return true;
+}
+
+bool ir_tx_release(void)
+{
+    ir_tx_item_t item = { IR_TX_ITEM_RELEASE, { IR_PROTOCOL_RAW, 0, 0, 0, 0, NULL }, 0 };
+
+    // A lost release would repeat the key forever, keep it pending instead
+    if(!ir_tx_push(&item))
+        release_pending = true;
+    return true;
+}
+
+void ir_tx_get_stats(ir_tx_stats_t* stats)
+{
+    stats->enqueued = stat_enqueued;
+    stats->sent = stat_sent;
+    stats->repeats = stat_repeats;
+    stats->dropped = stat_dropped;
+    stats->depth = (ir_tx_queue != NULL) ? uxQueueMessagesWaiting(ir_tx_queue) : 0;
+    stats->max_depth = stat_max_depth;
+}
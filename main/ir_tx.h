@@ -0,0 +1,54 @@
+/* Non-blocking IR transmitter */
+
+/*
+ * Frames are pushed into a bounded queue from the BTstack run loop and sent
+ * by a dedicated task, so the ~67 ms NEC busy-wait never stalls HCI/L2CAP
+ * processing. When the queue is full new frames are dropped and counted.
+ * Each frame starts at least one period of its protocol after the previous
+ * one (see ir_frame.h).
+ */
+
+#ifndef IR_TX_H
+#define IR_TX_H
+
+#include <stdint.h>
+
+#include "ir_frame.h"
+#include "ir_waveform.h"
+
+// Maximum number of frames waiting to be sent
+#ifndef IR_TX_QUEUE_LEN
+    #define IR_TX_QUEUE_LEN 16
+#endif
+
+typedef struct {
+    uint32_t enqueued;   // Frames accepted in the queue
+    uint32_t sent;       // Frames completely sent by the transmitter task
+    uint32_t repeats;    // Repeat bursts sent for held keys
+    uint32_t dropped;    // Frames rejected because the queue was full
+    uint16_t depth;      // Frames currently waiting in the queue
+    uint16_t max_depth;  // Highest queue depth seen since init
+} ir_tx_stats_t;
+
+// Create the queue and the transmitter task driving the IR LED on given pin
+void ir_tx_init(const uint8_t pin);
+
+// Queue a frame of any protocol (copied), returns immediately (false if it was dropped)
+bool ir_tx_enqueue_frame(const ir_frame_t* frame);
+
+// Queue a 32 bits NEC frame
+bool ir_tx_enqueue(const uint32_t code);
+
+// Queue a precomputed waveform (only the pointer is copied, it must stay valid)
+bool ir_tx_enqueue_waveform(const ir_waveform_t* waveform);
+
+// Queue a NEC frame of a held key, its repeat burst is sent every 108 ms until ir_tx_release()
+bool ir_tx_hold(const ir_waveform_t* waveform);
+
+// Stop repeating the held key (queued, so frames already waiting are sent first)
+bool ir_tx_release(void);
+
+// Get a snapshot of the transmitter statistics
+void ir_tx_get_stats(ir_tx_stats_t* stats);
+
+#endif
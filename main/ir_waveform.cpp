@@ -0,0 +1,121 @@
+/* Precomputed IR waveforms */
+
+#include "ir_waveform.h"
+#include "lg32ls570s.h"
+
+/**************************************************************************************************/
+
+#define LG_WAVEFORM(code) { code, IR_NEC_WAVEFORM(NEC_INIT_MASK | code) }
+
+typedef struct {
+    uint16_t      code;
+    ir_waveform_t waveform;
+} lg_waveform_entry_t;
+
+// Flash table with the NEC frame of every LG-32LS570S code
+static constexpr lg_waveform_entry_t lg_waveforms[] =
+{
+    LG_WAVEFORM(LG_POWER),
+    LG_WAVEFORM(LG_HELP),
+    LG_WAVEFORM(LG_RATIO),
+    LG_WAVEFORM(LG_INPUT),
+    LG_WAVEFORM(LG_TVRAD),
+    LG_WAVEFORM(LG_NUMBER_1),
+    LG_WAVEFORM(LG_NUMBER_2),
+    LG_WAVEFORM(LG_NUMBER_3),
+    LG_WAVEFORM(LG_NUMBER_4),
+    LG_WAVEFORM(LG_NUMBER_5),
+    LG_WAVEFORM(LG_NUMBER_6),
+    LG_WAVEFORM(LG_NUMBER_7),
+    LG_WAVEFORM(LG_NUMBER_8),
+    LG_WAVEFORM(LG_NUMBER_9),
+    LG_WAVEFORM(LG_NUMBER_0),
+    LG_WAVEFORM(LG_VOL_PLUS),
+    LG_WAVEFORM(LG_VOL_LESS),
+    LG_WAVEFORM(LG_PROG_PLUS),
+    LG_WAVEFORM(LG_PROG_LESS),
+    LG_WAVEFORM(LG_FAV),
+    LG_WAVEFORM(LG_INFO),
+    LG_WAVEFORM(LG_MUTE),
+    LG_WAVEFORM(LG_SETTINGS),
+    LG_WAVEFORM(LG_HOME),
+    LG_WAVEFORM(LG_APPS),
+    LG_WAVEFORM(LG_LEFT),
+    LG_WAVEFORM(LG_RIGHT),
+    LG_WAVEFORM(LG_UP),
+    LG_WAVEFORM(LG_DOWN),
+    LG_WAVEFORM(LG_OK),
+    LG_WAVEFORM(LG_BACK),
+    LG_WAVEFORM(LG_GUIDE),
+    LG_WAVEFORM(LG_EXIT),
+    LG_WAVEFORM(LG_RED),
+    LG_WAVEFORM(LG_GREEN),
+    LG_WAVEFORM(LG_YELLOW),
+    LG_WAVEFORM(LG_BLUE),
+    LG_WAVEFORM(LG_TVTEXT),
+    LG_WAVEFORM(LG_TOPT),
+    LG_WAVEFORM(LG_QMENU),
+    LG_WAVEFORM(LG_STOP),
+    LG_WAVEFORM(LG_PLAY),
+    LG_WAVEFORM(LG_PAUSE),
+    LG_WAVEFORM(LG_BACKWARD),
+    LG_WAVEFORM(LG_FORWARD),
+    LG_WAVEFORM(LG_REC),
+    LG_WAVEFORM(LG_ENERGY_SAVE),
+    LG_WAVEFORM(LG_AD),
+    LG_WAVEFORM(LG_APP)
+};
+
+#define LG_WAVEFORM_COUNT (sizeof(lg_waveforms)/sizeof(lg_waveforms[0]))
+#define LG_WAVEFORM_NONE  0xFF
+
+// Index in lg_waveforms of the code with given low byte (the inverted command of NEC, unique per
+// code), so the lookup on the send path is a table read instead of a scan
+constexpr uint8_t lg_waveform_find(const size_t low, const size_t i)
+{
+    return (i == LG_WAVEFORM_COUNT) ? LG_WAVEFORM_NONE :
+           ((lg_waveforms[i].code & 0xFF) == low) ? (uint8_t) i :
+           lg_waveform_find(low, i + 1);
+}
+
+template<typename SEQ> struct lg_waveform_index_impl;
+template<size_t... I> struct lg_waveform_index_impl<ir_index_seq<I...> >
+{
+    static constexpr uint8_t index[sizeof...(I)] = { lg_waveform_find(I, 0)... };
+};
+template<size_t... I>
+constexpr uint8_t lg_waveform_index_impl<ir_index_seq<I...> >::index[sizeof...(I)];
+
+typedef lg_waveform_index_impl<ir_make_index_seq<256>::type> lg_waveform_index;
+
+// Every code must be found back from its low byte
+constexpr bool lg_waveform_index_check(const size_t i)
+{
+    return (i == LG_WAVEFORM_COUNT) ||
+           ((lg_waveform_find(lg_waveforms[i].code & 0xFF, 0) == i) && lg_waveform_index_check(i + 1));
+}
+
+static_assert(LG_WAVEFORM_COUNT < LG_WAVEFORM_NONE, "LG waveform index");
+static_assert(lg_waveform_index_check(0), "LG codes sharing their low byte");
+
+static const uint32_t nec_repeat_items[] =
+{
+    IR_RMT_ITEM(IR_NEC_HDR_MARK, IR_NEC_RPT_SPACE),
+    IR_RMT_ITEM(IR_NEC_BIT_MARK, 0)
+};
+
+const ir_waveform_t ir_nec_repeat_waveform =
+{
+    nec_repeat_items, sizeof(nec_repeat_items)/sizeof(nec_repeat_items[0]), IR_NEC_KHZ
+};
+
+/**************************************************************************************************/
+
+const ir_waveform_t* ir_waveform_lg_lookup(const uint16_t code)
+{
+    const uint8_t i = lg_waveform_index::index[code & 0xFF];
+
+    if((i == LG_WAVEFORM_NONE) || (lg_waveforms[i].code != code))
+        return NULL;
+    return &lg_waveforms[i].waveform;
+}
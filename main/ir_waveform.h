@@ -0,0 +1,90 @@
+/* Precomputed IR waveforms */
+
+/*
+ * NEC frames are generated at compile time as RMT item arrays (one mark and
+ * one space per 32 bits item, see irRmtEncoder.h) and stored in flash, so
+ * sending a known code only needs a pointer to its table instead of deriving
+ * the pulse train bit by bit on every key press.
+ */
+
+#ifndef IR_WAVEFORM_H
+#define IR_WAVEFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "irRmtEncoder.h"
+
+/**************************************************************************************************/
+
+// NEC timings in microseconds (same values used by IRsend::sendNEC)
+#define IR_NEC_KHZ             38
+#define IR_NEC_HDR_MARK      9000
+#define IR_NEC_HDR_SPACE     4500
+#define IR_NEC_BIT_MARK       560
+#define IR_NEC_ONE_SPACE     1690
+#define IR_NEC_ZERO_SPACE     560
+#define IR_NEC_RPT_SPACE     2250
+
+// Period of the repeat burst while a key is held (from frame start to frame start)
+#define IR_NEC_REPEAT_PERIOD_MS 108
+
+// Header item + 32 data bit items + final mark (terminated by a zero length space)
+#define IR_NEC_FRAME_ITEMS 34
+
+typedef struct {
+    const uint32_t* items;  // RMT items (flash)
+    uint16_t        len;    // Number of items
+    uint8_t         khz;    // Carrier frequency
+} ir_waveform_t;
+
+/**************************************************************************************************/
+
+// Compile time index sequence (std::index_sequence is C++14)
+template<size_t... I> struct ir_index_seq {};
+template<size_t N, size_t... I> struct ir_make_index_seq : ir_make_index_seq<N - 1, N - 1, I...> {};
+template<size_t... I> struct ir_make_index_seq<0, I...> { typedef ir_index_seq<I...> type; };
+
+// Item i of the NEC frame for given 32 bits data (MSB first, as sendNEC)
+constexpr uint32_t ir_nec_item(const uint32_t data, const size_t i)
+{
+    return (i == 0) ? IR_RMT_ITEM(IR_NEC_HDR_MARK, IR_NEC_HDR_SPACE) :
+           (i == IR_NEC_FRAME_ITEMS - 1) ? IR_RMT_ITEM(IR_NEC_BIT_MARK, 0) :
+           ((data >> (32 - i)) & 1) ? IR_RMT_ITEM(IR_NEC_BIT_MARK, IR_NEC_ONE_SPACE) :
+                                      IR_RMT_ITEM(IR_NEC_BIT_MARK, IR_NEC_ZERO_SPACE);
+}
+
+template<uint32_t DATA, typename SEQ> struct ir_nec_waveform_impl;
+template<uint32_t DATA, size_t... I> struct ir_nec_waveform_impl<DATA, ir_index_seq<I...> >
+{
+    static constexpr uint32_t items[sizeof...(I)] = { ir_nec_item(DATA, I)... };
+};
+template<uint32_t DATA, size_t... I>
+constexpr uint32_t ir_nec_waveform_impl<DATA, ir_index_seq<I...> >::items[sizeof...(I)];
+
+// RMT items of the NEC frame for given 32 bits data
+template<uint32_t DATA> struct ir_nec_waveform :
+    ir_nec_waveform_impl<DATA, typename ir_make_index_seq<IR_NEC_FRAME_ITEMS>::type> {};
+
+// Waveform descriptor of a constant NEC code
+#define IR_NEC_WAVEFORM(data) \
+    { ir_nec_waveform<(uint32_t)(data)>::items, IR_NEC_FRAME_ITEMS, IR_NEC_KHZ }
+
+/**************************************************************************************************/
+
+// Check the generator against the sendNEC pulse train of a known code (LG power, 0x20DF10EF)
+static_assert(ir_nec_waveform<0x20DF10EF>::items[0] == IR_RMT_ITEM(9000, 4500), "NEC header");
+static_assert(ir_nec_waveform<0x20DF10EF>::items[1] == IR_RMT_ITEM(560, 560), "NEC bit 31");
+static_assert(ir_nec_waveform<0x20DF10EF>::items[3] == IR_RMT_ITEM(560, 1690), "NEC bit 29");
+static_assert(ir_nec_waveform<0x20DF10EF>::items[32] == IR_RMT_ITEM(560, 1690), "NEC bit 0");
+static_assert(ir_nec_waveform<0x20DF10EF>::items[33] == IR_RMT_ITEM(560, 0), "NEC footer");
+
+/**************************************************************************************************/
+
+// NEC repeat burst (header mark, repeat space and final mark)
+extern const ir_waveform_t ir_nec_repeat_waveform;
+
+// Get the precomputed waveform of a 16 bits LG-32LS570S code (NULL if it is not a known code)
+const ir_waveform_t* ir_waveform_lg_lookup(const uint16_t code);
+
+#endif
@@ -0,0 +1,232 @@
+/* HID keyboard usage to IR action keymap */
+
+#include "keymap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_tlv.h"
+#include "lg32ls570s.h"
+
+/**************************************************************************************************/
+
+// TLV tag of the stored keymap (entries with the usage page and the IR frame address)
+#define KEYMAP_TLV_TAG (((uint32_t)'K' << 24) | ((uint32_t)'M' << 16) | ((uint32_t)'A' << 8) | '3')
+
+#define LG_KEY(usage, code, repeat, label) \
+    KEYMAP_KEY_NEC(usage, NEC_INIT_MASK | (code), repeat, label)
+
+// Bluetooth numpad keys of the LG-32LS570S TV
+static constexpr keymap_key_t lg32ls570s_keys[] =
+{
+    KEYMAP_KEY_NONE(0x2A, "BackSpace"),
+    KEYMAP_KEY_NONE(0x53, "NumLock"),
+    LG_KEY(0x54, LG_PROG_LESS, KEYMAP_REPEAT_HOLD, "/"),
+    LG_KEY(0x55, LG_PROG_PLUS, KEYMAP_REPEAT_HOLD, "*"),
+    LG_KEY(0x56, LG_VOL_LESS,  KEYMAP_REPEAT_HOLD, "-"),
+    LG_KEY(0x57, LG_VOL_PLUS,  KEYMAP_REPEAT_HOLD, "+"),
+    KEYMAP_KEY_MACRO(0x58, 0,  "Enter"),  // Next input source
+    LG_KEY(0x59, LG_NUMBER_1,  KEYMAP_REPEAT_ONCE, "1"),
+    LG_KEY(0x5A, LG_NUMBER_2,  KEYMAP_REPEAT_ONCE, "2"),
+    LG_KEY(0x5B, LG_NUMBER_3,  KEYMAP_REPEAT_ONCE, "3"),
+    LG_KEY(0x5C, LG_NUMBER_4,  KEYMAP_REPEAT_ONCE, "4"),
+    LG_KEY(0x5D, LG_NUMBER_5,  KEYMAP_REPEAT_ONCE, "5"),
+    LG_KEY(0x5E, LG_NUMBER_6,  KEYMAP_REPEAT_ONCE, "6"),
+    LG_KEY(0x5F, LG_NUMBER_7,  KEYMAP_REPEAT_ONCE, "7"),
+    LG_KEY(0x60, LG_NUMBER_8,  KEYMAP_REPEAT_ONCE, "8"),
+    LG_KEY(0x61, LG_NUMBER_9,  KEYMAP_REPEAT_ONCE, "9"),
+    LG_KEY(0x62, LG_NUMBER_0,  KEYMAP_REPEAT_ONCE, "0"),
+    LG_KEY(0x63, LG_POWER,     KEYMAP_REPEAT_ONCE, ".")
+};
+
+const keymap_action_t* const keymap_lg32ls570s =
+    keymap_table<lg32ls570s_keys, sizeof(lg32ls570s_keys)/sizeof(lg32ls570s_keys[0])>::table;
+
+// Consumer control keys (usage 0 is "Unassigned" and stays unmapped)
+static constexpr keymap_key_t lg32ls570s_consumer_keys[] =
+{
+    LG_KEY(0x30, LG_POWER,     KEYMAP_REPEAT_ONCE, "Power"),
+    LG_KEY(0x40, LG_SETTINGS,  KEYMAP_REPEAT_ONCE, "Menu"),
+    LG_KEY(0x41, LG_OK,        KEYMAP_REPEAT_ONCE, "Menu Pick"),
+    LG_KEY(0x42, LG_UP,        KEYMAP_REPEAT_HOLD, "Menu Up"),
+    LG_KEY(0x43, LG_DOWN,      KEYMAP_REPEAT_HOLD, "Menu Down"),
+    LG_KEY(0x44, LG_LEFT,      KEYMAP_REPEAT_HOLD, "Menu Left"),
+    LG_KEY(0x45, LG_RIGHT,     KEYMAP_REPEAT_HOLD, "Menu Right"),
+    LG_KEY(0x46, LG_BACK,      KEYMAP_REPEAT_ONCE, "Menu Escape"),
+    LG_KEY(0x8D, LG_GUIDE,     KEYMAP_REPEAT_ONCE, "Guide"),
+    LG_KEY(0x9C, LG_PROG_PLUS, KEYMAP_REPEAT_HOLD, "Channel+"),
+    LG_KEY(0x9D, LG_PROG_LESS, KEYMAP_REPEAT_HOLD, "Channel-"),
+    LG_KEY(0xB0, LG_PLAY,      KEYMAP_REPEAT_ONCE, "Play"),
+    LG_KEY(0xB1, LG_PAUSE,     KEYMAP_REPEAT_ONCE, "Pause"),
+    LG_KEY(0xB2, LG_REC,       KEYMAP_REPEAT_ONCE, "Record"),
+    LG_KEY(0xB3, LG_FORWARD,   KEYMAP_REPEAT_ONCE, "Fast Forward"),
+    LG_KEY(0xB4, LG_BACKWARD,  KEYMAP_REPEAT_ONCE, "Rewind"),
+    LG_KEY(0xB7, LG_STOP,      KEYMAP_REPEAT_ONCE, "Stop"),
+    LG_KEY(0xCD, LG_PLAY,      KEYMAP_REPEAT_ONCE, "Play/Pause"),
+    LG_KEY(0xE2, LG_MUTE,      KEYMAP_REPEAT_ONCE, "Mute"),
+    LG_KEY(0xE9, LG_VOL_PLUS,  KEYMAP_REPEAT_HOLD, "Volume+"),
+    LG_KEY(0xEA, LG_VOL_LESS,  KEYMAP_REPEAT_HOLD, "Volume-")
+};
+
+const keymap_action_t* const keymap_consumer_lg32ls570s =
+    keymap_table<lg32ls570s_consumer_keys,
+        sizeof(lg32ls570s_consumer_keys)/sizeof(lg32ls570s_consumer_keys[0])>::table;
+
+const keymap_action_t* keymap_active = keymap_lg32ls570s;
+const keymap_action_t* keymap_consumer_active = keymap_consumer_lg32ls570s;
+
+// RAM tables of the keymap loaded from TLV, per usage page
+static keymap_action_t keymap_stored[KEYMAP_SIZE];
+static keymap_action_t keymap_consumer_stored[KEYMAP_SIZE];
+
+/**************************************************************************************************/
+
+// Build the RAM keymaps from stored keys and make them active, the builtin keymap of a page stays
+// active if no key of that page is stored
+static void keymap_build(const keymap_stored_key_t* keys, const uint16_t num_keys)
+{
+    const ir_waveform_t* waveform;
+    const keymap_action_t* builtin;
+    keymap_action_t* action;
+    bool keyboard = false;
+    bool consumer = false;
+
+    for(uint16_t i = 0; i < KEYMAP_SIZE; i++)
+    {
+        keymap_stored[i] = keymap_unmapped();
+        keymap_consumer_stored[i] = keymap_unmapped();
+    }
+
+    for(uint16_t i = 0; i < num_keys; i++)
+    {
+        if(keys[i].usage_page == HID_USAGE_PAGE_CONSUMER)
+        {
+            action = &keymap_consumer_stored[keys[i].usage];
+            builtin = keymap_consumer_lg32ls570s;
+            consumer = true;
+        }
+        else
+        {
+            action = &keymap_stored[keys[i].usage];
+            builtin = keymap_lg32ls570s;
+            keyboard = true;
+        }
+        action->protocol = keys[i].protocol;
+        action->repeat = keys[i].repeat;
+        action->address = keys[i].address;
+        action->code = keys[i].code;
+
+        // Reuse the builtin label and, for LG codes, the precomputed frame
+        action->label = builtin[keys[i].usage].label;
+        if(action->label == NULL)
+            action->label = "Key";
+        waveform = NULL;
+        if((keys[i].protocol == KEYMAP_PROTOCOL_NEC) &&
+           ((keys[i].code & 0xFFFF0000) == NEC_INIT_MASK))
+        {
+            waveform = ir_waveform_lg_lookup(keys[i].code & 0xFFFF);
+        }
+        if(waveform != NULL)
+            action->waveform = *waveform;
+    }
+
+    keymap_set(keyboard ? keymap_stored : keymap_lg32ls570s);
+    keymap_consumer_active = consumer ? keymap_consumer_stored : keymap_consumer_lg32ls570s;
+}
+
+/**************************************************************************************************/
+
+void keymap_set(const keymap_action_t* keymap)
+{
+    keymap_active = keymap;
+}
+
+int keymap_load(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    keymap_stored_key_t keys[KEYMAP_STORED_MAX_KEYS];
+    int size;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return 0;
+
+    size = tlv_impl->get_tag(tlv_context, KEYMAP_TLV_TAG, (uint8_t*)keys, sizeof(keys));
+    if(size < (int)sizeof(keymap_stored_key_t))
+        return 0;
+
+    keymap_build(keys, size / sizeof(keymap_stored_key_t));
+    return size / sizeof(keymap_stored_key_t);
+}
+
+int keymap_store(const keymap_stored_key_t* keys, const uint16_t num_keys)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    if((num_keys == 0) || (num_keys > KEYMAP_STORED_MAX_KEYS))
+        return -1;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl == NULL)
+        return -1;
+    if(tlv_impl->store_tag(tlv_context, KEYMAP_TLV_TAG, (const uint8_t*)keys,
+        num_keys * sizeof(keymap_stored_key_t)) != 0)
+    {
+        return -1;
+    }
+
+    keymap_build(keys, num_keys);
+    return 0;
+}
+
+void keymap_clear(void)
+{
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if(tlv_impl != NULL)
+        tlv_impl->delete_tag(tlv_context, KEYMAP_TLV_TAG);
+    keymap_set(keymap_lg32ls570s);
+    keymap_consumer_active = keymap_consumer_lg32ls570s;
+}
+
+int keymap_parse_key(const char* text, keymap_stored_key_t* key)
+{
+    char protocol[16];
+    uint8_t usage_page = HID_USAGE_PAGE_KEYBOARD;
+    unsigned int usage;
+    unsigned int address;
+    unsigned long code;
+    uint8_t i;
+
+    if((text != NULL) && (strncmp(text, "c:", 2) == 0))
+    {
+        usage_page = HID_USAGE_PAGE_CONSUMER;
+        text += 2;
+    }
+    if((text == NULL) || (sscanf(text, "%x %15s %x %lx", &usage, protocol, &address, &code) != 4) ||
+       (usage >= KEYMAP_SIZE) || (address > 0xFFFF))
+    {
+        return -1;
+    }
+    // Raw frames need a precomputed waveform, none is stored
+    for(i = IR_PROTOCOL_RAW + 1; i < IR_PROTOCOL_COUNT; i++)
+    {
+        if(strcmp(protocol, ir_protocol_get(i)->name) == 0)
+            break;
+    }
+    if(i == IR_PROTOCOL_COUNT)
+        return -1;
+
+    memset(key, 0, sizeof(keymap_stored_key_t));
+    key->usage_page = usage_page;
+    key->usage = (uint8_t)usage;
+    key->protocol = KEYMAP_PROTOCOL_IR | i;
+    key->repeat = KEYMAP_REPEAT_ONCE;
+    key->address = (uint16_t)address;
+    key->code = (uint32_t)code;
+    return 0;
+}
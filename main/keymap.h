@@ -0,0 +1,152 @@
+/* HID keyboard usage to IR action keymap */
+
+/*
+ * Each keymap is a 256 entries table indexed by the HID usage, so
+ * resolving a key is a single indexed load. Builtin keymaps are generated at
+ * compile time from a declarative list of keys; an alternative keymap can be
+ * stored in (and loaded from) the BTstack TLV storage without reflashing. A
+ * stored keymap holds keys of the keyboard and consumer usage pages, each
+ * page it has keys for replaces the builtin keymap of that page.
+ */
+
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ir_frame.h"
+#include "ir_waveform.h"
+
+/**************************************************************************************************/
+
+// IR protocol of an action
+#define KEYMAP_PROTOCOL_NONE     0  // Known key without IR action (only logged)
+#define KEYMAP_PROTOCOL_NEC      1
+#define KEYMAP_PROTOCOL_MACRO    2  // Run the IR macro numbered by the code (see ir_macro.h)
+#define KEYMAP_PROTOCOL_LEARNED  3  // Send the timings of the learned key numbered by the code (see ir_learn.h)
+#define KEYMAP_PROTOCOL_IR       0x10  // Frame of the IR protocol in the low bits (IR_PROTOCOL_*, see
+                                       // ir_frame.h), with the address and code as command
+
+// Repeat policy of an action
+#define KEYMAP_REPEAT_ONCE    0  // Send the frame once per key press
+#define KEYMAP_REPEAT_HOLD    1  // Send repeat bursts while the key is held
+
+// Usage pages handled by the bridge
+#define HID_USAGE_PAGE_KEYBOARD  0x07
+#define HID_USAGE_PAGE_CONSUMER  0x0C
+
+// Number of entries of a keymap (HID keyboard usages are 8 bits in boot reports)
+#define KEYMAP_SIZE 256
+
+// Maximum number of keys of a keymap stored in TLV
+#define KEYMAP_STORED_MAX_KEYS 64
+
+typedef struct {
+    uint8_t       protocol;  // KEYMAP_PROTOCOL_* (NONE with NULL label for unmapped usages)
+    uint8_t       repeat;    // KEYMAP_REPEAT_*
+    uint16_t      address;   // IR frame address (KEYMAP_PROTOCOL_IR)
+    uint32_t      code;      // IR frame value
+    ir_waveform_t waveform;  // Precomputed frame (NULL items to encode the code on send)
+    const char*   label;     // Key name
+} keymap_action_t;
+
+// Declarative keymap entry
+typedef struct {
+    uint8_t         usage;
+    keymap_action_t action;
+} keymap_key_t;
+
+// Stored keymap entry (packed, as written in TLV)
+typedef struct __attribute__((packed)) {
+    uint8_t  usage_page;  // HID_USAGE_PAGE_KEYBOARD or HID_USAGE_PAGE_CONSUMER
+    uint8_t  usage;
+    uint8_t  protocol;
+    uint8_t  repeat;
+    uint32_t code;
+    uint16_t address;
+} keymap_stored_key_t;
+
+/**************************************************************************************************/
+
+// Compile time generation of a 256 entries keymap from a declarative list of keys
+
+constexpr keymap_action_t keymap_unmapped(void)
+{
+    return { KEYMAP_PROTOCOL_NONE, KEYMAP_REPEAT_ONCE, 0, 0, { NULL, 0, 0 }, NULL };
+}
+
+constexpr keymap_action_t keymap_find(const keymap_key_t* keys, const size_t num_keys,
+    const size_t usage)
+{
+    return (num_keys == 0) ? keymap_unmapped() :
+           (keys[0].usage == usage) ? keys[0].action :
+           keymap_find(keys + 1, num_keys - 1, usage);
+}
+
+template<const keymap_key_t* KEYS, size_t NUM_KEYS, typename SEQ> struct keymap_table_impl;
+template<const keymap_key_t* KEYS, size_t NUM_KEYS, size_t... I>
+struct keymap_table_impl<KEYS, NUM_KEYS, ir_index_seq<I...> >
+{
+    static constexpr keymap_action_t table[sizeof...(I)] = { keymap_find(KEYS, NUM_KEYS, I)... };
+};
+template<const keymap_key_t* KEYS, size_t NUM_KEYS, size_t... I>
+constexpr keymap_action_t keymap_table_impl<KEYS, NUM_KEYS, ir_index_seq<I...> >::table[sizeof...(I)];
+
+// 256 entries keymap table of a declarative key list (KEYS must have static storage)
+template<const keymap_key_t* KEYS, size_t NUM_KEYS> struct keymap_table :
+    keymap_table_impl<KEYS, NUM_KEYS, typename ir_make_index_seq<KEYMAP_SIZE>::type> {};
+
+// Declarative key entries
+#define KEYMAP_KEY_NEC(usage, data, repeat, label) \
+    { usage, { KEYMAP_PROTOCOL_NEC, repeat, 0, (uint32_t)(data), IR_NEC_WAVEFORM(data), label } }
+#define KEYMAP_KEY_IR(usage, protocol, address, command, label) \
+    { usage, { KEYMAP_PROTOCOL_IR | (protocol), KEYMAP_REPEAT_ONCE, address, (uint32_t)(command), \
+        { NULL, 0, 0 }, label } }
+#define KEYMAP_KEY_MACRO(usage, macro, label) \
+    { usage, { KEYMAP_PROTOCOL_MACRO, KEYMAP_REPEAT_ONCE, 0, (uint32_t)(macro), { NULL, 0, 0 }, label } }
+#define KEYMAP_KEY_NONE(usage, label) \
+    { usage, { KEYMAP_PROTOCOL_NONE, KEYMAP_REPEAT_ONCE, 0, 0, { NULL, 0, 0 }, label } }
+
+/**************************************************************************************************/
+
+// Builtin keymap of the LG-32LS570S TV
+extern const keymap_action_t* const keymap_lg32ls570s;
+
+// Builtin consumer control (media keys and remotes) keymap of the LG-32LS570S TV
+extern const keymap_action_t* const keymap_consumer_lg32ls570s;
+
+// Active keymaps of the keyboard and consumer pages (default to the builtin LG-32LS570S ones)
+extern const keymap_action_t* keymap_active;
+extern const keymap_action_t* keymap_consumer_active;
+
+// Get the action of a HID keyboard usage in the active keymap
+static inline const keymap_action_t* keymap_get(const uint8_t usage)
+{
+    return &keymap_active[usage];
+}
+
+// Get the action of a HID consumer control usage (only usages below KEYMAP_SIZE are mapped)
+static inline const keymap_action_t* keymap_consumer_get(const uint16_t usage)
+{
+    return &keymap_consumer_active[(usage < KEYMAP_SIZE) ? usage : 0];
+}
+
+// Select a keyboard keymap table (KEYMAP_SIZE entries)
+void keymap_set(const keymap_action_t* keymap);
+
+// Load the keymap stored in TLV and make it active, returns number of keys (0 if none stored)
+int keymap_load(void);
+
+// Store a keymap in TLV (replacing the stored one) and make it active
+int keymap_store(const keymap_stored_key_t* keys, const uint16_t num_keys);
+
+// Remove the keymap stored in TLV and make the builtin ones active
+void keymap_clear(void);
+
+// Parse a key to store: "<usage> <protocol> <address> <code>", hex values and the protocol named as
+// in ir_frame.cpp (nec, samsung, ...), keyboard usages alone and consumer ones as "c:<usage>",
+// returns 0 if valid
+int keymap_parse_key(const char* text, keymap_stored_key_t* key);
+
+#endif
@@ -0,0 +1,167 @@
+/* Key to IR latency instrumentation */
+
+#include "latency.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**************************************************************************************************/
+
+// Give up the core offset measurement if the other core does not answer (in cycles)
+#define LATENCY_SYNC_TIMEOUT (100000 * LATENCY_CYCLES_PER_US)
+
+// Offset measurement handshake states
+#define LATENCY_SYNC_IDLE      0
+#define LATENCY_SYNC_REQUESTED 1
+#define LATENCY_SYNC_ANSWERED  2
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[LATENCY_NUM_BUCKETS];
+} latency_histogram_t;
+
+static const char* const stage_names[LATENCY_NUM_STAGES] =
+{
+    "L2CAP dispatch",
+    "Report decode",
+    "IR enqueue",
+    "IR first mark",
+    "IR last space",
+};
+
+// Histograms in cycles (each one has a single writer)
+static latency_histogram_t histograms[LATENCY_NUM_STAGES];
+
+// Trace in progress on the BTstack run loop (0 if none)
+static uint32_t trace_origin = 0;
+
+// Cycle counter offset of the other core
+static volatile uint8_t sync_state = LATENCY_SYNC_IDLE;
+static volatile uint32_t sync_cycles = 0;
+static int32_t remote_offset = 0;
+
+/**************************************************************************************************/
+
+void latency_begin(const uint32_t origin)
+{
+    // 0 means no trace, a counter read as 0 is off by a single cycle
+    trace_origin = (origin == 0) ? 1 : origin;
+}
+
+void latency_end(void)
+{
+    trace_origin = 0;
+}
+
+uint32_t latency_origin(void)
+{
+    return trace_origin;
+}
+
+void latency_mark(const latency_stage_t stage)
+{
+    if(trace_origin == 0)
+        return;
+    latency_record(stage, latency_now() - trace_origin);
+}
+
+void latency_record(const latency_stage_t stage, const uint32_t cycles)
+{
+    latency_histogram_t* histogram = &histograms[stage];
+    uint32_t us = cycles / LATENCY_CYCLES_PER_US;
+    uint8_t bucket = (us == 0) ? 0 : (32 - __builtin_clz(us));
+
+    if(bucket >= LATENCY_NUM_BUCKETS)
+        bucket = LATENCY_NUM_BUCKETS - 1;
+    histogram->buckets[bucket]++;
+    if((histogram->count == 0) || (cycles < histogram->min))
+        histogram->min = cycles;
+    if(cycles > histogram->max)
+        histogram->max = cycles;
+    histogram->sum += cycles;
+    histogram->count++;
+}
+
+uint32_t latency_now_remote(void)
+{
+    return latency_now() - remote_offset;
+}
+
+/**************************************************************************************************/
+
+void latency_init(void)
+{
+    memset(histograms, 0, sizeof(histograms));
+}
+
+void latency_sync_local(void)
+{
+    uint32_t start = latency_now();
+
+    while(sync_state != LATENCY_SYNC_REQUESTED)
+    {
+        if((latency_now() - start) > LATENCY_SYNC_TIMEOUT)
+            return;
+    }
+    sync_cycles = latency_now();
+    sync_state = LATENCY_SYNC_ANSWERED;
+}
+
+void latency_sync_remote(void)
+{
+    uint32_t request;
+    uint32_t answer;
+
+    // The local counter was read between the request and the answer, take the middle
+    request = latency_now();
+    sync_state = LATENCY_SYNC_REQUESTED;
+    while(sync_state != LATENCY_SYNC_ANSWERED)
+    {
+        if((latency_now() - request) > LATENCY_SYNC_TIMEOUT)
+        {
+            sync_state = LATENCY_SYNC_IDLE;
+            return;
+        }
+    }
+    answer = latency_now();
+    remote_offset = (int32_t)((request + ((answer - request) / 2)) - sync_cycles);
+    sync_state = LATENCY_SYNC_IDLE;
+}
+
+void latency_dump(void)
+{
+    const latency_histogram_t* histogram;
+    uint32_t low;
+
+    printf("Key to IR latency from HCI receive:\n");
+    for(uint8_t i = 0; i < LATENCY_NUM_STAGES; i++)
+    {
+        histogram = &histograms[i];
+        if(histogram->count == 0)
+        {
+            printf("  %-14s no samples\n", stage_names[i]);
+            continue;
+        }
+        printf("  %-14s %u samples, min %u us, avg %u us, max %u us\n", stage_names[i],
+            histogram->count, histogram->min / LATENCY_CYCLES_PER_US,
+            (uint32_t)((histogram->sum / histogram->count) / LATENCY_CYCLES_PER_US),
+            histogram->max / LATENCY_CYCLES_PER_US);
+        for(uint8_t bucket = 0; bucket < LATENCY_NUM_BUCKETS; bucket++)
+        {
+            if(histogram->buckets[bucket] == 0)
+                continue;
+            low = (bucket == 0) ? 0 : ((uint32_t)1 << (bucket - 1));
+            if(bucket == 0)
+                printf("    < 1 us: %u\n", histogram->buckets[bucket]);
+            else if(bucket == 1)
+                printf("    1 us: %u\n", histogram->buckets[bucket]);
+            else if(bucket == LATENCY_NUM_BUCKETS - 1)
+                printf("    >= %u us: %u\n", low, histogram->buckets[bucket]);
+            else
+                printf("    %u-%u us: %u\n", low, ((uint32_t)1 << bucket) - 1, histogram->buckets[bucket]);
+        }
+    }
+}
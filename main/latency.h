@@ -0,0 +1,98 @@
+/* Key to IR latency instrumentation */
+
+/*
+ * Each HID report is traced from the HCI transport receiving it to the IR
+ * frame it produces leaving the LED. Timestamps are raw cycle counter reads
+ * and every stage adds its time since the HCI receive to a fixed bucket
+ * histogram kept in RAM, so tracing costs a few tens of cycles per stage and
+ * stays enabled in production builds. latency_dump() prints the histograms.
+ *
+ * Each stage has a single writer: the BTstack run loop for the host side
+ * stages and the IR transmitter task for the on air stages.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+    #include "sdkconfig.h"
+    #include "xtensa/hal.h"
+#else
+    #include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stages of a trace, all measured from the HCI transport receiving the packet
+typedef enum {
+    LATENCY_STAGE_L2CAP_DISPATCH = 0,  // L2CAP data packet reaches the application
+    LATENCY_STAGE_REPORT_DECODE,       // HID report decoded into keys
+    LATENCY_STAGE_IR_ENQUEUE,          // IR frame queued to the transmitter
+    LATENCY_STAGE_IR_FIRST_MARK,       // First mark of the frame starts on the LED
+    LATENCY_STAGE_IR_LAST_SPACE,       // Last space of the frame ends
+    LATENCY_NUM_STAGES
+} latency_stage_t;
+
+// Histogram buckets: bucket 0 is below 1 us, bucket n holds [2^(n-1), 2^n) us, last one is open
+#define LATENCY_NUM_BUCKETS 21
+
+// Cycle counter
+#ifdef ESP_PLATFORM
+    #define LATENCY_CYCLES_PER_US CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+    static inline uint32_t latency_now(void)
+    {
+        return xthal_get_ccount();
+    }
+#else
+    #define LATENCY_CYCLES_PER_US 1000
+    static inline uint32_t latency_now(void)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+    }
+#endif
+
+// Cycle counter value when the HCI packet being delivered was received (provided by the transport)
+uint32_t hci_transport_rx_cycles(void);
+
+// Start the trace of a packet received at given cycle counter value
+void latency_begin(const uint32_t origin);
+
+// End the trace once the packet is handled, frames queued later (macro steps run from timers) are
+// not traced
+void latency_end(void);
+
+// Origin of the trace in progress (carried along with the IR frames it produces), 0 if none
+uint32_t latency_origin(void);
+
+// Current trace reached a stage, ignored if no trace is in progress
+void latency_mark(const latency_stage_t stage);
+
+// Add a stage latency measured in cycles
+void latency_record(const latency_stage_t stage, const uint32_t cycles);
+
+// Cycle counter of the IR transmitter core in the time base of the BTstack core (the counters
+// of the two cores are not in sync, their offset is measured once by the sync handshake)
+uint32_t latency_now_remote(void);
+
+// Clear the histograms
+void latency_init(void);
+
+// Offset measurement handshake, latency_sync_local() runs on the BTstack core while the other
+// core runs latency_sync_remote()
+void latency_sync_local(void);
+void latency_sync_remote(void);
+
+// Print the histograms to the console
+void latency_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
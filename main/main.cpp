@@ -63,9 +63,22 @@ Enter:         A1 01 00 00 58 00 00 00 00 00
 
 #include "btstack_config.h"
 #include "btstack.h"
-#include "Arduino.h"
-#include "IRremote.h"
-#include "lg32ls570s.h"
+#include "event_log.h"
+#include "hid_cache.h"
+#include "hid_context.h"
+#include "hid_pairing.h"
+#include "hid_reconnect.h"
+#include "hid_sniff.h"
+#include "ir_learn.h"
+#include "ir_macro.h"
+#include "ir_rx.h"
+#include "ir_tx.h"
+#include "keymap.h"
+#include "latency.h"
+
+#ifdef ESP_PLATFORM
+    #include "Arduino.h"
+#endif
 
 #define DEBUG 0
 #define debug(...) do { if(DEBUG) printf(__VA_ARGS__); } while (0)
@@ -73,27 +86,46 @@ Enter:         A1 01 00 00 58 00 00 00 00 00
 
 #define MAX_ATTRIBUTE_VALUE_SIZE 300
 
-// Device connection status
-static uint8_t device_is_connected = 0;
-
 // SDP
-static uint8_t            hid_descriptor[MAX_ATTRIBUTE_VALUE_SIZE];
-static uint16_t           hid_descriptor_len;
-
-static uint16_t           hid_control_psm;
-static uint16_t           hid_interrupt_psm;
-
 static uint8_t            attribute_value[MAX_ATTRIBUTE_VALUE_SIZE];
 static const unsigned int attribute_value_buffer_size = MAX_ATTRIBUTE_VALUE_SIZE;
 
-// L2CAP
-static uint16_t           l2cap_hid_control_cid;
-static uint16_t           l2cap_hid_interrupt_cid;
+// SDP query in progress (the SDP client stays busy until it completes even if its device is
+// removed), its device (NULL if removed) and the record it returns
+static bool               sdp_busy = false;
+static hid_context_t*     sdp_device = NULL;
+static hid_cache_entry_t  sdp_record;
 
-// MBP 2016
-static const char* remote_addr_string = "3D-0E-01-16-05-2E";
+// Boot keyboard report (with report ID 1) used for devices without descriptor
+static const uint8_t hid_boot_keyboard_descriptor[] =
+{
+    0x05, 0x01,        // Usage Page (Generic Desktop)
+    0x09, 0x06,        // Usage (Keyboard)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x01,        //   Report ID (1)
+    0x05, 0x07,        //   Usage Page (Keyboard)
+    0x19, 0xE0,        //   Usage Minimum (Left Control)
+    0x29, 0xE7,        //   Usage Maximum (Right GUI)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x08,        //   Report Count (8)
+    0x81, 0x02,        //   Input (Data, Variable, Absolute) - Modifiers
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x01,        //   Input (Constant) - Reserved
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x2A, 0xFF, 0x00,  //   Usage Maximum (255)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x06,        //   Report Count (6)
+    0x81, 0x00,        //   Input (Data, Array) - Keys
+    0xC0               // End Collection
+};
 
-static bd_addr_t remote_addr;
+// Device whose key frame was queued last, only it can stop the repeats of a held key
+static uint8_t ir_owner = HID_CONTEXT_NONE;
 
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
@@ -101,18 +133,301 @@ static btstack_packet_callback_registration_t hci_event_callback_registration;
 
 // Receive and Transmit pins
 #define PIN_O_IR_TX 12
+#define PIN_I_IR_RX 14
+
+// Pairing mode button (BOOT button of the ESP32 boards, low while pressed) and its polling period
+#define PIN_I_PAIRING 0
+#define PAIRING_BUTTON_POLL_MS 50
+
+// Queue the IR frame of a key action (sent asynchronously by the IR transmitter task), the frames
+// of all devices go through the transmitter queue in arrival order, any key stops a running macro
+static void ir_send_action(const hid_context_t* device, const keymap_action_t* action)
+{
+    ir_frame_t frame = { IR_PROTOCOL_NEC, 32, 0, (uint16_t)(action->code >> 16), action->code & 0xFFFF,
+        action->waveform.items != NULL ? &action->waveform : NULL };
+    bool queued;
+
+    ir_macro_cancel();
+    if(action->protocol == KEYMAP_PROTOCOL_MACRO)
+    {
+        if(!ir_macro_start((uint8_t)action->code))
+            debug("IR macro %u not defined\n", action->code);
+        return;
+    }
+    if(action->protocol == KEYMAP_PROTOCOL_LEARNED)
+    {
+        if(!ir_learn_send(action->code))
+            debug("IR TX busy, learned key %u dropped\n", action->code);
+        return;
+    }
+    if(action->protocol & KEYMAP_PROTOCOL_IR)
+    {
+        frame.protocol = action->protocol & ~KEYMAP_PROTOCOL_IR;
+        frame.bits = 0;
+        frame.address = action->address;
+        frame.command = action->code;
+        frame.waveform = NULL;
+    }
+    else if(action->protocol != KEYMAP_PROTOCOL_NEC)
+        return;
+
+    // NEC frames use the precomputed frame if available, otherwise the transmitter encodes them,
+    // held keys repeat only with the precomputed frame
+    if((action->repeat == KEYMAP_REPEAT_HOLD) && (frame.waveform != NULL))
+        queued = ir_tx_hold(frame.waveform);
+    else
+        queued = ir_tx_enqueue_frame(&frame);
+    if(!queued)
+    {
+        debug("IR TX queue full, code 0x%08X dropped\n", action->code);
+        return;
+    }
+    ir_owner = device->index;
+}
+
+// Stop the repeats of the key held by a device (those of another device keep going)
+static void ir_release(const hid_context_t* device)
+{
+    if(ir_owner != device->index)
+        return;
+    ir_owner = HID_CONTEXT_NONE;
+    ir_tx_release();
+}
+
+// Compile the layout of the device HID descriptor (boot keyboard layout if there is none)
+static void hid_layout_setup(hid_context_t* device)
+{
+    btstack_hid_report_layout_t* layout = &device->layout;
+
+    memset(device->num_pressed, 0, sizeof(device->num_pressed));
+    if((device->record.descriptor_len > 0) && (btstack_hid_report_layout_compile(
+        device->record.descriptor, device->record.descriptor_len, layout) == 0))
+    {
+        debug("HID layout %u: %u reports, %u fields\n", device->index, layout->num_reports,
+            layout->num_fields);
+        return;
+    }
+    debug("HID layout %u: using boot keyboard\n", device->index);
+    btstack_hid_report_layout_compile(hid_boot_keyboard_descriptor,
+        sizeof(hid_boot_keyboard_descriptor), layout);
+}
+
+// Get the action of a key, the learned one if any or the keymap one
+static const keymap_action_t* hid_key_action(const hid_key_t* key)
+{
+    const keymap_action_t* learned = ir_learn_get(key->usage_page, key->usage);
+
+    if(learned != NULL)
+        return learned;
+    if(key->usage_page == HID_USAGE_PAGE_CONSUMER)
+        return keymap_consumer_get(key->usage);
+    return keymap_get((uint8_t)key->usage);
+}
+
+#ifdef ESP_PLATFORM
+static btstack_timer_source_t pairing_button_timer;
+
+// Start the pairing mode when the button gets pressed
+static void pairing_button_poll(btstack_timer_source_t* ts)
+{
+    static bool pressed = false;
+    bool now_pressed = (digitalRead(PIN_I_PAIRING) == LOW);
+
+    if(now_pressed && !pressed)
+        hid_pairing_start();
+    pressed = now_pressed;
+    btstack_run_loop_set_timer(ts, PAIRING_BUTTON_POLL_MS);
+    btstack_run_loop_add_timer(ts);
+}
+#endif
+
+#ifdef HAVE_BTSTACK_STDIN
+// BTstack memory in use, high-water mark and failed allocations of the pools used by the bridge,
+// to size their MAX_NR_* (the pool size is 0 when allocated with malloc)
+static void memory_dump(void)
+{
+    static const struct
+    {
+        const char* name;
+        void (*get_stats)(btstack_memory_pool_stats_t* stats);
+    } pools[] = {
+        { "hci_connection",      btstack_memory_hci_connection_get_stats },
+        { "l2cap_service",       btstack_memory_l2cap_service_get_stats },
+        { "l2cap_channel",       btstack_memory_l2cap_channel_get_stats },
+        { "service_record_item", btstack_memory_service_record_item_get_stats },
+    };
+    btstack_memory_pool_stats_t stats;
+
+    printf("BTstack memory:\n");
+    for(uint8_t i = 0; i < sizeof(pools)/sizeof(pools[0]); i++)
+    {
+        pools[i].get_stats(&stats);
+        printf("  %-20s %u in use, max %u of %u, %" PRIu32 " failed\n", pools[i].name, stats.used,
+            stats.max_used, stats.count, stats.failed);
+    }
+}
+
+// Text lines entered in the console after a command ('k'), given to the handler of the command
+// until it leaves the line mode
+#define CONSOLE_LINE_MAX 64
+
+static void (*console_line_handler)(const char* line) = NULL;
+static char    console_line[CONSOLE_LINE_MAX];
+static uint8_t console_line_len;
+static char    console_last_char;
+
+static void console_line_process(char c)
+{
+    char last = console_last_char;
+
+    console_last_char = c;
+    if((c == '\n') && (last == '\r'))
+        return;
+    if((c != '\r') && (c != '\n'))
+    {
+        if(console_line_len < CONSOLE_LINE_MAX - 1)
+            console_line[console_line_len++] = c;
+        return;
+    }
+    console_line[console_line_len] = 0;
+    console_line_len = 0;
+    console_line_handler(console_line);
+}
+
+// Keymap entered in the console, stored in TLV once an empty line ends it
+static keymap_stored_key_t console_keys[KEYMAP_STORED_MAX_KEYS];
+static uint16_t            console_num_keys;
+
+static void console_keymap_line(const char* line)
+{
+    if(line[0] == 0)
+    {
+        console_line_handler = NULL;
+        if(console_num_keys == 0)
+            printf("Keymap unchanged.\n");
+        else if(keymap_store(console_keys, console_num_keys) == 0)
+            printf("Keymap of %u keys stored.\n", console_num_keys);
+        else
+            printf("Keymap not stored.\n");
+        return;
+    }
+    if(console_num_keys == KEYMAP_STORED_MAX_KEYS)
+        printf("Keymap full, key ignored.\n");
+    else if(keymap_parse_key(line, &console_keys[console_num_keys]) == 0)
+        console_num_keys++;
+    else
+        printf("Invalid key: %s\n", line);
+}
 
-// Send a NEC code message
-void ir_send_nec(const uint16_t code);
+// Macro table entered in the console as hex bytes, stored in TLV once an empty line ends it
+static uint8_t  console_macros[IR_MACRO_TABLE_LEN];
+static uint16_t console_macros_len;
 
-// IR Send Object
-IRsend ir_tx(PIN_O_IR_TX);
+static void console_macro_line(const char* line)
+{
+    int len;
+
+    if(line[0] == 0)
+    {
+        console_line_handler = NULL;
+        if(console_macros_len == 0)
+            printf("Macros unchanged.\n");
+        else if(ir_macro_store(console_macros, console_macros_len) == 0)
+            printf("Macro table of %u bytes stored.\n", console_macros_len);
+        else
+            printf("Macro table not valid, not stored.\n");
+        return;
+    }
+    len = ir_macro_parse(line, &console_macros[console_macros_len], IR_MACRO_TABLE_LEN - console_macros_len);
+    if(len < 0)
+        printf("Invalid bytes: %s\n", line);
+    else
+        console_macros_len += len;
+}
 
-// Send a NEC code message
-void ir_send_nec(const uint16_t code)
+// Serial console commands
+static void stdin_process(char cmd)
 {
-    ir_tx.sendNEC(NEC_INIT_MASK | code, 32);
+    if(console_line_handler != NULL)
+    {
+        console_line_process(cmd);
+        return;
+    }
+    console_last_char = cmd;
+
+    switch(cmd)
+    {
+        case '\r':
+        case '\n':
+            break;
+        case 'k':
+            printf("Keymap keys, one per line: <usage> <protocol> <address> <code> (hex, consumer usages "
+                "as c:<usage>, protocol nec, samsung, sony, rc5, rc6, panasonic or jvc), an empty line "
+                "stores them.\n");
+            console_num_keys = 0;
+            console_line_handler = console_keymap_line;
+            break;
+        case 'K':
+            keymap_clear();
+            printf("Builtin keymap.\n");
+            break;
+        case 'M':
+            printf("Macro table bytecode (see ir_macro.h), hex bytes on one or more lines, an empty line "
+                "stores it.\n");
+            console_macros_len = 0;
+            console_line_handler = console_macro_line;
+            break;
+        case 'l':
+            latency_dump();
+            break;
+        case 'L':
+            latency_init();
+            printf("Latency histograms cleared.\n");
+            break;
+        case 'r':
+            hid_reconnect_dump();
+            break;
+        case 's':
+            hid_sniff_dump();
+            break;
+        case 'm':
+            ir_macro_dump();
+            break;
+        case 'i':
+            if(ir_learn_active())
+                ir_learn_stop();
+            else
+                ir_learn_start();
+            break;
+        case 'I':
+            ir_learn_dump();
+            break;
+        case 'b':
+            memory_dump();
+            break;
+        case 'p':
+            if(hid_pairing_active())
+                hid_pairing_stop();
+            else
+                hid_pairing_start();
+            break;
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+            event_log_set_level(cmd - '0');
+            printf("Log level %u.\n", event_log_get_level());
+            break;
+        default:
+            printf("Commands: l (dump latency histograms), L (clear latency histograms), "
+                "r (dump reconnection statistics), s (dump link mode statistics), m (dump macro statistics), "
+                "b (dump BTstack memory statistics), p (start/stop pairing mode), i (start/stop IR learning mode), I (dump learned keys), "
+                "k (enter and store a keymap), K (back to the builtin keymap), M (enter and store a macro table), "
+                "0-3 (log level off, error, info, debug)\n");
+            break;
+    }
 }
+#endif
 
 /**************************************************************************************************/
 
@@ -137,11 +452,200 @@ static void hid_host_setup(void){
     // Allow sniff mode requests by HID device
     gap_set_default_link_policy_settings(LM_LINK_POLICY_ENABLE_SNIFF_MODE);
 
+    // Bond through Secure Simple Pairing without user interaction (the bridge has no display nor
+    // keyboard), L2CAP requests encryption for the HID channels
+    gap_set_bondable_mode(1);
+    gap_ssp_set_io_capability(SSP_IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    gap_ssp_set_auto_accept(1);
+
+    // Accept the HID channels of the devices reconnecting on their own
+    l2cap_register_service(packet_handler, BLUETOOTH_PSM_HID_CONTROL, 48, LEVEL_2);
+    l2cap_register_service(packet_handler, BLUETOOTH_PSM_HID_INTERRUPT, 48, LEVEL_2);
+
     // Disable stdout buffering
     setbuf(stdout, NULL);
 }
 /* LISTING_END */
 
+// Use the SDP record of a device and store it in the cache if it changed, returns true if it did
+static bool hid_host_cache_update(hid_context_t* device, const hid_cache_entry_t* record)
+{
+    device->cache_checked = 1;
+    if(device->cache_used && hid_cache_equal(record, &device->record))
+        return false;
+    memcpy(&device->record, record, sizeof(hid_cache_entry_t));
+    device->cache_used = 1;
+    if(!hid_cache_store(&device->record))
+        debug("HID cache store failed\n");
+    return true;
+}
+
+// Start the next SDP query waiting for the SDP client
+static void hid_host_sdp_next(void)
+{
+    hid_context_t* device;
+
+    if(sdp_busy)
+        return;
+    for(uint8_t i = 0; i < HID_CONTEXT_MAX; i++)
+    {
+        device = hid_context_get(i);
+        if((device == NULL) || !device->sdp_pending)
+            continue;
+        device->sdp_pending = 0;
+        memset(&sdp_record, 0, sizeof(sdp_record));
+        memcpy(sdp_record.addr, device->addr, sizeof(bd_addr_t));
+        if(sdp_client_query_uuid16(&handle_sdp_client_query_result, device->addr,
+            BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE) != ERROR_CODE_SUCCESS)
+        {
+            if(device->sdp_mode == HID_CONTEXT_SDP_CONNECT)
+            {
+                device->state = HID_CONTEXT_IDLE;
+                hid_reconnect_lost(device, false);
+            }
+            continue;
+        }
+        sdp_busy = true;
+        sdp_device = device;
+        return;
+    }
+}
+
+// Queue the SDP query of the HID service of a device
+static void hid_host_sdp_query(hid_context_t* device, const uint8_t mode)
+{
+    device->sdp_mode = mode;
+    device->sdp_pending = 1;
+    hid_host_sdp_next();
+}
+
+// Open the HID control channel (the interrupt channel is opened once it is)
+static void hid_host_open_control(hid_context_t* device)
+{
+    uint8_t status;
+
+    device->state = HID_CONTEXT_CONNECTING;
+    status = l2cap_create_channel(packet_handler, device->addr, device->record.control_psm, 48,
+        &device->control_cid);
+    if(status != ERROR_CODE_SUCCESS)
+    {
+        event_log(EVENT_LOG_L2CAP_FAILED, &status, 1);
+        device->control_cid = 0;
+        device->state = HID_CONTEXT_IDLE;
+        hid_reconnect_lost(device, false);
+        return;
+    }
+    hid_context_bind_cid(device, device->control_cid);
+}
+
+// Open the HID channels of a device, right away if its SDP information is cached
+static void hid_host_connect(hid_context_t* device)
+{
+    if(device->state != HID_CONTEXT_IDLE)
+        return;
+
+    if(hid_cache_get(device->addr, &device->record))
+    {
+        device->cache_used = 1;
+        hid_layout_setup(device);
+        debug("Setup HID %u from cache\n", device->index);
+        hid_host_open_control(device);
+        return;
+    }
+
+    debug("Start SDP HID query for remote HID Device %u.\n", device->index);
+    device->cache_used = 0;
+    device->state = HID_CONTEXT_SDP_QUERY;
+    hid_host_sdp_query(device, HID_CONTEXT_SDP_CONNECT);
+}
+
+// Page a device for the reconnection manager, returns false if it is already connected or the
+// connection failed right away
+static bool hid_host_page(hid_context_t* device)
+{
+    if(device->state != HID_CONTEXT_IDLE)
+        return false;
+    hid_host_connect(device);
+    return (device->state != HID_CONTEXT_IDLE);
+}
+
+// HID channels opened by the device, use the cached record (boot keyboard layout until the SDP
+// query of the connection gets one if there is none)
+static void hid_host_incoming(hid_context_t* device)
+{
+    if((device->state == HID_CONTEXT_CONNECTING) || (device->state == HID_CONTEXT_CONNECTED))
+        return;
+    device->cache_used = hid_cache_get(device->addr, &device->record);
+    if(!device->cache_used)
+    {
+        memset(&device->record, 0, sizeof(hid_cache_entry_t));
+        device->cache_checked = 0;
+    }
+    hid_layout_setup(device);
+    device->state = HID_CONTEXT_CONNECTING;
+}
+
+// HID channels open, check the record used to open them if not done since boot
+static void hid_host_connected(hid_context_t* device)
+{
+    device->state = HID_CONTEXT_CONNECTED;
+    hid_reconnect_connected(device);
+    hid_sniff_connected(device);
+    if(!device->cache_checked)
+        hid_host_sdp_query(device, HID_CONTEXT_SDP_REFRESH);
+}
+
+// Connection of a device lost, forget its channels and stop the key it holds
+static void hid_host_disconnected(hid_context_t* device)
+{
+    hid_sniff_disconnected(device);
+    hid_context_unbind_cid(device->control_cid);
+    hid_context_unbind_cid(device->interrupt_cid);
+    device->control_cid = 0;
+    device->interrupt_cid = 0;
+    device->con_handle = HCI_CON_HANDLE_INVALID;
+    device->sdp_pending = 0;
+    device->state = HID_CONTEXT_IDLE;
+    memset(device->num_pressed, 0, sizeof(device->num_pressed));
+    ir_release(device);
+}
+
+// Forget a device, closing its connection
+static void hid_host_remove(hid_context_t* device)
+{
+    hci_con_handle_t con_handle = device->con_handle;
+
+    hid_host_disconnected(device);
+    hid_reconnect_stop(device);
+    if(con_handle != HCI_CON_HANDLE_INVALID)
+        gap_disconnect(con_handle);
+    if(sdp_device == device)
+        sdp_device = NULL;
+    hid_context_remove(device);
+}
+
+// Device paired in pairing mode, serve it in place of the one it evicted from the allow-list
+static void hid_host_paired(const bd_addr_t addr, const uint8_t* evicted_addr)
+{
+    hid_context_t* device;
+
+    if(evicted_addr != NULL)
+    {
+        device = hid_context_get_by_addr(evicted_addr);
+        if(device != NULL)
+            hid_host_remove(device);
+    }
+    device = hid_context_add(addr);
+    if(device == NULL)
+    {
+        printf("Device %s paired, no room to connect it.\n", bd_addr_to_str(addr));
+        return;
+    }
+    hid_reconnect_start(device);
+}
+
+/**************************************************************************************************/
+
 /* @section SDP parser callback 
  * 
  * @text The SDP parsers retrieves the BNEP PAN UUID as explained in  
@@ -161,6 +665,7 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
     uint8_t       *element;
     uint32_t       uuid;
     uint8_t        status;
+    hid_context_t  *device;
 
     switch (hci_event_packet_get_type(packet)){
         case SDP_EVENT_QUERY_ATTRIBUTE_VALUE:
@@ -181,8 +686,8 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
                                 switch (uuid){
                                     case BLUETOOTH_PROTOCOL_L2CAP:
                                         if (!des_iterator_has_more(&prot_it)) continue;
-                                        de_element_get_uint16(des_iterator_get_element(&prot_it), &hid_control_psm);
-                                        debug("HID Control PSM: 0x%04x\n", (int) hid_control_psm);
+                                        de_element_get_uint16(des_iterator_get_element(&prot_it), &sdp_record.control_psm);
+                                        debug("HID Control PSM: 0x%04x\n", (int) sdp_record.control_psm);
                                         break;
                                     default:
                                         break;
@@ -205,8 +710,8 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
                                     switch (uuid){
                                         case BLUETOOTH_PROTOCOL_L2CAP:
                                             if (!des_iterator_has_more(&prot_it)) continue;
-                                            de_element_get_uint16(des_iterator_get_element(&prot_it), &hid_interrupt_psm);
-                                            debug("HID Interrupt PSM: 0x%04x\n", (int) hid_interrupt_psm);
+                                            de_element_get_uint16(des_iterator_get_element(&prot_it), &sdp_record.interrupt_psm);
+                                            debug("HID Interrupt PSM: 0x%04x\n", (int) sdp_record.interrupt_psm);
                                             break;
                                         default:
                                             break;
@@ -222,10 +727,10 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
                                     if (des_iterator_get_type(&additional_des_it) != DE_STRING) continue;
                                     element = des_iterator_get_element(&additional_des_it);
                                     const uint8_t * descriptor = de_get_string(element);
-                                    hid_descriptor_len = de_get_data_size(element);
-                                    memcpy(hid_descriptor, descriptor, hid_descriptor_len);
+                                    sdp_record.descriptor_len = btstack_min(de_get_data_size(element), HID_CACHE_MAX_DESCRIPTOR_LEN);
+                                    memcpy(sdp_record.descriptor, descriptor, sdp_record.descriptor_len);
                                     debug("HID Descriptor:\n");
-                                    debug_hexdump(hid_descriptor, hid_descriptor_len);
+                                    debug_hexdump(sdp_record.descriptor, sdp_record.descriptor_len);
                                 }
                             }                        
                             break;
@@ -239,151 +744,142 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
             break;
             
         case SDP_EVENT_QUERY_COMPLETE:
-            if (!hid_control_psm) {
-                debug("HID Control PSM missing\n");
-                break;
-            }
-            if (!hid_interrupt_psm) {
-                debug("HID Interrupt PSM missing\n");
+            device = sdp_device;
+            sdp_busy = false;
+            sdp_device = NULL;
+            status = sdp_event_query_complete_get_status(packet);
+            // Ignore the result if the device was removed (its slot may serve another device now),
+            // disconnected or queued a new query meanwhile
+            if ((device == NULL) || (bd_addr_cmp(device->addr, sdp_record.addr) != 0) || device->sdp_pending) {
+                hid_host_sdp_next();
                 break;
             }
-            debug("Setup HID\n");
-            status = l2cap_create_channel(packet_handler, remote_addr, hid_control_psm, 48, &l2cap_hid_control_cid);
-            if (status){
-                debug("Connecting to HID Control failed: 0x%02x\n", status);
+            if (device->sdp_mode == HID_CONTEXT_SDP_REFRESH) {
+                // The descriptor in use is only replaced if the device reported a different one
+                if ((device->state == HID_CONTEXT_CONNECTED) && (status == ERROR_CODE_SUCCESS) &&
+                    sdp_record.control_psm && sdp_record.interrupt_psm &&
+                    hid_host_cache_update(device, &sdp_record)) {
+                    debug("HID cache %u refreshed\n", device->index);
+                    hid_layout_setup(device);
+                }
+            } else if (device->state == HID_CONTEXT_SDP_QUERY) {
+                if ((status != ERROR_CODE_SUCCESS) || !sdp_record.control_psm || !sdp_record.interrupt_psm) {
+                    debug("HID %u: SDP query failed (0x%02x) or PSM missing\n", device->index, status);
+                    device->state = HID_CONTEXT_IDLE;
+                    hid_reconnect_lost(device, false);
+                } else {
+                    hid_host_cache_update(device, &sdp_record);
+                    hid_layout_setup(device);
+                    debug("Setup HID %u\n", device->index);
+                    hid_host_open_control(device);
+                }
             }
+            hid_host_sdp_next();
             break;
     }
 }
 
-char parse_numpad(const uint8_t val)
-{
-    if(val == 0x2A)
-        return (char)(8); // BackSpace
-    if(val == 0x54)
-        return '/';
-    if(val == 0x55)
-        return '*';
-    if(val == 0x56)
-        return '-';
-    if(val == 0x57)
-        return '+';
-    if(val == 0x58)
-        return (char)(10); // Enter
-    if(val == 0x59)
-        return '1';
-    if(val == 0x5A)
-        return '2';
-    if(val == 0x5B)
-        return '3';
-    if(val == 0x5C)
-        return '4';
-    if(val == 0x5D)
-        return '5';
-    if(val == 0x5E)
-        return '6';
-    if(val == 0x5F)
-        return '7';
-    if(val == 0x60)
-        return '8';
-    if(val == 0x61)
-        return '9';
-    if(val == 0x62)
-        return '0';
-    if(val == 0x63)
-        return '.';
-
-    return '\0';
-}
-
 /*
  * @section HID Report Handler
  * 
- * @text Use BTstack's compact HID Parser to process incoming HID Report
- * Iterate over all fields and process fields with usage page = 0x07 / Keyboard
- * Check if SHIFT is down and process first character (don't handle multiple key presses)
+ * @text Decode incoming HID input reports with the layout compiled from the device HID descriptor
+ * Keyboard (usage page 0x07) and consumer control (usage page 0x0C) keys are looked up in the
+ * keymap when pressed, and repeats of held keys are stopped once all keys are released
  * 
  */
-static void hid_host_handle_interrupt_report(const uint8_t* report, uint16_t report_len)
+static void hid_host_handle_interrupt_report(hid_context_t* device, const uint8_t* report,
+    uint16_t report_len)
 {
-    char c = '\0';
+    const btstack_hid_report_layout_t* layout = &device->layout;
+    const btstack_hid_report_id_layout_t* report_layout;
+    const keymap_action_t* action;
+    btstack_hid_report_field_t values[MAX_NR_HID_REPORT_LAYOUT_FIELDS];
+    hid_key_t keys[HID_CONTEXT_MAX_PRESSED];
+    hid_key_t* pressed;
+    uint8_t report_index;
+    uint8_t num_keys;
+    uint8_t num_pressed;
+    int num_values;
+    int i, j;
 
-    // Ignore if report frame has an unwanted length (we want data frames with 10 bytes)
-    if (report_len < 10)
-        return;
-    // Ignore if report frame doesn't start with expected values
-    // "A1 01 00 00 KEY_1 KEY_2 KEY_3 KEY_4 KEY_5 00"
-    if ((report[0] != 0xa1) || (report[1] != 0x01) || (report[2] != 0x00) || (report[3] != 0x00))
-        return;
-    // Ignore if report frame is for invalid number of keys pressed "A1 01 00 00 01 01 01 01 01 01"
-    if ((report[0] == 0xa1) && (report[1] == 0x01) && (report[2] == 0x00) && (report[3] == 0x00) &&
-        (report[4] == 0x01) && (report[5] == 0x01) && (report[6] == 0x01) && (report[7] == 0x01) &&
-        (report[8] == 0x01) && (report[9] == 0x01))
-    {
+    // Ignore if it is not an input report frame "A1 <report>"
+    if ((report_len < 2) || (report[0] != 0xa1))
         return;
-    }
-
-    // Just keep keys data bytes from the frame (bypass "A1 01 00 00")
-    report = report + 4;
-    report_len = report_len - 4;
+    report = report + 1;
+    report_len = report_len - 1;
 
-    // Detect all keys realeased
-    if ((report[0] == 0x00) && (report[1] == 0x00) && (report[2] == 0x00) && 
-        (report[3] == 0x00) && (report[4] == 0x00) && (report[5] == 0x00))
-    {
-        printf("Key: Released\n");
+    report_layout = btstack_hid_report_layout_find(layout, report, report_len);
+    if (report_layout == NULL)
         return;
-    }
+    num_values = btstack_hid_report_layout_extract(layout, report, report_len, values,
+        MAX_NR_HID_REPORT_LAYOUT_FIELDS);
+    latency_mark(LATENCY_STAGE_REPORT_DECODE);
 
-    for(uint8_t i = 0; i < report_len; i++)
+    // Get the keys pressed in the report
+    num_keys = 0;
+    for(i = 0; i < num_values; i++)
     {
-        c = parse_numpad(report[i]);
-        if(report[i] == 0x2A)
+        // Skip released variable keys and empty array slots
+        if((values[i].value == 0) || (values[i].usage == 0))
+            continue;
+        if(values[i].usage_page == HID_USAGE_PAGE_KEYBOARD)
         {
-            printf("Key: BackSpace\n");
+            // Ignore the report if it is for an invalid number of keys pressed ("01 01 01 01 01 01")
+            if((values[i].usage > 0x00) && (values[i].usage <= 0x03))
+                return;
+        }
+        else if(values[i].usage_page != HID_USAGE_PAGE_CONSUMER)
             continue;
+        if(num_keys < HID_CONTEXT_MAX_PRESSED)
+        {
+            keys[num_keys].usage_page = values[i].usage_page;
+            keys[num_keys].usage = values[i].usage;
+            num_keys++;
         }
-        if(report[i] == 0x58)
+    }
+
+    // Send the action of the keys that were not already pressed in the previous report
+    report_index = report_layout - layout->reports;
+    pressed = device->pressed[report_index];
+    num_pressed = device->num_pressed[report_index];
+    for(i = 0; i < num_keys; i++)
+    {
+        for(j = 0; j < num_pressed; j++)
         {
-            printf("Key: Enter\n");
-            continue;
+            if((pressed[j].usage_page == keys[i].usage_page) && (pressed[j].usage == keys[i].usage))
+                break;
         }
-        if(report[i] != 0x00)
+        if(j < num_pressed)
+            continue;
+        // In learning mode the key is bound to the next IR frame received instead of sent
+        if(ir_learn_key(keys[i].usage_page, keys[i].usage))
+            continue;
+        action = hid_key_action(&keys[i]);
+        if(action->label == NULL)
+            continue;
+        event_log_text(EVENT_LOG_KEY, action->label);
+        ir_send_action(device, action);
+        hid_reconnect_key(device);
+    }
+    memcpy(pressed, keys, num_keys * sizeof(hid_key_t));
+    device->num_pressed[report_index] = num_keys;
+
+    // Detect all keys realeased
+    if ((num_keys == 0) && (num_pressed != 0))
+    {
+        for(i = 0; i < layout->num_reports; i++)
         {
-            printf("Key: %c\n", c);
-            if(c == '0')
-                ir_send_nec(LG_NUMBER_0);
-            else if(c == '1')
-                ir_send_nec(LG_NUMBER_1);
-            else if(c == '2')
-                ir_send_nec(LG_NUMBER_2);
-            else if(c == '3')
-                ir_send_nec(LG_NUMBER_3);
-            else if(c == '4')
-                ir_send_nec(LG_NUMBER_4);
-            else if(c == '5')
-                ir_send_nec(LG_NUMBER_5);
-            else if(c == '6')
-                ir_send_nec(LG_NUMBER_6);
-            else if(c == '7')
-                ir_send_nec(LG_NUMBER_7);
-            else if(c == '8')
-                ir_send_nec(LG_NUMBER_8);
-            else if(c == '9')
-                ir_send_nec(LG_NUMBER_9);
-            else if(c == '+')
-                ir_send_nec(LG_VOL_PLUS);
-            else if(c == '-')
-                ir_send_nec(LG_VOL_LESS);
-            else if(c == '*')
-                ir_send_nec(LG_PROG_PLUS);
-            else if(c == '/')
-                ir_send_nec(LG_PROG_LESS);
-            else if(c == '.')
-                ir_send_nec(LG_POWER);
+            if(device->num_pressed[i] != 0)
+                return;
         }
+
+        ir_tx_stats_t ir_stats;
+        event_log(EVENT_LOG_KEY_RELEASED, &device->index, 1);
+        ir_release(device);
+        ir_tx_get_stats(&ir_stats);
+        debug("IR TX: %u sent, %u repeats, %u queued (max %u), %u dropped\n", ir_stats.sent,
+            ir_stats.repeats, ir_stats.depth, ir_stats.max_depth, ir_stats.dropped);
     }
-    printf("\n");
 }
 
 /*
@@ -400,41 +896,53 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
     bd_addr_t event_addr;
     uint8_t   status;
     uint16_t  l2cap_cid;
+    hid_context_t* device;
 
     /* LISTING_RESUME */
     switch (packet_type) {
 		case HCI_EVENT_PACKET:
             event = hci_event_packet_get_type(packet);
-            printf("\n---Event received with code: 0x%02X---\n", event);
+            event_log(EVENT_LOG_HCI_EVENT, packet, size);
             switch (event) {
                 /* @text When BTSTACK_EVENT_STATE with state HCI_STATE_WORKING
                  * is received and the example is started in client mode, the remote SDP HID query is started.
                  */
                 case BTSTACK_EVENT_STATE:
                     if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING) {
-                        debug("Start SDP HID query for remote HID Device.\n");
-                        sdp_client_query_uuid16(&handle_sdp_client_query_result, remote_addr, BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE);
+                        for (uint8_t i = 0; i < HID_CONTEXT_MAX; i++) {
+                            device = hid_context_get(i);
+                            if (device != NULL)
+                                hid_reconnect_start(device);
+                        }
+                        // Nothing paired yet, look for a device right away
+                        if (hid_context_count() == 0)
+                            hid_pairing_start();
                     }
                     break;
 
                 case HCI_EVENT_CONNECTION_COMPLETE:
-                    if(!device_is_connected)
-                        sdp_client_query_uuid16(&handle_sdp_client_query_result, remote_addr, BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE);
+                    if (hci_event_connection_complete_get_status(packet))
+                        break;
+                    hci_event_connection_complete_get_bd_addr(packet, event_addr);
+                    device = hid_context_get_by_addr(event_addr);
+                    if (device == NULL)
+                        break;
+                    device->con_handle = hci_event_connection_complete_get_connection_handle(packet);
+                    event_log(EVENT_LOG_DEVICE_CONNECTED, &device->index, 1);
                     break;
 
-                case BTSTACK_EVENT_NR_CONNECTIONS_CHANGED:
-                    if (packet[2])
-                    {
-                        device_is_connected = 1;
-                        printf("Device connected.\n");
-                    }
-                    else
-                    {
-                        device_is_connected = 0;
-                        printf("Device disconnected.\n");
-                        // Re-enable connection
-                        sdp_client_query_uuid16(&handle_sdp_client_query_result, remote_addr, BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE);
-                    }
+                case HCI_EVENT_DISCONNECTION_COMPLETE:
+                    device = hid_context_get_by_con_handle(hci_event_disconnection_complete_get_connection_handle(packet));
+                    if (device == NULL)
+                        break;
+                    event_log(EVENT_LOG_DEVICE_DISCONNECTED, &device->index, 1);
+                    hid_host_disconnected(device);
+                    // A device going to sleep pages the bridge when it wakes up, one lost out of
+                    // range is paged
+                    status = hci_event_disconnection_complete_get_reason(packet);
+                    hid_reconnect_lost(device, (status == ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION) ||
+                        (status == ERROR_CODE_REMOTE_DEVICE_TERMINATED_CONNECTION_DUE_TO_LOW_RESOURCES) ||
+                        (status == ERROR_CODE_REMOTE_DEVICE_TERMINATED_CONNECTION_DUE_TO_POWER_OFF));
                     break;
 
                 /* LISTING_PAUSE */
@@ -453,49 +961,103 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
 
                 /* LISTING_RESUME */
 
-                case L2CAP_EVENT_CHANNEL_OPENED:
-                    status = packet[2];
-                    if (status){
-                        printf("L2CAP Connection failed: 0x%02x\n", status);
+                case L2CAP_EVENT_INCOMING_CONNECTION:
+                    l2cap_cid = l2cap_event_incoming_connection_get_local_cid(packet);
+                    l2cap_event_incoming_connection_get_address(packet, event_addr);
+                    device = hid_context_get_by_addr(event_addr);
+                    if (device == NULL) {
+                        l2cap_decline_connection(l2cap_cid);
                         break;
                     }
-                    l2cap_cid  = little_endian_read_16(packet, 13);
-                    if (!l2cap_cid)
-                    {
-                        printf("No\n");
+                    if (l2cap_event_incoming_connection_get_psm(packet) == BLUETOOTH_PSM_HID_CONTROL) {
+                        if (device->control_cid) {
+                            l2cap_decline_connection(l2cap_cid);
+                            break;
+                        }
+                        hid_host_incoming(device);
+                        device->control_cid = l2cap_cid;
+                    } else {
+                        if (device->interrupt_cid || (device->state != HID_CONTEXT_CONNECTING)) {
+                            l2cap_decline_connection(l2cap_cid);
+                            break;
+                        }
+                        device->interrupt_cid = l2cap_cid;
+                    }
+                    hid_context_bind_cid(device, l2cap_cid);
+                    l2cap_accept_connection(l2cap_cid);
+                    break;
+
+                case L2CAP_EVENT_CHANNEL_OPENED:
+                    status = l2cap_event_channel_opened_get_status(packet);
+                    l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
+                    device = hid_context_get_by_cid(l2cap_cid);
+                    if (device == NULL)
+                        break;
+                    if (status){
+                        event_log(EVENT_LOG_L2CAP_FAILED, &status, 1);
+                        hid_host_disconnected(device);
+                        // The cached PSMs are wrong, fall back to the SDP query
+                        if (device->cache_used && (status == L2CAP_CONNECTION_RESPONSE_RESULT_REFUSED_PSM)){
+                            hid_cache_delete(device->addr);
+                            device->cache_used = 0;
+                            hid_host_connect(device);
+                        } else {
+                            hid_reconnect_lost(device, false);
+                        }
                         break;
                     }
-                    if (l2cap_cid == l2cap_hid_control_cid){
-                        status = l2cap_create_channel(packet_handler, remote_addr, hid_interrupt_psm, 48, &l2cap_hid_interrupt_cid);
+                    device->con_handle = l2cap_event_channel_opened_get_handle(packet);
+                    // The device opens its interrupt channel itself after its control channel
+                    if ((l2cap_cid == device->control_cid) && l2cap_event_channel_opened_get_incoming(packet)){
+                        event_log(EVENT_LOG_HID_CONTROL_CONNECTED, &device->index, 1);
+                    } else if (l2cap_cid == device->control_cid){
+                        status = l2cap_create_channel(packet_handler, device->addr, device->record.interrupt_psm, 48, &device->interrupt_cid);
                         if (status){
-                            printf("Connecting to HID Control failed: 0x%02x\n", status);
+                            event_log(EVENT_LOG_L2CAP_FAILED, &status, 1);
+                            device->interrupt_cid = 0;
+                            device->state = HID_CONTEXT_IDLE;
+                            hid_reconnect_lost(device, false);
                             break;
                         }
-                        else
-                            printf("HID Control connected.\n");
+                        hid_context_bind_cid(device, device->interrupt_cid);
+                        event_log(EVENT_LOG_HID_CONTROL_CONNECTED, &device->index, 1);
                     }
-                    if (l2cap_cid == l2cap_hid_interrupt_cid){
-                        printf("HID Connection established\n");
+                    if (l2cap_cid == device->interrupt_cid){
+                        event_log(EVENT_LOG_HID_CONNECTED, &device->index, 1);
+                        hid_host_connected(device);
                     }
-                    else
-                        printf("HID Connection not established\n");
+                    break;
+
+                case L2CAP_EVENT_CHANNEL_CLOSED:
+                    l2cap_cid = l2cap_event_channel_closed_get_local_cid(packet);
+                    device = hid_context_get_by_cid(l2cap_cid);
+                    hid_context_unbind_cid(l2cap_cid);
+                    if (device == NULL)
+                        break;
+                    if (l2cap_cid == device->control_cid)
+                        device->control_cid = 0;
+                    if (l2cap_cid == device->interrupt_cid)
+                        device->interrupt_cid = 0;
                     break;
                 default:
                     break;
             }
             break;
         case L2CAP_DATA_PACKET:
-            // for now, just dump incoming data
-            printf("HID packet received: ");
-            printf_hexdump(packet, size);
-            if (channel == l2cap_hid_interrupt_cid){
-                hid_host_handle_interrupt_report(packet,  size);
-            } else if (channel == l2cap_hid_control_cid){
-                debug("HID Control: ");
-                debug_hexdump(packet, size);
-            } else {
+            device = hid_context_get_by_cid(channel);
+            if (device == NULL)
                 break;
+            if (channel == device->interrupt_cid){
+                latency_begin(hci_transport_rx_cycles());
+                latency_mark(LATENCY_STAGE_L2CAP_DISPATCH);
+                event_log(EVENT_LOG_HID_REPORT, packet, size);
+                hid_host_handle_interrupt_report(device, packet, size);
+                latency_end();
+                hid_sniff_activity(device);
+            } else if (channel == device->control_cid){
+                event_log(EVENT_LOG_HID_CONTROL, packet, size);
             }
+            break;
         default:
             break;
     }
@@ -505,13 +1067,52 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
 extern "C" { int btstack_main(int argc, const char * argv[]); }
 int btstack_main(int argc, const char * argv[])
 {
-    (void)argc;
-    (void)argv;
+    bd_addr_t addr;
+    bd_addr_t allowed[HID_PAIRING_MAX_DEVICES];
+    uint8_t num_allowed;
 
     hid_host_setup();
+    hid_pairing_init(&hid_host_paired);
+    hid_reconnect_init(&hid_host_page);
+    hid_sniff_init();
+
+    // Print the log from a low priority task
+    event_log_init();
+
+    // Start the IR transmitter task
+    ir_tx_init(PIN_O_IR_TX);
+    ir_rx_init(PIN_I_IR_RX);
+
+    // Use the keymap stored in TLV if any (builtin LG-32LS570S keymap otherwise)
+    if(keymap_load() > 0)
+        printf("Stored keymap loaded.\n");
+    if(ir_macro_load() > 0)
+        printf("Stored IR macros loaded.\n");
+    if(ir_learn_init() > 0)
+        printf("Learned keys loaded.\n");
+
+    // Devices to connect, the paired ones and those given as arguments (human readable Bluetooth
+    // addresses), the pairing mode starts on power up if there is none
+    num_allowed = hid_pairing_get_allow_list(allowed, HID_PAIRING_MAX_DEVICES);
+    for(uint8_t i = 0; i < num_allowed; i++)
+        hid_context_add(allowed[i]);
+    for(int i = 1; i < argc; i++)
+    {
+        if(!sscanf_bd_addr(argv[i], addr) || (hid_context_add(addr) == NULL))
+            printf("Device %s not added.\n", argv[i]);
+    }
+
+#ifdef ESP_PLATFORM
+    // Poll the pairing mode button
+    pinMode(PIN_I_PAIRING, INPUT_PULLUP);
+    btstack_run_loop_set_timer_handler(&pairing_button_timer, &pairing_button_poll);
+    btstack_run_loop_set_timer(&pairing_button_timer, PAIRING_BUTTON_POLL_MS);
+    btstack_run_loop_add_timer(&pairing_button_timer);
+#endif
 
-    // parse human readable Bluetooth address
-    sscanf_bd_addr(remote_addr_string, remote_addr);
+#ifdef HAVE_BTSTACK_STDIN
+    btstack_stdin_setup(stdin_process);
+#endif
 
     // Turn on the device 
     hci_power_control(HCI_POWER_ON);